@@ -11,6 +11,8 @@
 import sys
 import unicode
 
+BLOCK_BITS = 7
+
 def generate_decompositions():
 	ud = unicode.data()
 	con = unicode.confusables()
@@ -51,6 +53,9 @@ def generate_decompositions():
 
 	return {c: gen(c) for c in interesting}
 
+def gen_index(decompositions):
+	return unicode.two_level_table({k: i + 1 for i, k in enumerate(sorted(decompositions))}, BLOCK_BITS)
+
 def gen_header(decompositions, len_set):
 	print("""\
 #include <cstdint>
@@ -65,6 +70,8 @@ struct DECOMP_SLICE
 	print("{")
 	print(f"\tNUM_DECOMP_LENGTHS = {len(len_set)},")
 	print(f"\tNUM_DECOMPS = {len(decompositions)},")
+	print(f"\tDECOMP_BLOCK_BITS = {BLOCK_BITS},")
+	print(f"\tNUM_DECOMP_BLOCKS = {len(gen_index(decompositions)[1]) >> BLOCK_BITS},")
 	print("};")
 	print()
 
@@ -72,6 +79,11 @@ struct DECOMP_SLICE
 	print("extern const int32_t decomp_chars[NUM_DECOMPS];")
 	print("extern const struct DECOMP_SLICE decomp_slices[NUM_DECOMPS];")
 	print("extern const int32_t decomp_data[];")
+	print()
+	print("// Two-level lookup of the index into `decomp_chars` plus one, 0 for code")
+	print("// points without a decomposition.")
+	print("extern const uint16_t decomp_block_index[0x110000 >> DECOMP_BLOCK_BITS];")
+	print("extern const uint16_t decomp_blocks[NUM_DECOMP_BLOCKS << DECOMP_BLOCK_BITS];")
 
 def gen_data(decompositions, decomposition_set, decomposition_offsets, len_set):
 	print("""\
@@ -106,6 +118,17 @@ def gen_data(decompositions, decomposition_set, decomposition_offsets, len_set):
 		for c in d:
 			print(f"\t0x{c:x},")
 	print("};")
+	print()
+
+	block_index, blocks = gen_index(decompositions)
+	print("const uint16_t decomp_block_index[0x110000 >> DECOMP_BLOCK_BITS] = {")
+	unicode.print_table(block_index)
+	print("};")
+	print()
+
+	print("const uint16_t decomp_blocks[NUM_DECOMP_BLOCKS << DECOMP_BLOCK_BITS] = {")
+	unicode.print_table(blocks)
+	print("};")
 
 def main():
 	decompositions = generate_decompositions()
@@ -10,10 +10,15 @@
 import sys
 import unicode
 
+BLOCK_BITS = 8
+
 def generate_cases():
 	ud = unicode.data()
 	return [(unicode.unhex(u["Value"]), unicode.unhex(u["Simple_Lowercase_Mapping"])) for u in ud if u["Simple_Lowercase_Mapping"]]
 
+def gen_index(cases):
+	return unicode.two_level_table({upper_code: i + 1 for i, (upper_code, _) in enumerate(cases)}, BLOCK_BITS)
+
 def gen_header(cases):
 	print(f"""\
 #include <cstdint>
@@ -27,9 +32,16 @@ struct UPPER_LOWER
 enum
 {{
 \tNUM_TOLOWER = {len(cases)},
+\tTOLOWER_BLOCK_BITS = {BLOCK_BITS},
+\tNUM_TOLOWER_BLOCKS = {len(gen_index(cases)[1]) >> BLOCK_BITS},
 }};
 
-extern const struct UPPER_LOWER tolowermap[];""")
+extern const struct UPPER_LOWER tolowermap[];
+
+// Two-level lookup of the index into `tolowermap` plus one, 0 for code
+// points without a lowercase mapping.
+extern const uint16_t tolower_block_index[0x110000 >> TOLOWER_BLOCK_BITS];
+extern const uint16_t tolower_blocks[NUM_TOLOWER_BLOCKS << TOLOWER_BLOCK_BITS];""")
 
 def gen_data(cases):
 	print("""\
@@ -41,6 +53,17 @@ const struct UPPER_LOWER tolowermap[] = {""")
 	for upper_code, lower_code in cases:
 		print(f"\t{{{upper_code}, {lower_code}}},")
 	print("};")
+	print()
+
+	block_index, blocks = gen_index(cases)
+	print("const uint16_t tolower_block_index[0x110000 >> TOLOWER_BLOCK_BITS] = {")
+	unicode.print_table(block_index)
+	print("};")
+	print()
+
+	print("const uint16_t tolower_blocks[NUM_TOLOWER_BLOCKS << TOLOWER_BLOCK_BITS] = {")
+	unicode.print_table(blocks)
+	print("};")
 
 def main():
 	cases = generate_cases()
@@ -33,3 +33,24 @@ def unhex(s):
 
 def unhex_sequence(s):
 	return [unhex(x) for x in s.split()] if '<' not in s else None
+
+NUM_CODEPOINTS = 0x110000
+
+def two_level_table(values, block_bits):
+	"""Splits the mapping from code points to small non-zero integers into
+	an index of deduplicated blocks, unmapped code points get 0."""
+	block_size = 1 << block_bits
+	block_ids = {}
+	index = []
+	blocks = []
+	for start in range(0, NUM_CODEPOINTS, block_size):
+		block = tuple(values.get(c, 0) for c in range(start, start + block_size))
+		if block not in block_ids:
+			block_ids[block] = len(block_ids)
+			blocks.extend(block)
+		index.append(block_ids[block])
+	return index, blocks
+
+def print_table(values, per_line=16):
+	for i in range(0, len(values), per_line):
+		print("\t" + " ".join(f"{v}," for v in values[i:i + per_line]))
@@ -6,22 +6,20 @@
 
 static int str_utf8_skeleton(int ch, const int **skeleton, int *skeleton_len)
 {
-	int i;
-	for(i = 0; i < NUM_DECOMPS; i++)
+	int i = 0;
+	if(ch >= 0 && ch < 0x110000)
 	{
-		if(ch == decomp_chars[i])
-		{
-			int offset = decomp_slices[i].offset;
-			int length = decomp_lengths[decomp_slices[i].length];
+		int block = decomp_block_index[ch >> DECOMP_BLOCK_BITS];
+		i = decomp_blocks[(block << DECOMP_BLOCK_BITS) | (ch & ((1 << DECOMP_BLOCK_BITS) - 1))];
+	}
+	if(i != 0)
+	{
+		int offset = decomp_slices[i - 1].offset;
+		int length = decomp_lengths[decomp_slices[i - 1].length];
 
-			*skeleton = &decomp_data[offset];
-			*skeleton_len = length;
-			return 1;
-		}
-		else if(ch < decomp_chars[i])
-		{
-			break;
-		}
+		*skeleton = &decomp_data[offset];
+		*skeleton_len = length;
+		return 1;
 	}
 	*skeleton = NULL;
 	*skeleton_len = 1;
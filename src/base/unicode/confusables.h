@@ -10,9 +10,16 @@ enum
 {
 	NUM_DECOMP_LENGTHS = 8,
 	NUM_DECOMPS = 9770,
+	DECOMP_BLOCK_BITS = 7,
+	NUM_DECOMP_BLOCKS = 266,
 };
 
 extern const uint8_t decomp_lengths[NUM_DECOMP_LENGTHS];
 extern const int32_t decomp_chars[NUM_DECOMPS];
 extern const struct DECOMP_SLICE decomp_slices[NUM_DECOMPS];
 extern const int32_t decomp_data[];
+
+// Two-level lookup of the index into `decomp_chars` plus one, 0 for code
+// points without a decomposition.
+extern const uint16_t decomp_block_index[0x110000 >> DECOMP_BLOCK_BITS];
+extern const uint16_t decomp_blocks[NUM_DECOMP_BLOCKS << DECOMP_BLOCK_BITS];
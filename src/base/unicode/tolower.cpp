@@ -1,24 +1,15 @@
-#include <cstdlib>
-
 #include "tolower.h"
 
-static int compul(const void *a, const void *b)
-{
-	struct UPPER_LOWER *ul_a = (struct UPPER_LOWER *)a;
-	struct UPPER_LOWER *ul_b = (struct UPPER_LOWER *)b;
-	return ul_a->upper - ul_b->upper;
-}
-
 int str_utf8_tolower(int code)
 {
-	struct UPPER_LOWER key;
-	struct UPPER_LOWER *res;
-	key.upper = code;
-	res = (UPPER_LOWER *)bsearch(&key, tolowermap, NUM_TOLOWER, sizeof(struct UPPER_LOWER), compul);
+	if(code < 0 || code >= 0x110000)
+		return code;
 
-	if(res == NULL)
+	int block = tolower_block_index[code >> TOLOWER_BLOCK_BITS];
+	int i = tolower_blocks[(block << TOLOWER_BLOCK_BITS) | (code & ((1 << TOLOWER_BLOCK_BITS) - 1))];
+	if(i == 0)
 		return code;
-	return res->lower;
+	return tolowermap[i - 1].lower;
 }
 
 #define TOLOWER_DATA
@@ -9,6 +9,13 @@ struct UPPER_LOWER
 enum
 {
 	NUM_TOLOWER = 1433,
+	TOLOWER_BLOCK_BITS = 8,
+	NUM_TOLOWER_BLOCKS = 24,
 };
 
 extern const struct UPPER_LOWER tolowermap[];
+
+// Two-level lookup of the index into `tolowermap` plus one, 0 for code
+// points without a lowercase mapping.
+extern const uint16_t tolower_block_index[0x110000 >> TOLOWER_BLOCK_BITS];
+extern const uint16_t tolower_blocks[NUM_TOLOWER_BLOCKS << TOLOWER_BLOCK_BITS];
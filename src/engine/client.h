@@ -218,6 +218,8 @@ public:
 	// TODO: Refactor: should redo this a bit i think, too many virtual calls
 	virtual int SnapNumItems(int SnapID) const = 0;
 	virtual const void *SnapFindItem(int SnapID, int Type, int ID) const = 0;
+	// Returns the number of items of the given type and their indices for `SnapGetItem`.
+	virtual int SnapItemsOfType(int SnapID, int Type, const int **ppIndices) const = 0;
 	virtual void *SnapGetItem(int SnapID, int Index, CSnapItem *pItem) const = 0;
 	virtual int SnapItemSize(int SnapID, int Index) const = 0;
 
@@ -695,10 +695,13 @@ int CClient::SnapItemSize(int SnapID, int Index) const
 
 const void *CClient::SnapFindItem(int SnapID, int Type, int ID) const
 {
-	if(!m_aapSnapshots[g_Config.m_ClDummy][SnapID])
+	const CSnapshotStorage::CHolder *pHolder = m_aapSnapshots[g_Config.m_ClDummy][SnapID];
+	if(!pHolder)
 		return nullptr;
 
-	return m_aapSnapshots[g_Config.m_ClDummy][SnapID]->m_pAltSnap->FindItem(Type, ID);
+	if(pHolder->m_pAltDirectory)
+		return pHolder->m_pAltDirectory->FindItem(Type, ID);
+	return pHolder->m_pAltSnap->FindItem(Type, ID);
 }
 
 int CClient::SnapNumItems(int SnapID) const
@@ -709,6 +712,18 @@ int CClient::SnapNumItems(int SnapID) const
 	return m_aapSnapshots[g_Config.m_ClDummy][SnapID]->m_pAltSnap->NumItems();
 }
 
+int CClient::SnapItemsOfType(int SnapID, int Type, const int **ppIndices) const
+{
+	dbg_assert(SnapID >= 0 && SnapID < NUM_SNAPSHOT_TYPES, "invalid SnapID");
+	const CSnapshotStorage::CHolder *pHolder = m_aapSnapshots[g_Config.m_ClDummy][SnapID];
+	if(!pHolder || !pHolder->m_pAltDirectory)
+	{
+		*ppIndices = nullptr;
+		return 0;
+	}
+	return pHolder->m_pAltDirectory->ItemsOfType(Type, ppIndices);
+}
+
 void CClient::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
@@ -2303,6 +2318,7 @@ void CClient::OnDemoPlayerSnapshot(void *pData, int Size)
 	std::swap(m_aapSnapshots[g_Config.m_ClDummy][SNAP_PREV], m_aapSnapshots[g_Config.m_ClDummy][SNAP_CURRENT]);
 	mem_copy(m_aapSnapshots[g_Config.m_ClDummy][SNAP_CURRENT]->m_pSnap, pData, Size);
 	mem_copy(m_aapSnapshots[g_Config.m_ClDummy][SNAP_CURRENT]->m_pAltSnap, pAltSnapBuffer, AltSnapSize);
+	m_aapSnapshots[g_Config.m_ClDummy][SNAP_CURRENT]->m_pAltDirectory->Build(m_aapSnapshots[g_Config.m_ClDummy][SNAP_CURRENT]->m_pAltSnap);
 
 	GameClient()->OnNewSnapshot();
 }
@@ -3055,6 +3071,7 @@ void CClient::Run()
 	m_Fifo.Shutdown();
 
 	GameClient()->OnShutdown();
+	m_GhostRecorder.Shutdown();
 	Disconnect();
 
 	// close socket
@@ -3563,6 +3580,8 @@ const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType] = &m_aDemorecSnapshotHolders[SnapshotType];
 		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType]->m_pSnap = (CSnapshot *)&m_aaaDemorecSnapshotData[SnapshotType][0];
 		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType]->m_pAltSnap = (CSnapshot *)&m_aaaDemorecSnapshotData[SnapshotType][1];
+		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType]->m_pAltDirectory = &m_aDemorecSnapshotDirectories[SnapshotType];
+		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType]->m_pAltDirectory->Clear();
 		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType]->m_SnapSize = 0;
 		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType]->m_AltSnapSize = 0;
 		m_aapSnapshots[g_Config.m_ClDummy][SnapshotType]->m_Tick = -1;
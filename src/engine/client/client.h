@@ -193,6 +193,7 @@ class CClient : public IClient, public CDemoPlayer::IListener
 	int m_aSnapshotIncomingDataSize[NUM_DUMMIES] = {0, 0};
 
 	CSnapshotStorage::CHolder m_aDemorecSnapshotHolders[NUM_SNAPSHOT_TYPES];
+	CSnapshotDirectory m_aDemorecSnapshotDirectories[NUM_SNAPSHOT_TYPES];
 	char m_aaaDemorecSnapshotData[NUM_SNAPSHOT_TYPES][2][CSnapshot::MAX_SIZE];
 
 	CSnapshotDelta m_SnapshotDelta;
@@ -327,6 +328,7 @@ public:
 	int SnapItemSize(int SnapID, int Index) const override;
 	const void *SnapFindItem(int SnapID, int Type, int ID) const override;
 	int SnapNumItems(int SnapID) const override;
+	int SnapItemsOfType(int SnapID, int Type, const int **ppIndices) const override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
 
 	void Render();
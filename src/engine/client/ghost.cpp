@@ -1,43 +1,130 @@
 #include "ghost.h"
 
+#include <base/log.h>
 #include <base/system.h>
 
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/shared/compression.h>
 #include <engine/shared/config.h>
 #include <engine/shared/network.h>
 #include <engine/storage.h>
 
+#include <algorithm>
+#include <atomic>
+
 static const unsigned char gs_aHeaderMarker[8] = {'T', 'W', 'G', 'H', 'O', 'S', 'T', 0};
 static const unsigned char gs_CurVersion = 6;
 static const int gs_NumTicksOffset = 93;
 
+static const unsigned char gs_aIndexMarker[8] = {'T', 'W', 'G', 'H', 'I', 'D', 'X', 0};
+static const unsigned char gs_IndexVersion = 1;
+
 static const ColorRGBA gs_GhostPrintColor{0.65f, 0.6f, 0.6f, 1.0f};
 
+class CGhostRecorder::CWriteJob : public IJob
+{
+	IStorage *m_pStorage;
+	char m_aFilename[IO_MAX_PATH_LENGTH];
+	std::vector<unsigned char> m_vData;
+	// set by whichever comes first, the job or Cancel()
+	std::atomic<bool> m_Claimed;
+	SEMAPHORE m_Done;
+
+	void Write()
+	{
+		// write to a temporary file first so the ghost list never sees a partial ghost
+		char aTmpFilename[IO_MAX_PATH_LENGTH];
+		str_format(aTmpFilename, sizeof(aTmpFilename), "%s.tmp", m_aFilename);
+		IOHANDLE File = m_pStorage->OpenFile(aTmpFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(!File)
+		{
+			log_error("ghost_recorder", "Unable to open '%s' for ghost recording", aTmpFilename);
+			return;
+		}
+		const bool Written = io_write(File, m_vData.data(), m_vData.size()) == m_vData.size();
+		if(io_close(File) != 0 || !Written)
+		{
+			log_error("ghost_recorder", "Error writing ghost to '%s'", aTmpFilename);
+			m_pStorage->RemoveFile(aTmpFilename, IStorage::TYPE_SAVE);
+			return;
+		}
+		if(!m_pStorage->RenameFile(aTmpFilename, m_aFilename, IStorage::TYPE_SAVE))
+			m_pStorage->RemoveFile(aTmpFilename, IStorage::TYPE_SAVE);
+	}
+
+	void Run() override
+	{
+		if(!m_Claimed.exchange(true))
+			Write();
+		sphore_signal(&m_Done);
+	}
+
+public:
+	CWriteJob(IStorage *pStorage, const char *pFilename, std::vector<unsigned char> &&vData) :
+		m_pStorage(pStorage), m_vData(std::move(vData)), m_Claimed(false)
+	{
+		str_copy(m_aFilename, pFilename);
+		sphore_init(&m_Done);
+	}
+
+	~CWriteJob()
+	{
+		sphore_destroy(&m_Done);
+	}
+
+	const char *Filename() const { return m_aFilename; }
+
+	// returns false if the job already started writing
+	bool Cancel()
+	{
+		return !m_Claimed.exchange(true);
+	}
+
+	void Wait()
+	{
+		sphore_wait(&m_Done);
+	}
+};
+
 CGhostRecorder::CGhostRecorder()
 {
-	m_File = 0;
+	m_Recording = false;
 	ResetBuffer();
 }
 
 void CGhostRecorder::Init()
 {
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 }
 
-// Record
-int CGhostRecorder::Start(const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, const char *pName)
+void CGhostRecorder::Shutdown()
 {
-	m_File = m_pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
-	if(!m_File)
+	for(auto &pJob : m_vpWriteJobs)
+		pJob->Wait();
+	m_vpWriteJobs.clear();
+}
+
+void CGhostRecorder::CancelWrite(const char *pFilename)
+{
+	for(auto It = m_vpWriteJobs.begin(); It != m_vpWriteJobs.end();)
 	{
-		char aBuf[256];
-		str_format(aBuf, sizeof(aBuf), "Unable to open '%s' for ghost recording", pFilename);
-		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost_recorder", aBuf, gs_GhostPrintColor);
-		return -1;
+		if(str_comp((*It)->Filename(), pFilename) == 0)
+		{
+			if(!(*It)->Cancel())
+				(*It)->Wait();
+			It = m_vpWriteJobs.erase(It);
+		}
+		else
+			++It;
 	}
+}
 
+// Record
+int CGhostRecorder::Start(const char *pMap, SHA256_DIGEST MapSha256, const char *pName)
+{
 	// write header
 	CGhostHeader Header;
 	mem_zero(&Header, sizeof(Header));
@@ -46,14 +133,14 @@ int CGhostRecorder::Start(const char *pFilename, const char *pMap, SHA256_DIGEST
 	str_copy(Header.m_aOwner, pName);
 	str_copy(Header.m_aMap, pMap);
 	Header.m_MapSha256 = MapSha256;
-	io_write(m_File, &Header, sizeof(Header));
+	const unsigned char *pHeader = (const unsigned char *)&Header;
+	m_vData.assign(pHeader, pHeader + sizeof(Header));
 
+	m_Recording = true;
 	m_LastItem.Reset();
 	ResetBuffer();
 
-	char aBuf[256];
-	str_format(aBuf, sizeof(aBuf), "ghost recording to '%s'", pFilename);
-	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost_recorder", aBuf, gs_GhostPrintColor);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost_recorder", "Started ghost recording", gs_GhostPrintColor);
 	return 0;
 }
 
@@ -77,7 +164,7 @@ static void DiffItem(int *pPast, int *pCurrent, int *pOut, int Size)
 
 void CGhostRecorder::WriteData(int Type, const void *pData, int Size)
 {
-	if(!m_File || (unsigned)Size > MAX_ITEM_SIZE || Size <= 0 || Type == -1)
+	if(!m_Recording || (unsigned)Size > MAX_ITEM_SIZE || Size <= 0 || Type == -1)
 		return;
 
 	CGhostItem Data(Type);
@@ -107,7 +194,7 @@ void CGhostRecorder::FlushChunk()
 	int Size = m_pBufferPos - m_aBuffer;
 	int Type = m_LastItem.m_Type;
 
-	if(!m_File || Size == 0)
+	if(!m_Recording || Size == 0)
 		return;
 
 	while(Size & 3)
@@ -126,48 +213,68 @@ void CGhostRecorder::FlushChunk()
 	aChunk[2] = (Size >> 8) & 0xff;
 	aChunk[3] = (Size)&0xff;
 
-	io_write(m_File, aChunk, sizeof(aChunk));
-	io_write(m_File, s_aBuffer2, Size);
+	m_vData.insert(m_vData.end(), aChunk, aChunk + sizeof(aChunk));
+	m_vData.insert(m_vData.end(), s_aBuffer2, s_aBuffer2 + Size);
 
 	m_LastItem.Reset();
 	ResetBuffer();
 }
 
-int CGhostRecorder::Stop(int Ticks, int Time)
+int CGhostRecorder::Stop(int Ticks, int Time, const char *pFilename)
 {
-	if(!m_File)
+	if(!m_Recording)
 		return -1;
 
 	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost_recorder", "Stopped ghost recording", gs_GhostPrintColor);
 
 	FlushChunk();
+	m_Recording = false;
 
-	// write down num shots and time
-	io_seek(m_File, gs_NumTicksOffset, IOSEEK_START);
+	if(!pFilename)
+	{
+		m_vData.clear();
+		return 0;
+	}
 
-	unsigned char aNumTicks[sizeof(int32_t)];
-	uint_to_bytes_be(aNumTicks, Ticks);
-	io_write(m_File, aNumTicks, sizeof(aNumTicks));
+	// write down num shots and time
+	uint_to_bytes_be(&m_vData[gs_NumTicksOffset], Ticks);
+	uint_to_bytes_be(&m_vData[gs_NumTicksOffset + sizeof(int32_t)], Time);
 
-	unsigned char aTime[sizeof(int32_t)];
-	uint_to_bytes_be(aTime, Time);
-	io_write(m_File, aTime, sizeof(aTime));
+	m_vpWriteJobs.erase(std::remove_if(m_vpWriteJobs.begin(), m_vpWriteJobs.end(), [](const std::shared_ptr<CWriteJob> &pJob) { return pJob->Status() == IJob::STATE_DONE; }), m_vpWriteJobs.end());
+	m_vpWriteJobs.push_back(std::make_shared<CWriteJob>(m_pStorage, pFilename, std::move(m_vData)));
+	m_pEngine->AddJob(m_vpWriteJobs.back());
+	m_vData.clear();
 
-	io_close(m_File);
-	m_File = 0;
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "saving ghost to '%s'", pFilename);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost_recorder", aBuf, gs_GhostPrintColor);
 	return 0;
 }
 
 CGhostLoader::CGhostLoader()
 {
 	m_File = 0;
+	m_aIndexFilename[0] = '\0';
+	m_IndexChanged = false;
 	ResetBuffer();
 }
 
 void CGhostLoader::Init()
 {
-	m_pConsole = Kernel()->RequestInterface<IConsole>();
-	m_pStorage = Kernel()->RequestInterface<IStorage>();
+	Init(Kernel()->RequestInterface<IConsole>(), Kernel()->RequestInterface<IStorage>());
+}
+
+void CGhostLoader::Init(IConsole *pConsole, IStorage *pStorage)
+{
+	m_pConsole = pConsole;
+	m_pStorage = pStorage;
+}
+
+std::unique_ptr<IGhostLoader> CGhostLoader::CreateLoader() const
+{
+	auto pLoader = std::make_unique<CGhostLoader>();
+	pLoader->Init(m_pConsole, m_pStorage);
+	return pLoader;
 }
 
 void CGhostLoader::ResetBuffer()
@@ -262,8 +369,6 @@ int CGhostLoader::Load(const char *pFilename, const char *pMap, SHA256_DIGEST Ma
 
 int CGhostLoader::ReadChunk(int *pType)
 {
-	static char s_aCompresseddata[MAX_ITEM_SIZE * NUM_ITEMS_PER_CHUNK];
-	static char s_aDecompressed[MAX_ITEM_SIZE * NUM_ITEMS_PER_CHUNK];
 	unsigned char aChunk[4];
 
 	if(m_Header.m_Version != 4)
@@ -280,20 +385,20 @@ int CGhostLoader::ReadChunk(int *pType)
 	if(Size > MAX_ITEM_SIZE * NUM_ITEMS_PER_CHUNK || Size <= 0)
 		return -1;
 
-	if(io_read(m_File, s_aCompresseddata, Size) != (unsigned)Size)
+	if(io_read(m_File, m_aCompressedChunk, Size) != (unsigned)Size)
 	{
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost", "error reading chunk");
 		return -1;
 	}
 
-	Size = CNetBase::Decompress(s_aCompresseddata, Size, s_aDecompressed, sizeof(s_aDecompressed));
+	Size = CNetBase::Decompress(m_aCompressedChunk, Size, m_aDecompressedChunk, sizeof(m_aDecompressedChunk));
 	if(Size < 0)
 	{
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost", "error during network decompression");
 		return -1;
 	}
 
-	Size = CVariableInt::Decompress(s_aDecompressed, Size, m_aBuffer, sizeof(m_aBuffer));
+	Size = CVariableInt::Decompress(m_aDecompressedChunk, Size, m_aBuffer, sizeof(m_aBuffer));
 	if(Size < 0)
 	{
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost", "error during intpack decompression");
@@ -363,18 +468,119 @@ void CGhostLoader::Close()
 	m_File = 0;
 }
 
-bool CGhostLoader::GetGhostInfo(const char *pFilename, CGhostInfo *pGhostInfo, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc)
+void CGhostLoader::LoadIndex(const char *pFilename)
 {
-	CGhostHeader Header;
-	mem_zero(&Header, sizeof(Header));
+	str_copy(m_aIndexFilename, pFilename);
+	m_IndexEntries.clear();
+	m_IndexChanged = false;
+
+	void *pData;
+	unsigned Size;
+	if(!m_pStorage->ReadFile(pFilename, IStorage::TYPE_SAVE, &pData, &Size))
+		return;
+
+	// marker and version, followed by entries of name length, name,
+	// modification time and the raw ghost header
+	const unsigned char *pCur = (const unsigned char *)pData;
+	const unsigned char *pEnd = pCur + Size;
+	if(Size >= sizeof(gs_aIndexMarker) + 1 && mem_comp(pCur, gs_aIndexMarker, sizeof(gs_aIndexMarker)) == 0 && pCur[sizeof(gs_aIndexMarker)] == gs_IndexVersion)
+	{
+		pCur += sizeof(gs_aIndexMarker) + 1;
+		while(pEnd - pCur >= 2)
+		{
+			const int NameLength = (pCur[0] << 8) | pCur[1];
+			pCur += 2;
+			if(NameLength >= IO_MAX_PATH_LENGTH || pEnd - pCur < NameLength + 2 * (int)sizeof(int32_t) + (int)sizeof(CGhostHeader))
+				break;
+			const std::string Name((const char *)pCur, NameLength);
+			pCur += NameLength;
+			SIndexEntry Entry;
+			Entry.m_Modified = ((int64_t)bytes_be_to_uint(pCur) << 32) | bytes_be_to_uint(pCur + sizeof(int32_t));
+			pCur += 2 * sizeof(int32_t);
+			mem_copy(&Entry.m_Header, pCur, sizeof(CGhostHeader));
+			pCur += sizeof(CGhostHeader);
+			Entry.m_Used = false;
+			m_IndexEntries[Name] = Entry;
+		}
+	}
+	free(pData);
+}
+
+void CGhostLoader::SaveIndex()
+{
+	if(!m_aIndexFilename[0])
+		return;
+
+	// drop the files that are gone
+	bool Unused = false;
+	for(const auto &[Name, Entry] : m_IndexEntries)
+		Unused |= !Entry.m_Used;
+
+	if(m_IndexChanged || Unused)
+	{
+		std::vector<unsigned char> vData(gs_aIndexMarker, gs_aIndexMarker + sizeof(gs_aIndexMarker));
+		vData.push_back(gs_IndexVersion);
+		for(const auto &[Name, Entry] : m_IndexEntries)
+		{
+			if(!Entry.m_Used)
+				continue;
+			vData.push_back((Name.size() >> 8) & 0xff);
+			vData.push_back(Name.size() & 0xff);
+			vData.insert(vData.end(), Name.begin(), Name.end());
+			unsigned char aModified[2 * sizeof(int32_t)];
+			uint_to_bytes_be(aModified, (uint64_t)Entry.m_Modified >> 32);
+			uint_to_bytes_be(aModified + sizeof(int32_t), (uint64_t)Entry.m_Modified & 0xffffffff);
+			vData.insert(vData.end(), aModified, aModified + sizeof(aModified));
+			const unsigned char *pHeader = (const unsigned char *)&Entry.m_Header;
+			vData.insert(vData.end(), pHeader, pHeader + sizeof(CGhostHeader));
+		}
+
+		IOHANDLE File = m_pStorage->OpenFile(m_aIndexFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(File)
+		{
+			io_write(File, vData.data(), vData.size());
+			io_close(File);
+		}
+	}
+
+	m_aIndexFilename[0] = '\0';
+	m_IndexEntries.clear();
+	m_IndexChanged = false;
+}
+
+bool CGhostLoader::ReadHeader(const char *pFilename, time_t Modified, CGhostHeader *pHeader)
+{
+	auto Entry = m_IndexEntries.find(pFilename);
+	if(Entry != m_IndexEntries.end() && Entry->second.m_Modified == Modified)
+	{
+		Entry->second.m_Used = true;
+		*pHeader = Entry->second.m_Header;
+		return true;
+	}
+
+	mem_zero(pHeader, sizeof(*pHeader));
 
 	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
 	if(!File)
 		return false;
 
-	io_read(File, &Header, sizeof(Header));
+	io_read(File, pHeader, sizeof(*pHeader));
 	io_close(File);
 
+	if(m_aIndexFilename[0])
+	{
+		m_IndexEntries[pFilename] = {Modified, *pHeader, true};
+		m_IndexChanged = true;
+	}
+	return true;
+}
+
+bool CGhostLoader::GetGhostInfo(const char *pFilename, time_t Modified, CGhostInfo *pGhostInfo, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc)
+{
+	CGhostHeader Header;
+	if(!ReadHeader(pFilename, Modified, &Header))
+		return false;
+
 	if(mem_comp(Header.m_aMarker, gs_aHeaderMarker, sizeof(gs_aHeaderMarker)) || !(4 <= Header.m_Version && Header.m_Version <= gs_CurVersion))
 		return false;
 
@@ -5,6 +5,11 @@
 
 #include <base/system.h>
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 enum
 {
 	MAX_ITEM_SIZE = 128,
@@ -60,10 +65,18 @@ public:
 
 class CGhostRecorder : public IGhostRecorder
 {
-	IOHANDLE m_File;
+	class CWriteJob;
+
 	class IConsole *m_pConsole;
+	class IEngine *m_pEngine;
 	class IStorage *m_pStorage;
 
+	// header and compressed chunks of the current recording,
+	// written to disk all at once when it is stopped
+	bool m_Recording;
+	std::vector<unsigned char> m_vData;
+	std::vector<std::shared_ptr<CWriteJob>> m_vpWriteJobs;
+
 	CGhostItem m_LastItem;
 
 	char m_aBuffer[MAX_ITEM_SIZE * NUM_ITEMS_PER_CHUNK];
@@ -77,12 +90,14 @@ public:
 	CGhostRecorder();
 
 	void Init();
+	void Shutdown() override;
 
-	int Start(const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, const char *pName) override;
-	int Stop(int Ticks, int Time) override;
+	int Start(const char *pMap, SHA256_DIGEST MapSha256, const char *pName) override;
+	int Stop(int Ticks, int Time, const char *pFilename) override;
+	void CancelWrite(const char *pFilename) override;
 
 	void WriteData(int Type, const void *pData, int Size) override;
-	bool IsRecording() const override { return m_File != nullptr; }
+	bool IsRecording() const override { return m_Recording; }
 };
 
 class CGhostLoader : public IGhostLoader
@@ -97,18 +112,33 @@ class CGhostLoader : public IGhostLoader
 	CGhostItem m_LastItem;
 
 	char m_aBuffer[MAX_ITEM_SIZE * NUM_ITEMS_PER_CHUNK];
+	char m_aCompressedChunk[MAX_ITEM_SIZE * NUM_ITEMS_PER_CHUNK];
+	char m_aDecompressedChunk[MAX_ITEM_SIZE * NUM_ITEMS_PER_CHUNK];
 	char *m_pBufferPos;
 	int m_BufferNumItems;
 	int m_BufferCurItem;
 	int m_BufferPrevItem;
 
+	struct SIndexEntry
+	{
+		time_t m_Modified;
+		CGhostHeader m_Header;
+		bool m_Used;
+	};
+
+	char m_aIndexFilename[IO_MAX_PATH_LENGTH];
+	std::unordered_map<std::string, SIndexEntry> m_IndexEntries;
+	bool m_IndexChanged;
+
 	void ResetBuffer();
 	int ReadChunk(int *pType);
+	bool ReadHeader(const char *pFilename, time_t Modified, CGhostHeader *pHeader);
 
 public:
 	CGhostLoader();
 
 	void Init();
+	void Init(class IConsole *pConsole, class IStorage *pStorage);
 
 	int Load(const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc) override;
 	void Close() override;
@@ -117,6 +147,10 @@ public:
 	bool ReadNextType(int *pType) override;
 	bool ReadData(int Type, void *pData, int Size) override;
 
-	bool GetGhostInfo(const char *pFilename, CGhostInfo *pGhostInfo, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc) override;
+	std::unique_ptr<IGhostLoader> CreateLoader() const override;
+
+	void LoadIndex(const char *pFilename) override;
+	void SaveIndex() override;
+	bool GetGhostInfo(const char *pFilename, time_t Modified, CGhostInfo *pGhostInfo, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc) override;
 };
 #endif
@@ -36,7 +36,7 @@ class CSortWrap
 public:
 	CSortWrap(CServerBrowser *pServer, SortFunc Func) :
 		m_pfnSort(Func), m_pThis(pServer) {}
-	bool operator()(int a, int b) { return (g_Config.m_BrSortOrder ? (m_pThis->*m_pfnSort)(b, a) : (m_pThis->*m_pfnSort)(a, b)); }
+	bool operator()(int a, int b) const { return (g_Config.m_BrSortOrder ? (m_pThis->*m_pfnSort)(b, a) : (m_pThis->*m_pfnSort)(a, b)); }
 };
 
 bool matchesPart(const char *a, const char *b)
@@ -398,176 +398,202 @@ bool CServerBrowser::SortCompareNumPlayersAndPing(int Index1, int Index2) const
 		return pIndex1->m_Info.m_Latency > pIndex2->m_Info.m_Latency;
 }
 
-void CServerBrowser::Filter()
+void ServerBrowserFoldSearchKey(char *pBuffer, int BufferSize, const char *pStr)
 {
-	m_NumSortedServers = 0;
-	m_NumSortedPlayers = 0;
-
-	// allocate the sorted list
-	if(m_NumSortedServersCapacity < m_NumServers)
+	int Length = 0;
+	while(*pStr)
 	{
-		free(m_pSortedServerlist);
-		m_NumSortedServersCapacity = m_NumServers;
-		m_pSortedServerlist = (int *)calloc(m_NumSortedServersCapacity, sizeof(int));
+		int Code = str_utf8_decode(&pStr);
+		// invalid sequences only match each other
+		if(Code < 0)
+			Code = 0xFFFD;
+		char aEncoded[4];
+		const int Size = str_utf8_encode(aEncoded, str_utf8_tolower(Code));
+		if(Length + Size >= BufferSize)
+			break;
+		mem_copy(pBuffer + Length, aEncoded, Size);
+		Length += Size;
 	}
+	pBuffer[Length] = '\0';
+}
 
-	// filter the servers
-	for(int i = 0; i < m_NumServers; i++)
+void CServerBrowser::ParseSearchTokens(const char *pStr, std::vector<CSearchToken> &vTokens)
+{
+	vTokens.clear();
+	char aToken[sizeof(g_Config.m_BrFilterString)];
+	while((pStr = str_next_token(pStr, IServerBrowser::SEARCH_EXCLUDE_TOKEN, aToken, sizeof(aToken))))
 	{
-		CServerInfo &Info = m_ppServerlist[i]->m_Info;
-		bool Filtered = false;
+		if(aToken[0] == '\0')
+		{
+			continue;
+		}
+		CSearchToken Token;
+		Token.m_Exact = false;
+		const int TokenLen = str_length(aToken);
+		if(aToken[0] == '"' && aToken[TokenLen - 1] == '"')
+		{
+			aToken[TokenLen - 1] = '\0';
+			Token.m_Exact = true;
+		}
+		Token.m_Token = aToken;
+		char aKey[sizeof(aToken) * 3 / 2];
+		ServerBrowserFoldSearchKey(aKey, sizeof(aKey), aToken);
+		Token.m_Key = aKey;
+		vTokens.push_back(Token);
+	}
+}
 
-		if(g_Config.m_BrFilterEmpty && Info.m_NumFilteredPlayers == 0)
-			Filtered = true;
-		else if(g_Config.m_BrFilterFull && Players(Info) == Max(Info))
-			Filtered = true;
-		else if(g_Config.m_BrFilterPw && Info.m_Flags & SERVER_FLAG_PASSWORD)
-			Filtered = true;
-		else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(Info.m_aAddress, g_Config.m_BrFilterServerAddress))
-			Filtered = true;
-		else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = true;
-		else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_utf8_find_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = true;
-		else if(g_Config.m_BrFilterUnfinishedMap && Info.m_HasRank == CServerInfo::RANK_RANKED)
-			Filtered = true;
-		else
+void CServerBrowser::UpdateSearchKeys(CServerEntry *pEntry)
+{
+	ServerBrowserFoldSearchKey(pEntry->m_aNameKey, sizeof(pEntry->m_aNameKey), pEntry->m_Info.m_aName);
+	ServerBrowserFoldSearchKey(pEntry->m_aMapKey, sizeof(pEntry->m_aMapKey), pEntry->m_Info.m_aMap);
+	ServerBrowserFoldSearchKey(pEntry->m_aGameTypeKey, sizeof(pEntry->m_aGameTypeKey), pEntry->m_Info.m_aGameType);
+}
+
+static bool MatchesToken(const char *pStr, const char *pKey, const std::string &Token, const std::string &Key, bool Exact)
+{
+	if(Exact)
+		return matchesExactly(pStr, Token.c_str());
+	return str_find(pKey, Key.c_str()) != nullptr;
+}
+
+bool CServerBrowser::FilterServer(CServerEntry *pEntry) const
+{
+	CServerInfo &Info = pEntry->m_Info;
+	bool Filtered = false;
+
+	if(g_Config.m_BrFilterEmpty && Info.m_NumFilteredPlayers == 0)
+		Filtered = true;
+	else if(g_Config.m_BrFilterFull && Players(Info) == Max(Info))
+		Filtered = true;
+	else if(g_Config.m_BrFilterPw && Info.m_Flags & SERVER_FLAG_PASSWORD)
+		Filtered = true;
+	else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(Info.m_aAddress, g_Config.m_BrFilterServerAddress))
+		Filtered = true;
+	else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = true;
+	else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_utf8_find_nocase(Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = true;
+	else if(g_Config.m_BrFilterUnfinishedMap && Info.m_HasRank == CServerInfo::RANK_RANKED)
+		Filtered = true;
+	else
+	{
+		if(!Communities().empty())
 		{
-			if(!Communities().empty())
+			if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES)
 			{
-				if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES)
-				{
-					Filtered = CommunitiesFilter().Filtered(Info.m_aCommunityId);
-				}
-				if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES ||
-					(m_ServerlistType >= IServerBrowser::TYPE_FAVORITE_COMMUNITY_1 && m_ServerlistType <= IServerBrowser::TYPE_FAVORITE_COMMUNITY_3))
-				{
-					Filtered = Filtered || CountriesFilter().Filtered(Info.m_aCommunityCountry);
-					Filtered = Filtered || TypesFilter().Filtered(Info.m_aCommunityType);
-				}
+				Filtered = CommunitiesFilter().Filtered(Info.m_aCommunityId);
 			}
+			if(m_ServerlistType == IServerBrowser::TYPE_INTERNET || m_ServerlistType == IServerBrowser::TYPE_FAVORITES ||
+				(m_ServerlistType >= IServerBrowser::TYPE_FAVORITE_COMMUNITY_1 && m_ServerlistType <= IServerBrowser::TYPE_FAVORITE_COMMUNITY_3))
+			{
+				Filtered = Filtered || CountriesFilter().Filtered(Info.m_aCommunityCountry);
+				Filtered = Filtered || TypesFilter().Filtered(Info.m_aCommunityType);
+			}
+		}
 
-			if(!Filtered && g_Config.m_BrFilterCountry)
+		if(!Filtered && g_Config.m_BrFilterCountry)
+		{
+			Filtered = true;
+			// match against player country
+			for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
 			{
-				Filtered = true;
-				// match against player country
-				for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
+				if(Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
 				{
-					if(Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
-					{
-						Filtered = false;
-						break;
-					}
+					Filtered = false;
+					break;
 				}
 			}
+		}
 
-			if(!Filtered && g_Config.m_BrFilterString[0] != '\0')
-			{
-				Info.m_QuickSearchHit = 0;
+		if(!Filtered && g_Config.m_BrFilterString[0] != '\0')
+		{
+			Info.m_QuickSearchHit = 0;
 
-				const char *pStr = g_Config.m_BrFilterString;
-				char aFilterStr[sizeof(g_Config.m_BrFilterString)];
-				while((pStr = str_next_token(pStr, IServerBrowser::SEARCH_EXCLUDE_TOKEN, aFilterStr, sizeof(aFilterStr))))
+			for(const CSearchToken &Token : m_vFilterTokens)
+			{
+				// match against server name
+				if(MatchesToken(Info.m_aName, pEntry->m_aNameKey, Token.m_Token, Token.m_Key, Token.m_Exact))
 				{
-					if(aFilterStr[0] == '\0')
-					{
-						continue;
-					}
-					auto MatchesFn = matchesPart;
-					const int FilterLen = str_length(aFilterStr);
-					if(aFilterStr[0] == '"' && aFilterStr[FilterLen - 1] == '"')
-					{
-						aFilterStr[FilterLen - 1] = '\0';
-						MatchesFn = matchesExactly;
-					}
-
-					// match against server name
-					if(MatchesFn(Info.m_aName, aFilterStr))
-					{
-						Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
-					}
+					Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+				}
 
-					// match against players
-					for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
+				// match against players
+				for(int p = 0; p < minimum(Info.m_NumClients, (int)MAX_CLIENTS); p++)
+				{
+					auto MatchesFn = Token.m_Exact ? matchesExactly : matchesPart;
+					if(MatchesFn(Info.m_aClients[p].m_aName, Token.m_Token.c_str()) ||
+						MatchesFn(Info.m_aClients[p].m_aClan, Token.m_Token.c_str()))
 					{
-						if(MatchesFn(Info.m_aClients[p].m_aName, aFilterStr) ||
-							MatchesFn(Info.m_aClients[p].m_aClan, aFilterStr))
+						if(g_Config.m_BrFilterConnectingPlayers &&
+							str_comp(Info.m_aClients[p].m_aName, "(connecting)") == 0 &&
+							Info.m_aClients[p].m_aClan[0] == '\0')
 						{
-							if(g_Config.m_BrFilterConnectingPlayers &&
-								str_comp(Info.m_aClients[p].m_aName, "(connecting)") == 0 &&
-								Info.m_aClients[p].m_aClan[0] == '\0')
-							{
-								continue;
-							}
-							Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
-							break;
+							continue;
 						}
-					}
-
-					// match against map
-					if(MatchesFn(Info.m_aMap, aFilterStr))
-					{
-						Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+						Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+						break;
 					}
 				}
 
-				if(!Info.m_QuickSearchHit)
-					Filtered = true;
-			}
-
-			if(!Filtered && g_Config.m_BrExcludeString[0] != '\0')
-			{
-				const char *pStr = g_Config.m_BrExcludeString;
-				char aExcludeStr[sizeof(g_Config.m_BrExcludeString)];
-				while((pStr = str_next_token(pStr, IServerBrowser::SEARCH_EXCLUDE_TOKEN, aExcludeStr, sizeof(aExcludeStr))))
+				// match against map
+				if(MatchesToken(Info.m_aMap, pEntry->m_aMapKey, Token.m_Token, Token.m_Key, Token.m_Exact))
 				{
-					if(aExcludeStr[0] == '\0')
-					{
-						continue;
-					}
-					auto MatchesFn = matchesPart;
-					const int FilterLen = str_length(aExcludeStr);
-					if(aExcludeStr[0] == '"' && aExcludeStr[FilterLen - 1] == '"')
-					{
-						aExcludeStr[FilterLen - 1] = '\0';
-						MatchesFn = matchesExactly;
-					}
-
-					// match against server name
-					if(MatchesFn(Info.m_aName, aExcludeStr))
-					{
-						Filtered = true;
-						break;
-					}
-
-					// match against map
-					if(MatchesFn(Info.m_aMap, aExcludeStr))
-					{
-						Filtered = true;
-						break;
-					}
-
-					// match against gametype
-					if(MatchesFn(Info.m_aGameType, aExcludeStr))
-					{
-						Filtered = true;
-						break;
-					}
+					Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
 				}
 			}
+
+			if(!Info.m_QuickSearchHit)
+				Filtered = true;
 		}
 
 		if(!Filtered)
 		{
-			UpdateServerFriends(&Info);
-
-			if(!g_Config.m_BrFilterFriends || Info.m_FriendState != IFriends::FRIEND_NO)
+			for(const CSearchToken &Token : m_vExcludeTokens)
 			{
-				m_NumSortedPlayers += Info.m_NumFilteredPlayers;
-				m_pSortedServerlist[m_NumSortedServers++] = i;
+				// match against server name, map and gametype
+				if(MatchesToken(Info.m_aName, pEntry->m_aNameKey, Token.m_Token, Token.m_Key, Token.m_Exact) ||
+					MatchesToken(Info.m_aMap, pEntry->m_aMapKey, Token.m_Token, Token.m_Key, Token.m_Exact) ||
+					MatchesToken(Info.m_aGameType, pEntry->m_aGameTypeKey, Token.m_Token, Token.m_Key, Token.m_Exact))
+				{
+					Filtered = true;
+					break;
+				}
 			}
 		}
 	}
+
+	if(Filtered)
+		return false;
+
+	UpdateServerFriends(&Info);
+	return !g_Config.m_BrFilterFriends || Info.m_FriendState != IFriends::FRIEND_NO;
+}
+
+void CServerBrowser::Filter()
+{
+	m_NumSortedServers = 0;
+	m_NumSortedPlayers = 0;
+
+	// allocate the sorted list
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		free(m_pSortedServerlist);
+		m_NumSortedServersCapacity = m_NumServers;
+		m_pSortedServerlist = (int *)calloc(m_NumSortedServersCapacity, sizeof(int));
+	}
+
+	// filter the servers
+	for(int i = 0; i < m_NumServers; i++)
+	{
+		CServerEntry *pEntry = m_ppServerlist[i];
+		pEntry->m_Visible = FilterServer(pEntry);
+		if(pEntry->m_Visible)
+		{
+			m_NumSortedPlayers += pEntry->m_Info.m_NumFilteredPlayers;
+			m_pSortedServerlist[m_NumSortedServers++] = i;
+		}
+	}
 }
 
 int CServerBrowser::SortHash() const
@@ -586,6 +612,23 @@ int CServerBrowser::SortHash() const
 	return i;
 }
 
+CServerBrowser::FSortCompare CServerBrowser::CurrentSortCompare() const
+{
+	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
+		return &CServerBrowser::SortCompareNumPlayersAndPing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
+		return &CServerBrowser::SortCompareName;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
+		return &CServerBrowser::SortComparePing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
+		return &CServerBrowser::SortCompareMap;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
+		return &CServerBrowser::SortCompareNumPlayers;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
+		return &CServerBrowser::SortCompareGametype;
+	return nullptr;
+}
+
 void CServerBrowser::Sort()
 {
 	// update number of filtered players
@@ -595,25 +638,71 @@ void CServerBrowser::Sort()
 	}
 
 	// create filtered list
+	ParseSearchTokens(g_Config.m_BrFilterString, m_vFilterTokens);
+	ParseSearchTokens(g_Config.m_BrExcludeString, m_vExcludeTokens);
 	Filter();
 
 	// sort
-	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, CSortWrap(this, &CServerBrowser::SortCompareNumPlayersAndPing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, CSortWrap(this, &CServerBrowser::SortCompareName));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, CSortWrap(this, &CServerBrowser::SortComparePing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, CSortWrap(this, &CServerBrowser::SortCompareMap));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, CSortWrap(this, &CServerBrowser::SortCompareNumPlayers));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, CSortWrap(this, &CServerBrowser::SortCompareGametype));
+	const FSortCompare pfnCompare = CurrentSortCompare();
+	if(pfnCompare)
+		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, CSortWrap(this, pfnCompare));
+
+	for(int Index : m_vDirtyServers)
+		m_ppServerlist[Index]->m_Dirty = false;
+	m_vDirtyServers.clear();
 
 	m_Sorthash = SortHash();
 }
 
+void CServerBrowser::SortDirty()
+{
+	// the sorted list might not have room for servers added since the
+	// last sort
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		int *pNewList = (int *)calloc(m_NumServers, sizeof(int));
+		if(m_NumSortedServers > 0)
+			mem_copy(pNewList, m_pSortedServerlist, m_NumSortedServers * sizeof(int));
+		free(m_pSortedServerlist);
+		m_pSortedServerlist = pNewList;
+		m_NumSortedServersCapacity = m_NumServers;
+	}
+
+	// only filter the servers that changed, the filter settings are the
+	// same as for the last full sort
+	for(int Index : m_vDirtyServers)
+	{
+		CServerEntry *pEntry = m_ppServerlist[Index];
+		UpdateServerFilteredPlayers(&pEntry->m_Info);
+		pEntry->m_Visible = FilterServer(pEntry);
+	}
+
+	const FSortCompare pfnCompare = CurrentSortCompare();
+	CSortWrap Compare(this, pfnCompare);
+	m_vResortServers = m_vDirtyServers;
+	m_NumSortedServers = ServerBrowserMergeSorted(
+		m_pSortedServerlist, m_NumSortedServers, m_vResortServers,
+		[&](int Index1, int Index2) { return pfnCompare && Compare(Index1, Index2); },
+		[this](int Index) { return m_ppServerlist[Index]->m_Dirty; },
+		[this](int Index) { return m_ppServerlist[Index]->m_Visible; });
+
+	m_NumSortedPlayers = 0;
+	for(int i = 0; i < m_NumSortedServers; i++)
+		m_NumSortedPlayers += m_ppServerlist[m_pSortedServerlist[i]]->m_Info.m_NumFilteredPlayers;
+
+	for(int Index : m_vDirtyServers)
+		m_ppServerlist[Index]->m_Dirty = false;
+	m_vDirtyServers.clear();
+}
+
+void CServerBrowser::MarkDirty(CServerEntry *pEntry)
+{
+	if(pEntry->m_Dirty)
+		return;
+	pEntry->m_Dirty = true;
+	m_vDirtyServers.push_back(pEntry->m_Info.m_ServerIndex);
+}
+
 void CServerBrowser::RemoveRequest(CServerEntry *pEntry)
 {
 	if(pEntry->m_pPrevReq || pEntry->m_pNextReq || m_pFirstReqServer == pEntry)
@@ -692,6 +781,7 @@ void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info) cons
 	mem_copy(pEntry->m_Info.m_aAddresses, TmpInfo.m_aAddresses, sizeof(pEntry->m_Info.m_aAddresses));
 	pEntry->m_Info.m_NumAddresses = TmpInfo.m_NumAddresses;
 	ServerBrowserFormatAddresses(pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aAddress), pEntry->m_Info.m_aAddresses, pEntry->m_Info.m_NumAddresses);
+	UpdateSearchKeys(pEntry);
 	str_copy(pEntry->m_Info.m_aCommunityId, TmpInfo.m_aCommunityId);
 	str_copy(pEntry->m_Info.m_aCommunityCountry, TmpInfo.m_aCommunityCountry);
 	str_copy(pEntry->m_Info.m_aCommunityType, TmpInfo.m_aCommunityType);
@@ -790,6 +880,7 @@ void CServerBrowser::SetLatency(NETADDR Addr, int Latency)
 		}
 		m_ppServerlist[i]->m_Info.m_Latency = Ping;
 		m_ppServerlist[i]->m_Info.m_LatencyIsEstimated = false;
+		MarkDirty(m_ppServerlist[i]);
 	}
 }
 
@@ -808,6 +899,7 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR *pAddrs, int Num
 	ServerBrowserFormatAddresses(pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aAddress), pEntry->m_Info.m_aAddresses, pEntry->m_Info.m_NumAddresses);
 	UpdateServerCommunity(&pEntry->m_Info);
 	str_copy(pEntry->m_Info.m_aName, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aName));
+	UpdateSearchKeys(pEntry);
 
 	// check if it's a favorite
 	pEntry->m_Info.m_Favorite = m_pFavorites->IsFavorite(pEntry->m_Info.m_aAddresses, pEntry->m_Info.m_NumAddresses);
@@ -833,6 +925,7 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR *pAddrs, int Num
 	m_ppServerlist[m_NumServers] = pEntry;
 	pEntry->m_Info.m_ServerIndex = m_NumServers;
 	m_NumServers++;
+	MarkDirty(pEntry);
 
 	return pEntry;
 }
@@ -909,7 +1002,7 @@ void CServerBrowser::OnServerInfoUpdate(const NETADDR &Addr, int Token, const CS
 		pEntry->m_RequestTime = -1; // Request has been answered
 	}
 	RemoveRequest(pEntry);
-	RequestResort();
+	MarkDirty(pEntry);
 }
 
 void CServerBrowser::Refresh(int Type, bool Force)
@@ -1160,6 +1253,7 @@ void CServerBrowser::CleanUp()
 	m_NumServers = 0;
 	m_NumSortedServers = 0;
 	m_NumSortedPlayers = 0;
+	m_vDirtyServers.clear();
 	m_ByAddr.clear();
 	m_pFirstReqServer = nullptr;
 	m_pLastReqServer = nullptr;
@@ -1257,6 +1351,10 @@ void CServerBrowser::Update()
 		Sort();
 		m_NeedResort = false;
 	}
+	else if(!m_vDirtyServers.empty())
+	{
+		SortDirty();
+	}
 }
 
 const json_value *CServerBrowser::LoadDDNetInfo()
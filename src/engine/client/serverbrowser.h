@@ -10,9 +10,12 @@
 #include <engine/serverbrowser.h>
 #include <engine/shared/memheap.h>
 
+#include <algorithm>
 #include <functional>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 typedef struct _json_value json_value;
 class CNetClient;
@@ -216,6 +219,16 @@ public:
 
 		CServerEntry *m_pPrevReq; // request list
 		CServerEntry *m_pNextReq;
+
+		// changed since the last sort, see MarkDirty
+		bool m_Dirty;
+		// passed the filters at the last sort
+		bool m_Visible;
+
+		// case folded copies of the strings searched by the filters
+		char m_aNameKey[sizeof(CServerInfo::m_aName) * 3 / 2];
+		char m_aMapKey[sizeof(CServerInfo::m_aMap) * 3 / 2];
+		char m_aGameTypeKey[sizeof(CServerInfo::m_aGameType) * 3 / 2];
 	};
 
 	CServerBrowser();
@@ -321,6 +334,21 @@ private:
 
 	bool m_NeedResort;
 	int m_Sorthash;
+	// indices of the servers with m_Dirty set
+	std::vector<int> m_vDirtyServers;
+	std::vector<int> m_vResortServers;
+
+	// parsed br_filter_string and br_exclude_string
+	struct CSearchToken
+	{
+		// the token as passed to matchesPart or matchesExactly
+		std::string m_Token;
+		// case folded token for partial matches
+		std::string m_Key;
+		bool m_Exact;
+	};
+	std::vector<CSearchToken> m_vFilterTokens;
+	std::vector<CSearchToken> m_vExcludeTokens;
 
 	// used instead of g_Config.br_max_requests to get more servers
 	int m_CurrentMaxRequests;
@@ -348,9 +376,17 @@ private:
 	bool SortCompareNumClients(int Index1, int Index2) const;
 	bool SortCompareNumPlayersAndPing(int Index1, int Index2) const;
 
+	typedef bool (CServerBrowser::*FSortCompare)(int Index1, int Index2) const;
+	FSortCompare CurrentSortCompare() const;
+
 	//
+	static void ParseSearchTokens(const char *pStr, std::vector<CSearchToken> &vTokens);
+	static void UpdateSearchKeys(CServerEntry *pEntry);
+	bool FilterServer(CServerEntry *pEntry) const;
 	void Filter();
 	void Sort();
+	void SortDirty();
+	void MarkDirty(CServerEntry *pEntry);
 	int SortHash() const;
 
 	void CleanUp();
@@ -385,4 +421,47 @@ private:
 	static bool ParseCommunityServers(CCommunity *pCommunity, const json_value &Servers);
 };
 
+// Lowercases every code point the same way str_utf8_find_nocase compares
+// them, so a case insensitive search turns into str_find on folded strings.
+void ServerBrowserFoldSearchKey(char *pBuffer, int BufferSize, const char *pStr);
+
+// Brings the list of indices `pSorted` back into the order of
+// std::stable_sort over ascending indices after the entries for which
+// `IsChanged` returns true changed. The changed entries are passed in
+// `vChanged` and only kept if `IsVisible` returns true for them. The
+// buffer must be large enough for all the entries. Returns the new size.
+template<typename TLess, typename TIsChanged, typename TIsVisible>
+int ServerBrowserMergeSorted(int *pSorted, int NumSorted, std::vector<int> &vChanged, TLess &&Less, TIsChanged &&IsChanged, TIsVisible &&IsVisible)
+{
+	int NumKept = 0;
+	for(int i = 0; i < NumSorted; i++)
+	{
+		if(!IsChanged(pSorted[i]))
+			pSorted[NumKept++] = pSorted[i];
+	}
+
+	vChanged.erase(std::remove_if(vChanged.begin(), vChanged.end(), [&](int Index) { return !IsVisible(Index); }), vChanged.end());
+	auto &&LessOrIndex = [&](int Index1, int Index2) {
+		if(Less(Index1, Index2))
+			return true;
+		if(Less(Index2, Index1))
+			return false;
+		return Index1 < Index2;
+	};
+	std::sort(vChanged.begin(), vChanged.end(), LessOrIndex);
+
+	// merge from the back so it works in place
+	int Out = NumKept + (int)vChanged.size() - 1;
+	int Kept = NumKept - 1;
+	int Changed = (int)vChanged.size() - 1;
+	while(Changed >= 0)
+	{
+		if(Kept >= 0 && LessOrIndex(vChanged[Changed], pSorted[Kept]))
+			pSorted[Out--] = pSorted[Kept--];
+		else
+			pSorted[Out--] = vChanged[Changed--];
+	}
+	return NumKept + (int)vChanged.size();
+}
+
 #endif
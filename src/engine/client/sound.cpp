@@ -10,6 +10,7 @@
 #include <engine/storage.h>
 
 #include "sound.h"
+#include "sound_mixer.h"
 
 #if defined(CONF_VIDEORECORDER)
 #include <engine/shared/video.h>
@@ -29,22 +30,20 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 	Frames = minimum(Frames, m_MaxFrames);
 	mem_zero(m_pMixBuffer, Frames * 2 * sizeof(int));
 
-	// acquire lock while we are mixing
-	m_SoundLock.lock();
+	const CLockScope MixLockScope(m_MixLock);
+	int NumJobs = 0;
 
-	const int MasterVol = m_SoundVolume.load(std::memory_order_relaxed);
+	// only hold the sound lock while collecting the voices and advancing
+	// them, so the game thread is not blocked while the frames are mixed
+	m_SoundLock.lock();
 
 	for(auto &Voice : m_aVoices)
 	{
 		if(!Voice.m_pSample)
 			continue;
 
-		// mix voice
-		int *pOut = m_pMixBuffer;
-
-		const int Step = Voice.m_pSample->m_Channels; // setup input sources
-		short *pInL = &Voice.m_pSample->m_pData[Voice.m_Tick * Step];
-		short *pInR = &Voice.m_pSample->m_pData[Voice.m_Tick * Step + 1];
+		const int Step = Voice.m_pSample->m_Channels;
+		const short *pIn = &Voice.m_pSample->m_pData[Voice.m_Tick * Step];
 
 		unsigned End = Voice.m_pSample->m_NumFrames - Voice.m_Tick;
 
@@ -55,10 +54,6 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 		if(Frames < End)
 			End = Frames;
 
-		// check if we have a mono sound
-		if(Voice.m_pSample->m_Channels == 1)
-			pInR = pInL;
-
 		// volume calculation
 		if(Voice.m_Flags & ISound::FLAG_POS && Voice.m_pChannel->m_Pan)
 		{
@@ -149,15 +144,17 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 			}
 		}
 
-		// process all frames
-		for(unsigned s = 0; s < End; s++)
+		// voices out of hearing range still advance but are not mixed
+		if(End > 0 && (VolumeL != 0 || VolumeR != 0))
 		{
-			*pOut++ += (*pInL) * VolumeL;
-			*pOut++ += (*pInR) * VolumeR;
-			pInL += Step;
-			pInR += Step;
-			Voice.m_Tick++;
+			CMixJob &Job = m_aMixJobs[NumJobs++];
+			Job.m_pData = pIn;
+			Job.m_Channels = Step;
+			Job.m_NumFrames = End;
+			Job.m_VolumeL = VolumeL;
+			Job.m_VolumeR = VolumeR;
 		}
+		Voice.m_Tick += End;
 
 		// free voice if not used any more
 		if(Voice.m_Tick == Voice.m_pSample->m_NumFrames)
@@ -174,9 +171,14 @@ void CSound::Mix(short *pFinalOut, unsigned Frames)
 
 	m_SoundLock.unlock();
 
+	for(int i = 0; i < NumJobs; i++)
+	{
+		const CMixJob &Job = m_aMixJobs[i];
+		SoundMixAccumulate(m_pMixBuffer, Job.m_pData, Job.m_Channels, Job.m_NumFrames, Job.m_VolumeL, Job.m_VolumeR);
+	}
+
 	// clamp accumulated values
-	for(unsigned i = 0; i < Frames * 2; i++)
-		pFinalOut[i] = clamp<int>(((m_pMixBuffer[i] * MasterVol) / 101) >> 8, std::numeric_limits<short>::min(), std::numeric_limits<short>::max());
+	SoundMixConvert(pFinalOut, m_pMixBuffer, Frames * 2, m_SoundVolume.load(std::memory_order_relaxed));
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(pFinalOut, sizeof(short), Frames * 2);
@@ -647,6 +649,11 @@ void CSound::UnloadSample(int SampleID)
 
 	Stop(SampleID);
 
+	// wait for a mix that might still read the sample data
+	{
+		const CLockScope MixLockScope(m_MixLock);
+	}
+
 	// Free data
 	CSample &Sample = m_aSamples[SampleID];
 	free(Sample.m_pData);
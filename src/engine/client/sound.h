@@ -64,8 +64,22 @@ class CSound : public IEngineSound
 		NUM_CHANNELS = 16,
 	};
 
+	// frames of one voice to add to the mix buffer, collected under
+	// m_SoundLock and mixed after releasing it
+	struct CMixJob
+	{
+		const short *m_pData;
+		int m_Channels;
+		unsigned m_NumFrames;
+		int m_VolumeL;
+		int m_VolumeR;
+	};
+
 	bool m_SoundEnabled = false;
 	SDL_AudioDeviceID m_Device = 0;
+	// held by the audio thread for the whole mix, so sample data is not
+	// freed while it is still being read
+	CLock m_MixLock ACQUIRED_BEFORE(m_SoundLock);
 	CLock m_SoundLock;
 
 	CSample m_aSamples[NUM_SAMPLES] = {{0}};
@@ -85,6 +99,7 @@ class CSound : public IEngineSound
 	IStorage *m_pStorage = nullptr;
 
 	int *m_pMixBuffer = nullptr;
+	CMixJob m_aMixJobs[NUM_VOICES] GUARDED_BY(m_MixLock);
 
 	CSample *AllocSample();
 	void RateConvert(CSample &Sample) const;
@@ -97,7 +112,7 @@ class CSound : public IEngineSound
 public:
 	int Init() override;
 	int Update() override;
-	void Shutdown() override REQUIRES(!m_SoundLock);
+	void Shutdown() override REQUIRES(!m_SoundLock, !m_MixLock);
 
 	bool IsSoundEnabled() override { return m_SoundEnabled; }
 
@@ -105,7 +120,7 @@ public:
 	int LoadWV(const char *pFilename, int StorageType = IStorage::TYPE_ALL) override REQUIRES(!m_SoundLock);
 	int LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEditor) override REQUIRES(!m_SoundLock);
 	int LoadWVFromMem(const void *pData, unsigned DataSize, bool FromEditor) override REQUIRES(!m_SoundLock);
-	void UnloadSample(int SampleID) override REQUIRES(!m_SoundLock);
+	void UnloadSample(int SampleID) override REQUIRES(!m_SoundLock, !m_MixLock);
 
 	float GetSampleTotalTime(int SampleID) override; // in s
 	float GetSampleCurrentTime(int SampleID) override REQUIRES(!m_SoundLock); // in s
@@ -131,7 +146,7 @@ public:
 	void StopVoice(CVoiceHandle Voice) override REQUIRES(!m_SoundLock);
 	bool IsPlaying(int SampleID) override REQUIRES(!m_SoundLock);
 
-	void Mix(short *pFinalOut, unsigned Frames) override REQUIRES(!m_SoundLock);
+	void Mix(short *pFinalOut, unsigned Frames) override REQUIRES(!m_SoundLock, !m_MixLock);
 	void PauseAudioDevice() override;
 	void UnpauseAudioDevice() override;
 };
@@ -0,0 +1,75 @@
+#include "sound_mixer.h"
+
+#include <base/math.h>
+
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE2__)
+// Multiplies the 8 interleaved 16 bit values `Frames` by the 16 bit volumes
+// in `Volumes` and adds the full 32 bit products to `pOut[0]` to `pOut[7]`.
+static inline void AccumulateSse2(int *pOut, __m128i Frames, __m128i Volumes)
+{
+	const __m128i Low = _mm_mullo_epi16(Frames, Volumes);
+	const __m128i High = _mm_mulhi_epi16(Frames, Volumes);
+	__m128i *pOut0 = reinterpret_cast<__m128i *>(pOut);
+	__m128i *pOut1 = reinterpret_cast<__m128i *>(pOut + 4);
+	_mm_storeu_si128(pOut0, _mm_add_epi32(_mm_loadu_si128(pOut0), _mm_unpacklo_epi16(Low, High)));
+	_mm_storeu_si128(pOut1, _mm_add_epi32(_mm_loadu_si128(pOut1), _mm_unpackhi_epi16(Low, High)));
+}
+#endif
+
+void SoundMixAccumulate(int *pOut, const short *pIn, int Channels, unsigned NumFrames, int VolumeL, int VolumeR)
+{
+	unsigned Frame = 0;
+#if defined(__SSE2__)
+	// the products are exact as long as the volumes fit into 16 bit, which
+	// they always do for channel and voice volumes up to 255
+	if(VolumeL >= std::numeric_limits<short>::min() && VolumeL <= std::numeric_limits<short>::max() &&
+		VolumeR >= std::numeric_limits<short>::min() && VolumeR <= std::numeric_limits<short>::max())
+	{
+		const __m128i Volumes = _mm_set_epi16(VolumeR, VolumeL, VolumeR, VolumeL, VolumeR, VolumeL, VolumeR, VolumeL);
+		if(Channels == 1)
+		{
+			for(; Frame + 8 <= NumFrames; Frame += 8)
+			{
+				const __m128i In = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + Frame));
+				AccumulateSse2(pOut + Frame * 2, _mm_unpacklo_epi16(In, In), Volumes);
+				AccumulateSse2(pOut + Frame * 2 + 8, _mm_unpackhi_epi16(In, In), Volumes);
+			}
+		}
+		else if(Channels == 2)
+		{
+			for(; Frame + 4 <= NumFrames; Frame += 4)
+				AccumulateSse2(pOut + Frame * 2, _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + Frame * 2)), Volumes);
+		}
+	}
+#endif
+
+	// remaining frames, or all of them without SSE2
+	if(Channels == 1)
+	{
+		for(; Frame < NumFrames; Frame++)
+		{
+			pOut[Frame * 2] += pIn[Frame] * VolumeL;
+			pOut[Frame * 2 + 1] += pIn[Frame] * VolumeR;
+		}
+	}
+	else
+	{
+		for(; Frame < NumFrames; Frame++)
+		{
+			pOut[Frame * 2] += pIn[Frame * Channels] * VolumeL;
+			pOut[Frame * 2 + 1] += pIn[Frame * Channels + 1] * VolumeR;
+		}
+	}
+}
+
+void SoundMixConvert(short *pOut, const int *pIn, unsigned NumSamples, int MasterVol)
+{
+	for(unsigned i = 0; i < NumSamples; i++)
+		pOut[i] = clamp<int>(((pIn[i] * MasterVol) / 101) >> 8, std::numeric_limits<short>::min(), std::numeric_limits<short>::max());
+}
@@ -0,0 +1,18 @@
+#ifndef ENGINE_CLIENT_SOUND_MIXER_H
+#define ENGINE_CLIENT_SOUND_MIXER_H
+
+// Inner loops of the sound mixer, kept free of SDL so they can be tested
+// and benchmarked without an audio device. The mix buffer holds
+// interleaved stereo frames of 32 bit accumulators.
+
+// Adds `NumFrames` frames of the 16 bit sample data `pIn` (mono or
+// interleaved stereo, depending on `Channels`) scaled by the given volumes
+// to `pOut`. The result is the same as for the scalar loop
+// `pOut[2 * i] += pInL[i] * VolumeL; pOut[2 * i + 1] += pInR[i] * VolumeR;`.
+void SoundMixAccumulate(int *pOut, const short *pIn, int Channels, unsigned NumFrames, int VolumeL, int VolumeR);
+
+// Applies the master volume (0 - 100) to `NumSamples` accumulated values
+// and converts them to 16 bit, saturating at the limits.
+void SoundMixConvert(short *pOut, const int *pIn, unsigned NumSamples, int MasterVol);
+
+#endif
@@ -0,0 +1,978 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include "text_layout.h"
+
+#include <base/log.h>
+#include <base/math.h>
+
+FT_Face CGlyphMap::GetFaceByName(const char *pFamilyName)
+{
+	if(pFamilyName == nullptr || pFamilyName[0] == '\0')
+		return nullptr;
+
+	FT_Face FamilyNameMatch = nullptr;
+	char aFamilyStyleName[FONT_NAME_SIZE];
+
+	for(const auto &CurrentFace : m_vFtFaces)
+	{
+		// Best match: font face with matching family and style name
+		str_format(aFamilyStyleName, sizeof(aFamilyStyleName), "%s %s", CurrentFace->family_name, CurrentFace->style_name);
+		if(str_comp(pFamilyName, aFamilyStyleName) == 0)
+		{
+			return CurrentFace;
+		}
+
+		// Second best match: font face with matching family
+		if(!FamilyNameMatch && str_comp(pFamilyName, CurrentFace->family_name) == 0)
+		{
+			FamilyNameMatch = CurrentFace;
+		}
+	}
+
+	return FamilyNameMatch;
+}
+
+void CGlyphMap::OnFacesChanged()
+{
+	m_CharGlyphs.clear();
+	++m_Generation;
+}
+
+bool CGlyphMap::IncreaseGlyphMapSize()
+{
+	if(m_TextureDimension >= MAXIMUM_ATLAS_DIMENSION)
+		return false;
+
+	const size_t NewTextureDimension = m_TextureDimension * 2;
+	log_debug("textrender", "Increasing atlas dimension to %" PRIzu " (%" PRIzu " MB used for textures)", NewTextureDimension, (NewTextureDimension / 1024) * (NewTextureDimension / 1024) * NUM_FONT_TEXTURES);
+	UnloadTextures();
+
+	for(auto &pTextureData : m_apTextureData)
+	{
+		uint8_t *pTmpTexBuffer = new uint8_t[NewTextureDimension * NewTextureDimension];
+		mem_zero(pTmpTexBuffer, NewTextureDimension * NewTextureDimension * sizeof(uint8_t));
+		for(size_t y = 0; y < m_TextureDimension; ++y)
+		{
+			mem_copy(&pTmpTexBuffer[y * NewTextureDimension], &pTextureData[y * m_TextureDimension], m_TextureDimension);
+		}
+		delete[] pTextureData;
+		pTextureData = pTmpTexBuffer;
+	}
+
+	m_TextureAtlas.IncreaseDimension(NewTextureDimension);
+
+	m_TextureDimension = NewTextureDimension;
+
+	UploadTextures();
+	return true;
+}
+
+void CGlyphMap::UploadTextures()
+{
+	if(m_pGraphics == nullptr)
+		return;
+	const size_t NewTextureSize = m_TextureDimension * m_TextureDimension;
+	void *pTmpTextFillData = malloc(NewTextureSize);
+	void *pTmpTextOutlineData = malloc(NewTextureSize);
+	mem_copy(pTmpTextFillData, m_apTextureData[FONT_TEXTURE_FILL], NewTextureSize);
+	mem_copy(pTmpTextOutlineData, m_apTextureData[FONT_TEXTURE_OUTLINE], NewTextureSize);
+	Graphics()->LoadTextTextures(m_TextureDimension, m_TextureDimension, m_aTextures[FONT_TEXTURE_FILL], m_aTextures[FONT_TEXTURE_OUTLINE], pTmpTextFillData, pTmpTextOutlineData);
+}
+
+void CGlyphMap::UnloadTextures()
+{
+	if(m_pGraphics == nullptr)
+		return;
+	Graphics()->UnloadTextTextures(m_aTextures[FONT_TEXTURE_FILL], m_aTextures[FONT_TEXTURE_OUTLINE]);
+}
+
+FT_UInt CGlyphMap::GetCharGlyph(int Chr, FT_Face *pFace, bool AllowReplacementCharacter)
+{
+	// probing all the fallback faces is slow for characters that are not in the default face
+	const auto Key = std::make_tuple(m_SelectedFace, Chr, (int)AllowReplacementCharacter);
+	const auto Cached = m_CharGlyphs.find(Key);
+	if(Cached != m_CharGlyphs.end())
+	{
+		*pFace = Cached->second.first;
+		return Cached->second.second;
+	}
+	const FT_UInt GlyphIndex = FindCharGlyph(Chr, pFace, AllowReplacementCharacter);
+	m_CharGlyphs[Key] = std::make_pair(*pFace, GlyphIndex);
+	return GlyphIndex;
+}
+
+FT_UInt CGlyphMap::FindCharGlyph(int Chr, FT_Face *pFace, bool AllowReplacementCharacter)
+{
+	for(FT_Face Face : {m_SelectedFace, m_DefaultFace, m_VariantFace})
+	{
+		if(Face && Face->charmap)
+		{
+			FT_UInt GlyphIndex = FT_Get_Char_Index(Face, (FT_ULong)Chr);
+			if(GlyphIndex)
+			{
+				*pFace = Face;
+				return GlyphIndex;
+			}
+		}
+	}
+
+	for(const auto &FallbackFace : m_vFallbackFaces)
+	{
+		if(FallbackFace->charmap)
+		{
+			FT_UInt GlyphIndex = FT_Get_Char_Index(FallbackFace, (FT_ULong)Chr);
+			if(GlyphIndex)
+			{
+				*pFace = FallbackFace;
+				return GlyphIndex;
+			}
+		}
+	}
+
+	if(!m_DefaultFace || !m_DefaultFace->charmap || !AllowReplacementCharacter)
+	{
+		*pFace = nullptr;
+		return 0;
+	}
+
+	FT_UInt GlyphIndex = FT_Get_Char_Index(m_DefaultFace, (FT_ULong)REPLACEMENT_CHARACTER);
+	*pFace = m_DefaultFace;
+
+	if(GlyphIndex == 0)
+	{
+		log_debug("textrender", "Default font has no glyph for either %d or replacement char %d.", Chr, REPLACEMENT_CHARACTER);
+	}
+
+	return GlyphIndex;
+}
+
+void CGlyphMap::Grow(const unsigned char *pIn, unsigned char *pOut, int w, int h, int OutlineCount) const
+{
+	for(int y = 0; y < h; y++)
+	{
+		for(int x = 0; x < w; x++)
+		{
+			int c = pIn[y * w + x];
+
+			for(int sy = -OutlineCount; sy <= OutlineCount; sy++)
+			{
+				for(int sx = -OutlineCount; sx <= OutlineCount; sx++)
+				{
+					int GetX = x + sx;
+					int GetY = y + sy;
+					if(GetX >= 0 && GetY >= 0 && GetX < w && GetY < h)
+					{
+						int Index = GetY * w + GetX;
+						float Mask = 1.f - clamp(length(vec2(sx, sy)) - OutlineCount, 0.f, 1.f);
+						c = maximum(c, int(pIn[Index] * Mask));
+					}
+				}
+			}
+
+			pOut[y * w + x] = c;
+		}
+	}
+}
+
+int CGlyphMap::AdjustOutlineThicknessToFontSize(int OutlineThickness, int FontSize) const
+{
+	if(FontSize > 48)
+		OutlineThickness *= 4;
+	else if(FontSize >= 18)
+		OutlineThickness *= 2;
+	return OutlineThickness;
+}
+
+void CGlyphMap::UploadGlyph(int TextureIndex, int PosX, int PosY, size_t Width, size_t Height, const unsigned char *pData)
+{
+	for(size_t y = 0; y < Height; ++y)
+	{
+		mem_copy(&m_apTextureData[TextureIndex][PosX + ((y + PosY) * m_TextureDimension)], &pData[y * Width], Width);
+	}
+	if(m_pGraphics != nullptr)
+		Graphics()->UpdateTextTexture(m_aTextures[TextureIndex], PosX, PosY, Width, Height, pData);
+}
+
+bool CGlyphMap::FitGlyph(size_t Width, size_t Height, int &PosX, int &PosY)
+{
+	return m_TextureAtlas.Add(Width, Height, PosX, PosY);
+}
+
+bool CGlyphMap::RenderGlyph(SGlyph &Glyph)
+{
+	FT_Set_Pixel_Sizes(Glyph.m_Face, 0, Glyph.m_FontSize);
+
+	if(FT_Load_Glyph(Glyph.m_Face, Glyph.m_GlyphIndex, FT_LOAD_RENDER | FT_LOAD_NO_BITMAP))
+	{
+		log_debug("textrender", "Error loading glyph. Chr=%d GlyphIndex=%u", Glyph.m_Chr, Glyph.m_GlyphIndex);
+		return false;
+	}
+
+	const FT_Bitmap *pBitmap = &Glyph.m_Face->glyph->bitmap;
+
+	const unsigned RealWidth = pBitmap->width;
+	const unsigned RealHeight = pBitmap->rows;
+
+	// adjust spacing
+	int OutlineThickness = 0;
+	int x = 0;
+	int y = 0;
+	if(RealWidth > 0)
+	{
+		OutlineThickness = AdjustOutlineThicknessToFontSize(1, Glyph.m_FontSize);
+		x += (OutlineThickness + 1);
+		y += (OutlineThickness + 1);
+	}
+
+	const unsigned Width = RealWidth + x * 2;
+	const unsigned Height = RealHeight + y * 2;
+
+	int X = 0;
+	int Y = 0;
+
+	if(Width > 0 && Height > 0)
+	{
+		// find space in atlas, or increase size if necessary
+		while(!FitGlyph(Width, Height, X, Y))
+		{
+			if(!IncreaseGlyphMapSize())
+			{
+				log_debug("textrender", "Cannot fit glyph into atlas, which is already at maximum size. Chr=%d GlyphIndex=%u", Glyph.m_Chr, Glyph.m_GlyphIndex);
+				return false;
+			}
+		}
+
+		// prepare glyph data
+		mem_zero(m_aaGlyphData[FONT_TEXTURE_FILL], (size_t)Width * Height * sizeof(uint8_t));
+		for(unsigned py = 0; py < pBitmap->rows; ++py)
+		{
+			mem_copy(&m_aaGlyphData[FONT_TEXTURE_FILL][(py + y) * Width + x], &pBitmap->buffer[py * pBitmap->width], pBitmap->width);
+		}
+
+		// upload the glyph
+		UploadGlyph(FONT_TEXTURE_FILL, X, Y, Width, Height, m_aaGlyphData[FONT_TEXTURE_FILL]);
+		Grow(m_aaGlyphData[FONT_TEXTURE_FILL], m_aaGlyphData[FONT_TEXTURE_OUTLINE], Width, Height, OutlineThickness);
+		UploadGlyph(FONT_TEXTURE_OUTLINE, X, Y, Width, Height, m_aaGlyphData[FONT_TEXTURE_OUTLINE]);
+	}
+
+	// set glyph info
+	{
+		const int BmpWidth = pBitmap->width + x * 2;
+		const int BmpHeight = pBitmap->rows + y * 2;
+
+		Glyph.m_Height = Height;
+		Glyph.m_Width = Width;
+		Glyph.m_CharHeight = RealHeight;
+		Glyph.m_CharWidth = RealWidth;
+		Glyph.m_OffsetX = (Glyph.m_Face->glyph->metrics.horiBearingX >> 6);
+		Glyph.m_OffsetY = -((Glyph.m_Face->glyph->metrics.height >> 6) - (Glyph.m_Face->glyph->metrics.horiBearingY >> 6));
+		Glyph.m_AdvanceX = (Glyph.m_Face->glyph->advance.x >> 6);
+
+		Glyph.m_aUVs[0] = X;
+		Glyph.m_aUVs[1] = Y;
+		Glyph.m_aUVs[2] = Glyph.m_aUVs[0] + BmpWidth;
+		Glyph.m_aUVs[3] = Glyph.m_aUVs[1] + BmpHeight;
+
+		Glyph.m_State = SGlyph::EState::RENDERED;
+	}
+	return true;
+}
+
+CGlyphMap::CGlyphMap(IGraphics *pGraphics)
+{
+	m_pGraphics = pGraphics;
+	for(auto &pTextureData : m_apTextureData)
+	{
+		pTextureData = new uint8_t[m_TextureDimension * m_TextureDimension];
+		mem_zero(pTextureData, m_TextureDimension * m_TextureDimension * sizeof(uint8_t));
+	}
+
+	m_TextureAtlas.Clear(m_TextureDimension);
+	UploadTextures();
+}
+
+CGlyphMap::~CGlyphMap()
+{
+	UnloadTextures();
+	for(auto &pTextureData : m_apTextureData)
+	{
+		delete[] pTextureData;
+	}
+}
+
+void CGlyphMap::AddFace(FT_Face Face)
+{
+	m_vFtFaces.push_back(Face);
+	if(!m_DefaultFace)
+	{
+		m_DefaultFace = Face;
+		OnFacesChanged();
+	}
+}
+
+void CGlyphMap::SetDefaultFaceByName(const char *pFamilyName)
+{
+	m_DefaultFace = GetFaceByName(pFamilyName);
+	OnFacesChanged();
+}
+
+void CGlyphMap::SetIconFaceByName(const char *pFamilyName)
+{
+	m_IconFace = GetFaceByName(pFamilyName);
+	OnFacesChanged();
+}
+
+void CGlyphMap::AddFallbackFaceByName(const char *pFamilyName)
+{
+	FT_Face Face = GetFaceByName(pFamilyName);
+	if(Face != nullptr && std::find(m_vFallbackFaces.begin(), m_vFallbackFaces.end(), Face) == m_vFallbackFaces.end())
+	{
+		m_vFallbackFaces.push_back(Face);
+		OnFacesChanged();
+	}
+}
+
+void CGlyphMap::SetVariantFaceByName(const char *pFamilyName)
+{
+	FT_Face Face = GetFaceByName(pFamilyName);
+	if(m_VariantFace != Face)
+	{
+		m_VariantFace = Face;
+		OnFacesChanged();
+		Clear(); // rebuild atlas after changing variant font
+	}
+}
+
+void CGlyphMap::SetFontPreset(EFontPreset FontPreset)
+{
+	switch(FontPreset)
+	{
+	case EFontPreset::DEFAULT_FONT:
+		m_SelectedFace = nullptr;
+		break;
+	case EFontPreset::ICON_FONT:
+		m_SelectedFace = m_IconFace;
+		break;
+	}
+}
+
+void CGlyphMap::Clear()
+{
+	for(size_t TextureIndex = 0; TextureIndex < NUM_FONT_TEXTURES; ++TextureIndex)
+	{
+		mem_zero(m_apTextureData[TextureIndex], m_TextureDimension * m_TextureDimension * sizeof(uint8_t));
+		if(m_pGraphics != nullptr)
+			Graphics()->UpdateTextTexture(m_aTextures[TextureIndex], 0, 0, m_TextureDimension, m_TextureDimension, m_apTextureData[TextureIndex]);
+	}
+
+	m_TextureAtlas.Clear(m_TextureDimension);
+	m_Glyphs.clear();
+	++m_Generation;
+}
+
+const SGlyph *CGlyphMap::GetGlyph(int Chr, int FontSize)
+{
+	FontSize = clamp(FontSize, MIN_FONT_SIZE, MAX_FONT_SIZE);
+
+	// Find glyph index and most appropriate font face.
+	FT_Face Face;
+	FT_UInt GlyphIndex = GetCharGlyph(Chr, &Face, false);
+	if(GlyphIndex == 0)
+	{
+		// Use replacement character if glyph could not be found,
+		// also retrieve replacement character from the atlas.
+		return Chr == REPLACEMENT_CHARACTER ? nullptr : GetGlyph(REPLACEMENT_CHARACTER, FontSize);
+	}
+
+	// Check if glyph for this (font face, character, font size)-combination was already rendered.
+	SGlyph &Glyph = m_Glyphs[std::make_tuple(Face, Chr, FontSize)];
+	if(Glyph.m_State == SGlyph::EState::RENDERED)
+		return &Glyph;
+	else if(Glyph.m_State == SGlyph::EState::ERROR)
+		return nullptr;
+
+	// Else, render it.
+	Glyph.m_FontSize = FontSize;
+	Glyph.m_Face = Face;
+	Glyph.m_Chr = Chr;
+	Glyph.m_GlyphIndex = GlyphIndex;
+	if(RenderGlyph(Glyph))
+		return &Glyph;
+
+	// Use replacement character if the glyph could not be rendered,
+	// also retrieve replacement character from the atlas.
+	const SGlyph *pReplacementCharacter = Chr == REPLACEMENT_CHARACTER ? nullptr : GetGlyph(REPLACEMENT_CHARACTER, FontSize);
+	if(pReplacementCharacter)
+	{
+		Glyph = *pReplacementCharacter;
+		return &Glyph;
+	}
+
+	// Keep failed glyph in the cache so we don't attempt to render it again,
+	// but set its state to ERROR so we don't return it to the text render.
+	Glyph.m_State = SGlyph::EState::ERROR;
+	return nullptr;
+}
+
+vec2 CGlyphMap::Kerning(const SGlyph *pLeft, const SGlyph *pRight) const
+{
+	if(pLeft != nullptr && pRight != nullptr && pLeft->m_Face == pRight->m_Face && pLeft->m_FontSize == pRight->m_FontSize)
+	{
+		FT_Vector Kerning = {0, 0};
+		FT_Set_Pixel_Sizes(pLeft->m_Face, 0, pLeft->m_FontSize);
+		FT_Get_Kerning(pLeft->m_Face, pLeft->m_Chr, pRight->m_Chr, FT_KERNING_DEFAULT, &Kerning);
+		return vec2(Kerning.x >> 6, Kerning.y >> 6);
+	}
+	return vec2(0.0f, 0.0f);
+}
+
+void CGlyphMap::UploadEntityLayerText(void *pTexBuff, size_t PixelSize, size_t TexWidth, size_t TexHeight, int TexSubWidth, int TexSubHeight, const char *pText, int Length, float x, float y, int FontSize)
+{
+	if(FontSize < 1)
+		return;
+
+	const char *pCurrent = pText;
+	const char *pEnd = pCurrent + Length;
+	int WidthLastChars = 0;
+
+	while(pCurrent < pEnd)
+	{
+		const char *pTmp = pCurrent;
+		const int NextCharacter = str_utf8_decode(&pTmp);
+
+		if(NextCharacter)
+		{
+			FT_Face Face;
+			FT_UInt GlyphIndex = GetCharGlyph(NextCharacter, &Face, true);
+			if(GlyphIndex == 0)
+			{
+				pCurrent = pTmp;
+				continue;
+			}
+
+			FT_Set_Pixel_Sizes(Face, 0, FontSize);
+			if(FT_Load_Char(Face, NextCharacter, FT_LOAD_RENDER | FT_LOAD_NO_BITMAP))
+			{
+				log_debug("textrender", "Error loading glyph. Chr=%d GlyphIndex=%u", NextCharacter, GlyphIndex);
+				pCurrent = pTmp;
+				continue;
+			}
+
+			const FT_Bitmap *pBitmap = &Face->glyph->bitmap;
+
+			// prepare glyph data
+			const size_t GlyphDataSize = (size_t)pBitmap->width * pBitmap->rows * sizeof(uint8_t);
+			if(pBitmap->pixel_mode == FT_PIXEL_MODE_GRAY)
+				mem_copy(m_aaGlyphData[FONT_TEXTURE_FILL], pBitmap->buffer, GlyphDataSize);
+			else
+				mem_zero(m_aaGlyphData[FONT_TEXTURE_FILL], GlyphDataSize);
+
+			uint8_t *pImageBuff = (uint8_t *)pTexBuff;
+			for(unsigned OffY = 0; OffY < pBitmap->rows; ++OffY)
+			{
+				for(unsigned OffX = 0; OffX < pBitmap->width; ++OffX)
+				{
+					const int ImgOffX = clamp(x + OffX + WidthLastChars, x, (x + TexSubWidth) - 1);
+					const int ImgOffY = clamp(y + OffY, y, (y + TexSubHeight) - 1);
+					const size_t ImageOffset = ImgOffY * (TexWidth * PixelSize) + ImgOffX * PixelSize;
+					const size_t GlyphOffset = OffY * pBitmap->width + OffX;
+					for(size_t i = 0; i < PixelSize; ++i)
+					{
+						if(i != PixelSize - 1)
+						{
+							*(pImageBuff + ImageOffset + i) = 255;
+						}
+						else
+						{
+							*(pImageBuff + ImageOffset + i) = *(m_aaGlyphData[FONT_TEXTURE_FILL] + GlyphOffset);
+						}
+					}
+				}
+			}
+
+			WidthLastChars += (pBitmap->width + 1);
+		}
+		pCurrent = pTmp;
+	}
+}
+
+void STextGlyphRun::SaveCursor(const CTextCursor *pCursor)
+{
+	m_Flags = pCursor->m_Flags;
+	m_LineCount = pCursor->m_LineCount;
+	m_GlyphCount = pCursor->m_GlyphCount;
+	m_CharCount = pCursor->m_CharCount;
+	m_X = pCursor->m_X;
+	m_Y = pCursor->m_Y;
+	m_MaxCharacterHeight = pCursor->m_MaxCharacterHeight;
+	m_LongestLineWidth = pCursor->m_LongestLineWidth;
+	m_AlignedFontSize = pCursor->m_AlignedFontSize;
+	m_AlignedLineSpacing = pCursor->m_AlignedLineSpacing;
+}
+
+void STextGlyphRun::RestoreCursor(CTextCursor *pCursor) const
+{
+	pCursor->m_Flags = m_Flags;
+	pCursor->m_LineCount = m_LineCount;
+	pCursor->m_GlyphCount = m_GlyphCount;
+	pCursor->m_CharCount = m_CharCount;
+	pCursor->m_X = m_X;
+	pCursor->m_Y = m_Y;
+	pCursor->m_MaxCharacterHeight = m_MaxCharacterHeight;
+	pCursor->m_LongestLineWidth = m_LongestLineWidth;
+	pCursor->m_AlignedFontSize = m_AlignedFontSize;
+	pCursor->m_AlignedLineSpacing = m_AlignedLineSpacing;
+}
+
+bool STextLayoutKey::operator==(const STextLayoutKey &Other) const
+{
+	return m_FontSize == Other.m_FontSize && m_LineWidth == Other.m_LineWidth && m_LineSpacing == Other.m_LineSpacing &&
+	       m_MaxLines == Other.m_MaxLines && m_Flags == Other.m_Flags && m_RenderFlags == Other.m_RenderFlags &&
+	       m_DefaultRenderFlags == Other.m_DefaultRenderFlags && m_FakeToScreen == Other.m_FakeToScreen &&
+	       m_Position == Other.m_Position && m_StartPosition == Other.m_StartPosition && m_SelectedFace == Other.m_SelectedFace;
+}
+
+size_t STextLayoutKey::Hash(std::string_view Text) const
+{
+	size_t Hash = std::hash<std::string_view>()(Text);
+	Hash = Hash * 31 + std::hash<float>()(m_FontSize);
+	Hash = Hash * 31 + std::hash<float>()(m_LineWidth);
+	Hash = Hash * 31 + std::hash<float>()(m_LineSpacing);
+	Hash = Hash * 31 + std::hash<int>()(m_MaxLines);
+	Hash = Hash * 31 + std::hash<int>()(m_Flags);
+	Hash = Hash * 31 + std::hash<unsigned>()(m_RenderFlags);
+	Hash = Hash * 31 + std::hash<unsigned>()(m_DefaultRenderFlags);
+	Hash = Hash * 31 + std::hash<float>()(m_FakeToScreen.x);
+	Hash = Hash * 31 + std::hash<float>()(m_FakeToScreen.y);
+	Hash = Hash * 31 + std::hash<float>()(m_Position.x);
+	Hash = Hash * 31 + std::hash<float>()(m_Position.y);
+	Hash = Hash * 31 + std::hash<float>()(m_StartPosition.x);
+	Hash = Hash * 31 + std::hash<float>()(m_StartPosition.y);
+	Hash = Hash * 31 + std::hash<FT_Face>()(m_SelectedFace);
+	return Hash;
+}
+
+CTextLayout::CTextLayout(CGlyphMap *pGlyphMap, bool CacheEnabled) :
+	m_pGlyphMap(pGlyphMap), m_CacheEnabled(CacheEnabled), m_CacheGeneration(pGlyphMap->Generation())
+{
+}
+
+void CTextLayout::SetCursor(CTextCursor *pCursor, float x, float y, float FontSize, int Flags)
+{
+	pCursor->m_Flags = Flags;
+	pCursor->m_LineCount = 1;
+	pCursor->m_GlyphCount = 0;
+	pCursor->m_CharCount = 0;
+	pCursor->m_MaxLines = 0;
+
+	pCursor->m_LineSpacing = 0;
+	pCursor->m_AlignedLineSpacing = 0;
+
+	pCursor->m_StartX = x;
+	pCursor->m_StartY = y;
+	pCursor->m_LineWidth = -1.0f;
+	pCursor->m_X = x;
+	pCursor->m_Y = y;
+	pCursor->m_MaxCharacterHeight = 0.0f;
+	pCursor->m_LongestLineWidth = 0.0f;
+
+	pCursor->m_FontSize = FontSize;
+	pCursor->m_AlignedFontSize = FontSize;
+
+	pCursor->m_CalculateSelectionMode = TEXT_CURSOR_SELECTION_MODE_NONE;
+	pCursor->m_SelectionHeightFactor = 1.0f;
+	pCursor->m_PressMouse = vec2(0.0f, 0.0f);
+	pCursor->m_ReleaseMouse = vec2(0.0f, 0.0f);
+	pCursor->m_SelectionStart = 0;
+	pCursor->m_SelectionEnd = 0;
+
+	pCursor->m_CursorMode = TEXT_CURSOR_CURSOR_MODE_NONE;
+	pCursor->m_ForceCursorRendering = false;
+	pCursor->m_CursorCharacter = -1;
+	pCursor->m_CursorRenderedPosition = vec2(-1.0f, -1.0f);
+
+	pCursor->m_vColorSplits = {};
+}
+
+unsigned CTextLayout::ContainerRenderFlags(unsigned RenderFlags, float LineWidth)
+{
+	if(LineWidth <= 0)
+		return RenderFlags | ETextRenderFlags::TEXT_RENDER_FLAG_NO_FIRST_CHARACTER_X_BEARING | ETextRenderFlags::TEXT_RENDER_FLAG_NO_LAST_CHARACTER_ADVANCE;
+	return RenderFlags;
+}
+
+int CTextLayout::WordLength(const char *pText)
+{
+	const char *pCursor = pText;
+	while(true)
+	{
+		if(*pCursor == '\0')
+			return pCursor - pText;
+		if(*pCursor == '\n' || *pCursor == '\t' || *pCursor == ' ')
+			return pCursor - pText + 1;
+		str_utf8_decode(&pCursor);
+	}
+}
+
+void CTextLayout::ClearCache()
+{
+	m_LayoutCacheLru.clear();
+	m_LayoutCache.clear();
+}
+
+const STextGlyphRun &CTextLayout::Layout(CTextCursor *pCursor, const char *pText, int Length, unsigned RenderFlags, unsigned DefaultRenderFlags, vec2 FakeToScreen)
+{
+	if(m_CacheGeneration != m_pGlyphMap->Generation())
+	{
+		// glyphs were looked up in other faces or the atlas was rebuilt
+		ClearCache();
+		m_CacheGeneration = m_pGlyphMap->Generation();
+	}
+
+	// only the layouts of new cursors are cached, the state of the cursor
+	// after appending to a text container depends on everything before
+	const bool NewCursor = pCursor->m_LineCount == 1 && pCursor->m_GlyphCount == 0 && pCursor->m_CharCount == 0 &&
+			       pCursor->m_MaxCharacterHeight == 0.0f && pCursor->m_LongestLineWidth == 0.0f;
+	if(!m_CacheEnabled || !NewCursor)
+	{
+		DoLayout(pCursor, pText, Length, RenderFlags, DefaultRenderFlags, FakeToScreen, &m_UncachedRun);
+		return m_UncachedRun;
+	}
+
+	if(Length < 0)
+		Length = str_length(pText);
+	else
+		Length = minimum(Length, str_length(pText));
+	const std::string_view Text(pText, Length);
+
+	// these flags only change how the text container is uploaded
+	const unsigned UploadFlags = TEXT_RENDER_FLAG_ONE_TIME_USE | TEXT_RENDER_FLAG_NO_AUTOMATIC_QUAD_UPLOAD;
+	STextLayoutKey Key;
+	Key.m_FontSize = pCursor->m_FontSize;
+	Key.m_LineWidth = pCursor->m_LineWidth;
+	Key.m_LineSpacing = pCursor->m_LineSpacing;
+	Key.m_MaxLines = pCursor->m_MaxLines;
+	Key.m_Flags = pCursor->m_Flags;
+	Key.m_RenderFlags = RenderFlags & ~UploadFlags;
+	Key.m_DefaultRenderFlags = DefaultRenderFlags & ~UploadFlags;
+	Key.m_FakeToScreen = FakeToScreen;
+	Key.m_Position = vec2(pCursor->m_X, pCursor->m_Y);
+	Key.m_StartPosition = vec2(pCursor->m_StartX, pCursor->m_StartY);
+	Key.m_SelectedFace = m_pGlyphMap->SelectedFace();
+	const size_t Hash = Key.Hash(Text);
+
+	const auto Cached = m_LayoutCache.find(Hash);
+	if(Cached != m_LayoutCache.end())
+	{
+		if(Cached->second->m_Key == Key && Cached->second->m_Text == Text)
+		{
+			m_LayoutCacheLru.splice(m_LayoutCacheLru.begin(), m_LayoutCacheLru, Cached->second);
+			Cached->second->m_Run.RestoreCursor(pCursor);
+			return Cached->second->m_Run;
+		}
+		// hash collision, the new layout replaces the old one
+		m_LayoutCacheLru.erase(Cached->second);
+		m_LayoutCache.erase(Cached);
+	}
+
+	STextGlyphRun Run;
+	DoLayout(pCursor, pText, Length, RenderFlags, DefaultRenderFlags, FakeToScreen, &Run);
+
+	if(m_LayoutCacheLru.size() >= MAX_CACHED_LAYOUTS)
+	{
+		m_LayoutCache.erase(m_LayoutCacheLru.back().m_Hash);
+		m_LayoutCacheLru.pop_back();
+	}
+	m_LayoutCacheLru.push_front(STextLayoutCacheEntry{Hash, Key, std::string(Text), std::move(Run)});
+	m_LayoutCache[Hash] = m_LayoutCacheLru.begin();
+	return m_LayoutCacheLru.front().m_Run;
+}
+
+void CTextLayout::Measure(CTextCursor *pCursor, float Size, const char *pText, int Length, float LineWidth, float LineSpacing, int Flags, unsigned DefaultRenderFlags, vec2 FakeToScreen)
+{
+	SetCursor(pCursor, 0, 0, Size, Flags);
+	pCursor->m_LineWidth = LineWidth;
+	pCursor->m_LineSpacing = LineSpacing;
+	Layout(pCursor, pText, Length, ContainerRenderFlags(DefaultRenderFlags, LineWidth), DefaultRenderFlags, FakeToScreen);
+}
+
+void CTextLayout::DoLayout(CTextCursor *pCursor, const char *pText, int Length, unsigned RenderFlags, unsigned DefaultRenderFlags, vec2 FakeToScreen, STextGlyphRun *pRun)
+{
+	if(pRun != nullptr)
+		pRun->m_vGlyphs.clear();
+
+	const float CursorX = round_to_int(pCursor->m_X * FakeToScreen.x) / FakeToScreen.x;
+	const float CursorY = round_to_int(pCursor->m_Y * FakeToScreen.y) / FakeToScreen.y;
+	const int ActualSize = round_truncate(pCursor->m_FontSize * FakeToScreen.y);
+	pCursor->m_AlignedFontSize = ActualSize / FakeToScreen.y;
+	pCursor->m_AlignedLineSpacing = round_truncate(pCursor->m_LineSpacing * FakeToScreen.y) / FakeToScreen.y;
+
+	// string length
+	if(Length < 0)
+		Length = str_length(pText);
+	else
+		Length = minimum(Length, str_length(pText));
+
+	const char *pCurrent = pText;
+	const char *pEnd = pCurrent + Length;
+	const char *pEllipsis = "…";
+	const SGlyph *pEllipsisGlyph = nullptr;
+	if(pCursor->m_Flags & TEXTFLAG_ELLIPSIS_AT_END)
+	{
+		if(pCursor->m_LineWidth != -1)
+		{
+			// the width of the whole text on one line
+			CTextCursor WidthCursor;
+			SetCursor(&WidthCursor, 0, 0, pCursor->m_FontSize, 0);
+			DoLayout(&WidthCursor, pText, -1, ContainerRenderFlags(DefaultRenderFlags, -1.0f), DefaultRenderFlags, FakeToScreen, nullptr);
+			if(pCursor->m_LineWidth < WidthCursor.m_LongestLineWidth)
+			{
+				pEllipsisGlyph = m_pGlyphMap->GetGlyph(0x2026, ActualSize); // …
+				if(pEllipsisGlyph == nullptr)
+				{
+					// no ellipsis char in font, just stop at end instead
+					pCursor->m_Flags &= ~TEXTFLAG_ELLIPSIS_AT_END;
+					pCursor->m_Flags |= TEXTFLAG_STOP_AT_END;
+				}
+			}
+		}
+	}
+
+	float DrawX = 0.0f, DrawY = 0.0f;
+	if((RenderFlags & TEXT_RENDER_FLAG_NO_PIXEL_ALIGMENT) != 0)
+	{
+		DrawX = pCursor->m_X;
+		DrawY = pCursor->m_Y;
+	}
+	else
+	{
+		DrawX = CursorX;
+		DrawY = CursorY;
+	}
+
+	int LineCount = pCursor->m_LineCount;
+
+	float LastSelX = DrawX;
+	float LastSelWidth = 0;
+	float LastCharX = DrawX;
+	float LastCharWidth = 0;
+
+	// Returns true if line was started
+	const auto &&StartNewLine = [&]() {
+		if(pCursor->m_MaxLines > 0 && LineCount >= pCursor->m_MaxLines)
+			return false;
+
+		DrawX = pCursor->m_StartX;
+		DrawY += pCursor->m_AlignedFontSize + pCursor->m_AlignedLineSpacing;
+		if((RenderFlags & TEXT_RENDER_FLAG_NO_PIXEL_ALIGMENT) == 0)
+		{
+			DrawX = round_to_int(DrawX * FakeToScreen.x) / FakeToScreen.x; // realign
+			DrawY = round_to_int(DrawY * FakeToScreen.y) / FakeToScreen.y;
+		}
+		LastSelX = DrawX;
+		LastSelWidth = 0;
+		LastCharX = DrawX;
+		LastCharWidth = 0;
+		++LineCount;
+		return true;
+	};
+
+	const SGlyph *pLastGlyph = nullptr;
+	bool GotNewLine = false;
+	bool GotNewLineLast = false;
+
+	while(pCurrent < pEnd && pCurrent != pEllipsis)
+	{
+		bool NewLine = false;
+		const char *pBatchEnd = pEnd;
+		if(pCursor->m_LineWidth > 0 && !(pCursor->m_Flags & TEXTFLAG_STOP_AT_END) && !(pCursor->m_Flags & TEXTFLAG_ELLIPSIS_AT_END))
+		{
+			int Wlen = minimum(WordLength(pCurrent), (int)(pEnd - pCurrent));
+			CTextCursor Compare = *pCursor;
+			Compare.m_CalculateSelectionMode = TEXT_CURSOR_SELECTION_MODE_NONE;
+			Compare.m_CursorMode = TEXT_CURSOR_CURSOR_MODE_NONE;
+			Compare.m_X = DrawX;
+			Compare.m_Y = DrawY;
+			Compare.m_Flags &= ~TEXTFLAG_RENDER;
+			Compare.m_Flags |= TEXTFLAG_DISALLOW_NEWLINE;
+			Compare.m_LineWidth = -1;
+			DoLayout(&Compare, pCurrent, Wlen, ContainerRenderFlags(DefaultRenderFlags, Compare.m_LineWidth), DefaultRenderFlags, FakeToScreen, nullptr);
+
+			if(Compare.m_X - DrawX > pCursor->m_LineWidth)
+			{
+				// word can't be fitted in one line, cut it
+				CTextCursor Cutter = *pCursor;
+				Cutter.m_CalculateSelectionMode = TEXT_CURSOR_SELECTION_MODE_NONE;
+				Cutter.m_CursorMode = TEXT_CURSOR_CURSOR_MODE_NONE;
+				Cutter.m_GlyphCount = 0;
+				Cutter.m_CharCount = 0;
+				Cutter.m_X = DrawX;
+				Cutter.m_Y = DrawY;
+				Cutter.m_Flags &= ~TEXTFLAG_RENDER;
+				Cutter.m_Flags |= TEXTFLAG_STOP_AT_END | TEXTFLAG_DISALLOW_NEWLINE;
+
+				DoLayout(&Cutter, pCurrent, Wlen, ContainerRenderFlags(DefaultRenderFlags, Cutter.m_LineWidth), DefaultRenderFlags, FakeToScreen, nullptr);
+				Wlen = str_utf8_rewind(pCurrent, Cutter.m_CharCount); // rewind once to skip the last character that did not fit
+				NewLine = true;
+
+				if(Cutter.m_GlyphCount <= 3 && !GotNewLineLast) // if we can't place 3 chars of the word on this line, take the next
+					Wlen = 0;
+			}
+			else if(Compare.m_X - pCursor->m_StartX > pCursor->m_LineWidth && !GotNewLineLast)
+			{
+				NewLine = true;
+				Wlen = 0;
+			}
+
+			pBatchEnd = pCurrent + Wlen;
+		}
+
+		const char *pTmp = pCurrent;
+		int NextCharacter = str_utf8_decode(&pTmp);
+
+		while(pCurrent < pBatchEnd && pCurrent != pEllipsis)
+		{
+			pCursor->m_CharCount += pTmp - pCurrent;
+			pCurrent = pTmp;
+			int Character = NextCharacter;
+			NextCharacter = str_utf8_decode(&pTmp);
+
+			if(Character == '\n')
+			{
+				if((pCursor->m_Flags & TEXTFLAG_DISALLOW_NEWLINE) == 0)
+				{
+					pLastGlyph = nullptr;
+					if(!StartNewLine())
+						break;
+					continue;
+				}
+				else
+				{
+					Character = ' ';
+				}
+			}
+
+			const SGlyph *pGlyph = m_pGlyphMap->GetGlyph(Character, ActualSize);
+			if(pGlyph)
+			{
+				const float Scale = 1.0f / pGlyph->m_FontSize;
+
+				const bool ApplyBearingX = !(((RenderFlags & TEXT_RENDER_FLAG_NO_X_BEARING) != 0) || (pCursor->m_GlyphCount == 0 && (RenderFlags & TEXT_RENDER_FLAG_NO_FIRST_CHARACTER_X_BEARING) != 0));
+				const float Advance = ((((RenderFlags & TEXT_RENDER_FLAG_ONLY_ADVANCE_WIDTH) != 0) ? (pGlyph->m_Width) : (pGlyph->m_AdvanceX + ((!ApplyBearingX) ? (-pGlyph->m_OffsetX) : 0.f)))) * Scale * pCursor->m_AlignedFontSize;
+
+				const float OutLineRealDiff = (pGlyph->m_Width - pGlyph->m_CharWidth) * Scale * pCursor->m_AlignedFontSize;
+
+				float CharKerning = 0.0f;
+				if((RenderFlags & TEXT_RENDER_FLAG_KERNING) != 0)
+					CharKerning = m_pGlyphMap->Kerning(pLastGlyph, pGlyph).x * Scale * pCursor->m_AlignedFontSize;
+				pLastGlyph = pGlyph;
+
+				if(pEllipsisGlyph != nullptr && pCursor->m_Flags & TEXTFLAG_ELLIPSIS_AT_END && pCurrent < pBatchEnd && pCurrent != pEllipsis)
+				{
+					float AdvanceEllipsis = ((((RenderFlags & TEXT_RENDER_FLAG_ONLY_ADVANCE_WIDTH) != 0) ? (pEllipsisGlyph->m_Width) : (pEllipsisGlyph->m_AdvanceX + ((!ApplyBearingX) ? (-pEllipsisGlyph->m_OffsetX) : 0.f)))) * Scale * pCursor->m_AlignedFontSize;
+					float CharKerningEllipsis = 0.0f;
+					if((RenderFlags & TEXT_RENDER_FLAG_KERNING) != 0)
+					{
+						CharKerningEllipsis = m_pGlyphMap->Kerning(pGlyph, pEllipsisGlyph).x * Scale * pCursor->m_AlignedFontSize;
+					}
+					if(DrawX + CharKerning + Advance + CharKerningEllipsis + AdvanceEllipsis - pCursor->m_StartX > pCursor->m_LineWidth)
+					{
+						// we hit the end, only render ellipsis and finish
+						pTmp = pEllipsis;
+						NextCharacter = 0x2026;
+						continue;
+					}
+				}
+
+				if(pCursor->m_Flags & TEXTFLAG_STOP_AT_END && (DrawX + CharKerning) + Advance - pCursor->m_StartX > pCursor->m_LineWidth)
+				{
+					// we hit the end of the line, no more to render or count
+					pCurrent = pEnd;
+					break;
+				}
+
+				float BearingX = (!ApplyBearingX ? 0.f : pGlyph->m_OffsetX) * Scale * pCursor->m_AlignedFontSize;
+				float CharWidth = pGlyph->m_Width * Scale * pCursor->m_AlignedFontSize;
+
+				float BearingY = (((RenderFlags & TEXT_RENDER_FLAG_NO_Y_BEARING) != 0) ? 0.f : (pGlyph->m_OffsetY * Scale * pCursor->m_AlignedFontSize));
+				float CharHeight = pGlyph->m_Height * Scale * pCursor->m_AlignedFontSize;
+
+				if((RenderFlags & TEXT_RENDER_FLAG_NO_OVERSIZE) != 0)
+				{
+					if(CharHeight + BearingY > pCursor->m_AlignedFontSize)
+					{
+						BearingY = 0;
+						float ScaleChar = (CharHeight + BearingY) / pCursor->m_AlignedFontSize;
+						CharHeight = pCursor->m_AlignedFontSize;
+						CharWidth /= ScaleChar;
+					}
+				}
+
+				const float TmpY = (DrawY + pCursor->m_AlignedFontSize);
+				const float CharX = (DrawX + CharKerning) + BearingX;
+				const float CharY = TmpY - BearingY;
+
+				// calculate the full width from the last selection point to the end of this selection draw on screen
+				const float SelWidth = (CharX + maximum(Advance, CharWidth - OutLineRealDiff / 2)) - (LastSelX + LastSelWidth);
+				const float SelX = (LastSelX + LastSelWidth);
+
+				if(pRun != nullptr)
+				{
+					STextGlyphPlacement &Placement = pRun->m_vGlyphs.emplace_back();
+					Placement.m_X = CharX;
+					Placement.m_Y = CharY;
+					Placement.m_Width = CharWidth;
+					Placement.m_Height = CharHeight;
+					std::copy(std::begin(pGlyph->m_aUVs), std::end(pGlyph->m_aUVs), std::begin(Placement.m_aUVs));
+					Placement.m_GlyphIndex = pCursor->m_GlyphCount;
+					Placement.m_Line = LineCount;
+					Placement.m_LineY = DrawY;
+					Placement.m_SelX = SelX;
+					Placement.m_SelWidth = SelWidth;
+					Placement.m_LastCharX = LastCharX;
+					Placement.m_LastCharWidth = LastCharWidth;
+				}
+
+				pCursor->m_MaxCharacterHeight = maximum(pCursor->m_MaxCharacterHeight, CharHeight + BearingY);
+
+				if(NextCharacter == 0 && (RenderFlags & TEXT_RENDER_FLAG_NO_LAST_CHARACTER_ADVANCE) != 0 && Character != ' ')
+					DrawX += BearingX + CharKerning + CharWidth;
+				else
+					DrawX += Advance + CharKerning;
+
+				pCursor->m_GlyphCount++;
+
+				LastSelX = SelX;
+				LastSelWidth = SelWidth;
+				LastCharX = CharX;
+				LastCharWidth = CharWidth;
+			}
+
+			pCursor->m_LongestLineWidth = maximum(pCursor->m_LongestLineWidth, DrawX - pCursor->m_StartX);
+		}
+
+		if(NewLine)
+		{
+			if(!StartNewLine())
+				break;
+			GotNewLine = true;
+			GotNewLineLast = true;
+		}
+		else
+			GotNewLineLast = false;
+	}
+
+	// even if no text is drawn the cursor position will be adjusted
+	pCursor->m_X = DrawX;
+	pCursor->m_LineCount = LineCount;
+
+	if(GotNewLine)
+		pCursor->m_Y = DrawY;
+
+	if(pRun != nullptr)
+	{
+		pRun->m_LineY = DrawY;
+		pRun->m_SelEnd = LastSelX + LastSelWidth;
+		pRun->SaveCursor(pCursor);
+	}
+}
@@ -0,0 +1,507 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_TEXT_LAYOUT_H
+#define ENGINE_CLIENT_TEXT_LAYOUT_H
+
+#include <base/system.h>
+#include <base/vmath.h>
+
+#include <engine/graphics.h>
+#include <engine/textrender.h>
+
+// ft2 texture
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <list>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+enum
+{
+	FONT_NAME_SIZE = 128,
+};
+
+struct SGlyph
+{
+	enum class EState
+	{
+		UNINITIALIZED,
+		RENDERED,
+		ERROR,
+	};
+	EState m_State = EState::UNINITIALIZED;
+
+	int m_FontSize;
+	FT_Face m_Face;
+	int m_Chr;
+	FT_UInt m_GlyphIndex;
+
+	// these values are scaled to the font size
+	// width * font_size == real_size
+	float m_Width;
+	float m_Height;
+	float m_CharWidth;
+	float m_CharHeight;
+	float m_OffsetX;
+	float m_OffsetY;
+	float m_AdvanceX;
+
+	float m_aUVs[4];
+};
+
+struct SGlyphKeyHash
+{
+	size_t operator()(const std::tuple<FT_Face, int, int> &Key) const
+	{
+		size_t Hash = 17;
+		Hash = Hash * 31 + std::hash<FT_Face>()(std::get<0>(Key));
+		Hash = Hash * 31 + std::hash<int>()(std::get<1>(Key));
+		Hash = Hash * 31 + std::hash<int>()(std::get<2>(Key));
+		return Hash;
+	}
+};
+
+struct SGlyphKeyEquals
+{
+	bool operator()(const std::tuple<FT_Face, int, int> &Lhs, const std::tuple<FT_Face, int, int> &Rhs) const
+	{
+		return std::get<0>(Lhs) == std::get<0>(Rhs) && std::get<1>(Lhs) == std::get<1>(Rhs) && std::get<2>(Lhs) == std::get<2>(Rhs);
+	}
+};
+
+class CAtlas
+{
+	struct SSectionKeyHash
+	{
+		size_t operator()(const std::tuple<size_t, size_t> &Key) const
+		{
+			// Width and height should never be above 2^16 so this hash should cause no collisions
+			return (std::get<0>(Key) << 16) ^ std::get<1>(Key);
+		}
+	};
+
+	struct SSectionKeyEquals
+	{
+		bool operator()(const std::tuple<size_t, size_t> &Lhs, const std::tuple<size_t, size_t> &Rhs) const
+		{
+			return std::get<0>(Lhs) == std::get<0>(Rhs) && std::get<1>(Lhs) == std::get<1>(Rhs);
+		}
+	};
+
+	struct SSection
+	{
+		size_t m_X;
+		size_t m_Y;
+		size_t m_W;
+		size_t m_H;
+
+		SSection() = default;
+
+		SSection(size_t X, size_t Y, size_t W, size_t H) :
+			m_X(X), m_Y(Y), m_W(W), m_H(H)
+		{
+		}
+	};
+
+	/**
+	 * Sections with a smaller width or height will not be created
+	 * when cutting larger sections, to prevent collecting many
+	 * small, mostly unusable sections.
+	 */
+	static constexpr size_t MIN_SECTION_DIMENSION = 6;
+
+	/**
+	 * Sections with larger width or height will be stored in m_vSections.
+	 * Sections with width and height equal or smaller will be stored in m_SectionsMap.
+	 * This achieves a good balance between the size of the vector storing all large
+	 * sections and the map storing vectors of all sections with specific small sizes.
+	 * Lowering this value will result in the size of m_vSections becoming the bottleneck.
+	 * Increasing this value will result in the map becoming the bottleneck.
+	 */
+	static constexpr size_t MAX_SECTION_DIMENSION_MAPPED = 8 * MIN_SECTION_DIMENSION;
+
+	size_t m_TextureDimension;
+	std::vector<SSection> m_vSections;
+	std::unordered_map<std::tuple<size_t, size_t>, std::vector<SSection>, SSectionKeyHash, SSectionKeyEquals> m_SectionsMap;
+
+	void AddSection(size_t X, size_t Y, size_t W, size_t H)
+	{
+		std::vector<SSection> &vSections = W <= MAX_SECTION_DIMENSION_MAPPED && H <= MAX_SECTION_DIMENSION_MAPPED ? m_SectionsMap[std::make_tuple(W, H)] : m_vSections;
+		vSections.emplace_back(X, Y, W, H);
+	}
+
+	void UseSection(const SSection &Section, size_t Width, size_t Height, int &PosX, int &PosY)
+	{
+		PosX = Section.m_X;
+		PosY = Section.m_Y;
+
+		// Create cut sections
+		const size_t CutW = Section.m_W - Width;
+		const size_t CutH = Section.m_H - Height;
+		if(CutW == 0)
+		{
+			if(CutH >= MIN_SECTION_DIMENSION)
+				AddSection(Section.m_X, Section.m_Y + Height, Section.m_W, CutH);
+		}
+		else if(CutH == 0)
+		{
+			if(CutW >= MIN_SECTION_DIMENSION)
+				AddSection(Section.m_X + Width, Section.m_Y, CutW, Section.m_H);
+		}
+		else if(CutW > CutH)
+		{
+			if(CutW >= MIN_SECTION_DIMENSION)
+				AddSection(Section.m_X + Width, Section.m_Y, CutW, Section.m_H);
+			if(CutH >= MIN_SECTION_DIMENSION)
+				AddSection(Section.m_X, Section.m_Y + Height, Width, CutH);
+		}
+		else
+		{
+			if(CutH >= MIN_SECTION_DIMENSION)
+				AddSection(Section.m_X, Section.m_Y + Height, Section.m_W, CutH);
+			if(CutW >= MIN_SECTION_DIMENSION)
+				AddSection(Section.m_X + Width, Section.m_Y, CutW, Height);
+		}
+	}
+
+public:
+	void Clear(size_t TextureDimension)
+	{
+		m_TextureDimension = TextureDimension;
+		m_vSections.clear();
+		m_vSections.emplace_back(0, 0, m_TextureDimension, m_TextureDimension);
+		m_SectionsMap.clear();
+	}
+
+	void IncreaseDimension(size_t NewTextureDimension)
+	{
+		dbg_assert(NewTextureDimension == m_TextureDimension * 2, "New atlas dimension must be twice the old one");
+		// Create 3 square sections to cover the new area, add the sections
+		// to the beginning of the vector so they are considered last.
+		m_vSections.emplace_back(m_TextureDimension, m_TextureDimension, m_TextureDimension, m_TextureDimension);
+		m_vSections.emplace_back(m_TextureDimension, 0, m_TextureDimension, m_TextureDimension);
+		m_vSections.emplace_back(0, m_TextureDimension, m_TextureDimension, m_TextureDimension);
+		std::rotate(m_vSections.rbegin(), m_vSections.rbegin() + 3, m_vSections.rend());
+		m_TextureDimension = NewTextureDimension;
+	}
+
+	bool Add(size_t Width, size_t Height, int &PosX, int &PosY)
+	{
+		if(m_vSections.empty() || m_TextureDimension < Width || m_TextureDimension < Height)
+			return false;
+
+		// Find small section more efficiently by using maps
+		if(Width <= MAX_SECTION_DIMENSION_MAPPED && Height <= MAX_SECTION_DIMENSION_MAPPED)
+		{
+			const auto UseSectionFromVector = [&](std::vector<SSection> &vSections) {
+				if(!vSections.empty())
+				{
+					const SSection Section = vSections.back();
+					vSections.pop_back();
+					UseSection(Section, Width, Height, PosX, PosY);
+					return true;
+				}
+				return false;
+			};
+
+			if(UseSectionFromVector(m_SectionsMap[std::make_tuple(Width, Height)]))
+				return true;
+
+			for(size_t CheckWidth = Width + 1; CheckWidth <= MAX_SECTION_DIMENSION_MAPPED; ++CheckWidth)
+			{
+				if(UseSectionFromVector(m_SectionsMap[std::make_tuple(CheckWidth, Height)]))
+					return true;
+			}
+
+			for(size_t CheckHeight = Height + 1; CheckHeight <= MAX_SECTION_DIMENSION_MAPPED; ++CheckHeight)
+			{
+				if(UseSectionFromVector(m_SectionsMap[std::make_tuple(Width, CheckHeight)]))
+					return true;
+			}
+
+			// We don't iterate sections in the map with increasing width and height at the same time,
+			// because it's slower and doesn't noticeable increase the atlas utilization.
+		}
+
+		// Check vector for larger section
+		size_t SmallestLossValue = std::numeric_limits<size_t>::max();
+		size_t SmallestLossIndex = m_vSections.size();
+		size_t SectionIndex = m_vSections.size();
+		do
+		{
+			--SectionIndex;
+			const SSection &Section = m_vSections[SectionIndex];
+			if(Section.m_W < Width || Section.m_H < Height)
+				continue;
+
+			const size_t LossW = Section.m_W - Width;
+			const size_t LossH = Section.m_H - Height;
+
+			size_t Loss;
+			if(LossW == 0)
+				Loss = LossH;
+			else if(LossH == 0)
+				Loss = LossW;
+			else
+				Loss = LossW * LossH;
+
+			if(Loss < SmallestLossValue)
+			{
+				SmallestLossValue = Loss;
+				SmallestLossIndex = SectionIndex;
+				if(SmallestLossValue == 0)
+					break;
+			}
+		} while(SectionIndex > 0);
+		if(SmallestLossIndex == m_vSections.size())
+			return false; // No usable section found in vector
+
+		// Use the section with the smallest loss
+		const SSection Section = m_vSections[SmallestLossIndex];
+		m_vSections.erase(m_vSections.begin() + SmallestLossIndex);
+		UseSection(Section, Width, Height, PosX, PosY);
+		return true;
+	}
+};
+
+class CGlyphMap
+{
+public:
+	enum
+	{
+		FONT_TEXTURE_FILL = 0, // the main text body
+		FONT_TEXTURE_OUTLINE, // the text outline
+		NUM_FONT_TEXTURES,
+	};
+
+private:
+	/**
+	 * The initial dimension of the atlas textures.
+	 * Results in 1 MB of memory being used per texture.
+	 */
+	static constexpr int INITIAL_ATLAS_DIMENSION = 1024;
+
+	/**
+	 * The maximum dimension of the atlas textures.
+	 * Results in 256 MB of memory being used per texture.
+	 */
+	static constexpr int MAXIMUM_ATLAS_DIMENSION = 16 * 1024;
+
+	/**
+	 * The minimum supported font size.
+	 */
+	static constexpr int MIN_FONT_SIZE = 6;
+
+	/**
+	 * The maximum supported font size.
+	 */
+	static constexpr int MAX_FONT_SIZE = 128;
+
+	/**
+	 * White square to indicate missing glyph.
+	 */
+	static constexpr int REPLACEMENT_CHARACTER = 0x25a1;
+
+	IGraphics *m_pGraphics;
+	IGraphics *Graphics() { return m_pGraphics; }
+
+	// Atlas textures and data
+	IGraphics::CTextureHandle m_aTextures[NUM_FONT_TEXTURES];
+	// Width and height are the same, all font textures have the same dimensions
+	size_t m_TextureDimension = INITIAL_ATLAS_DIMENSION;
+	// Keep the full texture data, because OpenGL doesn't provide texture copying
+	uint8_t *m_apTextureData[NUM_FONT_TEXTURES];
+	CAtlas m_TextureAtlas;
+	std::unordered_map<std::tuple<FT_Face, int, int>, SGlyph, SGlyphKeyHash, SGlyphKeyEquals> m_Glyphs;
+	// (selected face, character, allow replacement) -> face and glyph index found by GetCharGlyph
+	std::unordered_map<std::tuple<FT_Face, int, int>, std::pair<FT_Face, FT_UInt>, SGlyphKeyHash, SGlyphKeyEquals> m_CharGlyphs;
+
+	// Data used for rendering glyphs
+	uint8_t m_aaGlyphData[NUM_FONT_TEXTURES][64 * 1024];
+
+	// Font faces
+	FT_Face m_DefaultFace = nullptr;
+	FT_Face m_IconFace = nullptr;
+	FT_Face m_VariantFace = nullptr;
+	FT_Face m_SelectedFace = nullptr;
+	std::vector<FT_Face> m_vFallbackFaces;
+	std::vector<FT_Face> m_vFtFaces;
+
+	// Incremented whenever glyphs or the faces they are looked up in change
+	unsigned m_Generation = 0;
+
+	FT_Face GetFaceByName(const char *pFamilyName);
+	void OnFacesChanged();
+	bool IncreaseGlyphMapSize();
+	void UploadTextures();
+	void UnloadTextures();
+	FT_UInt GetCharGlyph(int Chr, FT_Face *pFace, bool AllowReplacementCharacter);
+	FT_UInt FindCharGlyph(int Chr, FT_Face *pFace, bool AllowReplacementCharacter);
+	void Grow(const unsigned char *pIn, unsigned char *pOut, int w, int h, int OutlineCount) const;
+	int AdjustOutlineThicknessToFontSize(int OutlineThickness, int FontSize) const;
+	void UploadGlyph(int TextureIndex, int PosX, int PosY, size_t Width, size_t Height, const unsigned char *pData);
+	bool FitGlyph(size_t Width, size_t Height, int &PosX, int &PosY);
+	bool RenderGlyph(SGlyph &Glyph);
+
+public:
+	/**
+	 * @param pGraphics The graphics to upload the atlas textures to. Without
+	 * graphics, glyphs are still rendered to the atlas data but never uploaded.
+	 */
+	CGlyphMap(IGraphics *pGraphics);
+	~CGlyphMap();
+
+	FT_Face DefaultFace() const { return m_DefaultFace; }
+	FT_Face IconFace() const { return m_IconFace; }
+	FT_Face SelectedFace() const { return m_SelectedFace; }
+	unsigned Generation() const { return m_Generation; }
+
+	void AddFace(FT_Face Face);
+	void SetDefaultFaceByName(const char *pFamilyName);
+	void SetIconFaceByName(const char *pFamilyName);
+	void AddFallbackFaceByName(const char *pFamilyName);
+	void SetVariantFaceByName(const char *pFamilyName);
+	void SetFontPreset(EFontPreset FontPreset);
+	void Clear();
+
+	const SGlyph *GetGlyph(int Chr, int FontSize);
+	vec2 Kerning(const SGlyph *pLeft, const SGlyph *pRight) const;
+
+	void UploadEntityLayerText(void *pTexBuff, size_t PixelSize, size_t TexWidth, size_t TexHeight, int TexSubWidth, int TexSubHeight, const char *pText, int Length, float x, float y, int FontSize);
+
+	size_t TextureDimension() const { return m_TextureDimension; }
+	IGraphics::CTextureHandle Texture(size_t TextureIndex) const { return m_aTextures[TextureIndex]; }
+};
+
+// A glyph of a laid out text with everything text containers need to build
+// its quad, selection and cursor without laying out the text again
+struct STextGlyphPlacement
+{
+	float m_X;
+	float m_Y;
+	float m_Width;
+	float m_Height;
+	float m_aUVs[4];
+
+	// the number of glyphs before this one
+	int m_GlyphIndex;
+	int m_Line;
+	float m_LineY;
+	// the selection area from the end of the previous glyph to the end of this one
+	float m_SelX;
+	float m_SelWidth;
+	// the previous glyph on the same line
+	float m_LastCharX;
+	float m_LastCharWidth;
+};
+
+// The glyphs of a laid out text and the state of the cursor after it
+struct STextGlyphRun
+{
+	std::vector<STextGlyphPlacement> m_vGlyphs;
+	float m_LineY;
+	float m_SelEnd;
+
+	int m_Flags;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	float m_X;
+	float m_Y;
+	float m_MaxCharacterHeight;
+	float m_LongestLineWidth;
+	float m_AlignedFontSize;
+	float m_AlignedLineSpacing;
+
+	void SaveCursor(const CTextCursor *pCursor);
+	void RestoreCursor(CTextCursor *pCursor) const;
+};
+
+// Everything a layout depends on besides the text and the glyph map. The
+// text itself is only hashed here and compared in the cache entry.
+struct STextLayoutKey
+{
+	float m_FontSize;
+	float m_LineWidth;
+	float m_LineSpacing;
+	int m_MaxLines;
+	int m_Flags;
+	unsigned m_RenderFlags;
+	unsigned m_DefaultRenderFlags;
+	vec2 m_FakeToScreen;
+	vec2 m_Position;
+	vec2 m_StartPosition;
+	FT_Face m_SelectedFace;
+
+	bool operator==(const STextLayoutKey &Other) const;
+	size_t Hash(std::string_view Text) const;
+};
+
+struct STextLayoutCacheEntry
+{
+	size_t m_Hash;
+	STextLayoutKey m_Key;
+	std::string m_Text;
+	STextGlyphRun m_Run;
+};
+
+// Lays out texts with the glyphs of a glyph map, without a graphics backend.
+// UI code lays out the same labels every frame, so the glyph runs of texts
+// laid out with a new cursor are cached.
+class CTextLayout
+{
+	CGlyphMap *m_pGlyphMap;
+	bool m_CacheEnabled;
+	unsigned m_CacheGeneration;
+
+	std::list<STextLayoutCacheEntry> m_LayoutCacheLru;
+	std::unordered_map<size_t, std::list<STextLayoutCacheEntry>::iterator> m_LayoutCache;
+	STextGlyphRun m_UncachedRun;
+
+	static int WordLength(const char *pText);
+	void DoLayout(CTextCursor *pCursor, const char *pText, int Length, unsigned RenderFlags, unsigned DefaultRenderFlags, vec2 FakeToScreen, STextGlyphRun *pRun);
+
+public:
+	/**
+	 * Number of glyph runs that are kept, least recently used ones are evicted first.
+	 */
+	static constexpr size_t MAX_CACHED_LAYOUTS = 1024;
+
+	CTextLayout(CGlyphMap *pGlyphMap, bool CacheEnabled = true);
+
+	static void SetCursor(CTextCursor *pCursor, float x, float y, float FontSize, int Flags);
+
+	/**
+	 * The render flags of a text container created with `RenderFlags` for a
+	 * cursor with the line width `LineWidth`.
+	 */
+	static unsigned ContainerRenderFlags(unsigned RenderFlags, float LineWidth);
+
+	/**
+	 * Lays out the text at the cursor and advances the cursor like rendering it does.
+	 *
+	 * @param RenderFlags The render flags of the text container.
+	 * @param DefaultRenderFlags The render flags of the text renderer, used to measure parts of the text.
+	 * @param FakeToScreen The ratio of screen pixels to UI units.
+	 *
+	 * @return The placed glyphs, valid until the next call.
+	 */
+	const STextGlyphRun &Layout(CTextCursor *pCursor, const char *pText, int Length, unsigned RenderFlags, unsigned DefaultRenderFlags, vec2 FakeToScreen);
+
+	/**
+	 * Lays out the text with a new cursor at 0, 0 without rendering it, like TextWidth and TextBoundingBox.
+	 */
+	void Measure(CTextCursor *pCursor, float Size, const char *pText, int Length, float LineWidth, float LineSpacing, int Flags, unsigned DefaultRenderFlags, vec2 FakeToScreen);
+
+	void ClearCache();
+	size_t NumCachedLayouts() const { return m_LayoutCacheLru.size(); }
+};
+
+#endif
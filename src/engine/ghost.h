@@ -6,6 +6,9 @@
 
 #include "kernel.h"
 
+#include <ctime>
+#include <memory>
+
 class CGhostInfo
 {
 public:
@@ -21,8 +24,11 @@ class IGhostRecorder : public IInterface
 public:
 	virtual ~IGhostRecorder() {}
 
-	virtual int Start(const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, const char *pName) = 0;
-	virtual int Stop(int Ticks, int Time) = 0;
+	virtual int Start(const char *pMap, SHA256_DIGEST MapSha256, const char *pName) = 0;
+	// Saves the recording to `pFilename` on a background thread, or discards it if `pFilename` is nullptr.
+	virtual int Stop(int Ticks, int Time, const char *pFilename) = 0;
+	// Drops a save of `pFilename` that did not start yet, or waits for the one in progress.
+	virtual void CancelWrite(const char *pFilename) = 0;
 
 	virtual void WriteData(int Type, const void *pData, int Size) = 0;
 	virtual bool IsRecording() const = 0;
@@ -42,7 +48,14 @@ public:
 	virtual bool ReadNextType(int *pType) = 0;
 	virtual bool ReadData(int Type, void *pData, int Size) = 0;
 
-	virtual bool GetGhostInfo(const char *pFilename, CGhostInfo *pInfo, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc) = 0;
+	// Creates a loader that does not share any state with this one, to read ghosts on a job.
+	virtual std::unique_ptr<IGhostLoader> CreateLoader() const = 0;
+
+	// The index caches the headers of the ghost files by their modification time,
+	// so listing the ghosts of a map does not have to open every file.
+	virtual void LoadIndex(const char *pFilename) = 0;
+	virtual void SaveIndex() = 0;
+	virtual bool GetGhostInfo(const char *pFilename, time_t Modified, CGhostInfo *pInfo, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc) = 0;
 };
 
 #endif
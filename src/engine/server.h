@@ -74,6 +74,9 @@ public:
 	 */
 	virtual int GetClientVersion(int ClientID) const = 0;
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID) = 0;
+	// Sends the message to every client in `Mask`. It is repacked only once
+	// per protocol instead of once per client.
+	virtual int SendMsgMask(CMsgPacker *pMsg, int Flags, const CClientMask &Mask) = 0;
 
 	template<class T, typename std::enable_if<!protocol7::is_sixup<T>::value, int>::type = 0>
 	inline int SendPackMsg(const T *pMsg, int Flags, int ClientID)
@@ -108,6 +111,71 @@ public:
 		return Result;
 	}
 
+	// Like `SendPackMsg` for every client in `Mask`, but the message is only
+	// packed once for all of them. Only for messages that don't have their
+	// client IDs translated, chat messages have their own overload.
+	template<class T, typename std::enable_if<!protocol7::is_sixup<T>::value, int>::type = 0>
+	int SendPackMsgMask(const T *pMsg, int Flags, const CClientMask &Mask)
+	{
+		CMsgPacker Packer(T::ms_MsgID, false);
+		if(pMsg->Pack(&Packer))
+			return -1;
+		return SendMsgMask(&Packer, Flags, Mask);
+	}
+
+	template<class T, typename std::enable_if<protocol7::is_sixup<T>::value, int>::type = 1>
+	int SendPackMsgMask(const T *pMsg, int Flags, const CClientMask &Mask)
+	{
+		CClientMask SixupMask;
+		for(int i = 0; i < MaxClients(); i++)
+			SixupMask[i] = Mask[i] && IsSixup(i);
+		if(SixupMask.none())
+			return 0;
+		CMsgPacker Packer(T::ms_MsgID, false, true);
+		if(pMsg->Pack(&Packer))
+			return -1;
+		return SendMsgMask(&Packer, Flags, SixupMask);
+	}
+
+	int SendPackMsgMask(const CNetMsg_Sv_Chat *pMsg, int Flags, const CClientMask &Mask)
+	{
+		int Result = 0;
+		CClientMask SixMask;
+		CClientMask SixupMask;
+		for(int i = 0; i < MaxClients(); i++)
+		{
+			if(!Mask[i])
+				continue;
+			if(IsSixup(i))
+				SixupMask.set(i);
+			else if(pMsg->m_ClientID >= 0 && GetClientVersion(i) < VERSION_DDNET_OLD)
+				Result = SendPackMsgTranslate(pMsg, Flags, i); // sees the chatter under its own client ID
+			else
+				SixMask.set(i);
+		}
+
+		if(SixMask.any())
+		{
+			CMsgPacker Packer(CNetMsg_Sv_Chat::ms_MsgID, false);
+			if(pMsg->Pack(&Packer))
+				return -1;
+			Result = SendMsgMask(&Packer, Flags, SixMask);
+		}
+		if(SixupMask.any())
+		{
+			protocol7::CNetMsg_Sv_Chat Msg7;
+			Msg7.m_ClientID = pMsg->m_ClientID;
+			Msg7.m_pMessage = pMsg->m_pMessage;
+			Msg7.m_Mode = pMsg->m_Team > 0 ? protocol7::CHAT_TEAM : protocol7::CHAT_ALL;
+			Msg7.m_TargetID = -1;
+			CMsgPacker Packer(protocol7::CNetMsg_Sv_Chat::ms_MsgID, false, true);
+			if(Msg7.Pack(&Packer))
+				return -1;
+			Result = SendMsgMask(&Packer, Flags, SixupMask);
+		}
+		return Result;
+	}
+
 	template<class T>
 	int SendPackMsgTranslate(const T *pMsg, int Flags, int ClientID)
 	{
@@ -240,6 +308,11 @@ public:
 	}
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
+	// Re-adds the items of the given types and ID from the previous snapshot
+	// of `SnappingClient` unless they are due for a refresh every `Interval`
+	// snapshots, see `sv_snap_lod`. Returns true if the items were re-added
+	// and must not be snapped again.
+	virtual bool SnapHoldItems(int SnappingClient, int ID, int Interval, const int *pTypes, int NumTypes) = 0;
 
 	enum
 	{
@@ -288,6 +361,10 @@ public:
 	virtual const char *GetMapName() const = 0;
 
 	virtual bool IsSixup(int ClientID) const = 0;
+
+	// Returns the PRNG seed of the teehistorian recording that is being
+	// replayed, or false if the server isn't replaying one.
+	virtual bool TeeHistorianReplaySeed(uint64_t aSeed[2]) const = 0;
 };
 
 class IGameServer : public IInterface
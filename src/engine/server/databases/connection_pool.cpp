@@ -1,6 +1,7 @@
 #include "connection_pool.h"
 #include "connection.h"
 
+#include <base/math.h>
 #include <base/system.h>
 #include <cstring>
 #include <engine/console.h>
@@ -64,6 +65,10 @@ struct CSqlExecData
 
 	std::unique_ptr<const ISqlData> m_pThreadData;
 	const char *m_pName;
+	// write query that can share a transaction with its neighbours
+	bool m_Batch = false;
+	// time_get_nanoseconds() when the query was queued
+	int64_t m_QueueTime = 0;
 };
 
 CSqlExecData::CSqlExecData(
@@ -72,7 +77,8 @@ CSqlExecData::CSqlExecData(
 	const char *pName) :
 	m_Mode(READ_ACCESS),
 	m_pThreadData(std::move(pThreadData)),
-	m_pName(pName)
+	m_pName(pName),
+	m_QueueTime(time_get_nanoseconds().count())
 {
 	m_Ptr.m_pReadFunc = pFunc;
 }
@@ -83,7 +89,8 @@ CSqlExecData::CSqlExecData(
 	const char *pName) :
 	m_Mode(WRITE_ACCESS),
 	m_pThreadData(std::move(pThreadData)),
-	m_pName(pName)
+	m_pName(pName),
+	m_QueueTime(time_get_nanoseconds().count())
 {
 	m_Ptr.m_pWriteFunc = pFunc;
 }
@@ -117,25 +124,109 @@ CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 	m_Ptr.m_Print.m_Mode = m;
 }
 
-void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+static std::unique_ptr<CSqlExecData> CopyAddDatabase(const CSqlExecData *pData)
+{
+	if(pData->m_Mode == CSqlExecData::ADD_MYSQL)
+		return std::make_unique<CSqlExecData>(pData->m_Ptr.m_MySql.m_Mode, &pData->m_Ptr.m_MySql.m_Config);
+	return std::make_unique<CSqlExecData>(pData->m_Ptr.m_Sqlite.m_Mode, pData->m_Ptr.m_Sqlite.m_FileName);
+}
+
+void CDbConnectionPool::Push(std::unique_ptr<CSqlExecData> pData)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pConsole, DatabaseMode);
+	m_pShared->m_aQueries[m_InsertIdx++] = std::move(pData);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
 	m_pShared->m_NumBackup.Signal();
 }
 
+void CDbConnectionPool::PushRead(int Worker, std::unique_ptr<CSqlExecData> pData)
+{
+	CReadQueue *pQueue = m_vpReadQueues[Worker].get();
+	pQueue->m_aQueries[pQueue->m_InsertIdx++] = std::move(pData);
+	pQueue->m_InsertIdx %= std::size(pQueue->m_aQueries);
+	pQueue->m_NumQueries.Signal();
+}
+
+static void PrintLatency(IConsole *pConsole, const char *pQueue, int Depth, const CTickHistogram &Latency)
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%s queue: depth=%d completed=%llu latency p50=%lluus p99=%lluus max=%lluus",
+		pQueue, Depth,
+		(unsigned long long)Latency.Count(),
+		(unsigned long long)Latency.Quantile(0.5),
+		(unsigned long long)Latency.Quantile(0.99),
+		(unsigned long long)Latency.Max());
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
+void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+{
+	if(DatabaseMode == Mode::READ && m_vpReadQueues.empty())
+	{
+		// don't start the read workers before sv_sql_read_workers is known,
+		// print the databases they will connect to instead
+		for(const auto &pData : m_vpReadDatabases)
+		{
+			char aBuf[512];
+			if(pData->m_Mode == CSqlExecData::ADD_SQLITE)
+			{
+				str_format(aBuf, sizeof(aBuf), "SQLite-Read: DB: '%s'", pData->m_Ptr.m_Sqlite.m_FileName);
+			}
+			else
+			{
+				const CMysqlConfig &Config = pData->m_Ptr.m_MySql.m_Config;
+				str_format(aBuf, sizeof(aBuf),
+					"MySQL-Read: DB: '%s' Prefix: '%s' User: '%s' IP: <{'%s'}> Port: %d",
+					Config.m_aDatabase, Config.m_aPrefix, Config.m_aUser, Config.m_aIp, Config.m_Port);
+			}
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		}
+		if(m_vpReadDatabases.empty())
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+		PrintLatency(pConsole, "Read", m_pShared->m_ReadDepth.load(), m_pShared->m_ReadLatency);
+	}
+	else if(DatabaseMode == Mode::READ)
+	{
+		PushRead(0, std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+	}
+	else
+	{
+		Push(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+	}
+}
+
+void CDbConnectionPool::SetNumReadWorkers(int NumReadWorkers)
+{
+	m_NumReadWorkers = maximum(NumReadWorkers, 1);
+}
+
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFileName[64])
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFileName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	auto pData = std::make_unique<CSqlExecData>(DatabaseMode, aFileName);
+	if(DatabaseMode == Mode::READ)
+	{
+		for(size_t i = 0; i < m_vpReadQueues.size(); i++)
+			PushRead(i, CopyAddDatabase(pData.get()));
+		m_vpReadDatabases.push_back(std::move(pData));
+	}
+	else
+	{
+		Push(std::move(pData));
+	}
 }
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	auto pData = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
+	if(DatabaseMode == Mode::READ)
+	{
+		for(size_t i = 0; i < m_vpReadQueues.size(); i++)
+			PushRead(i, CopyAddDatabase(pData.get()));
+		m_vpReadDatabases.push_back(std::move(pData));
+	}
+	else
+	{
+		Push(std::move(pData));
+	}
 }
 
 void CDbConnectionPool::Execute(
@@ -143,19 +234,35 @@ void CDbConnectionPool::Execute(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(m_Shutdown)
+	{
+		// the read workers don't take new queries anymore
+		if(pSqlRequestData->m_pResult != nullptr)
+			pSqlRequestData->m_pResult->m_Completed.store(true);
+		return;
+	}
+	StartReadWorkers();
+	int Worker = 0;
+	for(size_t i = 1; i < m_vpReadQueues.size(); i++)
+	{
+		if(m_vpReadQueues[i]->m_Depth.load() < m_vpReadQueues[Worker]->m_Depth.load())
+			Worker = i;
+	}
+	m_vpReadQueues[Worker]->m_Depth.fetch_add(1);
+	m_pShared->m_ReadDepth.fetch_add(1);
+	PushRead(Worker, std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
 }
 
 void CDbConnectionPool::ExecuteWrite(
 	FWrite pFunc,
 	std::unique_ptr<const ISqlData> pSqlRequestData,
-	const char *pName)
+	const char *pName,
+	bool Batch)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	auto pData = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
+	pData->m_Batch = Batch;
+	m_pShared->m_WriteDepth.fetch_add(1);
+	Push(std::move(pData));
 }
 
 void CDbConnectionPool::OnShutdown()
@@ -165,6 +272,9 @@ void CDbConnectionPool::OnShutdown()
 	m_Shutdown = true;
 	m_pShared->m_Shutdown.store(true);
 	m_pShared->m_NumBackup.Signal();
+	// the read workers exit after dismissing their remaining queries
+	for(auto &pQueue : m_vpReadQueues)
+		pQueue->m_NumQueries.Signal();
 	int i = 0;
 	while(m_pShared->m_Shutdown.load())
 	{
@@ -237,6 +347,7 @@ void CBackup::ProcessQueries()
 // the worker threads executes queries on mysql or sqlite. If we write on
 // a mysql server and have a backup server configured, we'll remove the
 // entry from the backup server after completing it on the write server.
+// Read queries are handed on to the read workers by the main thread.
 // static void Worker(void *pUser);
 class CWorker
 {
@@ -247,7 +358,15 @@ public:
 	void ProcessQueries();
 
 private:
+	enum
+	{
+		MAX_WRITE_BATCH = 32,
+	};
+
 	void Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode);
+	bool ProcessWrite(int JobNum, CSqlExecData *pData, bool *pFailMode);
+	// returns true if all writes of the batch were committed
+	bool ExecuteBatch(const std::vector<std::unique_ptr<CSqlExecData>> &vpBatch);
 
 	// There are two possible configurations
 	//  * sqlite mode: There exists exactly one READ and the same WRITE server
@@ -257,7 +376,6 @@ private:
 	//                Servers must be the same (to counteract double loads).
 	//                There may be one WRITE_BACKUP sqlite server.
 	// This variable should only change, before the worker threads
-	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
 	std::unique_ptr<IDbConnection> m_pWriteConnection;
 	std::unique_ptr<IDbConnection> m_pWriteBackup;
 
@@ -274,11 +392,10 @@ void CWorker::Start(void *pUser)
 
 void CWorker::ProcessQueries()
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	// enter fail mode when a sql request fails, skip read request during it and
-	// write to the backup database until all requests are handled
+	// enter fail mode when a sql request fails, write to the backup database
+	// until all requests are handled
 	bool FailMode = false;
+	std::vector<std::unique_ptr<CSqlExecData>> vpBatch;
 	for(int JobNum = 0;; JobNum++)
 	{
 		if(FailMode && m_pShared->m_NumWorker.GetApproximateValue() == 0)
@@ -293,77 +410,83 @@ void CWorker::ProcessQueries()
 			m_pShared->m_Shutdown.store(false);
 			return;
 		}
-		bool Success = false;
-		switch(pThreadData->m_Mode)
-		{
-		case CSqlExecData::READ_ACCESS:
+
+		// collect the following batchable writes the backup thread is
+		// already done with, this thread is the only one waiting on
+		// m_NumWorker, so waiting doesn't block if its value is positive
+		if(pThreadData->m_Mode == CSqlExecData::WRITE_ACCESS && pThreadData->m_Batch &&
+			m_pWriteConnection != nullptr && !FailMode && !m_pShared->m_Shutdown)
 		{
-			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+			vpBatch.push_back(std::move(pThreadData));
+			while(vpBatch.size() < MAX_WRITE_BATCH && m_pShared->m_NumWorker.GetApproximateValue() > 0)
 			{
-				if(m_pShared->m_Shutdown)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
-					break;
-				}
-				if(FailMode)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
+				auto &pNext = m_pShared->m_aQueries[(JobNum + 1) % std::size(m_pShared->m_aQueries)];
+				if(pNext == nullptr || pNext->m_Mode != CSqlExecData::WRITE_ACCESS || !pNext->m_Batch)
 					break;
-				}
-				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
-				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
-				{
-					ReadServer = CurServer;
-					dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
-				}
+				m_pShared->m_NumWorker.Wait();
+				vpBatch.push_back(std::move(pNext));
+				JobNum++;
 			}
-			if(!Success)
+			if(vpBatch.size() == 1)
 			{
-				FailMode = true;
+				pThreadData = std::move(vpBatch[0]);
+				vpBatch.clear();
 			}
 		}
-		break;
-		case CSqlExecData::WRITE_ACCESS:
+		if(!vpBatch.empty())
 		{
-			if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
+			if(ExecuteBatch(vpBatch))
 			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, pThreadData->m_pName);
-			}
-			else if(FailMode && m_pWriteBackup != nullptr)
-			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, pThreadData->m_pName);
-			}
-			else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pThreadData.get(), Write::NORMAL))
-			{
-				dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
-				Success = true;
+				dbg_msg("sql", "[%i] %d writes done in one transaction on write database", JobNum, (int)vpBatch.size());
+				m_pShared->m_NumWriteBatches.fetch_add(1);
+				m_pShared->m_NumBatchedWrites.fetch_add(vpBatch.size());
+				for(auto &pData : vpBatch)
+				{
+					if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pData.get(), Write::NORMAL_SUCCEEDED))
+					{
+						dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pData->m_pName);
+					}
+					m_pShared->Complete(pData.get(), true);
+				}
 			}
-			// enter fail mode if not successful
-			FailMode = FailMode || !Success;
-			const Write w = Success ? Write::NORMAL_SUCCEEDED : Write::NORMAL_FAILED;
-			if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData.get(), w))
+			else
 			{
-				dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
-				Success = true;
+				// nothing of the batch got written, find out which write
+				// fails by executing them one by one
+				dbg_msg("sql", "[%i] batch of %d writes failed, retrying them one by one", JobNum, (int)vpBatch.size());
+				for(auto &pData : vpBatch)
+				{
+					bool Success = ProcessWrite(JobNum, pData.get(), &FailMode);
+					if(!Success)
+						dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pData->m_pName);
+					m_pShared->Complete(pData.get(), Success);
+				}
 			}
+			vpBatch.clear();
+			continue;
 		}
-		break;
+
+		bool Success = false;
+		switch(pThreadData->m_Mode)
+		{
+		case CSqlExecData::READ_ACCESS:
+			dbg_assert(false, "read queries are executed by the read workers");
+			break;
+		case CSqlExecData::WRITE_ACCESS:
+			Success = ProcessWrite(JobNum, pThreadData.get(), &FailMode);
+			break;
 		case CSqlExecData::ADD_MYSQL:
 		{
 			auto pMysql = CreateMysqlConnection(pThreadData->m_Ptr.m_MySql.m_Config);
 			switch(pThreadData->m_Ptr.m_MySql.m_Mode)
 			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pMysql));
-				break;
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pMysql);
 				break;
 			case CDbConnectionPool::Mode::WRITE_BACKUP:
 				m_pWriteBackup = std::move(pMysql);
 				break;
+			case CDbConnectionPool::Mode::READ:
 			case CDbConnectionPool::Mode::NUM_MODES:
 				break;
 			}
@@ -375,15 +498,13 @@ void CWorker::ProcessQueries()
 			auto pSqlite = CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_FileName, true);
 			switch(pThreadData->m_Ptr.m_Sqlite.m_Mode)
 			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pSqlite));
-				break;
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pSqlite);
 				break;
 			case CDbConnectionPool::Mode::WRITE_BACKUP:
 				m_pWriteBackup = std::move(pSqlite);
 				break;
+			case CDbConnectionPool::Mode::READ:
 			case CDbConnectionPool::Mode::NUM_MODES:
 				break;
 			}
@@ -397,29 +518,87 @@ void CWorker::ProcessQueries()
 		}
 		if(!Success)
 			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
-		if(pThreadData->m_pThreadData != nullptr && pThreadData->m_pThreadData->m_pResult != nullptr)
-		{
-			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
-			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
-		}
+		m_pShared->Complete(pThreadData.get(), Success);
 	}
 }
 
-void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
+bool CWorker::ProcessWrite(int JobNum, CSqlExecData *pData, bool *pFailMode)
 {
-	if(DatabaseMode == CDbConnectionPool::Mode::READ)
+	bool Success = false;
+	if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
 	{
-		for(auto &pReadConnection : m_vpReadConnections)
-			pReadConnection->Print(pConsole, "Read");
-		if(m_vpReadConnections.empty())
-			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+		dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, pData->m_pName);
+	}
+	else if(*pFailMode && m_pWriteBackup != nullptr)
+	{
+		dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, pData->m_pName);
 	}
-	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
+	else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pData, Write::NORMAL))
+	{
+		dbg_msg("sql", "[%i] %s done on write database", JobNum, pData->m_pName);
+		Success = true;
+	}
+	// enter fail mode if not successful
+	*pFailMode = *pFailMode || !Success;
+	const Write w = Success ? Write::NORMAL_SUCCEEDED : Write::NORMAL_FAILED;
+	if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pData, w))
+	{
+		dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pData->m_pName);
+		Success = true;
+	}
+	return Success;
+}
+
+bool CWorker::ExecuteBatch(const std::vector<std::unique_ptr<CSqlExecData>> &vpBatch)
+{
+	IDbConnection *pConnection = m_pWriteConnection.get();
+	char aError[256] = "unknown error";
+	if(pConnection->Connect(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed connecting to db: %s", aError);
+		return false;
+	}
+	bool Success = !pConnection->BeginTransaction(aError, sizeof(aError));
+	for(const auto &pData : vpBatch)
+	{
+		if(!Success)
+			break;
+		Success = !pData->m_Ptr.m_pWriteFunc(pConnection, pData->m_pThreadData.get(), Write::NORMAL, aError, sizeof(aError));
+		if(!Success)
+			dbg_msg("sql", "%s failed: %s", pData->m_pName, aError);
+	}
+	if(Success)
+	{
+		Success = !pConnection->CommitTransaction(aError, sizeof(aError));
+	}
+	if(!Success)
+	{
+		char aRollbackError[256] = "unknown error";
+		if(pConnection->RollbackTransaction(aRollbackError, sizeof(aRollbackError)))
+			dbg_msg("sql", "rollback failed: %s", aRollbackError);
+	}
+	pConnection->Disconnect();
+	if(!Success)
+	{
+		dbg_msg("sql", "write batch failed: %s", aError);
+	}
+	return Success;
+}
+
+void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
+{
+	if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
 	{
 		if(m_pWriteConnection)
 			m_pWriteConnection->Print(pConsole, "Write");
 		else
 			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no write databases");
+		PrintLatency(pConsole, "Write", m_pShared->m_WriteDepth.load(), m_pShared->m_WriteLatency);
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "Write batches: %llu with %llu writes",
+			(unsigned long long)m_pShared->m_NumWriteBatches.load(),
+			(unsigned long long)m_pShared->m_NumBatchedWrites.load());
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 	}
 	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE_BACKUP)
 	{
@@ -430,6 +609,150 @@ void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 	}
 }
 
+// The read workers execute the read queries in parallel to each other and to
+// the writes, each with its own connection to every read database.
+class CReadWorker
+{
+public:
+	CReadWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared, std::shared_ptr<CDbConnectionPool::CReadQueue> pQueue) :
+		m_pShared(std::move(pShared)), m_pQueue(std::move(pQueue)) {}
+	static void Start(void *pUser);
+	void ProcessQueries();
+
+private:
+	void Print(IConsole *pConsole);
+
+	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+
+	std::shared_ptr<CDbConnectionPool::CSharedData> m_pShared;
+	std::shared_ptr<CDbConnectionPool::CReadQueue> m_pQueue;
+};
+
+/* static */
+void CReadWorker::Start(void *pUser)
+{
+	CReadWorker *pThis = (CReadWorker *)pUser;
+	pThis->ProcessQueries();
+	delete pThis;
+}
+
+void CReadWorker::ProcessQueries()
+{
+	// remember last working server and try to connect to it first
+	int ReadServer = 0;
+	// enter fail mode when a sql request fails, skip read request during it
+	// until all requests of this worker are handled
+	bool FailMode = false;
+	for(int JobNum = 0;; JobNum++)
+	{
+		if(FailMode && m_pQueue->m_NumQueries.GetApproximateValue() == 0)
+		{
+			FailMode = false;
+		}
+		m_pQueue->m_NumQueries.Wait();
+		auto pThreadData = std::move(m_pQueue->m_aQueries[JobNum % std::size(m_pQueue->m_aQueries)]);
+		if(pThreadData == nullptr)
+		{
+			return;
+		}
+		bool Success = false;
+		switch(pThreadData->m_Mode)
+		{
+		case CSqlExecData::READ_ACCESS:
+		{
+			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+			{
+				if(m_pShared->m_Shutdown)
+				{
+					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
+					break;
+				}
+				if(FailMode)
+				{
+					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
+					break;
+				}
+				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
+				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+				{
+					ReadServer = CurServer;
+					dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
+					Success = true;
+					break;
+				}
+			}
+			if(!Success)
+			{
+				FailMode = true;
+			}
+			m_pQueue->m_Depth.fetch_sub(1);
+		}
+		break;
+		case CSqlExecData::ADD_MYSQL:
+			m_vpReadConnections.push_back(CreateMysqlConnection(pThreadData->m_Ptr.m_MySql.m_Config));
+			Success = true;
+			break;
+		case CSqlExecData::ADD_SQLITE:
+			m_vpReadConnections.push_back(CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_FileName, true));
+			Success = true;
+			break;
+		case CSqlExecData::PRINT:
+			Print(pThreadData->m_Ptr.m_Print.m_pConsole);
+			Success = true;
+			break;
+		case CSqlExecData::WRITE_ACCESS:
+			dbg_assert(false, "write queries are executed by the write worker");
+			break;
+		}
+		if(!Success)
+			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
+		m_pShared->Complete(pThreadData.get(), Success);
+	}
+}
+
+void CReadWorker::Print(IConsole *pConsole)
+{
+	for(auto &pReadConnection : m_vpReadConnections)
+		pReadConnection->Print(pConsole, "Read");
+	if(m_vpReadConnections.empty())
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+	PrintLatency(pConsole, "Read", m_pShared->m_ReadDepth.load(), m_pShared->m_ReadLatency);
+}
+
+void CDbConnectionPool::CSharedData::Complete(CSqlExecData *pData, bool Success)
+{
+	int64_t Latency = (time_get_nanoseconds().count() - pData->m_QueueTime) / 1000;
+	if(pData->m_Mode == CSqlExecData::READ_ACCESS)
+	{
+		m_ReadLatency.Record(Latency);
+		m_ReadDepth.fetch_sub(1);
+	}
+	else if(pData->m_Mode == CSqlExecData::WRITE_ACCESS)
+	{
+		m_WriteLatency.Record(Latency);
+		m_WriteDepth.fetch_sub(1);
+	}
+	if(pData->m_pThreadData != nullptr && pData->m_pThreadData->m_pResult != nullptr)
+	{
+		pData->m_pThreadData->m_pResult->m_Success = Success;
+		pData->m_pThreadData->m_pResult->m_Completed.store(true);
+	}
+}
+
+void CDbConnectionPool::StartReadWorkers()
+{
+	if(!m_vpReadQueues.empty())
+		return;
+	for(int i = 0; i < m_NumReadWorkers; i++)
+	{
+		auto pQueue = std::make_shared<CReadQueue>();
+		m_vpReadQueues.push_back(pQueue);
+		for(const auto &pDatabase : m_vpReadDatabases)
+			PushRead(i, CopyAddDatabase(pDatabase.get()));
+		m_vpReadThreads.push_back(thread_init(CReadWorker::Start, new CReadWorker(m_pShared, std::move(pQueue)), "database read worker thread"));
+	}
+}
+
 /* static */
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, Write w)
 {
@@ -478,4 +801,6 @@ CDbConnectionPool::~CDbConnectionPool()
 		thread_wait(m_pWorkerThread);
 	if(m_pBackupThread)
 		thread_wait(m_pBackupThread);
+	for(void *pReadThread : m_vpReadThreads)
+		thread_wait(pReadThread);
 }
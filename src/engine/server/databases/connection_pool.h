@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <base/tl/threading.h>
+#include <engine/shared/tick_profiler.h>
 #include <memory>
 #include <vector>
 
@@ -78,6 +79,11 @@ public:
 
 	void Print(IConsole *pConsole, Mode DatabaseMode);
 
+	// Number of threads executing read queries in parallel, each with its
+	// own connections to the read databases. Only has an effect before the
+	// first read query.
+	void SetNumReadWorkers(int NumReadWorkers);
+
 	void RegisterSqliteDatabase(Mode DatabaseMode, const char FileName[64]);
 	void RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig);
 
@@ -86,20 +92,28 @@ public:
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
 	// writes to WRITE_BACKUP first and removes it from there when successfully
-	// executed on WRITE server
+	// executed on WRITE server. Consecutive queries with `Batch` set are
+	// executed in one transaction on the WRITE server, so `pFunc` must not
+	// start transactions itself.
 	void ExecuteWrite(
 		FWrite pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
-		const char *pName);
+		const char *pName,
+		bool Batch);
 
 	void OnShutdown();
 
 	friend class CWorker;
 	friend class CBackup;
+	friend class CReadWorker;
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
 
+	void Push(std::unique_ptr<struct CSqlExecData> pData);
+	void PushRead(int Worker, std::unique_ptr<struct CSqlExecData> pData);
+	void StartReadWorkers();
+
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
 	int m_InsertIdx = 0;
@@ -123,11 +137,42 @@ private:
 
 		// spsc queue with additional backup worker to look at queries first.
 		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+
+		// Statistics shown by dump_sqlservers. The depth counts the read or
+		// write queries that are queued or running, the latency is measured
+		// from queueing the query until it completed.
+		std::atomic_int m_ReadDepth{0};
+		std::atomic_int m_WriteDepth{0};
+		CTickHistogram m_ReadLatency;
+		CTickHistogram m_WriteLatency;
+		std::atomic<uint64_t> m_NumWriteBatches{0};
+		std::atomic<uint64_t> m_NumBatchedWrites{0};
+
+		// Records the statistics and hands the result to the main thread.
+		void Complete(struct CSqlExecData *pData, bool Success);
+	};
+
+	// spsc queue of one read worker, read queries go to the worker with the
+	// fewest queries queued
+	struct CReadQueue
+	{
+		CSemaphore m_NumQueries;
+		std::atomic_int m_Depth{0};
+		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+		// only accessed by the main thread
+		int m_InsertIdx = 0;
 	};
 
 	std::shared_ptr<CSharedData> m_pShared;
 	void *m_pWorkerThread = nullptr;
 	void *m_pBackupThread = nullptr;
+
+	int m_NumReadWorkers = 1;
+	std::vector<std::shared_ptr<CReadQueue>> m_vpReadQueues;
+	std::vector<void *> m_vpReadThreads;
+	// read databases registered so far, every new read worker connects to
+	// all of them
+	std::vector<std::unique_ptr<struct CSqlExecData>> m_vpReadDatabases;
 };
 
 #endif // ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
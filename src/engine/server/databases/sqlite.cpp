@@ -5,7 +5,16 @@
 #include <base/math.h>
 #include <engine/console.h>
 
+#include <algorithm>
 #include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Connections to the same database file, e.g. of the read workers, would
+// otherwise set it up at the same time. SQLite returns SQLITE_BUSY without
+// waiting for the busy timeout when two of them create the tables.
+static std::mutex g_SqliteSetupMutex;
 
 class CSqliteConnection : public IDbConnection
 {
@@ -50,6 +59,10 @@ public:
 	// passing a negative buffer size is undefined behavior
 	int GetBlob(int Col, unsigned char *pBuffer, int BufferSize) override;
 
+	bool BeginTransaction(char *pError, int ErrorSize) override;
+	bool CommitTransaction(char *pError, int ErrorSize) override;
+	bool RollbackTransaction(char *pError, int ErrorSize) override;
+
 	bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) override;
 
 	// fail safe
@@ -60,8 +73,22 @@ private:
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	bool m_Setup;
 
+	enum
+	{
+		STMT_CACHE_SIZE = 16,
+	};
+
+	struct CCachedStmt
+	{
+		std::string m_Query;
+		sqlite3_stmt *m_pStmt;
+	};
+
 	sqlite3 *m_pDb;
+	// points into m_vStmtCache
 	sqlite3_stmt *m_pStmt;
+	// prepared statements keyed by their query, most recently used first
+	std::vector<CCachedStmt> m_vStmtCache;
 	bool m_Done; // no more rows available for Step
 	// returns false, if the query succeeded
 	bool Execute(const char *pQuery, char *pError, int ErrorSize);
@@ -88,8 +115,8 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 
 CSqliteConnection::~CSqliteConnection()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	for(auto &CachedStmt : m_vStmtCache)
+		sqlite3_finalize(CachedStmt.m_pStmt);
 	sqlite3_close(m_pDb);
 	m_pDb = nullptr;
 }
@@ -146,6 +173,7 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 
 	if(m_Setup)
 	{
+		std::lock_guard<std::mutex> Lock(g_SqliteSetupMutex);
 		if(Execute("PRAGMA journal_mode=WAL", pError, ErrorSize))
 			return true;
 		char aBuf[1024];
@@ -181,8 +209,10 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 
 void CSqliteConnection::Disconnect()
 {
+	// keep the statement prepared for the next query, resetting it releases
+	// its locks on the database
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+		sqlite3_reset(m_pStmt);
 	m_pStmt = nullptr;
 	m_InUse.store(false);
 }
@@ -190,18 +220,40 @@ void CSqliteConnection::Disconnect()
 bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
 {
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+		sqlite3_reset(m_pStmt);
 	m_pStmt = nullptr;
+
+	auto It = std::find_if(m_vStmtCache.begin(), m_vStmtCache.end(), [pStmt](const CCachedStmt &CachedStmt) {
+		return CachedStmt.m_Query == pStmt;
+	});
+	if(It != m_vStmtCache.end())
+	{
+		std::rotate(m_vStmtCache.begin(), It, It + 1);
+		m_pStmt = m_vStmtCache.front().m_pStmt;
+		// the bound strings and blobs aren't owned by sqlite and might be gone
+		sqlite3_clear_bindings(m_pStmt);
+		m_Done = false;
+		return false;
+	}
+
+	sqlite3_stmt *pNewStmt = nullptr;
 	int Result = sqlite3_prepare_v2(
 		m_pDb,
 		pStmt,
 		-1, // pStmt can be any length
-		&m_pStmt,
+		&pNewStmt,
 		NULL);
 	if(FormatError(Result, pError, ErrorSize))
 	{
 		return true;
 	}
+	if(m_vStmtCache.size() >= STMT_CACHE_SIZE)
+	{
+		sqlite3_finalize(m_vStmtCache.back().m_pStmt);
+		m_vStmtCache.pop_back();
+	}
+	m_vStmtCache.insert(m_vStmtCache.begin(), CCachedStmt{pStmt, pNewStmt});
+	m_pStmt = pNewStmt;
 	m_Done = false;
 	return false;
 }
@@ -385,6 +437,27 @@ void CSqliteConnection::AssertNoError(int Result)
 	}
 }
 
+bool CSqliteConnection::BeginTransaction(char *pError, int ErrorSize)
+{
+	// take the write lock right away, upgrading a read transaction can fail
+	// without waiting for the busy timeout
+	return Execute("BEGIN IMMEDIATE", pError, ErrorSize);
+}
+
+bool CSqliteConnection::CommitTransaction(char *pError, int ErrorSize)
+{
+	if(m_pStmt != nullptr)
+		sqlite3_reset(m_pStmt);
+	return Execute("COMMIT", pError, ErrorSize);
+}
+
+bool CSqliteConnection::RollbackTransaction(char *pError, int ErrorSize)
+{
+	if(m_pStmt != nullptr)
+		sqlite3_reset(m_pStmt);
+	return Execute("ROLLBACK", pError, ErrorSize);
+}
+
 bool CSqliteConnection::AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize)
 {
 	char aBuf[512];
@@ -1,15 +1,69 @@
 #include "name_ban.h"
 
+#include <base/math.h>
 #include <base/system.h>
 
 #include <engine/shared/config.h>
 
+#include <algorithm>
+#include <iterator>
+
+static_assert(MAX_NAME_SKELETON_LENGTH <= 64, "skeletons must fit into the bit masks");
+
 CNameBan::CNameBan(const char *pName, const char *pReason, int Distance, bool IsSubstring) :
 	m_Distance(Distance), m_IsSubstring(IsSubstring)
 {
 	str_copy(m_aName, pName);
 	str_copy(m_aReason, pReason);
 	m_SkeletonLength = str_utf8_to_skeleton(m_aName, m_aSkeleton, std::size(m_aSkeleton));
+
+	std::copy(m_aSkeleton, m_aSkeleton + m_SkeletonLength, m_aSkeletonChars);
+	std::sort(m_aSkeletonChars, m_aSkeletonChars + m_SkeletonLength);
+	m_NumSkeletonChars = std::unique(m_aSkeletonChars, m_aSkeletonChars + m_SkeletonLength) - m_aSkeletonChars;
+	std::fill(m_aSkeletonCharMasks, m_aSkeletonCharMasks + m_NumSkeletonChars, 0);
+	for(int i = 0; i < m_SkeletonLength; i++)
+	{
+		const int Char = std::lower_bound(m_aSkeletonChars, m_aSkeletonChars + m_NumSkeletonChars, m_aSkeleton[i]) - m_aSkeletonChars;
+		m_aSkeletonCharMasks[Char] |= (uint64_t)1 << i;
+	}
+}
+
+int CNameBan::SkeletonDistance(const int *pSkeleton, int SkeletonLength) const
+{
+	if(m_SkeletonLength == 0)
+		return SkeletonLength;
+
+	// Myers' bit-parallel algorithm: one column of the dynamic programming
+	// matrix along the ban's skeleton is kept as vertical deltas in `Pv`
+	// (+1) and `Mv` (-1), updated for a character of the name at once.
+	const uint64_t Last = (uint64_t)1 << (m_SkeletonLength - 1);
+	uint64_t Pv = ~(uint64_t)0;
+	uint64_t Mv = 0;
+	int Score = m_SkeletonLength;
+	for(int i = 0; i < SkeletonLength; i++)
+	{
+		const int *pChar = std::lower_bound(m_aSkeletonChars, m_aSkeletonChars + m_NumSkeletonChars, pSkeleton[i]);
+		const uint64_t Eq = pChar != m_aSkeletonChars + m_NumSkeletonChars && *pChar == pSkeleton[i] ? m_aSkeletonCharMasks[pChar - m_aSkeletonChars] : 0;
+		const uint64_t Xv = Eq | Mv;
+		const uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+		uint64_t Ph = Mv | ~(Xh | Pv);
+		uint64_t Mh = Pv & Xh;
+		if(Ph & Last)
+			Score++;
+		else if(Mh & Last)
+			Score--;
+		// the first row of the matrix grows by one per character
+		Ph = (Ph << 1) | 1;
+		Mh <<= 1;
+		Pv = Mh | ~(Xv | Ph);
+		Mv = Ph & Xv;
+	}
+	return Score;
+}
+
+CNameBans::CNameBans()
+{
+	UpdateIndex();
 }
 
 void CNameBans::InitConsole(IConsole *pConsole)
@@ -36,11 +90,13 @@ void CNameBans::Ban(const char *pName, const char *pReason, const int Distance,
 			str_copy(Ban.m_aReason, pReason);
 			Ban.m_Distance = Distance;
 			Ban.m_IsSubstring = IsSubstring;
+			UpdateIndex();
 			return;
 		}
 	}
 
 	m_vNameBans.emplace_back(pName, pReason, Distance, IsSubstring);
+	UpdateIndex();
 	if(m_pConsole)
 	{
 		char aBuf[256];
@@ -70,6 +126,26 @@ void CNameBans::Unban(const char *pName)
 			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
 		}
 		m_vNameBans.erase(ToRemove, m_vNameBans.end());
+		UpdateIndex();
+	}
+}
+
+void CNameBans::UpdateIndex()
+{
+	for(int Length = 0; Length <= MAX_NAME_SKELETON_LENGTH; Length++)
+	{
+		m_avBansByLength[Length].clear();
+		m_aMaxDistanceByLength[Length] = -1;
+	}
+	m_vSubstringBans.clear();
+
+	for(int i = 0; i < (int)m_vNameBans.size(); i++)
+	{
+		const CNameBan &Ban = m_vNameBans[i];
+		m_avBansByLength[Ban.m_SkeletonLength].push_back(i);
+		m_aMaxDistanceByLength[Ban.m_SkeletonLength] = maximum(m_aMaxDistanceByLength[Ban.m_SkeletonLength], Ban.m_Distance);
+		if(Ban.m_IsSubstring)
+			m_vSubstringBans.push_back(i);
 	}
 }
 
@@ -94,16 +170,29 @@ const CNameBan *CNameBans::IsBanned(const char *pName) const
 
 	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
 	int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
-	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
 
-	const CNameBan *pResult = nullptr;
-	for(const CNameBan &Ban : m_vNameBans)
+	// the last matching ban wins
+	int Result = -1;
+	for(int Length = 0; Length <= MAX_NAME_SKELETON_LENGTH; Length++)
 	{
-		int Distance = str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
-		if(Distance <= Ban.m_Distance || (Ban.m_IsSubstring && str_utf8_find_nocase(pName, Ban.m_aName)))
-			pResult = &Ban;
+		if(absolute(Length - SkeletonLength) > m_aMaxDistanceByLength[Length])
+			continue;
+		for(int Index : m_avBansByLength[Length])
+		{
+			const CNameBan &Ban = m_vNameBans[Index];
+			if(Index > Result && absolute(Length - SkeletonLength) <= Ban.m_Distance && Ban.SkeletonDistance(aSkeleton, SkeletonLength) <= Ban.m_Distance)
+				Result = Index;
+		}
+	}
+	for(auto It = m_vSubstringBans.rbegin(); It != m_vSubstringBans.rend() && *It > Result; ++It)
+	{
+		if(str_utf8_find_nocase(pName, m_vNameBans[*It].m_aName))
+		{
+			Result = *It;
+			break;
+		}
 	}
-	return pResult;
+	return Result == -1 ? nullptr : &m_vNameBans[Result];
 }
 
 void CNameBans::ConNameBan(IConsole::IResult *pResult, void *pUser)
@@ -4,6 +4,7 @@
 #include <engine/console.h>
 #include <engine/shared/protocol.h>
 
+#include <cstdint>
 #include <vector>
 
 enum
@@ -14,6 +15,12 @@ enum
 
 class CNameBan
 {
+	// distinct characters of the skeleton, sorted, and the positions
+	// where they occur as bit masks for the edit distance
+	int m_aSkeletonChars[MAX_NAME_SKELETON_LENGTH];
+	uint64_t m_aSkeletonCharMasks[MAX_NAME_SKELETON_LENGTH];
+	int m_NumSkeletonChars;
+
 public:
 	CNameBan(const char *pName, const char *pReason, int Distance, bool IsSubstring);
 
@@ -23,6 +30,10 @@ public:
 	int m_SkeletonLength;
 	int m_Distance;
 	bool m_IsSubstring;
+
+	// Levenshtein distance between the skeleton of the ban and the given
+	// one, the same as `str_utf32_dist_buffer` returns.
+	int SkeletonDistance(const int *pSkeleton, int SkeletonLength) const;
 };
 
 class CNameBans
@@ -30,11 +41,22 @@ class CNameBans
 	IConsole *m_pConsole = nullptr;
 	std::vector<CNameBan> m_vNameBans;
 
+	// Indices of the bans by skeleton length and the largest distance among
+	// them. The distance is at least the difference of the lengths, so only
+	// lengths close enough to the name's need to be looked at.
+	std::vector<int> m_avBansByLength[MAX_NAME_SKELETON_LENGTH + 1];
+	int m_aMaxDistanceByLength[MAX_NAME_SKELETON_LENGTH + 1];
+	std::vector<int> m_vSubstringBans;
+
+	void UpdateIndex();
+
 	static void ConNameBan(IConsole::IResult *pResult, void *pUser);
 	static void ConNameUnban(IConsole::IResult *pResult, void *pUser);
 	static void ConNameBans(IConsole::IResult *pResult, void *pUser);
 
 public:
+	CNameBans();
+
 	void InitConsole(IConsole *pConsole);
 	void Ban(const char *pName, const char *pReason, const int Distance, const bool IsSubstring);
 	void Unban(const char *pName);
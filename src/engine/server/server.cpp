@@ -17,6 +17,7 @@
 #include <engine/shared/compression.h>
 #include <engine/shared/config.h>
 #include <engine/shared/console.h>
+#include <engine/shared/csv.h>
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
@@ -33,10 +34,15 @@
 #include <engine/shared/protocol_ex.h>
 #include <engine/shared/rust_version.h>
 #include <engine/shared/snapshot.h>
+#include <engine/shared/tick_profiler.h>
 
+#include <engine/external/json-parser/json.h>
+
+#include <game/server/entities/character.h>
 #include <game/server/gamecontext.h>
 #include <game/server/gamemodes/DDRace.h>
 #include <game/server/player.h>
+#include <game/server/teehistorian.h>
 
 #include <game/version.h>
 
@@ -218,6 +224,7 @@ void CServer::CClient::Reset()
 	mem_zero(&m_LatestInput, sizeof(m_LatestInput));
 
 	m_Snapshots.PurgeAll();
+	m_SnapLod.Reset();
 	m_LastAckedSnapshot = -1;
 	m_LastInputTick = -1;
 	m_SnapRate = CClient::SNAPRATE_INIT;
@@ -289,6 +296,8 @@ CServer::~CServer()
 
 	delete m_pRegister;
 	delete m_pConnectionPool;
+	delete m_pTeeHistorianReplay;
+	free(m_pTeeHistorianReplayData);
 }
 
 bool CServer::IsClientNameAvailable(int ClientID, const char *pNameRequest)
@@ -869,6 +878,63 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 	return 0;
 }
 
+int CServer::SendMsgMask(CMsgPacker *pMsg, int Flags, const CClientMask &Mask)
+{
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(CNetChunk));
+	if(Flags & MSGFLAG_VITAL)
+		Packet.m_Flags |= NETSENDFLAG_VITAL;
+	if(Flags & MSGFLAG_FLUSH)
+		Packet.m_Flags |= NETSENDFLAG_FLUSH;
+
+	// packed lazily, some messages only go to clients of one protocol
+	CPacker aPacks[2];
+	int aPacked[2] = {0, 0}; // 0 = not yet, 1 = packed, -1 = can't be sent
+	auto &&GetPack = [&](bool Sixup) -> const CPacker * {
+		if(aPacked[Sixup] == 0)
+			aPacked[Sixup] = RepackMsg(pMsg, aPacks[Sixup], Sixup) ? -1 : 1;
+		return aPacked[Sixup] == 1 ? &aPacks[Sixup] : nullptr;
+	};
+
+	int Result = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!Mask[i])
+			continue;
+
+		const CPacker *pPack = GetPack(m_aClients[i].m_Sixup);
+		if(!pPack)
+		{
+			Result = -1;
+			continue;
+		}
+
+		Packet.m_ClientID = i;
+		Packet.m_pData = pPack->Data();
+		Packet.m_DataSize = pPack->Size();
+		if(Antibot()->OnEngineServerMessage(i, Packet.m_pData, Packet.m_DataSize, Flags))
+			continue;
+
+		if(!(Flags & MSGFLAG_NORECORD) && m_aDemoRecorder[i].IsRecording())
+			m_aDemoRecorder[i].RecordMessage(pPack->Data(), pPack->Size());
+
+		if(!(Flags & MSGFLAG_NOSEND))
+			m_NetServer.Send(&Packet);
+	}
+
+	// the server-wide recorders get the message once, not once per client
+	if(!(Flags & MSGFLAG_NORECORD) && Mask.any() && GetPack(false))
+	{
+		for(int Recorder : {RECORDER_MANUAL, RECORDER_AUTO})
+		{
+			if(m_aDemoRecorder[Recorder].IsRecording())
+				m_aDemoRecorder[Recorder].RecordMessage(aPacks[0].Data(), aPacks[0].Size());
+		}
+	}
+
+	return Result;
+}
+
 void CServer::SendMsgRaw(int ClientID, const void *pData, int Size, int Flags)
 {
 	CNetChunk Packet;
@@ -975,6 +1041,7 @@ void CServer::DoSnapshot()
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
 			char aDeltaData[CSnapshot::MAX_SIZE];
 			int DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+			m_aClients[i].m_SnapLod.OnSnapshotSent(DeltaSize, Config()->m_SvSnapLodBudget);
 
 			if(DeltaSize)
 			{
@@ -1935,280 +2002,48 @@ void CServer::CCache::Clear()
 	m_vCache.clear();
 }
 
-void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
+CServerInfoHeader CServer::ServerInfoHeader(const CServerInfoEntry **ppEntries)
 {
-	pCache->Clear();
-
-	// One chance to improve the protocol!
-	CPacker p;
-	char aBuf[128];
-
-	// count the players
-	int PlayerCount = 0, ClientCount = 0;
 	for(int i = 0; i < MAX_CLIENTS; i++)
-	{
-		if(m_aClients[i].IncludedInServerInfo())
-		{
-			if(GameServer()->IsClientPlayer(i))
-				PlayerCount++;
-
-			ClientCount++;
-		}
-	}
-
-	p.Reset();
-
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
-#define ADD_INT(p, x) \
-	do \
-	{ \
-		str_from_int(x, aBuf); \
-		(p).AddString(aBuf, 0); \
-	} while(0)
-
-	p.AddString(GameServer()->Version(), 32);
-	if(Type != SERVERINFO_VANILLA)
-	{
-		p.AddString(Config()->m_SvName, 256);
-	}
-	else
-	{
-		if(m_NetServer.MaxClients() <= VANILLA_MAX_CLIENTS)
-		{
-			p.AddString(Config()->m_SvName, 64);
-		}
-		else
-		{
-			const int MaxClients = maximum(ClientCount, m_NetServer.MaxClients() - Config()->m_SvReservedSlots);
-			str_format(aBuf, sizeof(aBuf), "%s [%d/%d]", Config()->m_SvName, ClientCount, MaxClients);
-			p.AddString(aBuf, 64);
-		}
-	}
-	p.AddString(GetMapName(), 32);
-
-	if(Type == SERVERINFO_EXTENDED)
-	{
-		ADD_INT(p, m_aCurrentMapCrc[MAP_TYPE_SIX]);
-		ADD_INT(p, m_aCurrentMapSize[MAP_TYPE_SIX]);
-	}
-
-	// gametype
-	p.AddString(GameServer()->GameType(), 16);
-
-	// flags
-	ADD_INT(p, Config()->m_Password[0] ? SERVER_FLAG_PASSWORD : 0);
-
-	int MaxClients = m_NetServer.MaxClients();
-	// How many clients the used serverinfo protocol supports, has to be tracked
-	// separately to make sure we don't subtract the reserved slots from it
-	int MaxClientsProtocol = MAX_CLIENTS;
-	if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-	{
-		if(ClientCount >= VANILLA_MAX_CLIENTS)
-		{
-			if(ClientCount < MaxClients)
-				ClientCount = VANILLA_MAX_CLIENTS - 1;
-			else
-				ClientCount = VANILLA_MAX_CLIENTS;
-		}
-		MaxClientsProtocol = VANILLA_MAX_CLIENTS;
-		if(PlayerCount > ClientCount)
-			PlayerCount = ClientCount;
-	}
-
-	ADD_INT(p, PlayerCount); // num players
-	ADD_INT(p, minimum(MaxClientsProtocol, maximum(MaxClients - maximum(Config()->m_SvSpectatorSlots, Config()->m_SvReservedSlots), PlayerCount))); // max players
-	ADD_INT(p, ClientCount); // num clients
-	ADD_INT(p, minimum(MaxClientsProtocol, maximum(MaxClients - Config()->m_SvReservedSlots, ClientCount))); // max clients
-
-	if(Type == SERVERINFO_EXTENDED)
-		p.AddString("", 0); // extra info, reserved
-
-	const void *pPrefix = p.Data();
-	int PrefixSize = p.Size();
-
-	CPacker q;
-	int ChunksStored = 0;
-	int PlayersStored = 0;
-
-#define SAVE(size) \
-	do \
-	{ \
-		pCache->AddChunk(q.Data(), size); \
-		ChunksStored++; \
-	} while(0)
-
-#define RESET() \
-	do \
-	{ \
-		q.Reset(); \
-		q.AddRaw(pPrefix, PrefixSize); \
-	} while(0)
-
-	RESET();
-
-	if(Type == SERVERINFO_64_LEGACY)
-		q.AddInt(PlayersStored); // offset
-
-	if(!SendClients)
-	{
-		SAVE(q.Size());
-		return;
-	}
-
-	if(Type == SERVERINFO_EXTENDED)
-	{
-		pPrefix = "";
-		PrefixSize = 0;
-	}
-
-	int Remaining;
-	switch(Type)
-	{
-	case SERVERINFO_EXTENDED: Remaining = -1; break;
-	case SERVERINFO_64_LEGACY: Remaining = 24; break;
-	case SERVERINFO_VANILLA: Remaining = VANILLA_MAX_CLIENTS; break;
-	case SERVERINFO_INGAME: Remaining = VANILLA_MAX_CLIENTS; break;
-	default: dbg_assert(0, "caught earlier, unreachable"); return;
-	}
-
-	// Use the following strategy for sending:
-	// For vanilla, send the first 16 players.
-	// For legacy 64p, send 24 players per packet.
-	// For extended, send as much players as possible.
-
-	for(int i = 0; i < MAX_CLIENTS; i++)
-	{
-		if(m_aClients[i].IncludedInServerInfo())
-		{
-			if(Remaining == 0)
-			{
-				if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-					break;
-
-				// Otherwise we're SERVERINFO_64_LEGACY.
-				SAVE(q.Size());
-				RESET();
-				q.AddInt(PlayersStored); // offset
-				Remaining = 24;
-			}
-			if(Remaining > 0)
-			{
-				Remaining--;
-			}
-
-			int PreviousSize = q.Size();
-
-			q.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
-			q.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-
-			ADD_INT(q, m_aClients[i].m_Country); // client country
-
-			int Score;
-			if(m_aClients[i].m_Score.has_value())
-			{
-				Score = m_aClients[i].m_Score.value();
-				if(Score == 9999)
-					Score = -10000;
-				else if(Score == 0) // 0 time isn't displayed otherwise.
-					Score = -1;
-				else
-					Score = -Score;
-			}
-			else
-			{
-				Score = -9999;
-			}
-
-			ADD_INT(q, Score); // client score
-			ADD_INT(q, GameServer()->IsClientPlayer(i) ? 1 : 0); // is player?
-			if(Type == SERVERINFO_EXTENDED)
-				q.AddString("", 0); // extra info, reserved
+		ppEntries[i] = m_aClients[i].IncludedInServerInfo() ? &m_aServerInfoEntries[i] : nullptr;
+
+	CServerInfoHeader Header;
+	Header.m_pVersion = GameServer()->Version();
+	Header.m_pName = Config()->m_SvName;
+	Header.m_pHostname = Config()->m_SvHostname;
+	Header.m_pMapName = GetMapName();
+	Header.m_pGameType = GameServer()->GameType();
+	Header.m_MapCrc = m_aCurrentMapCrc[MAP_TYPE_SIX];
+	Header.m_MapSize = m_aCurrentMapSize[MAP_TYPE_SIX];
+	Header.m_Password = Config()->m_Password[0] != '\0';
+	Header.m_MaxClients = m_NetServer.MaxClients();
+	Header.m_SpectatorSlots = Config()->m_SvSpectatorSlots;
+	Header.m_ReservedSlots = Config()->m_SvReservedSlots;
+	Header.m_SkillLevel = Config()->m_SvSkillLevel;
+	return Header;
+}
 
-			if(Type == SERVERINFO_EXTENDED)
-			{
-				if(q.Size() >= NET_MAX_PAYLOAD - 18) // 8 bytes for type, 10 bytes for the largest token
-				{
-					// Retry current player.
-					i--;
-					SAVE(PreviousSize);
-					RESET();
-					ADD_INT(q, ChunksStored);
-					q.AddString("", 0); // extra info, reserved
-					continue;
-				}
-			}
-			PlayersStored++;
-		}
-	}
+void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
+{
+	pCache->Clear();
 
-	SAVE(q.Size());
-#undef SAVE
-#undef RESET
-#undef ADD_RAW
-#undef ADD_INT
+	const CServerInfoEntry *apEntries[MAX_CLIENTS];
+	const CServerInfoHeader Header = ServerInfoHeader(apEntries);
+	std::vector<std::vector<uint8_t>> vvChunks;
+	ServerInfoPack(vvChunks, Type, Header, apEntries, SendClients);
+	for(const auto &vChunk : vvChunks)
+		pCache->AddChunk(vChunk.data(), vChunk.size());
 }
 
 void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients)
 {
 	pCache->Clear();
 
-	CPacker Packer;
-	Packer.Reset();
-
-	// Could be moved to a separate function and cached
-	// count the players
-	int PlayerCount = 0, ClientCount = 0;
-	for(int i = 0; i < MAX_CLIENTS; i++)
-	{
-		if(m_aClients[i].IncludedInServerInfo())
-		{
-			if(GameServer()->IsClientPlayer(i))
-				PlayerCount++;
-
-			ClientCount++;
-		}
-	}
-
-	char aVersion[32];
-	str_format(aVersion, sizeof(aVersion), "0.7↔%s", GameServer()->Version());
-	Packer.AddString(aVersion, 32);
-	Packer.AddString(Config()->m_SvName, 64);
-	Packer.AddString(Config()->m_SvHostname, 128);
-	Packer.AddString(GetMapName(), 32);
-
-	// gametype
-	Packer.AddString(GameServer()->GameType(), 16);
-
-	// flags
-	int Flags = SERVER_FLAG_TIMESCORE;
-	if(Config()->m_Password[0]) // password set
-		Flags |= SERVER_FLAG_PASSWORD;
-	Packer.AddInt(Flags);
-
-	int MaxClients = m_NetServer.MaxClients();
-	Packer.AddInt(Config()->m_SvSkillLevel); // server skill level
-	Packer.AddInt(PlayerCount); // num players
-	Packer.AddInt(maximum(MaxClients - maximum(Config()->m_SvSpectatorSlots, Config()->m_SvReservedSlots), PlayerCount)); // max players
-	Packer.AddInt(ClientCount); // num clients
-	Packer.AddInt(maximum(MaxClients - Config()->m_SvReservedSlots, ClientCount)); // max clients
-
-	if(SendClients)
-	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
-		{
-			if(m_aClients[i].IncludedInServerInfo())
-			{
-				Packer.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
-				Packer.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-				Packer.AddInt(m_aClients[i].m_Country); // client country
-				Packer.AddInt(m_aClients[i].m_Score.value_or(-1)); // client score
-				Packer.AddInt(GameServer()->IsClientPlayer(i) ? 0 : 1); // flag spectator=1, bot=2 (player=0)
-			}
-		}
-	}
-
-	pCache->AddChunk(Packer.Data(), Packer.Size());
+	const CServerInfoEntry *apEntries[MAX_CLIENTS];
+	const CServerInfoHeader Header = ServerInfoHeader(apEntries);
+	std::vector<uint8_t> vData;
+	ServerInfoPackSixup(vData, Header, apEntries, SendClients);
+	pCache->AddChunk(vData.data(), vData.size());
 }
 
 void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
@@ -2294,6 +2129,15 @@ void CServer::ExpireServerInfo()
 	m_ServerInfoNeedsUpdate = true;
 }
 
+void CServer::UpdateServerInfoEntries()
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_aClients[i].IncludedInServerInfo())
+			m_aServerInfoEntries[i].Update(ClientName(i), ClientClan(i), m_aClients[i].m_Country, m_aClients[i].m_Score, GameServer()->IsClientPlayer(i));
+	}
+}
+
 void CServer::UpdateRegisterServerInfo()
 {
 	// count the players
@@ -2396,6 +2240,7 @@ void CServer::UpdateServerInfo(bool Resend)
 		return;
 
 	UpdateRegisterServerInfo();
+	UpdateServerInfoEntries();
 
 	for(int i = 0; i < 3; i++)
 		for(int j = 0; j < 2; j++)
@@ -2423,6 +2268,7 @@ void CServer::UpdateServerInfo(bool Resend)
 	}
 
 	m_ServerInfoNeedsUpdate = false;
+	m_ServerInfoLastUpdate = time_get();
 }
 
 void CServer::PumpNetwork(bool PacketWaiting)
@@ -2659,6 +2505,382 @@ void CServer::UpdateDebugDummies(bool ForceDisconnect)
 }
 #endif
 
+bool CServer::OpenTeeHistorianReplay()
+{
+	unsigned DataSize;
+	if(!Storage()->ReadFile(Config()->m_SvTeeHistorianReplay, IStorage::TYPE_ALL_OR_ABSOLUTE, &m_pTeeHistorianReplayData, &DataSize))
+	{
+		log_error("replay", "failed to open teehistorian file '%s'", Config()->m_SvTeeHistorianReplay);
+		return false;
+	}
+	m_pTeeHistorianReplay = new CTeeHistorianReader();
+	if(!m_pTeeHistorianReplay->Open(m_pTeeHistorianReplayData, DataSize))
+	{
+		log_error("replay", "failed to read teehistorian file '%s': %s", Config()->m_SvTeeHistorianReplay, m_pTeeHistorianReplay->Error());
+		return false;
+	}
+
+	// restore the non-default server config the recording was made with,
+	// except for settings that only concern the recording server's process
+	static const char *const s_apSkipConfig[] = {"bindaddr", "sv_port", "sv_register", "sv_name", "password", "logfile", "dbg_dummies", "sv_tee_historian", "sv_tee_historian_replay", "sv_tee_historian_replay_profile"};
+	const json_value *pConfig = json_object_get(m_pTeeHistorianReplay->Header(), "config");
+	if(pConfig->type == json_object)
+	{
+		for(unsigned i = 0; i < pConfig->u.object.length; i++)
+		{
+			const json_value *pValue = pConfig->u.object.values[i].value;
+			if(pValue->type != json_string)
+				continue;
+			const char *pName = pConfig->u.object.values[i].name;
+			if(std::any_of(std::begin(s_apSkipConfig), std::end(s_apSkipConfig), [pName](const char *pSkip) { return str_comp(pName, pSkip) == 0; }))
+				continue;
+			// string settings can be up to 64 KiB (e.g. hidden_skins), escaping may double them
+			const char *pStr = json_string_get(pValue);
+			std::vector<char> vLine(str_length(pName) + 2 * str_length(pStr) + 4);
+			char *pLine = vLine.data();
+			char *pDst = pLine;
+			str_format(pLine, vLine.size(), "%s \"", pName);
+			pDst += str_length(pLine);
+			str_escape(&pDst, pStr, pLine + vLine.size() - 2);
+			str_append(pLine, "\"", vLine.size());
+			Console()->ExecuteLine(pLine);
+		}
+	}
+
+	const char *pMapName = m_pTeeHistorianReplay->HeaderString("map_name");
+	if(pMapName)
+	{
+		str_copy(Config()->m_SvMap, pMapName);
+	}
+
+	// the replay must neither record nor be visible from the outside
+	Config()->m_SvTeeHistorian = 0;
+	str_copy(Config()->m_SvRegister, "0");
+	Config()->m_SvAutoDemoRecord = 0;
+	Config()->m_SvPlayerDemoRecord = 0;
+
+	log_info("replay", "replaying '%s', game_uuid=%s map='%s'", Config()->m_SvTeeHistorianReplay, m_pTeeHistorianReplay->HeaderString("game_uuid"), Config()->m_SvMap);
+	return true;
+}
+
+bool CServer::TeeHistorianReplaySeed(uint64_t aSeed[2]) const
+{
+	if(!m_pTeeHistorianReplay)
+		return false;
+	// "pcg-xsh-rr:%08x%08x:%08x%08x", see `CPrng::Description()`
+	const char *pDescription = m_pTeeHistorianReplay->HeaderString("prng_description");
+	const char *pSeed = pDescription ? str_find(pDescription, ":") : nullptr;
+	char aHex[33] = "";
+	if(pSeed && str_length(pSeed) == 34 && pSeed[17] == ':')
+	{
+		str_copy(aHex, pSeed + 1, 17);
+		str_append(aHex, pSeed + 18);
+	}
+	unsigned char aBytes[16];
+	if(str_hex_decode(aBytes, sizeof(aBytes), aHex))
+	{
+		log_warn("replay", "recording has no usable prng seed, prng_description=%s", pDescription ? pDescription : "");
+		return false;
+	}
+	for(int i = 0; i < 2; i++)
+	{
+		aSeed[i] = 0;
+		for(int b = 0; b < 8; b++)
+			aSeed[i] = (aSeed[i] << 8) | aBytes[i * 8 + b];
+	}
+	return true;
+}
+
+void CServer::RunTeeHistorianReplay()
+{
+	CGameContext *pGameContext = (CGameContext *)GameServer();
+	CTeeHistorianReader *pReader = m_pTeeHistorianReplay;
+
+	const char *pMapSha256 = pReader->HeaderString("map_sha256");
+	char aMapSha256[SHA256_MAXSTRSIZE];
+	sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIX], aMapSha256, sizeof(aMapSha256));
+	if(pMapSha256 && str_comp(pMapSha256, aMapSha256) != 0)
+	{
+		log_warn("replay", "map sha256 differs from the recording, expected=%s got=%s", pMapSha256, aMapSha256);
+	}
+
+	const json_value *pTuning = json_object_get(pReader->Header(), "tuning");
+	if(pTuning->type == json_object)
+	{
+		for(unsigned i = 0; i < pTuning->u.object.length; i++)
+		{
+			const json_value *pValue = pTuning->u.object.values[i].value;
+			if(pValue->type != json_string)
+				continue;
+			char aLine[256];
+			str_format(aLine, sizeof(aLine), "tune %s %.2f", pTuning->u.object.values[i].name, str_toint(json_string_get(pValue)) / 100.0f);
+			Console()->ExecuteLine(aLine);
+		}
+	}
+
+	IOHANDLE ProfileFile = 0;
+	if(Config()->m_SvTeeHistorianReplayProfile[0] != '\0')
+	{
+		ProfileFile = Storage()->OpenFile(Config()->m_SvTeeHistorianReplayProfile, IOFLAG_WRITE, IStorage::TYPE_SAVE_OR_ABSOLUTE);
+		if(!ProfileFile)
+		{
+			log_error("replay", "failed to open profile file '%s'", Config()->m_SvTeeHistorianReplayProfile);
+		}
+		else
+		{
+			const char *apColumns[] = {"tick", "input_us", "tick_us", "snap_us", "players", "diverged"};
+			CsvWrite(ProfileFile, std::size(apColumns), apColumns);
+		}
+	}
+
+	// positions as recorded after the last tick, see `CGameContext::OnTick`
+	struct CExpectedPlayer
+	{
+		bool m_Alive;
+		int m_X;
+		int m_Y;
+	};
+	CExpectedPlayer aExpected[MAX_CLIENTS] = {};
+	bool aHaveInput[MAX_CLIENTS] = {};
+	int aaInputs[MAX_CLIENTS][MAX_INPUT_SIZE] = {};
+
+	int NumTicks = 0;
+	int NumDivergedTicks = 0;
+	int64_t TotalInput = 0;
+	int64_t TotalTick = 0;
+	int64_t TotalSnap = 0;
+	int64_t MaxTick = 0;
+	int MaxTickTick = 0;
+
+	const auto &&CheckPositions = [&]() {
+		int Diverged = 0;
+		for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
+		{
+			CNetObj_CharacterCore Core;
+			CPlayer *pPlayer = pGameContext->m_apPlayers[ClientID];
+			bool Alive = pPlayer && pPlayer->GetCharacter();
+			if(Alive)
+			{
+				pPlayer->GetCharacter()->GetCore().Write(&Core);
+			}
+			const CExpectedPlayer &Expected = aExpected[ClientID];
+			if(Alive == Expected.m_Alive && (!Alive || (Core.m_X == Expected.m_X && Core.m_Y == Expected.m_Y)))
+				continue;
+			if(NumDivergedTicks < 20)
+			{
+				log_warn("replay", "tick=%d cid=%d diverged, expected=%s(%d, %d) got=%s(%d, %d)",
+					Tick(), ClientID,
+					Expected.m_Alive ? "alive" : "dead", Expected.m_X, Expected.m_Y,
+					Alive ? "alive" : "dead", Alive ? Core.m_X : 0, Alive ? Core.m_Y : 0);
+			}
+			Diverged++;
+		}
+		if(Diverged)
+		{
+			NumDivergedTicks++;
+		}
+		return Diverged;
+	};
+
+	int64_t aTimes[3];
+	int NumPlayers = 0;
+	const auto &&SimulateTick = [&]() {
+		int64_t Start = time_get();
+		for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
+		{
+			if(m_aClients[ClientID].m_State == CClient::STATE_INGAME)
+				GameServer()->OnClientPredictedEarlyInput(ClientID, aHaveInput[ClientID] ? aaInputs[ClientID] : nullptr);
+		}
+		m_CurrentGameTick++;
+		NumPlayers = 0;
+		for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
+		{
+			if(m_aClients[ClientID].m_State != CClient::STATE_INGAME)
+				continue;
+			GameServer()->OnClientPredictedInput(ClientID, aHaveInput[ClientID] ? aaInputs[ClientID] : nullptr);
+			NumPlayers++;
+		}
+		int64_t InputEnd = time_get();
+		GameServer()->OnTick();
+		int64_t TickEnd = time_get();
+		if(Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0)
+		{
+			DoSnapshot();
+			// replayed clients acknowledge every snapshot right away
+			for(auto &Client : m_aClients)
+			{
+				if(Client.m_State == CClient::STATE_INGAME)
+					Client.m_LastAckedSnapshot = m_CurrentGameTick;
+			}
+		}
+		int64_t SnapEnd = time_get();
+
+		aTimes[0] = InputEnd - Start;
+		aTimes[1] = TickEnd - InputEnd;
+		aTimes[2] = SnapEnd - TickEnd;
+		TotalInput += aTimes[0];
+		TotalTick += aTimes[1];
+		TotalSnap += aTimes[2];
+		if(aTimes[1] > MaxTick)
+		{
+			MaxTick = aTimes[1];
+			MaxTickTick = Tick();
+		}
+		NumTicks++;
+	};
+
+	const auto &&FinishTick = [&]() {
+		int Diverged = CheckPositions();
+		if(ProfileFile)
+		{
+			char aaBuf[6][16];
+			str_format(aaBuf[0], sizeof(aaBuf[0]), "%d", Tick());
+			for(int i = 0; i < 3; i++)
+				str_format(aaBuf[i + 1], sizeof(aaBuf[i + 1]), "%d", (int)(aTimes[i] * 1000000 / time_freq()));
+			str_format(aaBuf[4], sizeof(aaBuf[4]), "%d", NumPlayers);
+			str_format(aaBuf[5], sizeof(aaBuf[5]), "%d", Diverged);
+			const char *apColumns[] = {aaBuf[0], aaBuf[1], aaBuf[2], aaBuf[3], aaBuf[4], aaBuf[5]};
+			CsvWrite(ProfileFile, std::size(apColumns), apColumns);
+		}
+	};
+
+	int64_t ReplayStart = time_get();
+	bool InPlayers = false;
+	CTeeHistorianReader::CItem Item;
+	while(m_RunServer < STOPPING && !IsInterrupted() && pReader->Read(&Item))
+	{
+		if(Item.m_Type != CTeeHistorianReader::ITEM_PLAYER && Item.m_Type != CTeeHistorianReader::ITEM_PLAYER_DEAD && InPlayers)
+		{
+			// all position records of the recorded tick are known now
+			FinishTick();
+			InPlayers = false;
+		}
+
+		switch(Item.m_Type)
+		{
+		case CTeeHistorianReader::ITEM_TICK:
+			// ticks that were not recorded did not change any position
+			while(Tick() < Item.m_Tick - 1 && m_RunServer < STOPPING)
+			{
+				SimulateTick();
+				FinishTick();
+			}
+			if(Tick() < Item.m_Tick)
+			{
+				SimulateTick();
+				InPlayers = true;
+			}
+			break;
+		case CTeeHistorianReader::ITEM_PLAYER:
+			aExpected[Item.m_ClientID].m_Alive = true;
+			aExpected[Item.m_ClientID].m_X = Item.m_X;
+			aExpected[Item.m_ClientID].m_Y = Item.m_Y;
+			break;
+		case CTeeHistorianReader::ITEM_PLAYER_DEAD:
+			aExpected[Item.m_ClientID].m_Alive = false;
+			break;
+		case CTeeHistorianReader::ITEM_INPUT:
+			// recorded inputs are applied in the following tick
+			mem_zero(aaInputs[Item.m_ClientID], sizeof(aaInputs[Item.m_ClientID]));
+			mem_copy(aaInputs[Item.m_ClientID], &Item.m_Input, sizeof(Item.m_Input));
+			aHaveInput[Item.m_ClientID] = true;
+			if(m_aClients[Item.m_ClientID].m_State >= CClient::STATE_READY)
+			{
+				GameServer()->OnClientPrepareInput(Item.m_ClientID, aaInputs[Item.m_ClientID]);
+				if(m_aClients[Item.m_ClientID].m_State == CClient::STATE_INGAME)
+					GameServer()->OnClientDirectInput(Item.m_ClientID, aaInputs[Item.m_ClientID]);
+			}
+			break;
+		case CTeeHistorianReader::ITEM_MESSAGE:
+		{
+			if(m_aClients[Item.m_ClientID].m_State < CClient::STATE_READY)
+				break;
+			CUnpacker Unpacker;
+			Unpacker.Reset(Item.m_pData, Item.m_DataSize);
+			int MsgID = Unpacker.GetInt();
+			// only game messages are recorded
+			if(!Unpacker.Error() && (MsgID & 1) == 0)
+				GameServer()->OnMessage(MsgID >> 1, &Unpacker, Item.m_ClientID);
+			break;
+		}
+		case CTeeHistorianReader::ITEM_JOIN:
+			if(m_aClients[Item.m_ClientID].m_State != CClient::STATE_EMPTY)
+				DelClientCallback(Item.m_ClientID, "rejoin", this);
+			// the network handshake is not recorded, connect right away
+			NewClientCallback(Item.m_ClientID, this, Item.m_Protocol == CTeeHistorian::PROTOCOL_7);
+			m_aClients[Item.m_ClientID].m_DebugDummy = true;
+			m_aClients[Item.m_ClientID].m_State = CClient::STATE_READY;
+			aHaveInput[Item.m_ClientID] = false;
+			GameServer()->OnClientConnected(Item.m_ClientID, nullptr);
+			break;
+		case CTeeHistorianReader::ITEM_PLAYER_READY:
+			if(m_aClients[Item.m_ClientID].m_State != CClient::STATE_READY)
+				break;
+			m_aClients[Item.m_ClientID].m_State = CClient::STATE_INGAME;
+			m_aClients[Item.m_ClientID].m_SnapRate = CClient::SNAPRATE_FULL;
+			GameServer()->OnClientEnter(Item.m_ClientID);
+			break;
+		case CTeeHistorianReader::ITEM_DROP:
+			if(m_aClients[Item.m_ClientID].m_State != CClient::STATE_EMPTY)
+				DelClientCallback(Item.m_ClientID, Item.m_pString, this);
+			aHaveInput[Item.m_ClientID] = false;
+			break;
+		case CTeeHistorianReader::ITEM_CONSOLE_COMMAND:
+		{
+			// Chat commands, votes and server-side commands are reproduced
+			// by the game itself, only replay rcon commands of players.
+			if(Item.m_ClientID < 0 || (Item.m_FlagMask & CFGFLAG_CHAT) || m_aClients[Item.m_ClientID].m_State == CClient::STATE_EMPTY)
+				break;
+			char aLine[512];
+			str_copy(aLine, Item.m_pString);
+			for(int i = 0; i < Item.m_NumArgs; i++)
+			{
+				// ` "`, a character of the argument and the closing `"` must fit
+				if(str_length(aLine) + 4 >= (int)sizeof(aLine))
+					break;
+				str_append(aLine, " \"");
+				char *pDst = aLine + str_length(aLine);
+				// leaves room for the closing `"`
+				str_escape(&pDst, Item.m_apArgs[i], aLine + sizeof(aLine) - 1);
+				str_append(aLine, "\"");
+			}
+			m_RconClientID = Item.m_ClientID;
+			Console()->ExecuteLineFlag(aLine, CFGFLAG_SERVER, Item.m_ClientID);
+			m_RconClientID = IServer::RCON_CID_SERV;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	if(InPlayers)
+	{
+		FinishTick();
+	}
+	if(pReader->Error()[0] != '\0')
+	{
+		log_error("replay", "stopped reading at tick %d: %s", pReader->Tick(), pReader->Error());
+	}
+
+	int64_t ReplayTime = time_get() - ReplayStart;
+	log_info("replay", "replayed %d ticks in %.3fs (%.0f ticks/s), %d ticks diverged",
+		NumTicks, (float)ReplayTime / time_freq(), NumTicks * (float)time_freq() / maximum<int64_t>(ReplayTime, 1), NumDivergedTicks);
+	if(NumTicks)
+	{
+		log_info("replay", "average per tick: input=%dus tick=%dus snap=%dus, slowest tick=%d (%dus)",
+			(int)(TotalInput * 1000000 / time_freq() / NumTicks),
+			(int)(TotalTick * 1000000 / time_freq() / NumTicks),
+			(int)(TotalSnap * 1000000 / time_freq() / NumTicks),
+			MaxTickTick, (int)(MaxTick * 1000000 / time_freq()));
+	}
+
+	if(ProfileFile)
+	{
+		io_close(ProfileFile);
+	}
+	m_RunServer = STOPPING;
+}
+
 int CServer::Run()
 {
 	if(m_RunServer == UNINITIALIZED)
@@ -2681,6 +2903,11 @@ int CServer::Run()
 	}
 	m_pPersistentData = malloc(GameServer()->PersistentDataSize());
 
+	if(Config()->m_SvTeeHistorianReplay[0] != '\0' && !OpenTeeHistorianReplay())
+	{
+		return -1;
+	}
+
 	// load map
 	if(!LoadMap(Config()->m_SvMap))
 	{
@@ -2688,6 +2915,7 @@ int CServer::Run()
 		return -1;
 	}
 
+	DbPool()->SetNumReadWorkers(Config()->m_SvSqlReadWorkers);
 	if(Config()->m_SvSqliteFile[0] != '\0')
 	{
 		char aFullPath[IO_MAX_PATH_LENGTH];
@@ -2772,7 +3000,11 @@ int CServer::Run()
 		log_info("server", "+-------------------------+");
 	}
 
-	// start game
+	if(m_pTeeHistorianReplay)
+	{
+		RunTeeHistorianReplay();
+	}
+	else // start game
 	{
 		bool NonActive = false;
 		bool PacketWaiting = false;
@@ -2897,12 +3129,17 @@ int CServer::Run()
 
 			while(t > TickStartTime(m_CurrentGameTick + 1))
 			{
-				GameServer()->OnPreTickTeehistorian();
+				CTickProfileScope TickScope(TICK_SECTION_TICK);
+				{
+					CTickProfileScope Scope(TICK_SECTION_TEEHISTORIAN);
+					GameServer()->OnPreTickTeehistorian();
+				}
 
 #ifdef CONF_DEBUG
 				UpdateDebugDummies(false);
 #endif
 
+				CTickProfileScope InputScope(TICK_SECTION_INPUT);
 				for(int c = 0; c < MAX_CLIENTS; c++)
 				{
 					if(m_aClients[c].m_State != CClient::STATE_INGAME)
@@ -2941,8 +3178,12 @@ int CServer::Run()
 					if(!ClientHadInput)
 						GameServer()->OnClientPredictedInput(c, nullptr);
 				}
+				InputScope.Stop();
 
-				GameServer()->OnTick();
+				{
+					CTickProfileScope Scope(TICK_SECTION_GAME);
+					GameServer()->OnTick();
+				}
 				if(ErrorShutdown())
 				{
 					break;
@@ -2953,23 +3194,39 @@ int CServer::Run()
 			if(NewTicks)
 			{
 				if(Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0)
+				{
+					CTickProfileScope Scope(TICK_SECTION_SNAPSHOT);
 					DoSnapshot();
+				}
 
 				UpdateClientRconCommands();
 
 				m_Fifo.Update();
+
+				if(Config()->m_SvPerfFile[0] && time_get() > m_LastPerfFileWrite + Config()->m_SvPerfFileInterval * time_freq())
+					WritePerfFile();
 			}
 
 			// master server stuff
-			m_pRegister->Update();
+			{
+				CTickProfileScope Scope(TICK_SECTION_REGISTER);
+				m_pRegister->Update();
+			}
 
-			if(m_ServerInfoNeedsUpdate)
+			// changes often come in bursts, e.g. scores of many players at once
+			if(m_ServerInfoNeedsUpdate && ServerInfoUpdateDue(time_get(), m_ServerInfoLastUpdate, Config()->m_SvServerInfoUpdateInterval))
 				UpdateServerInfo();
 
-			Antibot()->OnEngineTick();
+			{
+				CTickProfileScope Scope(TICK_SECTION_ANTIBOT);
+				Antibot()->OnEngineTick();
+			}
 
 			if(!NonActive)
+			{
+				CTickProfileScope Scope(TICK_SECTION_NETWORK);
 				PumpNetwork(PacketWaiting);
+			}
 
 			NonActive = true;
 
@@ -3080,6 +3337,43 @@ void CServer::ConKick(IConsole::IResult *pResult, void *pUser)
 		((CServer *)pUser)->Kick(pResult->GetInteger(0), "Kicked by console");
 }
 
+void CServer::ConPerf(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	g_TickProfiler.Summary([](const char *pLine, void *pUserData) {
+		static_cast<CServer *>(pUserData)->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "perf", pLine);
+	},
+		pThis);
+}
+
+void CServer::ConPerfReset(IConsole::IResult *pResult, void *pUser)
+{
+	g_TickProfiler.Reset();
+	static_cast<CServer *>(pUser)->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "perf", "reset tick timings");
+}
+
+void CServer::WritePerfFile()
+{
+	m_LastPerfFileWrite = time_get();
+
+	// write to a temporary file first so scrapers never see a partial file
+	char aTmpFile[IO_MAX_PATH_LENGTH];
+	str_format(aTmpFile, sizeof(aTmpFile), "%s.tmp", Config()->m_SvPerfFile);
+	IOHANDLE File = Storage()->OpenFile(aTmpFile, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		log_error("perf", "failed to open '%s' for writing", aTmpFile);
+		return;
+	}
+	g_TickProfiler.WriteMetrics([](const char *pData, int Size, void *pUserData) {
+		io_write(*static_cast<IOHANDLE *>(pUserData), pData, Size);
+	},
+		&File);
+	io_close(File);
+	if(!Storage()->RenameFile(aTmpFile, Config()->m_SvPerfFile, IStorage::TYPE_SAVE))
+		log_error("perf", "failed to rename '%s' to '%s'", aTmpFile, Config()->m_SvPerfFile);
+}
+
 void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 {
 	char aBuf[1024];
@@ -3802,6 +4096,9 @@ void CServer::RegisterCommands()
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
 
+	Console()->Register("perf", "", CFGFLAG_SERVER, ConPerf, this, "Show the time spent per tick in each part of the server");
+	Console()->Register("perf_reset", "", CFGFLAG_SERVER, ConPerfReset, this, "Reset the tick timings shown by perf");
+
 	Console()->Register("auth_add", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAdd, this, "Add a rcon key");
 	Console()->Register("auth_add_p", "s[ident] s[level] s[hash] s[salt]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAddHashed, this, "Add a prehashed rcon key");
 	Console()->Register("auth_change", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthUpdate, this, "Update a rcon key");
@@ -3858,6 +4155,18 @@ void CServer::SnapSetStaticsize(int ItemType, int Size)
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
 }
 
+bool CServer::SnapHoldItems(int SnappingClient, int ID, int Interval, const int *pTypes, int NumTypes)
+{
+	if(!Config()->m_SvSnapLod || SnappingClient < 0 || SnappingClient >= MAX_CLIENTS)
+		return false;
+
+	// only hold items the client is known to keep receiving deltas for
+	const CClient &Client = m_aClients[SnappingClient];
+	if(Client.m_SnapRate != CClient::SNAPRATE_FULL || !Client.m_Snapshots.m_pLast || Client.m_SnapLod.IsDue(ID, Interval))
+		return false;
+	return m_SnapshotBuilder.CopyItems(Client.m_Snapshots.m_pLast->m_pSnap, ID, pTypes, NumTypes);
+}
+
 CServer *CreateServer() { return new CServer(); }
 
 // DDRace
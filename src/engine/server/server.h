@@ -26,6 +26,7 @@
 #include "antibot.h"
 #include "authmanager.h"
 #include "name_ban.h"
+#include "server_info_entry.h"
 #include "snap_id_pool.h"
 
 #if defined(CONF_UPNP)
@@ -88,6 +89,11 @@ class CServer : public IServer
 	void UpdateDebugDummies(bool ForceDisconnect);
 #endif
 
+	class CTeeHistorianReader *m_pTeeHistorianReplay = nullptr;
+	void *m_pTeeHistorianReplayData = nullptr;
+	bool OpenTeeHistorianReplay();
+	void RunTeeHistorianReplay();
+
 public:
 	class IGameServer *GameServer() { return m_pGameServer; }
 	class CConfig *Config() { return m_pConfig; }
@@ -143,6 +149,7 @@ public:
 		int m_LastAckedSnapshot;
 		int m_LastInputTick;
 		CSnapshotStorage m_Snapshots;
+		CSnapshotLod m_SnapLod;
 
 		CInput m_LatestInput;
 		CInput m_aInputs[200]; // TODO: handle input better
@@ -308,6 +315,7 @@ public:
 
 	int GetClientVersion(int ClientID) const override;
 	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID) override;
+	int SendMsgMask(CMsgPacker *pMsg, int Flags, const CClientMask &Mask) override;
 
 	void DoSnapshot();
 
@@ -356,11 +364,18 @@ public:
 	};
 	CCache m_aServerInfoCache[3 * 2];
 	CCache m_aSixupServerInfoCache[2];
+	CServerInfoEntry m_aServerInfoEntries[MAX_CLIENTS];
 	bool m_ServerInfoNeedsUpdate;
+	int64_t m_ServerInfoLastUpdate = 0;
+
+	int64_t m_LastPerfFileWrite = 0;
+	void WritePerfFile();
 
 	void FillAntibot(CAntibotRoundData *pData) override;
 
 	void ExpireServerInfo() override;
+	void UpdateServerInfoEntries();
+	CServerInfoHeader ServerInfoHeader(const CServerInfoEntry **ppEntries);
 	void CacheServerInfo(CCache *pCache, int Type, bool SendClients);
 	void CacheServerInfoSixup(CCache *pCache, bool SendClients);
 	void SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
@@ -374,6 +389,7 @@ public:
 
 	void ChangeMap(const char *pMap) override;
 	const char *GetMapName() const override;
+	bool TeeHistorianReplaySeed(uint64_t aSeed[2]) const override;
 	int LoadMap(const char *pMapName);
 
 	void SaveDemo(int ClientID, float Time) override;
@@ -405,6 +421,9 @@ public:
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData);
 
+	static void ConPerf(IConsole::IResult *pResult, void *pUser);
+	static void ConPerfReset(IConsole::IResult *pResult, void *pUser);
+
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainCommandAccessUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -431,6 +450,7 @@ public:
 	void SnapFreeID(int ID) override;
 	void *SnapNewItem(int Type, int ID, int Size) override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
+	bool SnapHoldItems(int SnappingClient, int ID, int Interval, const int *pTypes, int NumTypes) override;
 
 	// DDRace
 
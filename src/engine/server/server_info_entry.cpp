@@ -0,0 +1,316 @@
+#include "server_info_entry.h"
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/shared/masterserver.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+
+bool CServerInfoEntry::Update(const char *pName, const char *pClan, int Country, std::optional<int> Score, bool IsPlayer)
+{
+	if(m_Valid && str_comp(m_aName, pName) == 0 && str_comp(m_aClan, pClan) == 0 && m_Country == Country && m_Score == Score && m_IsPlayer == IsPlayer)
+		return false;
+
+	// copied byte for byte, `str_copy` would drop invalid UTF-8 at the end
+	// and the entry would never compare equal again
+	m_Valid = true;
+	mem_copy(m_aName, pName, minimum<int>(str_length(pName) + 1, sizeof(m_aName)));
+	m_aName[sizeof(m_aName) - 1] = '\0';
+	mem_copy(m_aClan, pClan, minimum<int>(str_length(pClan) + 1, sizeof(m_aClan)));
+	m_aClan[sizeof(m_aClan) - 1] = '\0';
+	m_Country = Country;
+	m_Score = Score;
+	m_IsPlayer = IsPlayer;
+
+	int LegacyScore;
+	if(Score.has_value())
+	{
+		LegacyScore = Score.value();
+		if(LegacyScore == 9999)
+			LegacyScore = -10000;
+		else if(LegacyScore == 0) // 0 time isn't displayed otherwise.
+			LegacyScore = -1;
+		else
+			LegacyScore = -LegacyScore;
+	}
+	else
+	{
+		LegacyScore = -9999;
+	}
+
+	char aBuf[16];
+	for(int Format = 0; Format < NUM_FORMATS; Format++)
+	{
+		CPacker Packer;
+		Packer.Reset();
+		Packer.AddString(pName, MAX_NAME_LENGTH); // client name
+		Packer.AddString(pClan, MAX_CLAN_LENGTH); // client clan
+		if(Format == FORMAT_SIXUP)
+		{
+			Packer.AddInt(Country); // client country
+			Packer.AddInt(Score.value_or(-1)); // client score
+			Packer.AddInt(IsPlayer ? 0 : 1); // flag spectator=1, bot=2 (player=0)
+		}
+		else
+		{
+			str_from_int(Country, aBuf);
+			Packer.AddString(aBuf, 0); // client country
+			str_from_int(LegacyScore, aBuf);
+			Packer.AddString(aBuf, 0); // client score
+			str_from_int(IsPlayer ? 1 : 0, aBuf);
+			Packer.AddString(aBuf, 0); // is player?
+			if(Format == FORMAT_EXTENDED)
+				Packer.AddString("", 0); // extra info, reserved
+		}
+		dbg_assert(!Packer.Error() && Packer.Size() <= MAX_SIZE, "server info entry too large");
+		mem_copy(m_aaData[Format], Packer.Data(), Packer.Size());
+		m_aSizes[Format] = Packer.Size();
+	}
+	return true;
+}
+
+static void CountClients(const CServerInfoEntry *const *ppEntries, int *pPlayerCount, int *pClientCount)
+{
+	*pPlayerCount = 0;
+	*pClientCount = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(ppEntries[i])
+		{
+			if(ppEntries[i]->IsPlayer())
+				(*pPlayerCount)++;
+
+			(*pClientCount)++;
+		}
+	}
+}
+
+void ServerInfoPack(std::vector<std::vector<uint8_t>> &vvChunks, int Type, const CServerInfoHeader &Header, const CServerInfoEntry *const *ppEntries, bool SendClients)
+{
+	vvChunks.clear();
+
+	// One chance to improve the protocol!
+	CPacker p;
+	char aBuf[128];
+
+	// count the players
+	int PlayerCount, ClientCount;
+	CountClients(ppEntries, &PlayerCount, &ClientCount);
+
+	p.Reset();
+
+#define ADD_INT(p, x) \
+	do \
+	{ \
+		str_from_int(x, aBuf); \
+		(p).AddString(aBuf, 0); \
+	} while(0)
+
+	p.AddString(Header.m_pVersion, 32);
+	if(Type != SERVERINFO_VANILLA)
+	{
+		p.AddString(Header.m_pName, 256);
+	}
+	else
+	{
+		if(Header.m_MaxClients <= VANILLA_MAX_CLIENTS)
+		{
+			p.AddString(Header.m_pName, 64);
+		}
+		else
+		{
+			const int MaxClients = maximum(ClientCount, Header.m_MaxClients - Header.m_ReservedSlots);
+			str_format(aBuf, sizeof(aBuf), "%s [%d/%d]", Header.m_pName, ClientCount, MaxClients);
+			p.AddString(aBuf, 64);
+		}
+	}
+	p.AddString(Header.m_pMapName, 32);
+
+	if(Type == SERVERINFO_EXTENDED)
+	{
+		ADD_INT(p, Header.m_MapCrc);
+		ADD_INT(p, Header.m_MapSize);
+	}
+
+	// gametype
+	p.AddString(Header.m_pGameType, 16);
+
+	// flags
+	ADD_INT(p, Header.m_Password ? SERVER_FLAG_PASSWORD : 0);
+
+	int MaxClients = Header.m_MaxClients;
+	// How many clients the used serverinfo protocol supports, has to be tracked
+	// separately to make sure we don't subtract the reserved slots from it
+	int MaxClientsProtocol = MAX_CLIENTS;
+	if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
+	{
+		if(ClientCount >= VANILLA_MAX_CLIENTS)
+		{
+			if(ClientCount < MaxClients)
+				ClientCount = VANILLA_MAX_CLIENTS - 1;
+			else
+				ClientCount = VANILLA_MAX_CLIENTS;
+		}
+		MaxClientsProtocol = VANILLA_MAX_CLIENTS;
+		if(PlayerCount > ClientCount)
+			PlayerCount = ClientCount;
+	}
+
+	ADD_INT(p, PlayerCount); // num players
+	ADD_INT(p, minimum(MaxClientsProtocol, maximum(MaxClients - maximum(Header.m_SpectatorSlots, Header.m_ReservedSlots), PlayerCount))); // max players
+	ADD_INT(p, ClientCount); // num clients
+	ADD_INT(p, minimum(MaxClientsProtocol, maximum(MaxClients - Header.m_ReservedSlots, ClientCount))); // max clients
+
+	if(Type == SERVERINFO_EXTENDED)
+		p.AddString("", 0); // extra info, reserved
+
+	const void *pPrefix = p.Data();
+	int PrefixSize = p.Size();
+
+	CPacker q;
+	int ChunksStored = 0;
+	int PlayersStored = 0;
+
+#define SAVE(size) \
+	do \
+	{ \
+		vvChunks.emplace_back(q.Data(), q.Data() + (size)); \
+		ChunksStored++; \
+	} while(0)
+
+#define RESET() \
+	do \
+	{ \
+		q.Reset(); \
+		q.AddRaw(pPrefix, PrefixSize); \
+	} while(0)
+
+	RESET();
+
+	if(Type == SERVERINFO_64_LEGACY)
+		q.AddInt(PlayersStored); // offset
+
+	if(!SendClients)
+	{
+		SAVE(q.Size());
+		return;
+	}
+
+	if(Type == SERVERINFO_EXTENDED)
+	{
+		pPrefix = "";
+		PrefixSize = 0;
+	}
+
+	int Remaining;
+	switch(Type)
+	{
+	case SERVERINFO_EXTENDED: Remaining = -1; break;
+	case SERVERINFO_64_LEGACY: Remaining = 24; break;
+	case SERVERINFO_VANILLA: Remaining = VANILLA_MAX_CLIENTS; break;
+	case SERVERINFO_INGAME: Remaining = VANILLA_MAX_CLIENTS; break;
+	default: dbg_assert(0, "caught earlier, unreachable"); return;
+	}
+
+	// Use the following strategy for sending:
+	// For vanilla, send the first 16 players.
+	// For legacy 64p, send 24 players per packet.
+	// For extended, send as much players as possible.
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(ppEntries[i])
+		{
+			if(Remaining == 0)
+			{
+				if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
+					break;
+
+				// Otherwise we're SERVERINFO_64_LEGACY.
+				SAVE(q.Size());
+				RESET();
+				q.AddInt(PlayersStored); // offset
+				Remaining = 24;
+			}
+			if(Remaining > 0)
+			{
+				Remaining--;
+			}
+
+			int PreviousSize = q.Size();
+
+			const int Format = Type == SERVERINFO_EXTENDED ? CServerInfoEntry::FORMAT_EXTENDED : CServerInfoEntry::FORMAT_VANILLA;
+			q.AddRaw(ppEntries[i]->Data(Format), ppEntries[i]->Size(Format));
+
+			if(Type == SERVERINFO_EXTENDED)
+			{
+				if(q.Size() >= NET_MAX_PAYLOAD - 18) // 8 bytes for type, 10 bytes for the largest token
+				{
+					// Retry current player.
+					i--;
+					SAVE(PreviousSize);
+					RESET();
+					ADD_INT(q, ChunksStored);
+					q.AddString("", 0); // extra info, reserved
+					continue;
+				}
+			}
+			PlayersStored++;
+		}
+	}
+
+	SAVE(q.Size());
+#undef SAVE
+#undef RESET
+#undef ADD_INT
+}
+
+void ServerInfoPackSixup(std::vector<uint8_t> &vData, const CServerInfoHeader &Header, const CServerInfoEntry *const *ppEntries, bool SendClients)
+{
+	CPacker Packer;
+	Packer.Reset();
+
+	// count the players
+	int PlayerCount, ClientCount;
+	CountClients(ppEntries, &PlayerCount, &ClientCount);
+
+	char aVersion[32];
+	str_format(aVersion, sizeof(aVersion), "0.7↔%s", Header.m_pVersion);
+	Packer.AddString(aVersion, 32);
+	Packer.AddString(Header.m_pName, 64);
+	Packer.AddString(Header.m_pHostname, 128);
+	Packer.AddString(Header.m_pMapName, 32);
+
+	// gametype
+	Packer.AddString(Header.m_pGameType, 16);
+
+	// flags
+	int Flags = SERVER_FLAG_TIMESCORE;
+	if(Header.m_Password) // password set
+		Flags |= SERVER_FLAG_PASSWORD;
+	Packer.AddInt(Flags);
+
+	int MaxClients = Header.m_MaxClients;
+	Packer.AddInt(Header.m_SkillLevel); // server skill level
+	Packer.AddInt(PlayerCount); // num players
+	Packer.AddInt(maximum(MaxClients - maximum(Header.m_SpectatorSlots, Header.m_ReservedSlots), PlayerCount)); // max players
+	Packer.AddInt(ClientCount); // num clients
+	Packer.AddInt(maximum(MaxClients - Header.m_ReservedSlots, ClientCount)); // max clients
+
+	if(SendClients)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(ppEntries[i])
+				Packer.AddRaw(ppEntries[i]->Data(CServerInfoEntry::FORMAT_SIXUP), ppEntries[i]->Size(CServerInfoEntry::FORMAT_SIXUP));
+		}
+	}
+
+	vData.assign(Packer.Data(), Packer.Data() + Packer.Size());
+}
+
+bool ServerInfoUpdateDue(int64_t Now, int64_t LastUpdate, int IntervalMs)
+{
+	return Now >= LastUpdate + time_freq() * IntervalMs / 1000;
+}
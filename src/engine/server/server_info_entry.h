@@ -0,0 +1,76 @@
+#ifndef ENGINE_SERVER_SERVER_INFO_ENTRY_H
+#define ENGINE_SERVER_SERVER_INFO_ENTRY_H
+
+#include <engine/shared/protocol.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// The packed entry of one client in the server info responses. It is kept
+// per client and only packed again when the client's info changed, so the
+// server info caches can be rebuilt by concatenating the entries.
+class CServerInfoEntry
+{
+public:
+	enum
+	{
+		FORMAT_VANILLA, // also used by the 64 player legacy and ingame info
+		FORMAT_EXTENDED,
+		FORMAT_SIXUP,
+		NUM_FORMATS,
+
+		MAX_SIZE = 128,
+	};
+
+private:
+	bool m_Valid = false;
+	char m_aName[MAX_NAME_LENGTH];
+	char m_aClan[MAX_CLAN_LENGTH];
+	int m_Country;
+	std::optional<int> m_Score;
+	bool m_IsPlayer;
+
+	unsigned char m_aaData[NUM_FORMATS][MAX_SIZE];
+	int m_aSizes[NUM_FORMATS];
+
+public:
+	// Returns whether the entry had to be packed again.
+	bool Update(const char *pName, const char *pClan, int Country, std::optional<int> Score, bool IsPlayer);
+
+	const unsigned char *Data(int Format) const { return m_aaData[Format]; }
+	int Size(int Format) const { return m_aSizes[Format]; }
+	bool IsPlayer() const { return m_IsPlayer; }
+};
+
+// What the server info responses say about the server itself.
+struct CServerInfoHeader
+{
+	const char *m_pVersion;
+	const char *m_pName;
+	const char *m_pHostname;
+	const char *m_pMapName;
+	const char *m_pGameType;
+	unsigned m_MapCrc;
+	unsigned m_MapSize;
+	bool m_Password;
+	int m_MaxClients;
+	int m_SpectatorSlots;
+	int m_ReservedSlots;
+	int m_SkillLevel;
+};
+
+// Packs the server info of `Type` (one of `SERVERINFO_*`) into `vvChunks`, one
+// chunk per packet without the packet header and token. `ppEntries` holds
+// `MAX_CLIENTS` entries, nullptr for the clients that aren't included in the
+// server info.
+void ServerInfoPack(std::vector<std::vector<uint8_t>> &vvChunks, int Type, const CServerInfoHeader &Header, const CServerInfoEntry *const *ppEntries, bool SendClients);
+// Packs the 0.7 server info into `vData`, like `ServerInfoPack`.
+void ServerInfoPackSixup(std::vector<uint8_t> &vData, const CServerInfoHeader &Header, const CServerInfoEntry *const *ppEntries, bool SendClients);
+
+// Returns whether a server info that changed since the last rebuild at
+// `LastUpdate` is rebuilt at `Now`, so that rebuilds are at least
+// `IntervalMs` apart.
+bool ServerInfoUpdateDue(int64_t Now, int64_t LastUpdate, int IntervalMs);
+
+#endif
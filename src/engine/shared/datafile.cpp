@@ -11,8 +11,11 @@
 
 #include "uuid_manager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <limits>
+#include <thread>
 
 #include <zlib.h>
 
@@ -21,6 +24,10 @@ static const int DEBUG = 0;
 enum
 {
 	OFFSET_UUID_TYPE = 0x8000,
+
+	// below this much data in total, starting threads costs more than
+	// compressing it directly
+	PARALLEL_COMPRESSION_MIN_SIZE = 256 * 1024,
 };
 
 struct CItemEx
@@ -792,26 +799,59 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 	}
 }
 
-void CDataFileWriter::Finish()
+void CDataFileWriter::CompressData(CDataInfo &DataInfo)
+{
+	unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
+	DataInfo.m_pCompressedData = malloc(CompressedSize);
+	const int Result = compress2((Bytef *)DataInfo.m_pCompressedData, &CompressedSize, (Bytef *)DataInfo.m_pUncompressedData, DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
+	DataInfo.m_CompressedSize = CompressedSize;
+	free(DataInfo.m_pUncompressedData);
+	DataInfo.m_pUncompressedData = nullptr;
+	if(Result != Z_OK)
+	{
+		char aError[32];
+		str_format(aError, sizeof(aError), "zlib compression error %d", Result);
+		dbg_assert(false, aError);
+	}
+}
+
+void CDataFileWriter::Finish(int NumThreads)
 {
 	dbg_assert((bool)m_File, "File not open");
 
 	// Compress data. This takes the majority of the time when saving a datafile,
 	// so it's delayed until the end so it can be off-loaded to another thread.
-	for(CDataInfo &DataInfo : m_vDatas)
+	// Every data item is compressed on its own, so they are spread over a few
+	// threads, largest first to even out the load, without changing the output.
+	size_t TotalUncompressedSize = 0;
+	std::vector<int> vDataOrder(m_vDatas.size());
+	for(int i = 0; i < (int)m_vDatas.size(); i++)
 	{
-		unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
-		DataInfo.m_pCompressedData = malloc(CompressedSize);
-		const int Result = compress2((Bytef *)DataInfo.m_pCompressedData, &CompressedSize, (Bytef *)DataInfo.m_pUncompressedData, DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
-		DataInfo.m_CompressedSize = CompressedSize;
-		free(DataInfo.m_pUncompressedData);
-		DataInfo.m_pUncompressedData = nullptr;
-		if(Result != Z_OK)
-		{
-			char aError[32];
-			str_format(aError, sizeof(aError), "zlib compression error %d", Result);
-			dbg_assert(false, aError);
-		}
+		vDataOrder[i] = i;
+		TotalUncompressedSize += m_vDatas[i].m_UncompressedSize;
+	}
+	if(NumThreads <= 0)
+		NumThreads = std::thread::hardware_concurrency();
+	NumThreads = TotalUncompressedSize < PARALLEL_COMPRESSION_MIN_SIZE ? 1 : clamp<int>(NumThreads, 1, m_vDatas.size());
+	if(NumThreads == 1)
+	{
+		for(CDataInfo &DataInfo : m_vDatas)
+			CompressData(DataInfo);
+	}
+	else
+	{
+		std::stable_sort(vDataOrder.begin(), vDataOrder.end(), [&](int a, int b) { return m_vDatas[a].m_UncompressedSize > m_vDatas[b].m_UncompressedSize; });
+		std::atomic<size_t> NextData(0);
+		auto &&CompressNext = [&]() {
+			for(size_t i = NextData++; i < vDataOrder.size(); i = NextData++)
+				CompressData(m_vDatas[vDataOrder[i]]);
+		};
+		std::vector<std::thread> vThreads;
+		for(int i = 1; i < NumThreads; i++)
+			vThreads.emplace_back(CompressNext);
+		CompressNext();
+		for(std::thread &Thread : vThreads)
+			Thread.join();
 	}
 
 	// Calculate total size of items
@@ -121,6 +121,7 @@ private:
 
 	int GetTypeFromIndex(int Index) const;
 	int GetExtendedItemTypeIndex(int Type, const CUuid *pUuid);
+	static void CompressData(CDataInfo &DataInfo);
 
 public:
 	CDataFileWriter();
@@ -140,7 +141,10 @@ public:
 	int AddData(size_t Size, const void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
 	int AddDataSwapped(size_t Size, const void *pData);
 	int AddDataString(const char *pStr);
-	void Finish();
+	// Compresses the data and writes the file. The data is compressed on
+	// up to `NumThreads` threads, or as many as the hardware has if it is 0;
+	// the file is the same in any case.
+	void Finish(int NumThreads = 0);
 };
 
 #endif
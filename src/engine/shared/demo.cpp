@@ -17,6 +17,8 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <algorithm>
+
 const double g_aSpeeds[g_DemoSpeeds] = {0.1, 0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 20.0, 24.0, 28.0, 32.0, 40.0, 48.0, 56.0, 64.0};
 const CUuid SHA256_EXTENSION =
 	{{0x6b, 0xe6, 0xda, 0x4a, 0xce, 0xbd, 0x38, 0x0c,
@@ -469,6 +471,7 @@ void CDemoPlayer::Construct(class CSnapshotDelta *pSnapshotDelta, bool UseVideo)
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_LastSnapshotDataSize = -1;
+	m_SnapshotCacheUses = 0;
 	m_pListener = nullptr;
 	m_UseVideo = UseVideo;
 
@@ -550,6 +553,8 @@ bool CDemoPlayer::ScanFile()
 {
 	const long StartPos = io_tell(m_File);
 	m_vKeyFrames.clear();
+	m_vSeekPoints.clear();
+	m_vSnapshotCache.clear();
 	if(StartPos < 0)
 		return false;
 
@@ -563,6 +568,7 @@ bool CDemoPlayer::ScanFile()
 			return false;
 		}
 
+		const int PreviousTick = ChunkTick;
 		int ChunkType, ChunkSize;
 		const EReadChunkHeaderResult Result = ReadChunkHeader(&ChunkType, &ChunkSize, &ChunkTick);
 		if(Result == CHUNKHEADER_EOF)
@@ -581,6 +587,10 @@ bool CDemoPlayer::ScanFile()
 			{
 				m_vKeyFrames.emplace_back(CurrentPos, ChunkTick);
 			}
+			if(PreviousTick != -1 && (m_vSeekPoints.empty() || ChunkTick - m_vSeekPoints.back().m_Tick >= SEEK_POINT_INTERVAL))
+			{
+				m_vSeekPoints.push_back({CurrentPos, ChunkTick, PreviousTick});
+			}
 
 			if(m_Info.m_Info.m_FirstTick == -1)
 				m_Info.m_Info.m_FirstTick = ChunkTick;
@@ -742,6 +752,10 @@ void CDemoPlayer::DoTick()
 			// check the remaining types
 			if(ChunkType & CHUNKTYPEFLAG_TICKMARKER)
 			{
+				// the last snapshot is only known when playback did not
+				// just start at a keyframe
+				if(m_Info.m_Info.m_CurrentTick != -1)
+					CacheSnapshot(ChunkTick);
 				m_Info.m_NextTick = ChunkTick;
 				break;
 			}
@@ -754,6 +768,48 @@ void CDemoPlayer::DoTick()
 	}
 }
 
+void CDemoPlayer::CacheSnapshot(int Tick)
+{
+	if(m_LastSnapshotDataSize == -1)
+		return;
+
+	const auto SeekPoint = std::lower_bound(m_vSeekPoints.begin(), m_vSeekPoints.end(), Tick, [](const SSeekPoint &Point, int Value) {
+		return Point.m_Tick < Value;
+	});
+	if(SeekPoint == m_vSeekPoints.end() || SeekPoint->m_Tick != Tick)
+		return;
+	const int SeekPointIndex = SeekPoint - m_vSeekPoints.begin();
+
+	SCachedSnapshot *pSlot = nullptr;
+	for(auto &Cached : m_vSnapshotCache)
+	{
+		if(Cached.m_SeekPoint == SeekPointIndex)
+			return;
+		if(!pSlot || Cached.m_LastUsed < pSlot->m_LastUsed)
+			pSlot = &Cached;
+	}
+	if(m_vSnapshotCache.size() < (size_t)MAX_CACHED_SNAPSHOTS)
+		pSlot = &m_vSnapshotCache.emplace_back();
+
+	pSlot->m_SeekPoint = SeekPointIndex;
+	pSlot->m_LastUsed = ++m_SnapshotCacheUses;
+	pSlot->m_vData.assign(m_aLastSnapshotData, m_aLastSnapshotData + m_LastSnapshotDataSize);
+}
+
+const CDemoPlayer::SCachedSnapshot *CDemoPlayer::FindCachedSnapshot(int MaxTick, int MinTick)
+{
+	SCachedSnapshot *pBest = nullptr;
+	for(auto &Cached : m_vSnapshotCache)
+	{
+		const int Tick = m_vSeekPoints[Cached.m_SeekPoint].m_Tick;
+		if(Tick > MinTick && Tick <= MaxTick && (!pBest || Tick > m_vSeekPoints[pBest->m_SeekPoint].m_Tick))
+			pBest = &Cached;
+	}
+	if(pBest)
+		pBest->m_LastUsed = ++m_SnapshotCacheUses;
+	return pBest;
+}
+
 void CDemoPlayer::Pause()
 {
 	m_Info.m_Info.m_Paused = true;
@@ -985,14 +1041,35 @@ int CDemoPlayer::SetPos(int WantedTick)
 	while(KeyFrame > 0 && m_vKeyFrames[KeyFrame].m_Tick > KeyFrameWantedTick)
 		KeyFrame--;
 
-	// seek to the correct key frame
-	if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+	// prefer a snapshot cached during earlier playback that is closer to
+	// the wanted tick than the key frame
+	const SCachedSnapshot *pCached = FindCachedSnapshot(KeyFrameWantedTick, m_vKeyFrames[KeyFrame].m_Tick);
+	if(pCached)
 	{
-		Stop("Error seeking keyframe position");
-		return -1;
+		const SSeekPoint &SeekPoint = m_vSeekPoints[pCached->m_SeekPoint];
+		if(io_seek(m_File, SeekPoint.m_Filepos, IOSEEK_START) != 0)
+		{
+			Stop("Error seeking snapshot position");
+			return -1;
+		}
+
+		// start with the tick before the seek point as the current tick, so
+		// the compressed tick marker can be decoded
+		m_Info.m_NextTick = SeekPoint.m_PreviousTick;
+		m_LastSnapshotDataSize = pCached->m_vData.size();
+		mem_copy(m_aLastSnapshotData, pCached->m_vData.data(), m_LastSnapshotDataSize);
+	}
+	else
+	{
+		// seek to the correct key frame
+		if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+		{
+			Stop("Error seeking keyframe position");
+			return -1;
+		}
+		m_Info.m_NextTick = -1;
 	}
 
-	m_Info.m_NextTick = -1;
 	m_Info.m_Info.m_CurrentTick = -1;
 	m_Info.m_PreviousTick = -1;
 
@@ -106,12 +106,40 @@ private:
 		}
 	};
 
+	enum
+	{
+		// minimum distance between two seek points
+		SEEK_POINT_INTERVAL = SERVER_TICK_SPEED / 2,
+		MAX_CACHED_SNAPSHOTS = 128,
+	};
+
+	// Tick marker at which playback can resume from a cached snapshot
+	// instead of the previous keyframe. `m_PreviousTick` is the tick the
+	// marker is relative to if it is compressed.
+	struct SSeekPoint
+	{
+		long m_Filepos;
+		int m_Tick;
+		int m_PreviousTick;
+	};
+
+	// Last snapshot as it was when reaching a seek point during playback
+	struct SCachedSnapshot
+	{
+		int m_SeekPoint;
+		int64_t m_LastUsed;
+		std::vector<unsigned char> m_vData;
+	};
+
 	class IConsole *m_pConsole;
 	IOHANDLE m_File;
 	long m_MapOffset;
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	char m_aErrorMessage[256];
 	std::vector<SKeyFrame> m_vKeyFrames;
+	std::vector<SSeekPoint> m_vSeekPoints;
+	std::vector<SCachedSnapshot> m_vSnapshotCache;
+	int64_t m_SnapshotCacheUses;
 	CMapInfo m_MapInfo;
 	int m_SpeedIndex;
 
@@ -138,6 +166,8 @@ private:
 	EReadChunkHeaderResult ReadChunkHeader(int *pType, int *pSize, int *pTick);
 	void DoTick();
 	bool ScanFile();
+	void CacheSnapshot(int Tick);
+	const SCachedSnapshot *FindCachedSnapshot(int MaxTick, int MinTick);
 
 	int64_t Time();
 
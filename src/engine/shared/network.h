@@ -89,6 +89,11 @@ enum
 	NET_CTRLMSG_CLOSE = 4,
 
 	NET_CONN_BUFFERSIZE = 1024 * 32,
+	// bounds of the retransmission timeout in milliseconds
+	NET_CONN_RTO_MIN = 200,
+	NET_CONN_RTO_MAX = 1000,
+	// most bytes of vital chunks that are resent in one go
+	NET_CONN_RESEND_BUDGET = NET_MAX_PAYLOAD * 4,
 
 	NET_CONNLIMIT_IPS = 16,
 
@@ -147,6 +152,7 @@ public:
 	int m_Sequence;
 	int64_t m_LastSendTime;
 	int64_t m_FirstSendTime;
+	int m_NumResends;
 };
 
 class CNetPacketConstruct
@@ -227,6 +233,14 @@ private:
 	int64_t m_LastRecvTime;
 	int64_t m_LastSendTime;
 
+	// Round trip time estimate from the acks of chunks that were only sent
+	// once and the resulting retransmission timeout, as TCP does it
+	// (RFC 6298). A smoothed RTT of 0 means there was no sample yet.
+	int64_t m_SmoothedRtt;
+	int64_t m_RttVariance;
+	int64_t m_RetransmitTimeout;
+	bool m_ResendRequested;
+
 	char m_aErrorString[256];
 
 	CNetPacketConstruct m_Construct;
@@ -240,13 +254,14 @@ private:
 	//
 	void ResetStats();
 	void SetError(const char *pString);
-	void AckChunks(int Ack);
+	void AckChunks(int Ack, int64_t Now);
+	void UpdateRtt(int64_t Sample);
 
 	int QueueChunkEx(int Flags, int DataSize, const void *pData, int Sequence);
 	void SendConnect();
 	void SendControl(int ControlMsg, const void *pExtra, int ExtraSize);
 	void ResendChunk(CNetChunkResend *pResend);
-	void Resend();
+	void Resend(int64_t Now);
 
 public:
 	bool m_TimeoutProtected;
@@ -295,6 +310,7 @@ public:
 	// Needed for GotProblems in NetClient
 	int64_t LastRecvTime() const { return m_LastRecvTime; }
 	int64_t ConnectTime() const { return m_LastUpdateTime; }
+	int64_t RetransmitTimeout() const { return m_RetransmitTimeout; }
 
 	int AckSequence() const { return m_Ack; }
 	int SeqSequence() const { return m_Sequence; }
@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "config.h"
 #include "network.h"
+#include <base/math.h>
 #include <base/system.h>
 
 SECURITY_TOKEN ToSecurityToken(unsigned char *pData)
@@ -38,6 +39,11 @@ void CNetConnection::Reset(bool Rejoin)
 	m_LastRecvTime = 0;
 	//m_LastUpdateTime = 0;
 
+	m_SmoothedRtt = 0;
+	m_RttVariance = 0;
+	m_RetransmitTimeout = time_freq() * NET_CONN_RTO_MAX / 1000;
+	m_ResendRequested = false;
+
 	mem_zero(&m_aConnectAddrs, sizeof(m_aConnectAddrs));
 	m_NumConnectAddrs = 0;
 	//mem_zero(&m_PeerAddr, sizeof(m_PeerAddr));
@@ -68,8 +74,9 @@ void CNetConnection::Init(NETSOCKET Socket, bool BlockCloseMsg)
 	mem_zero(m_aErrorString, sizeof(m_aErrorString));
 }
 
-void CNetConnection::AckChunks(int Ack)
+void CNetConnection::AckChunks(int Ack, int64_t Now)
 {
+	int64_t RttSample = -1;
 	while(true)
 	{
 		CNetChunkResend *pResend = m_Buffer.First();
@@ -77,10 +84,34 @@ void CNetConnection::AckChunks(int Ack)
 			break;
 
 		if(CNetBase::IsSeqInBackroom(pResend->m_Sequence, Ack))
+		{
+			// the ack of a resent chunk could belong to any of its sends
+			if(pResend->m_NumResends == 0)
+				RttSample = Now - pResend->m_FirstSendTime;
 			m_Buffer.PopFirst();
+		}
 		else
 			break;
 	}
+
+	if(RttSample >= 0)
+		UpdateRtt(RttSample);
+}
+
+void CNetConnection::UpdateRtt(int64_t Sample)
+{
+	if(m_SmoothedRtt == 0)
+	{
+		m_SmoothedRtt = maximum<int64_t>(Sample, 1);
+		m_RttVariance = Sample / 2;
+	}
+	else
+	{
+		m_RttVariance = (3 * m_RttVariance + absolute(m_SmoothedRtt - Sample)) / 4;
+		m_SmoothedRtt = maximum<int64_t>((7 * m_SmoothedRtt + Sample) / 8, 1);
+	}
+	// a fresh sample also ends the backoff
+	m_RetransmitTimeout = clamp<int64_t>(m_SmoothedRtt + 4 * m_RttVariance, time_freq() * NET_CONN_RTO_MIN / 1000, time_freq() * NET_CONN_RTO_MAX / 1000);
 }
 
 void CNetConnection::SignalResend()
@@ -145,6 +176,7 @@ int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int
 			pResend->m_pData = (unsigned char *)(pResend + 1);
 			pResend->m_FirstSendTime = time_get();
 			pResend->m_LastSendTime = pResend->m_FirstSendTime;
+			pResend->m_NumResends = 0;
 			mem_copy(pResend->m_pData, pData, DataSize);
 		}
 		else
@@ -185,12 +217,28 @@ void CNetConnection::ResendChunk(CNetChunkResend *pResend)
 {
 	QueueChunkEx(pResend->m_Flags | NET_CHUNKFLAG_RESEND, pResend->m_DataSize, pResend->m_pData, pResend->m_Sequence);
 	pResend->m_LastSendTime = time_get();
+	pResend->m_NumResends++;
 }
 
-void CNetConnection::Resend()
+void CNetConnection::Resend(int64_t Now)
 {
+	// The peer drops every chunk after a missing one, so all unacked chunks
+	// are resent, but only those that weren't already resent within the
+	// last round trip, as the peer keeps asking until the gap is filled.
+	// Large resends are spread over several updates.
+	const int64_t MinAge = m_SmoothedRtt ? m_SmoothedRtt : m_RetransmitTimeout;
+	int Budget = NET_CONN_RESEND_BUDGET;
 	for(CNetChunkResend *pResend = m_Buffer.First(); pResend; pResend = m_Buffer.Next(pResend))
+	{
+		if(pResend->m_NumResends > 0 && Now - pResend->m_LastSendTime < MinAge)
+			continue;
+		const int Size = pResend->m_DataSize + NET_MAX_CHUNKHEADERSIZE;
+		if(Size > Budget)
+			return;
+		Budget -= Size;
 		ResendChunk(pResend);
+	}
+	m_ResendRequested = false;
 }
 
 int CNetConnection::Connect(const NETADDR *pAddr, int NumAddrs)
@@ -297,9 +345,9 @@ int CNetConnection::Feed(CNetPacketConstruct *pPacket, NETADDR *pAddr, SECURITY_
 
 	int64_t Now = time_get();
 
-	// check if resend is requested
+	// check if resend is requested, answered once the acks are processed
 	if(pPacket->m_Flags & NET_PACKETFLAG_RESEND)
-		Resend();
+		m_ResendRequested = true;
 
 	//
 	if(pPacket->m_Flags & NET_PACKETFLAG_CONTROL)
@@ -420,9 +468,12 @@ int CNetConnection::Feed(CNetPacketConstruct *pPacket, NETADDR *pAddr, SECURITY_
 	if(State() == NET_CONNSTATE_ONLINE)
 	{
 		m_LastRecvTime = Now;
-		AckChunks(pPacket->m_Ack);
+		AckChunks(pPacket->m_Ack, Now);
 	}
 
+	if(m_ResendRequested)
+		Resend(Now);
+
 	return 1;
 }
 
@@ -465,14 +516,18 @@ int CNetConnection::Update()
 			SetError(aBuf);
 			m_TimeoutSituation = true;
 		}
-		else
+		else if(Now - pResend->m_LastSendTime > m_RetransmitTimeout)
 		{
-			// resend packet if we haven't got it acked in 1 second
-			if(Now - pResend->m_LastSendTime > time_freq())
-				ResendChunk(pResend);
+			// not acked in time, resend everything that is overdue and back
+			// off until the next round trip can be measured
+			m_ResendRequested = true;
+			m_RetransmitTimeout = minimum<int64_t>(2 * m_RetransmitTimeout, time_freq() * NET_CONN_RTO_MAX / 1000);
 		}
 	}
 
+	if(m_ResendRequested)
+		Resend(Now);
+
 	// send keep alives if nothing has happened for 250ms
 	if(State() == NET_CONNSTATE_ONLINE)
 	{
@@ -517,6 +572,11 @@ void CNetConnection::SetTimedOut(const NETADDR *pAddr, int Sequence, int Ack, SE
 	m_SecurityToken = SecurityToken;
 	m_Sixup = Sixup;
 
+	m_SmoothedRtt = 0;
+	m_RttVariance = 0;
+	m_RetransmitTimeout = time_freq() * NET_CONN_RTO_MAX / 1000;
+	m_ResendRequested = false;
+
 	// copy resend buffer
 	m_Buffer.Init();
 	while(pResendBuffer->First())
@@ -525,6 +585,7 @@ void CNetConnection::SetTimedOut(const NETADDR *pAddr, int Sequence, int Ack, SE
 
 		CNetChunkResend *pResend = m_Buffer.Allocate(sizeof(CNetChunkResend) + pFirst->m_DataSize);
 		mem_copy(pResend, pFirst, sizeof(CNetChunkResend) + pFirst->m_DataSize);
+		pResend->m_pData = (unsigned char *)(pResend + 1);
 
 		pResendBuffer->PopFirst();
 	}
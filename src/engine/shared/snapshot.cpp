@@ -4,7 +4,9 @@
 #include "compression.h"
 #include "uuid_manager.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
 #include <limits>
 
 #include <base/math.h>
@@ -14,6 +16,16 @@
 
 // CSnapshot
 
+// Type of the items that the given NETOBJTYPE_EX item names.
+static int ExternalItemType(const CSnapshotItem *pTypeItem)
+{
+	CUuid Uuid;
+	for(size_t i = 0; i < sizeof(CUuid) / sizeof(int32_t); i++)
+		uint_to_bytes_be(&Uuid.m_aData[i * sizeof(int32_t)], pTypeItem->Data()[i]);
+
+	return g_UuidManager.LookupUuid(Uuid);
+}
+
 const CSnapshotItem *CSnapshot::GetItem(int Index) const
 {
 	return (const CSnapshotItem *)(DataStart() + Offsets()[Index]);
@@ -46,12 +58,7 @@ int CSnapshot::GetExternalItemType(int InternalType) const
 	{
 		return InternalType;
 	}
-	const CSnapshotItem *pTypeItem = GetItem(TypeItemIndex);
-	CUuid Uuid;
-	for(size_t i = 0; i < sizeof(CUuid) / sizeof(int32_t); i++)
-		uint_to_bytes_be(&Uuid.m_aData[i * sizeof(int32_t)], pTypeItem->Data()[i]);
-
-	return g_UuidManager.LookupUuid(Uuid);
+	return ExternalItemType(GetItem(TypeItemIndex));
 }
 
 int CSnapshot::GetItemIndex(int Key) const
@@ -66,6 +73,12 @@ int CSnapshot::GetItemIndex(int Key) const
 }
 
 const void *CSnapshot::FindItem(int Type, int ID) const
+{
+	int Index = FindItemIndex(Type, ID);
+	return Index < 0 ? nullptr : GetItem(Index)->Data();
+}
+
+int CSnapshot::FindItemIndex(int Type, int ID) const
 {
 	int InternalType = Type;
 	if(Type >= OFFSET_UUID)
@@ -91,11 +104,10 @@ const void *CSnapshot::FindItem(int Type, int ID) const
 		}
 		if(!Found)
 		{
-			return nullptr;
+			return -1;
 		}
 	}
-	int Index = GetItemIndex((InternalType << 16) | ID);
-	return Index < 0 ? nullptr : GetItem(Index)->Data();
+	return GetItemIndex((InternalType << 16) | ID);
 }
 
 unsigned CSnapshot::Crc() const
@@ -146,6 +158,140 @@ bool CSnapshot::IsValid(size_t ActualSize) const
 	return true;
 }
 
+// CSnapshotDirectory
+
+static_assert(2 * CSnapshot::MAX_ITEMS <= 1 << 11, "snapshot directory hash is too small");
+
+void CSnapshotDirectory::Clear()
+{
+	m_pSnapshot = nullptr;
+	m_NumTypes = 0;
+	m_NumUuidTypes = 0;
+	for(auto &Index : m_aHashIndices)
+		Index = -1;
+}
+
+void CSnapshotDirectory::Build(const CSnapshot *pSnapshot)
+{
+	Clear();
+	dbg_assert(pSnapshot->NumItems() <= CSnapshot::MAX_ITEMS, "too many snapshot items");
+	m_pSnapshot = pSnapshot;
+	const int NumItems = pSnapshot->NumItems();
+
+	// the first item wins for duplicate keys, like in the linear search
+	for(int i = 0; i < NumItems; i++)
+	{
+		const int Key = pSnapshot->GetItem(i)->Key();
+		unsigned Slot = HashKey(Key);
+		while(m_aHashIndices[Slot] != -1 && m_aHashKeys[Slot] != Key)
+			Slot = (Slot + 1) & (HASH_SIZE - 1);
+		if(m_aHashIndices[Slot] == -1)
+		{
+			m_aHashKeys[Slot] = Key;
+			m_aHashIndices[Slot] = i;
+		}
+	}
+
+	// extended item types, the first type item for an uuid wins
+	int aInternalTypes[CSnapshot::MAX_ITEMS];
+	int aExternalTypes[CSnapshot::MAX_ITEMS];
+	int NumExtendedTypes = 0;
+	for(int i = 0; i < NumItems; i++)
+	{
+		const CSnapshotItem *pItem = pSnapshot->GetItem(i);
+		if(pItem->Type() != 0 || pItem->ID() < CSnapshot::OFFSET_UUID_TYPE || GetItemIndex(pItem->ID()) != i || pSnapshot->GetItemSize(i) < (int)sizeof(CUuid))
+			continue;
+		const int Type = ExternalItemType(pItem);
+		aInternalTypes[NumExtendedTypes] = pItem->ID();
+		aExternalTypes[NumExtendedTypes] = Type;
+		NumExtendedTypes++;
+		bool Known = false;
+		for(int j = 0; j < m_NumUuidTypes && !Known; j++)
+			Known = m_aUuidTypes[j].m_Type == Type;
+		if(!Known && Type >= OFFSET_UUID)
+			m_aUuidTypes[m_NumUuidTypes++] = {Type, pItem->ID()};
+	}
+
+	// group the item indices by type
+	int aItemTypes[CSnapshot::MAX_ITEMS];
+	for(int i = 0; i < NumItems; i++)
+	{
+		int Type = pSnapshot->GetItem(i)->Type();
+		if(Type >= CSnapshot::OFFSET_UUID_TYPE)
+		{
+			for(int j = 0; j < NumExtendedTypes; j++)
+			{
+				if(aInternalTypes[j] == Type)
+				{
+					Type = aExternalTypes[j];
+					break;
+				}
+			}
+		}
+		aItemTypes[i] = Type;
+		m_aTypeIndices[i] = i;
+	}
+	std::stable_sort(m_aTypeIndices, m_aTypeIndices + NumItems, [&](int a, int b) { return aItemTypes[a] < aItemTypes[b]; });
+	for(int i = 0; i < NumItems; i++)
+	{
+		const int Type = aItemTypes[m_aTypeIndices[i]];
+		if(m_NumTypes == 0 || m_aTypeRanges[m_NumTypes - 1].m_Type != Type)
+			m_aTypeRanges[m_NumTypes++] = {Type, i, 0};
+		m_aTypeRanges[m_NumTypes - 1].m_Num++;
+	}
+}
+
+int CSnapshotDirectory::GetItemIndex(int Key) const
+{
+	unsigned Slot = HashKey(Key);
+	while(m_aHashIndices[Slot] != -1)
+	{
+		if(m_aHashKeys[Slot] == Key)
+			return m_aHashIndices[Slot];
+		Slot = (Slot + 1) & (HASH_SIZE - 1);
+	}
+	return -1;
+}
+
+int CSnapshotDirectory::FindItemIndex(int Type, int ID) const
+{
+	int InternalType = Type;
+	if(Type >= OFFSET_UUID)
+	{
+		InternalType = -1;
+		for(int i = 0; i < m_NumUuidTypes; i++)
+		{
+			if(m_aUuidTypes[i].m_Type == Type)
+			{
+				InternalType = m_aUuidTypes[i].m_InternalType;
+				break;
+			}
+		}
+		if(InternalType == -1)
+			return -1;
+	}
+	return GetItemIndex((InternalType << 16) | ID);
+}
+
+const void *CSnapshotDirectory::FindItem(int Type, int ID) const
+{
+	int Index = FindItemIndex(Type, ID);
+	return Index < 0 ? nullptr : m_pSnapshot->GetItem(Index)->Data();
+}
+
+int CSnapshotDirectory::ItemsOfType(int Type, const int **ppIndices) const
+{
+	const CTypeRange *pEnd = m_aTypeRanges + m_NumTypes;
+	const CTypeRange *pRange = std::lower_bound(m_aTypeRanges, pEnd, Type, [](const CTypeRange &Range, int Value) { return Range.m_Type < Value; });
+	if(pRange == pEnd || pRange->m_Type != Type)
+	{
+		*ppIndices = nullptr;
+		return 0;
+	}
+	*ppIndices = m_aTypeIndices + pRange->m_Start;
+	return pRange->m_Num;
+}
+
 // CSnapshotDelta
 
 enum
@@ -469,6 +615,7 @@ void CSnapshotStorage::PurgeAll()
 		CHolder *pNext = m_pFirst->m_pNext;
 		free(m_pFirst->m_pSnap);
 		free(m_pFirst->m_pAltSnap);
+		delete m_pFirst->m_pAltDirectory;
 		free(m_pFirst);
 		m_pFirst = pNext;
 	}
@@ -486,6 +633,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 			return; // no more to remove
 		free(pHolder->m_pSnap);
 		free(pHolder->m_pAltSnap);
+		delete pHolder->m_pAltDirectory;
 		free(pHolder);
 
 		// did we come to the end of the list?
@@ -520,11 +668,14 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 		pHolder->m_pAltSnap = static_cast<CSnapshot *>(malloc(AltDataSize));
 		mem_copy(pHolder->m_pAltSnap, pAltData, AltDataSize);
 		pHolder->m_AltSnapSize = AltDataSize;
+		pHolder->m_pAltDirectory = new CSnapshotDirectory();
+		pHolder->m_pAltDirectory->Build(pHolder->m_pAltSnap);
 	}
 	else
 	{
 		pHolder->m_pAltSnap = nullptr;
 		pHolder->m_AltSnapSize = 0;
+		pHolder->m_pAltDirectory = nullptr;
 	}
 
 	// link
@@ -593,6 +744,31 @@ int *CSnapshotBuilder::GetItemData(int Key)
 	return nullptr;
 }
 
+bool CSnapshotBuilder::CopyItems(const CSnapshot *pFrom, int ID, const int *pTypes, int NumTypes)
+{
+	// item types of 0.7 snapshots are already translated and can't be looked up again
+	if(m_Sixup)
+		return false;
+
+	int aIndices[8];
+	dbg_assert(NumTypes <= (int)std::size(aIndices), "too many item types");
+	for(int i = 0; i < NumTypes; i++)
+	{
+		aIndices[i] = pFrom->FindItemIndex(pTypes[i], ID);
+		if(aIndices[i] < 0)
+			return false;
+	}
+	for(int i = 0; i < NumTypes; i++)
+	{
+		int Size = pFrom->GetItemSize(aIndices[i]);
+		void *pData = NewItem(pTypes[i], ID, Size);
+		if(!pData)
+			return false;
+		mem_copy(pData, pFrom->GetItem(aIndices[i])->Data(), Size);
+	}
+	return true;
+}
+
 int CSnapshotBuilder::Finish(void *pSnapData)
 {
 	// flatten and make the snapshot
@@ -683,3 +859,31 @@ void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
 
 	return pObj->Data();
 }
+
+// CSnapshotLod
+
+void CSnapshotLod::Reset()
+{
+	m_NumSnapshots = 0;
+	m_Level = 0;
+}
+
+bool CSnapshotLod::IsDue(int ID, int Interval) const
+{
+	if(Interval <= 1)
+		return true;
+	// stagger the items by their ID so that the refreshes are spread evenly
+	// over the snapshots
+	return (m_NumSnapshots + ID) % (Interval << m_Level) == 0;
+}
+
+void CSnapshotLod::OnSnapshotSent(int DeltaSize, int Budget)
+{
+	m_NumSnapshots++;
+	if(Budget <= 0)
+		m_Level = 0;
+	else if(DeltaSize > Budget)
+		m_Level = minimum(m_Level + 1, (int)MAX_LEVEL);
+	else if(DeltaSize < Budget / 2)
+		m_Level = maximum(m_Level - 1, 0);
+}
@@ -55,6 +55,7 @@ public:
 	int GetItemType(int Index) const;
 	int GetExternalItemType(int InternalType) const;
 	const void *FindItem(int Type, int ID) const;
+	int FindItemIndex(int Type, int ID) const;
 
 	unsigned Crc() const;
 	void DebugDump() const;
@@ -63,6 +64,63 @@ public:
 	static const CSnapshot *EmptySnapshot() { return &ms_EmptySnapshot; }
 };
 
+// CSnapshotDirectory
+
+// Lookup tables for the items of one snapshot, built once so that finding
+// an item by type and ID does not need a linear search. The items are also
+// grouped by type, with the (external) types that `GetItemType` returns.
+class CSnapshotDirectory
+{
+	enum
+	{
+		HASH_BITS = 11,
+		HASH_SIZE = 1 << HASH_BITS, // at most half full
+	};
+
+	struct CTypeRange
+	{
+		int m_Type;
+		int m_Start;
+		int m_Num;
+	};
+
+	struct CUuidType
+	{
+		int m_Type;
+		int m_InternalType;
+	};
+
+	int m_aHashKeys[HASH_SIZE];
+	short m_aHashIndices[HASH_SIZE];
+
+	int m_aTypeIndices[CSnapshot::MAX_ITEMS];
+	CTypeRange m_aTypeRanges[CSnapshot::MAX_ITEMS];
+	int m_NumTypes;
+
+	CUuidType m_aUuidTypes[CSnapshot::MAX_ITEMS];
+	int m_NumUuidTypes;
+
+	const CSnapshot *m_pSnapshot;
+
+	static unsigned HashKey(int Key) { return ((unsigned)Key * 2654435761u) >> (32 - HASH_BITS); }
+	int GetItemIndex(int Key) const;
+
+public:
+	CSnapshotDirectory() { Clear(); }
+
+	void Clear();
+	void Build(const CSnapshot *pSnapshot);
+	const CSnapshot *Snapshot() const { return m_pSnapshot; }
+
+	// Same results as the functions of `CSnapshot` with the same names.
+	int FindItemIndex(int Type, int ID) const;
+	const void *FindItem(int Type, int ID) const;
+
+	// Returns the number of items of the given type and their indices in
+	// snapshot order in `*ppIndices`.
+	int ItemsOfType(int Type, const int **ppIndices) const;
+};
+
 // CSnapshotDelta
 
 class CSnapshotDelta
@@ -120,6 +178,7 @@ public:
 
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+		CSnapshotDirectory *m_pAltDirectory;
 	};
 
 	CHolder *m_pFirst;
@@ -166,7 +225,41 @@ public:
 	CSnapshotItem *GetItem(int Index);
 	int *GetItemData(int Key);
 
+	// Adds the items with the given types and ID unchanged from `pFrom`.
+	// Adds nothing and returns false if one of them is missing there.
+	bool CopyItems(const CSnapshot *pFrom, int ID, const int *pTypes, int NumTypes);
+
 	int Finish(void *pSnapdata);
 };
 
+// CSnapshotLod
+
+// Level of detail for the snapshots of one client: items that are less
+// relevant to the client are only refreshed every few snapshots and keep the
+// data the client already has in between, which makes their delta empty.
+class CSnapshotLod
+{
+	int m_NumSnapshots;
+	int m_Level;
+
+public:
+	enum
+	{
+		// every level doubles the refresh intervals
+		MAX_LEVEL = 3,
+	};
+
+	CSnapshotLod() { Reset(); }
+	void Reset();
+
+	int Level() const { return m_Level; }
+	// Whether the item with the given ID and refresh interval (in snapshots)
+	// must be refreshed in the current snapshot. An interval of 1 is never
+	// stretched by the level.
+	bool IsDue(int ID, int Interval) const;
+	// Raises the level while the deltas exceed `Budget` bytes and lowers it
+	// again once they use less than half of it, `Budget` 0 means unlimited.
+	void OnSnapshotSent(int DeltaSize, int Budget);
+};
+
 #endif // ENGINE_SNAPSHOT_H
@@ -0,0 +1,159 @@
+#include "tick_profiler.h"
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <iterator>
+
+CTickProfiler g_TickProfiler;
+
+int CTickHistogram::BucketIndex(uint64_t Microseconds)
+{
+	if(Microseconds < 2 * SUB_BUCKETS)
+		return Microseconds;
+	int Exponent = 63;
+	while(!(Microseconds & ((uint64_t)1 << Exponent)))
+		Exponent--;
+	int SubBucket = (Microseconds >> (Exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+	return minimum(2 * SUB_BUCKETS + (Exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + SubBucket, (int)NUM_BUCKETS - 1);
+}
+
+uint64_t CTickHistogram::BucketUpperBound(int Bucket)
+{
+	if(Bucket < 2 * SUB_BUCKETS)
+		return Bucket;
+	int Exponent = (Bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+	int SubBucket = (Bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+	uint64_t Width = (uint64_t)1 << (Exponent - SUB_BUCKET_BITS);
+	return ((uint64_t)1 << Exponent) + (SubBucket + 1) * Width - 1;
+}
+
+void CTickHistogram::Record(int64_t Microseconds)
+{
+	uint64_t Value = maximum(Microseconds, (int64_t)0);
+	m_aBuckets[BucketIndex(Value)].fetch_add(1, std::memory_order_relaxed);
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+	m_Sum.fetch_add(Value, std::memory_order_relaxed);
+	uint64_t Max = m_Max.load(std::memory_order_relaxed);
+	while(Value > Max && !m_Max.compare_exchange_weak(Max, Value, std::memory_order_relaxed))
+	{
+	}
+}
+
+void CTickHistogram::Reset()
+{
+	for(auto &Bucket : m_aBuckets)
+		Bucket.store(0, std::memory_order_relaxed);
+	m_Count.store(0, std::memory_order_relaxed);
+	m_Sum.store(0, std::memory_order_relaxed);
+	m_Max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t CTickHistogram::Quantile(double Quantile) const
+{
+	uint64_t Count = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+		Count += BucketCount(i);
+	if(Count == 0)
+		return 0;
+	uint64_t Rank = maximum((uint64_t)1, (uint64_t)(Quantile * Count + 0.5));
+	uint64_t Seen = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+	{
+		Seen += BucketCount(i);
+		if(Seen >= Rank)
+			return minimum(BucketUpperBound(i), Max());
+	}
+	return Max();
+}
+
+const char *CTickProfiler::SectionName(int Section)
+{
+	static const char *const s_apNames[] = {
+		"tick",
+		"teehistorian",
+		"input",
+		"game",
+		"world",
+		"controller",
+		"hidden",
+		"teams",
+		"players",
+		"votes",
+		"snapshot",
+		"register",
+		"antibot",
+		"network",
+	};
+	static_assert(std::size(s_apNames) == NUM_TICK_SECTIONS, "missing tick section name");
+	return s_apNames[Section];
+}
+
+void CTickProfiler::Reset()
+{
+	for(auto &Section : m_aSections)
+		Section.Reset();
+}
+
+void CTickProfiler::Summary(void (*pfnCallback)(const char *pLine, void *pUser), void *pUser) const
+{
+	for(int i = 0; i < NUM_TICK_SECTIONS; i++)
+	{
+		const CTickHistogram &Histogram = m_aSections[i];
+		uint64_t Count = Histogram.Count();
+		char aLine[256];
+		str_format(aLine, sizeof(aLine), "%-12s count=%llu mean=%lluus p50=%lluus p99=%lluus p99.9=%lluus max=%lluus",
+			SectionName(i),
+			(unsigned long long)Count,
+			(unsigned long long)(Count ? Histogram.Sum() / Count : 0),
+			(unsigned long long)Histogram.Quantile(0.5),
+			(unsigned long long)Histogram.Quantile(0.99),
+			(unsigned long long)Histogram.Quantile(0.999),
+			(unsigned long long)Histogram.Max());
+		pfnCallback(aLine, pUser);
+	}
+}
+
+void CTickProfiler::WriteMetrics(void (*pfnWrite)(const char *pData, int Size, void *pUser), void *pUser) const
+{
+	char aBuf[256];
+	str_copy(aBuf, "# HELP ddnet_server_tick_section_seconds Time spent per server tick in each section\n# TYPE ddnet_server_tick_section_seconds histogram\n");
+	pfnWrite(aBuf, str_length(aBuf), pUser);
+	for(int i = 0; i < NUM_TICK_SECTIONS; i++)
+	{
+		const CTickHistogram &Histogram = m_aSections[i];
+		const char *pName = SectionName(i);
+		// only write the buckets up to the largest value recorded, the
+		// `+Inf` bucket covers the rest
+		int LastBucket = Histogram.Count() ? CTickHistogram::BucketIndex(Histogram.Max()) : -1;
+		uint64_t Cumulative = 0;
+		for(int b = 0; b <= LastBucket; b++)
+		{
+			Cumulative += Histogram.BucketCount(b);
+			str_format(aBuf, sizeof(aBuf), "ddnet_server_tick_section_seconds_bucket{section=\"%s\",le=\"%.6f\"} %llu\n",
+				pName, (CTickHistogram::BucketUpperBound(b) + 1) / 1000000.0, (unsigned long long)Cumulative);
+			pfnWrite(aBuf, str_length(aBuf), pUser);
+		}
+		str_format(aBuf, sizeof(aBuf),
+			"ddnet_server_tick_section_seconds_bucket{section=\"%s\",le=\"+Inf\"} %llu\n"
+			"ddnet_server_tick_section_seconds_sum{section=\"%s\"} %.6f\n"
+			"ddnet_server_tick_section_seconds_count{section=\"%s\"} %llu\n",
+			pName, (unsigned long long)Histogram.Count(),
+			pName, Histogram.Sum() / 1000000.0,
+			pName, (unsigned long long)Histogram.Count());
+		pfnWrite(aBuf, str_length(aBuf), pUser);
+	}
+}
+
+CTickProfileScope::CTickProfileScope(int Section) :
+	m_Section(Section), m_Start(time_get_nanoseconds().count())
+{
+}
+
+void CTickProfileScope::Stop()
+{
+	if(m_Section < 0)
+		return;
+	g_TickProfiler.Record(m_Section, (time_get_nanoseconds().count() - m_Start) / 1000);
+	m_Section = -1;
+}
@@ -0,0 +1,98 @@
+#ifndef ENGINE_SHARED_TICK_PROFILER_H
+#define ENGINE_SHARED_TICK_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+
+enum
+{
+	TICK_SECTION_TICK = 0,
+	TICK_SECTION_TEEHISTORIAN,
+	TICK_SECTION_INPUT,
+	TICK_SECTION_GAME,
+	TICK_SECTION_WORLD,
+	TICK_SECTION_CONTROLLER,
+	TICK_SECTION_HIDDEN,
+	TICK_SECTION_TEAMS,
+	TICK_SECTION_PLAYERS,
+	TICK_SECTION_VOTES,
+	TICK_SECTION_SNAPSHOT,
+	TICK_SECTION_REGISTER,
+	TICK_SECTION_ANTIBOT,
+	TICK_SECTION_NETWORK,
+	NUM_TICK_SECTIONS,
+};
+
+// Latency histogram with logarithmic buckets of 8 linear sub-buckets each,
+// like HdrHistogram with a precision of one significant octal digit. It is
+// only updated with relaxed atomics, so it can be read from other threads
+// while it is being recorded into.
+class CTickHistogram
+{
+public:
+	enum
+	{
+		SUB_BUCKET_BITS = 3,
+		SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+		// values below 2*SUB_BUCKETS microseconds get exact buckets, the
+		// largest bucket starts at about 35 minutes
+		NUM_BUCKETS = 2 * SUB_BUCKETS + (31 - SUB_BUCKET_BITS) * SUB_BUCKETS,
+	};
+
+	void Record(int64_t Microseconds);
+	void Reset();
+
+	uint64_t Count() const { return m_Count.load(std::memory_order_relaxed); }
+	uint64_t Sum() const { return m_Sum.load(std::memory_order_relaxed); }
+	uint64_t Max() const { return m_Max.load(std::memory_order_relaxed); }
+	uint64_t BucketCount(int Bucket) const { return m_aBuckets[Bucket].load(std::memory_order_relaxed); }
+	// Value at the given quantile (0 to 1), rounded up to the end of its
+	// bucket.
+	uint64_t Quantile(double Quantile) const;
+
+	static int BucketIndex(uint64_t Microseconds);
+	// Largest value that falls into the bucket.
+	static uint64_t BucketUpperBound(int Bucket);
+
+private:
+	std::atomic<uint64_t> m_aBuckets[NUM_BUCKETS] = {};
+	std::atomic<uint64_t> m_Count{0};
+	std::atomic<uint64_t> m_Sum{0};
+	std::atomic<uint64_t> m_Max{0};
+};
+
+class CTickProfiler
+{
+	CTickHistogram m_aSections[NUM_TICK_SECTIONS];
+
+public:
+	static const char *SectionName(int Section);
+
+	void Record(int Section, int64_t Microseconds) { m_aSections[Section].Record(Microseconds); }
+	const CTickHistogram &Section(int Section) const { return m_aSections[Section]; }
+	void Reset();
+
+	// Calls `pfnCallback` with one line per section: count, mean, p50, p99,
+	// p99.9 and max in microseconds.
+	void Summary(void (*pfnCallback)(const char *pLine, void *pUser), void *pUser) const;
+	// Writes all histograms in the Prometheus text exposition format, see
+	// https://prometheus.io/docs/instrumenting/exposition_formats/.
+	void WriteMetrics(void (*pfnWrite)(const char *pData, int Size, void *pUser), void *pUser) const;
+};
+
+extern CTickProfiler g_TickProfiler;
+
+// Measures the time until it goes out of scope or `Stop()` is called and
+// records it in the section of `g_TickProfiler`.
+class CTickProfileScope
+{
+	int m_Section;
+	int64_t m_Start;
+
+public:
+	CTickProfileScope(int Section);
+	~CTickProfileScope() { Stop(); }
+	void Stop();
+};
+
+#endif
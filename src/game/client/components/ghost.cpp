@@ -1,5 +1,8 @@
 /* (c) Rajh, Redix and Sushi. */
 
+#include <base/log.h>
+
+#include <engine/engine.h>
 #include <engine/ghost.h>
 #include <engine/shared/config.h>
 #include <engine/storage.h>
@@ -136,21 +139,17 @@ void CGhost::GetPath(char *pBuf, int Size, const char *pPlayerName, int Time) co
 	char aTimestamp[32];
 	str_timestamp_format(aTimestamp, sizeof(aTimestamp), FORMAT_NOSPACE);
 
-	if(Time < 0)
-		str_format(pBuf, Size, "%s/%s_%s_%s_tmp_%d.gho", ms_pGhostDir, pMap, aPlayerName, aSha256, pid());
-	else
-		str_format(pBuf, Size, "%s/%s_%s_%d.%03d_%s_%s.gho", ms_pGhostDir, pMap, aPlayerName, Time / 1000, Time % 1000, aTimestamp, aSha256);
+	str_format(pBuf, Size, "%s/%s_%s_%d.%03d_%s_%s.gho", ms_pGhostDir, pMap, aPlayerName, Time / 1000, Time % 1000, aTimestamp, aSha256);
 }
 
 void CGhost::AddInfos(const CNetObj_Character *pChar, const CNetObj_DDNetCharacter *pDDnetChar)
 {
 	int NumTicks = m_CurGhost.m_Path.Size();
 
-	// do not start writing to file as long as we still touch the start line
+	// do not start recording to file as long as we still touch the start line
 	if(g_Config.m_ClRaceSaveGhost && !GhostRecorder()->IsRecording() && NumTicks > 0)
 	{
-		GetPath(m_aTmpFilename, sizeof(m_aTmpFilename), m_CurGhost.m_aPlayer);
-		GhostRecorder()->Start(m_aTmpFilename, Client()->GetCurrentMap(), Client()->GetCurrentMapSha256(), m_CurGhost.m_aPlayer);
+		GhostRecorder()->Start(Client()->GetCurrentMap(), Client()->GetCurrentMapSha256(), m_CurGhost.m_aPlayer);
 
 		GhostRecorder()->WriteData(GHOSTDATA_TYPE_START_TICK, &m_CurGhost.m_StartTick, sizeof(int));
 		GhostRecorder()->WriteData(GHOSTDATA_TYPE_SKIN, &m_CurGhost.m_Skin, sizeof(CGhostSkin));
@@ -196,7 +195,7 @@ void CGhost::CheckStart()
 		if(m_LastRaceTick == -1) // no restart: reset rendering preparations
 			m_NewRenderTick = -1;
 		if(GhostRecorder()->IsRecording()) // race restarted: stop recording
-			GhostRecorder()->Stop(0, -1);
+			GhostRecorder()->Stop(0, -1, nullptr);
 		int StartTick = RaceTick;
 
 		if(GameClient()->m_GameInfo.m_BugDDRaceGhost) // the client recognizes the start one tick earlier than ddrace servers
@@ -250,7 +249,7 @@ void CGhost::CheckStartLocal(bool Predicted)
 			if(RecordTick != -1)
 			{
 				if(GhostRecorder()->IsRecording()) // race restarted: stop recording
-					GhostRecorder()->Stop(0, -1);
+					GhostRecorder()->Stop(0, -1, nullptr);
 				StartRecord(RecordTick);
 			}
 		}
@@ -311,6 +310,8 @@ void CGhost::OnNewPredictedSnapshot()
 
 void CGhost::OnRender()
 {
+	UpdateLoadJobs();
+
 	// Play the ghost
 	if(!m_Rendering || !g_Config.m_ClRaceShowGhost)
 		return;
@@ -319,7 +320,7 @@ void CGhost::OnRender()
 
 	for(auto &Ghost : m_aActiveGhosts)
 	{
-		if(Ghost.Empty())
+		if(Ghost.Empty() || Ghost.Pending())
 			continue;
 
 		int GhostTick = Ghost.m_StartTick + PlaybackTick;
@@ -425,9 +426,7 @@ void CGhost::StopRecord(int Time)
 {
 	m_Recording = false;
 	bool RecordingToFile = GhostRecorder()->IsRecording();
-
-	if(RecordingToFile)
-		GhostRecorder()->Stop(m_CurGhost.m_Path.Size(), Time);
+	const int NumTicks = m_CurGhost.m_Path.Size();
 
 	CMenus::CGhostItem *pOwnGhost = m_pClient->m_Menus.GetOwnGhost();
 	if(Time > 0 && (!pOwnGhost || Time < pOwnGhost->m_Time || !g_Config.m_ClRaceGhostSaveBest))
@@ -450,15 +449,13 @@ void CGhost::StopRecord(int Time)
 
 		// save new ghost file
 		if(Item.HasFile())
-			Storage()->RenameFile(m_aTmpFilename, Item.m_aFilename, IStorage::TYPE_SAVE);
+			GhostRecorder()->Stop(NumTicks, Time, Item.m_aFilename);
 
 		// add item to menu list
 		m_pClient->m_Menus.UpdateOwnGhost(Item);
 	}
 	else if(RecordingToFile) // no new record
-		Storage()->RemoveFile(m_aTmpFilename, IStorage::TYPE_SAVE);
-
-	m_aTmpFilename[0] = 0;
+		GhostRecorder()->Stop(0, -1, nullptr);
 
 	m_CurGhost.Reset();
 }
@@ -468,7 +465,36 @@ void CGhost::StartRender(int Tick)
 	m_Rendering = true;
 	m_StartRenderTick = Tick;
 	for(auto &Ghost : m_aActiveGhosts)
+	{
+		// the paths are read on the job pool, UpdateLoadJobs picks them up
+		if(Ghost.Pending() && !Ghost.m_pLoadJob)
+		{
+			Ghost.m_pLoadJob = std::make_shared<CPathLoadJob>(GhostLoader()->CreateLoader(), Ghost.m_aFilename, Client()->GetCurrentMap(), Client()->GetCurrentMapSha256(), Client()->GetCurrentMapCrc());
+			Engine()->AddJob(Ghost.m_pLoadJob);
+		}
 		Ghost.m_PlaybackPos = 0;
+	}
+}
+
+void CGhost::UpdateLoadJobs()
+{
+	for(int Slot = 0; Slot < MAX_ACTIVE_GHOSTS; Slot++)
+	{
+		CGhostItem *pGhost = &m_aActiveGhosts[Slot];
+		if(!pGhost->m_pLoadJob || pGhost->m_pLoadJob->Status() != IJob::STATE_DONE)
+			continue;
+
+		const std::shared_ptr<CPathLoadJob> pJob = pGhost->m_pLoadJob;
+		if(!pJob->m_Loaded)
+		{
+			pGhost->Reset();
+			m_pClient->m_Menus.GhostFailed(Slot);
+			continue;
+		}
+		*pGhost = std::move(pJob->m_Ghost);
+		InitRenderInfos(pGhost);
+		pGhost->m_PlaybackPos = 0;
+	}
 }
 
 void CGhost::StopRender()
@@ -495,9 +521,40 @@ int CGhost::Load(const char *pFilename)
 		return -1;
 	}
 
-	// select ghost
+	// select ghost, the path is only read when it starts playing
 	CGhostItem *pGhost = &m_aActiveGhosts[Slot];
 	pGhost->Reset();
+	str_copy(pGhost->m_aFilename, pFilename);
+	str_copy(pGhost->m_aPlayer, pInfo->m_aOwner);
+
+	GhostLoader()->Close();
+	return Slot;
+}
+
+CGhost::CPathLoadJob::CPathLoadJob(std::unique_ptr<IGhostLoader> &&pLoader, const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc) :
+	m_pLoader(std::move(pLoader)),
+	m_MapSha256(MapSha256),
+	m_MapCrc(MapCrc)
+{
+	str_copy(m_aFilename, pFilename);
+	str_copy(m_aMap, pMap);
+}
+
+void CGhost::CPathLoadJob::Run()
+{
+	if(m_pLoader->Load(m_aFilename, m_aMap, m_MapSha256, m_MapCrc) != 0)
+		return;
+
+	const CGhostInfo *pInfo = m_pLoader->GetInfo();
+	CGhostItem *pGhost = &m_Ghost;
+
+	if(pInfo->m_NumTicks <= 0 || pInfo->m_Time <= 0)
+	{
+		log_info("ghost", "invalid header info");
+		m_pLoader->Close();
+		return;
+	}
+
 	pGhost->m_Path.SetSize(pInfo->m_NumTicks);
 
 	str_copy(pGhost->m_aPlayer, pInfo->m_aOwner);
@@ -508,7 +565,7 @@ int CGhost::Load(const char *pFilename)
 	bool Error = false;
 
 	int Type;
-	while(!Error && GhostLoader()->ReadNextType(&Type))
+	while(!Error && m_pLoader->ReadNextType(&Type))
 	{
 		if(Index == pInfo->m_NumTicks && (Type == GHOSTDATA_TYPE_CHARACTER || Type == GHOSTDATA_TYPE_CHARACTER_NO_TICK))
 		{
@@ -519,34 +576,34 @@ int CGhost::Load(const char *pFilename)
 		if(Type == GHOSTDATA_TYPE_SKIN && !FoundSkin)
 		{
 			FoundSkin = true;
-			if(!GhostLoader()->ReadData(Type, &pGhost->m_Skin, sizeof(CGhostSkin)))
+			if(!m_pLoader->ReadData(Type, &pGhost->m_Skin, sizeof(CGhostSkin)))
 				Error = true;
 		}
 		else if(Type == GHOSTDATA_TYPE_CHARACTER_NO_TICK)
 		{
 			NoTick = true;
-			if(!GhostLoader()->ReadData(Type, pGhost->m_Path.Get(Index++), sizeof(CGhostCharacter_NoTick)))
+			if(!m_pLoader->ReadData(Type, pGhost->m_Path.Get(Index++), sizeof(CGhostCharacter_NoTick)))
 				Error = true;
 		}
 		else if(Type == GHOSTDATA_TYPE_CHARACTER)
 		{
-			if(!GhostLoader()->ReadData(Type, pGhost->m_Path.Get(Index++), sizeof(CGhostCharacter)))
+			if(!m_pLoader->ReadData(Type, pGhost->m_Path.Get(Index++), sizeof(CGhostCharacter)))
 				Error = true;
 		}
 		else if(Type == GHOSTDATA_TYPE_START_TICK)
 		{
-			if(!GhostLoader()->ReadData(Type, &pGhost->m_StartTick, sizeof(int)))
+			if(!m_pLoader->ReadData(Type, &pGhost->m_StartTick, sizeof(int)))
 				Error = true;
 		}
 	}
 
-	GhostLoader()->Close();
+	m_pLoader->Close();
 
 	if(Error || Index != pInfo->m_NumTicks)
 	{
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost", "invalid ghost data");
+		log_info("ghost", "invalid ghost data");
 		pGhost->Reset();
-		return -1;
+		return;
 	}
 
 	if(NoTick)
@@ -564,9 +621,7 @@ int CGhost::Load(const char *pFilename)
 
 	if(!FoundSkin)
 		GetGhostSkin(&pGhost->m_Skin, "default", 0, 0, 0);
-	InitRenderInfos(pGhost);
-
-	return Slot;
+	m_Loaded = true;
 }
 
 void CGhost::Unload(int Slot)
@@ -590,14 +645,14 @@ void CGhost::SaveGhost(CMenus::CGhostItem *pItem)
 
 	int NumTicks = pGhost->m_Path.Size();
 	GetPath(pItem->m_aFilename, sizeof(pItem->m_aFilename), pItem->m_aPlayer, pItem->m_Time);
-	GhostRecorder()->Start(pItem->m_aFilename, Client()->GetCurrentMap(), Client()->GetCurrentMapSha256(), pItem->m_aPlayer);
+	GhostRecorder()->Start(Client()->GetCurrentMap(), Client()->GetCurrentMapSha256(), pItem->m_aPlayer);
 
 	GhostRecorder()->WriteData(GHOSTDATA_TYPE_START_TICK, &pGhost->m_StartTick, sizeof(int));
 	GhostRecorder()->WriteData(GHOSTDATA_TYPE_SKIN, &pGhost->m_Skin, sizeof(CGhostSkin));
 	for(int i = 0; i < NumTicks; i++)
 		GhostRecorder()->WriteData(GHOSTDATA_TYPE_CHARACTER, pGhost->m_Path.Get(i), sizeof(CGhostCharacter));
 
-	GhostRecorder()->Stop(NumTicks, pItem->m_Time);
+	GhostRecorder()->Stop(NumTicks, pItem->m_Time, pItem->m_aFilename);
 }
 
 void CGhost::ConGPlay(IConsole::IResult *pResult, void *pUserData)
@@ -687,7 +742,7 @@ int CGhost::GetLastRaceTick() const
 void CGhost::OnRefreshSkins()
 {
 	const auto &&RefindSkin = [&](auto &Ghost) {
-		if(Ghost.Empty())
+		if(Ghost.Empty() || Ghost.Pending())
 			return;
 		char aSkinName[64];
 		IntsToStr(&Ghost.m_Skin.m_Skin0, 6, aSkinName);
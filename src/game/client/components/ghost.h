@@ -3,6 +3,9 @@
 #ifndef GAME_CLIENT_COMPONENTS_GHOST_H
 #define GAME_CLIENT_COMPONENTS_GHOST_H
 
+#include <engine/ghost.h>
+#include <engine/shared/jobs.h>
+
 #include <game/client/component.h>
 #include <game/client/components/menus.h>
 #include <game/generated/protocol.h>
@@ -84,6 +87,8 @@ private:
 		CGhostCharacter *Get(int Index);
 	};
 
+	class CPathLoadJob;
+
 	class CGhostItem
 	{
 	public:
@@ -93,18 +98,43 @@ private:
 		int m_StartTick;
 		char m_aPlayer[MAX_NAME_LENGTH];
 		int m_PlaybackPos;
+		// file to read the path from once the ghost starts playing
+		char m_aFilename[IO_MAX_PATH_LENGTH];
+		std::shared_ptr<CPathLoadJob> m_pLoadJob;
 
 		CGhostItem() { Reset(); }
 
-		bool Empty() const { return m_Path.Size() == 0; }
+		bool Empty() const { return m_Path.Size() == 0 && !Pending(); }
+		bool Pending() const { return m_aFilename[0] != '\0'; }
 		void Reset()
 		{
 			m_Path.Reset();
 			m_StartTick = -1;
 			m_PlaybackPos = -1;
+			m_aFilename[0] = '\0';
+			m_pLoadJob = nullptr;
 		}
 	};
 
+	// Reads the path of a ghost with its own loader, so playback does not
+	// wait for the file.
+	class CPathLoadJob : public IJob
+	{
+		std::unique_ptr<IGhostLoader> m_pLoader;
+		char m_aFilename[IO_MAX_PATH_LENGTH];
+		char m_aMap[64];
+		SHA256_DIGEST m_MapSha256;
+		unsigned m_MapCrc;
+
+		void Run() override;
+
+	public:
+		CPathLoadJob(std::unique_ptr<IGhostLoader> &&pLoader, const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc);
+
+		bool m_Loaded = false;
+		CGhostItem m_Ghost;
+	};
+
 	static const char *ms_pGhostDir;
 
 	class IGhostLoader *m_pGhostLoader;
@@ -113,8 +143,6 @@ private:
 	CGhostItem m_aActiveGhosts[MAX_ACTIVE_GHOSTS];
 	CGhostItem m_CurGhost;
 
-	char m_aTmpFilename[128];
-
 	int m_NewRenderTick;
 	int m_StartRenderTick;
 	int m_LastDeathTick;
@@ -128,7 +156,7 @@ private:
 	static void GetGhostCharacter(CGhostCharacter *pGhostChar, const CNetObj_Character *pChar, const CNetObj_DDNetCharacter *pDDnetChar);
 	static void GetNetObjCharacter(CNetObj_Character *pChar, const CGhostCharacter *pGhostChar);
 
-	void GetPath(char *pBuf, int Size, const char *pPlayerName, int Time = -1) const;
+	void GetPath(char *pBuf, int Size, const char *pPlayerName, int Time) const;
 
 	void AddInfos(const CNetObj_Character *pChar, const CNetObj_DDNetCharacter *pDDnetChar);
 	int GetSlot() const;
@@ -143,6 +171,7 @@ private:
 	void StopRender();
 
 	void InitRenderInfos(CGhostItem *pGhost);
+	void UpdateLoadJobs();
 
 	static void ConGPlay(IConsole::IResult *pResult, void *pUserData);
 
@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <engine/demo.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/keys.h>
 #include <engine/serverbrowser.h>
@@ -21,6 +22,7 @@
 #include "maplayers.h"
 
 #include <chrono>
+#include <memory>
 
 using namespace std::chrono_literals;
 
@@ -143,169 +145,6 @@ void CMapLayers::EnvelopeEval(int TimeOffsetMillis, int Env, ColorRGBA &Channels
 	}
 }
 
-void FillTmpTile(SGraphicTile *pTmpTile, SGraphicTileTexureCoords *pTmpTex, unsigned char Flags, unsigned char Index, int x, int y, const ivec2 &Offset, int Scale, CMapItemGroup *pGroup)
-{
-	if(pTmpTex)
-	{
-		unsigned char x0 = 0;
-		unsigned char y0 = 0;
-		unsigned char x1 = x0 + 1;
-		unsigned char y1 = y0;
-		unsigned char x2 = x0 + 1;
-		unsigned char y2 = y0 + 1;
-		unsigned char x3 = x0;
-		unsigned char y3 = y0 + 1;
-
-		if(Flags & TILEFLAG_XFLIP)
-		{
-			x0 = x2;
-			x1 = x3;
-			x2 = x3;
-			x3 = x0;
-		}
-
-		if(Flags & TILEFLAG_YFLIP)
-		{
-			y0 = y3;
-			y2 = y1;
-			y3 = y1;
-			y1 = y0;
-		}
-
-		if(Flags & TILEFLAG_ROTATE)
-		{
-			unsigned char Tmp = x0;
-			x0 = x3;
-			x3 = x2;
-			x2 = x1;
-			x1 = Tmp;
-			Tmp = y0;
-			y0 = y3;
-			y3 = y2;
-			y2 = y1;
-			y1 = Tmp;
-		}
-
-		pTmpTex->m_TexCoordTopLeft.x = x0;
-		pTmpTex->m_TexCoordTopLeft.y = y0;
-		pTmpTex->m_TexCoordBottomLeft.x = x3;
-		pTmpTex->m_TexCoordBottomLeft.y = y3;
-		pTmpTex->m_TexCoordTopRight.x = x1;
-		pTmpTex->m_TexCoordTopRight.y = y1;
-		pTmpTex->m_TexCoordBottomRight.x = x2;
-		pTmpTex->m_TexCoordBottomRight.y = y2;
-
-		pTmpTex->m_TexCoordTopLeft.z = Index;
-		pTmpTex->m_TexCoordBottomLeft.z = Index;
-		pTmpTex->m_TexCoordTopRight.z = Index;
-		pTmpTex->m_TexCoordBottomRight.z = Index;
-
-		bool HasRotation = (Flags & TILEFLAG_ROTATE) != 0;
-		pTmpTex->m_TexCoordTopLeft.w = HasRotation;
-		pTmpTex->m_TexCoordBottomLeft.w = HasRotation;
-		pTmpTex->m_TexCoordTopRight.w = HasRotation;
-		pTmpTex->m_TexCoordBottomRight.w = HasRotation;
-	}
-
-	pTmpTile->m_TopLeft.x = x * Scale + Offset.x;
-	pTmpTile->m_TopLeft.y = y * Scale + Offset.y;
-	pTmpTile->m_BottomLeft.x = x * Scale + Offset.x;
-	pTmpTile->m_BottomLeft.y = y * Scale + Scale + Offset.y;
-	pTmpTile->m_TopRight.x = x * Scale + Scale + Offset.x;
-	pTmpTile->m_TopRight.y = y * Scale + Offset.y;
-	pTmpTile->m_BottomRight.x = x * Scale + Scale + Offset.x;
-	pTmpTile->m_BottomRight.y = y * Scale + Scale + Offset.y;
-}
-
-void FillTmpTileSpeedup(SGraphicTile *pTmpTile, SGraphicTileTexureCoords *pTmpTex, unsigned char Flags, unsigned char Index, int x, int y, const ivec2 &Offset, int Scale, CMapItemGroup *pGroup, short AngleRotate)
-{
-	int Angle = AngleRotate % 360;
-	FillTmpTile(pTmpTile, pTmpTex, Angle >= 270 ? ROTATION_270 : (Angle >= 180 ? ROTATION_180 : (Angle >= 90 ? ROTATION_90 : 0)), AngleRotate % 90, x, y, Offset, Scale, pGroup);
-}
-
-bool CMapLayers::STileLayerVisuals::Init(unsigned int Width, unsigned int Height)
-{
-	m_Width = Width;
-	m_Height = Height;
-	if(Width == 0 || Height == 0)
-		return false;
-	if constexpr(sizeof(unsigned int) >= sizeof(ptrdiff_t))
-		if(Width >= std::numeric_limits<std::ptrdiff_t>::max() || Height >= std::numeric_limits<std::ptrdiff_t>::max())
-			return false;
-
-	m_pTilesOfLayer = new CMapLayers::STileLayerVisuals::STileVisual[Height * Width];
-
-	m_vBorderTop.resize(Width);
-	m_vBorderBottom.resize(Width);
-
-	m_vBorderLeft.resize(Height);
-	m_vBorderRight.resize(Height);
-	return true;
-}
-
-CMapLayers::STileLayerVisuals::~STileLayerVisuals()
-{
-	delete[] m_pTilesOfLayer;
-
-	m_pTilesOfLayer = NULL;
-}
-
-bool AddTile(std::vector<SGraphicTile> &vTmpTiles, std::vector<SGraphicTileTexureCoords> &vTmpTileTexCoords, unsigned char Index, unsigned char Flags, int x, int y, CMapItemGroup *pGroup, bool DoTextureCoords, bool FillSpeedup = false, int AngleRotate = -1, const ivec2 &Offset = ivec2{0, 0}, int Scale = 32)
-{
-	if(Index)
-	{
-		vTmpTiles.emplace_back();
-		SGraphicTile &Tile = vTmpTiles.back();
-		SGraphicTileTexureCoords *pTileTex = NULL;
-		if(DoTextureCoords)
-		{
-			vTmpTileTexCoords.emplace_back();
-			SGraphicTileTexureCoords &TileTex = vTmpTileTexCoords.back();
-			pTileTex = &TileTex;
-		}
-		if(FillSpeedup)
-			FillTmpTileSpeedup(&Tile, pTileTex, Flags, 0, x, y, Offset, Scale, pGroup, AngleRotate);
-		else
-			FillTmpTile(&Tile, pTileTex, Flags, Index, x, y, Offset, Scale, pGroup);
-
-		return true;
-	}
-	return false;
-}
-
-struct STmpQuadVertexTextured
-{
-	float m_X, m_Y, m_CenterX, m_CenterY;
-	unsigned char m_R, m_G, m_B, m_A;
-	float m_U, m_V;
-};
-
-struct STmpQuadVertex
-{
-	float m_X, m_Y, m_CenterX, m_CenterY;
-	unsigned char m_R, m_G, m_B, m_A;
-};
-
-struct STmpQuad
-{
-	STmpQuadVertex m_aVertices[4];
-};
-
-struct STmpQuadTextured
-{
-	STmpQuadVertexTextured m_aVertices[4];
-};
-
-void mem_copy_special(void *pDest, void *pSource, size_t Size, size_t Count, size_t Steps)
-{
-	size_t CurStep = 0;
-	for(size_t i = 0; i < Count; ++i)
-	{
-		mem_copy(((char *)pDest) + CurStep + i * Size, ((char *)pSource) + i * Size, Size);
-		CurStep += Steps;
-	}
-}
-
 CMapLayers::~CMapLayers()
 {
 	//clear everything and destroy all buffers
@@ -367,25 +206,14 @@ void CMapLayers::OnMapLoad()
 		RenderLoading();
 	}
 
+	// the visuals are built on the job pool, only the buffers are created here
+	std::vector<std::shared_ptr<CTileLayerBuild>> vpTileLayerBuilds;
+	std::vector<std::shared_ptr<CQuadLayerBuildJob>> vpQuadLayerJobs;
+
 	bool PassedGameLayer = false;
+	bool PassedLastLayer = false;
 	//prepare all visuals for all tile layers
-	std::vector<SGraphicTile> vtmpTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpTileTexCoords;
-	std::vector<SGraphicTile> vtmpBorderTopTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderTopTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderLeftTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderLeftTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderRightTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderRightTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderBottomTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderBottomTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderCorners;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderCornersTexCoords;
-
-	std::vector<STmpQuad> vtmpQuads;
-	std::vector<STmpQuadTextured> vtmpQuadsTextured;
-
-	for(int g = 0; g < m_pLayers->NumGroups(); g++)
+	for(int g = 0; g < m_pLayers->NumGroups() && !PassedLastLayer; g++)
 	{
 		CMapItemGroup *pGroup = m_pLayers->GetGroup(g);
 		if(!pGroup)
@@ -432,7 +260,10 @@ void CMapLayers::OnMapLoad()
 			if(m_Type <= TYPE_BACKGROUND_FORCE)
 			{
 				if(PassedGameLayer)
-					return;
+				{
+					PassedLastLayer = true;
+					break;
+				}
 			}
 			else if(m_Type == TYPE_FOREGROUND)
 			{
@@ -488,304 +319,39 @@ void CMapLayers::OnMapLoad()
 					DataIndex = pTMap->m_Data;
 					TileSize = sizeof(CTile);
 				}
+				// the map data is loaded lazily, so it has to be accessed here
 				unsigned int Size = m_pLayers->Map()->GetDataSize(DataIndex);
 				void *pTiles = m_pLayers->Map()->GetData(DataIndex);
 
 				if(Size >= pTMap->m_Width * pTMap->m_Height * TileSize)
 				{
-					int CurOverlay = 0;
-					while(CurOverlay < OverlayCount + 1)
+					for(int CurOverlay = 0; CurOverlay < OverlayCount + 1; ++CurOverlay)
 					{
 						// We can later just count the tile layers to get the idx in the vector
 						m_vpTileLayerVisuals.push_back(new STileLayerVisuals());
 						STileLayerVisuals &Visuals = *m_vpTileLayerVisuals.back();
 						if(!Visuals.Init(pTMap->m_Width, pTMap->m_Height))
-						{
-							++CurOverlay;
 							continue;
-						}
 						Visuals.m_IsTextured = DoTextureCoords;
 
-						vtmpTiles.clear();
-						vtmpTileTexCoords.clear();
-
-						vtmpBorderTopTiles.clear();
-						vtmpBorderLeftTiles.clear();
-						vtmpBorderRightTiles.clear();
-						vtmpBorderBottomTiles.clear();
-						vtmpBorderCorners.clear();
-						vtmpBorderTopTilesTexCoords.clear();
-						vtmpBorderLeftTilesTexCoords.clear();
-						vtmpBorderRightTilesTexCoords.clear();
-						vtmpBorderBottomTilesTexCoords.clear();
-						vtmpBorderCornersTexCoords.clear();
-
-						if(!DoTextureCoords)
-						{
-							vtmpTiles.reserve((size_t)pTMap->m_Width * pTMap->m_Height);
-							vtmpBorderTopTiles.reserve((size_t)pTMap->m_Width);
-							vtmpBorderBottomTiles.reserve((size_t)pTMap->m_Width);
-							vtmpBorderLeftTiles.reserve((size_t)pTMap->m_Height);
-							vtmpBorderRightTiles.reserve((size_t)pTMap->m_Height);
-							vtmpBorderCorners.reserve((size_t)4);
-						}
-						else
-						{
-							vtmpTileTexCoords.reserve((size_t)pTMap->m_Width * pTMap->m_Height);
-							vtmpBorderTopTilesTexCoords.reserve((size_t)pTMap->m_Width);
-							vtmpBorderBottomTilesTexCoords.reserve((size_t)pTMap->m_Width);
-							vtmpBorderLeftTilesTexCoords.reserve((size_t)pTMap->m_Height);
-							vtmpBorderRightTilesTexCoords.reserve((size_t)pTMap->m_Height);
-							vtmpBorderCornersTexCoords.reserve((size_t)4);
-						}
-
-						int x = 0;
-						int y = 0;
-						for(y = 0; y < pTMap->m_Height; ++y)
-						{
-							for(x = 0; x < pTMap->m_Width; ++x)
-							{
-								unsigned char Index = 0;
-								unsigned char Flags = 0;
-								int AngleRotate = -1;
-								if(IsEntityLayer)
-								{
-									if(IsGameLayer)
-									{
-										Index = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Index;
-										Flags = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-									}
-									if(IsFrontLayer)
-									{
-										Index = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Index;
-										Flags = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-									}
-									if(IsSwitchLayer)
-									{
-										Flags = 0;
-										Index = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										if(CurOverlay == 0)
-										{
-											Flags = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-											if(Index == TILE_SWITCHTIMEDOPEN)
-												Index = 8;
-										}
-										else if(CurOverlay == 1)
-											Index = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Number;
-										else if(CurOverlay == 2)
-											Index = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Delay;
-									}
-									if(IsTeleLayer)
-									{
-										Index = ((CTeleTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										Flags = 0;
-										if(CurOverlay == 1)
-										{
-											if(IsTeleTileNumberUsedAny(Index))
-												Index = ((CTeleTile *)pTiles)[y * pTMap->m_Width + x].m_Number;
-											else
-												Index = 0;
-										}
-									}
-									if(IsSpeedupLayer)
-									{
-										Index = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										Flags = 0;
-										AngleRotate = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Angle;
-										if(((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Force == 0)
-											Index = 0;
-										else if(CurOverlay == 1)
-											Index = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Force;
-										else if(CurOverlay == 2)
-											Index = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_MaxSpeed;
-									}
-									if(IsTuneLayer)
-									{
-										Index = ((CTuneTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										Flags = 0;
-									}
-								}
-								else
-								{
-									Index = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Index;
-									Flags = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-								}
-
-								//the amount of tiles handled before this tile
-								int TilesHandledCount = vtmpTiles.size();
-								Visuals.m_pTilesOfLayer[y * pTMap->m_Width + x].SetIndexBufferByteOffset((offset_ptr32)(TilesHandledCount));
-
-								bool AddAsSpeedup = false;
-								if(IsSpeedupLayer && CurOverlay == 0)
-									AddAsSpeedup = true;
-
-								if(AddTile(vtmpTiles, vtmpTileTexCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-									Visuals.m_pTilesOfLayer[y * pTMap->m_Width + x].Draw(true);
-
-								//do the border tiles
-								if(x == 0)
-								{
-									if(y == 0)
-									{
-										Visuals.m_BorderTopLeft.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size()));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{-32, -32}))
-											Visuals.m_BorderTopLeft.Draw(true);
-									}
-									else if(y == pTMap->m_Height - 1)
-									{
-										Visuals.m_BorderBottomLeft.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size()));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{-32, 0}))
-											Visuals.m_BorderBottomLeft.Draw(true);
-									}
-									Visuals.m_vBorderLeft[y].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderLeftTiles.size()));
-									if(AddTile(vtmpBorderLeftTiles, vtmpBorderLeftTilesTexCoords, Index, Flags, 0, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{-32, 0}))
-										Visuals.m_vBorderLeft[y].Draw(true);
-								}
-								else if(x == pTMap->m_Width - 1)
-								{
-									if(y == 0)
-									{
-										Visuals.m_BorderTopRight.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size()));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, -32}))
-											Visuals.m_BorderTopRight.Draw(true);
-									}
-									else if(y == pTMap->m_Height - 1)
-									{
-										Visuals.m_BorderBottomRight.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size()));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, 0}))
-											Visuals.m_BorderBottomRight.Draw(true);
-									}
-									Visuals.m_vBorderRight[y].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderRightTiles.size()));
-									if(AddTile(vtmpBorderRightTiles, vtmpBorderRightTilesTexCoords, Index, Flags, 0, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, 0}))
-										Visuals.m_vBorderRight[y].Draw(true);
-								}
-								if(y == 0)
-								{
-									Visuals.m_vBorderTop[x].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderTopTiles.size()));
-									if(AddTile(vtmpBorderTopTiles, vtmpBorderTopTilesTexCoords, Index, Flags, x, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, -32}))
-										Visuals.m_vBorderTop[x].Draw(true);
-								}
-								else if(y == pTMap->m_Height - 1)
-								{
-									Visuals.m_vBorderBottom[x].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderBottomTiles.size()));
-									if(AddTile(vtmpBorderBottomTiles, vtmpBorderBottomTilesTexCoords, Index, Flags, x, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, 0}))
-										Visuals.m_vBorderBottom[x].Draw(true);
-								}
-							}
-						}
-
-						//append one kill tile to the gamelayer
-						if(IsGameLayer)
-						{
-							Visuals.m_BorderKillTile.SetIndexBufferByteOffset((offset_ptr32)(vtmpTiles.size()));
-							if(AddTile(vtmpTiles, vtmpTileTexCoords, TILE_DEATH, 0, 0, 0, pGroup, DoTextureCoords))
-								Visuals.m_BorderKillTile.Draw(true);
-						}
-
-						//add the border corners, then the borders and fix their byte offsets
-						int TilesHandledCount = vtmpTiles.size();
-						Visuals.m_BorderTopLeft.AddIndexBufferByteOffset(TilesHandledCount);
-						Visuals.m_BorderTopRight.AddIndexBufferByteOffset(TilesHandledCount);
-						Visuals.m_BorderBottomLeft.AddIndexBufferByteOffset(TilesHandledCount);
-						Visuals.m_BorderBottomRight.AddIndexBufferByteOffset(TilesHandledCount);
-						//add the Corners to the tiles
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderCorners.begin(), vtmpBorderCorners.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderCornersTexCoords.begin(), vtmpBorderCornersTexCoords.end());
-
-						//now the borders
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Width > 0)
-						{
-							for(int i = 0; i < pTMap->m_Width; ++i)
-							{
-								Visuals.m_vBorderTop[i].AddIndexBufferByteOffset(TilesHandledCount);
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderTopTiles.begin(), vtmpBorderTopTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderTopTilesTexCoords.begin(), vtmpBorderTopTilesTexCoords.end());
-
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Width > 0)
-						{
-							for(int i = 0; i < pTMap->m_Width; ++i)
-							{
-								Visuals.m_vBorderBottom[i].AddIndexBufferByteOffset(TilesHandledCount);
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderBottomTiles.begin(), vtmpBorderBottomTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderBottomTilesTexCoords.begin(), vtmpBorderBottomTilesTexCoords.end());
-
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Height > 0)
-						{
-							for(int i = 0; i < pTMap->m_Height; ++i)
-							{
-								Visuals.m_vBorderLeft[i].AddIndexBufferByteOffset(TilesHandledCount);
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderLeftTiles.begin(), vtmpBorderLeftTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderLeftTilesTexCoords.begin(), vtmpBorderLeftTilesTexCoords.end());
-
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Height > 0)
-						{
-							for(int i = 0; i < pTMap->m_Height; ++i)
-							{
-								Visuals.m_vBorderRight[i].AddIndexBufferByteOffset(TilesHandledCount);
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderRightTiles.begin(), vtmpBorderRightTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderRightTilesTexCoords.begin(), vtmpBorderRightTilesTexCoords.end());
-
-						//setup params
-						float *pTmpTiles = vtmpTiles.empty() ? NULL : (float *)vtmpTiles.data();
-						unsigned char *pTmpTileTexCoords = vtmpTileTexCoords.empty() ? NULL : (unsigned char *)vtmpTileTexCoords.data();
-
-						Visuals.m_BufferContainerIndex = -1;
-						size_t UploadDataSize = vtmpTileTexCoords.size() * sizeof(SGraphicTileTexureCoords) + vtmpTiles.size() * sizeof(SGraphicTile);
-						if(UploadDataSize > 0)
-						{
-							char *pUploadData = (char *)malloc(sizeof(char) * UploadDataSize);
-
-							mem_copy_special(pUploadData, pTmpTiles, sizeof(vec2), vtmpTiles.size() * 4, (DoTextureCoords ? sizeof(ubvec4) : 0));
-							if(DoTextureCoords)
-							{
-								mem_copy_special(pUploadData + sizeof(vec2), pTmpTileTexCoords, sizeof(ubvec4), vtmpTiles.size() * 4, sizeof(vec2));
-							}
-
-							// first create the buffer object
-							int BufferObjectIndex = Graphics()->CreateBufferObject(UploadDataSize, pUploadData, 0, true);
-
-							// then create the buffer container
-							SBufferContainerInfo ContainerInfo;
-							ContainerInfo.m_Stride = (DoTextureCoords ? (sizeof(float) * 2 + sizeof(ubvec4)) : 0);
-							ContainerInfo.m_VertBufferBindingIndex = BufferObjectIndex;
-							ContainerInfo.m_vAttributes.emplace_back();
-							SBufferContainerInfo::SAttribute *pAttr = &ContainerInfo.m_vAttributes.back();
-							pAttr->m_DataTypeCount = 2;
-							pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
-							pAttr->m_Normalized = false;
-							pAttr->m_pOffset = 0;
-							pAttr->m_FuncType = 0;
-							if(DoTextureCoords)
-							{
-								ContainerInfo.m_vAttributes.emplace_back();
-								pAttr = &ContainerInfo.m_vAttributes.back();
-								pAttr->m_DataTypeCount = 4;
-								pAttr->m_Type = GRAPHICS_TYPE_UNSIGNED_BYTE;
-								pAttr->m_Normalized = false;
-								pAttr->m_pOffset = (void *)(sizeof(vec2));
-								pAttr->m_FuncType = 1;
-							}
-
-							Visuals.m_BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
-							// and finally inform the backend how many indices are required
-							Graphics()->IndicesNumRequiredNotify(vtmpTiles.size() * 6);
-
-							RenderLoading();
-						}
-
-						++CurOverlay;
+						auto pBuild = std::make_shared<CTileLayerBuild>();
+						pBuild->m_pVisuals = &Visuals;
+						pBuild->m_pTMap = pTMap;
+						pBuild->m_pTiles = pTiles;
+						pBuild->m_pGroup = pGroup;
+						pBuild->m_CurOverlay = CurOverlay;
+						pBuild->m_DoTextureCoords = DoTextureCoords;
+						pBuild->m_IsGameLayer = IsGameLayer;
+						pBuild->m_IsFrontLayer = IsFrontLayer;
+						pBuild->m_IsSwitchLayer = IsSwitchLayer;
+						pBuild->m_IsTeleLayer = IsTeleLayer;
+						pBuild->m_IsSpeedupLayer = IsSpeedupLayer;
+						pBuild->m_IsTuneLayer = IsTuneLayer;
+						pBuild->m_IsEntityLayer = IsEntityLayer;
+
+						for(const auto &pBand : pBuild->CreateBands())
+							Engine()->AddJob(pBand);
+						vpTileLayerBuilds.push_back(pBuild);
 					}
 				}
 			}
@@ -794,109 +360,117 @@ void CMapLayers::OnMapLoad()
 				CMapItemLayerQuads *pQLayer = (CMapItemLayerQuads *)pLayer;
 
 				m_vpQuadLayerVisuals.push_back(new SQuadLayerVisuals());
-				SQuadLayerVisuals *pQLayerVisuals = m_vpQuadLayerVisuals.back();
 
-				bool Textured = (pQLayer->m_Image != -1);
+				auto pJob = std::make_shared<CQuadLayerBuildJob>();
+				pJob->m_pVisuals = m_vpQuadLayerVisuals.back();
+				pJob->m_pQLayer = pQLayer;
+				pJob->m_pQuads = (CQuad *)m_pLayers->Map()->GetDataSwapped(pQLayer->m_Data);
+				pJob->m_Textured = pQLayer->m_Image != -1;
+				Engine()->AddJob(pJob);
+				vpQuadLayerJobs.push_back(pJob);
+			}
+		}
+	}
 
-				vtmpQuads.clear();
-				vtmpQuadsTextured.clear();
+	// the last band of each layer joins it on the job pool, upload the layers in order as they are done
+	for(const auto &pBuild : vpTileLayerBuilds)
+	{
+		pBuild->Wait();
 
-				if(Textured)
-					vtmpQuadsTextured.resize(pQLayer->m_NumQuads);
-				else
-					vtmpQuads.resize(pQLayer->m_NumQuads);
+		STileLayerVisuals &Visuals = *pBuild->m_pVisuals;
+		Visuals.m_BufferContainerIndex = -1;
+		if(pBuild->m_UploadDataSize > 0)
+		{
+			const bool DoTextureCoords = pBuild->m_DoTextureCoords;
+
+			// first create the buffer object, it takes the ownership of the data
+			int BufferObjectIndex = Graphics()->CreateBufferObject(pBuild->m_UploadDataSize, pBuild->m_pUploadData, 0, true);
+			pBuild->m_pUploadData = nullptr;
+
+			// then create the buffer container
+			SBufferContainerInfo ContainerInfo;
+			ContainerInfo.m_Stride = (DoTextureCoords ? (sizeof(float) * 2 + sizeof(ubvec4)) : 0);
+			ContainerInfo.m_VertBufferBindingIndex = BufferObjectIndex;
+			ContainerInfo.m_vAttributes.emplace_back();
+			SBufferContainerInfo::SAttribute *pAttr = &ContainerInfo.m_vAttributes.back();
+			pAttr->m_DataTypeCount = 2;
+			pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
+			pAttr->m_Normalized = false;
+			pAttr->m_pOffset = 0;
+			pAttr->m_FuncType = 0;
+			if(DoTextureCoords)
+			{
+				ContainerInfo.m_vAttributes.emplace_back();
+				pAttr = &ContainerInfo.m_vAttributes.back();
+				pAttr->m_DataTypeCount = 4;
+				pAttr->m_Type = GRAPHICS_TYPE_UNSIGNED_BYTE;
+				pAttr->m_Normalized = false;
+				pAttr->m_pOffset = (void *)(sizeof(vec2));
+				pAttr->m_FuncType = 1;
+			}
 
-				CQuad *pQuads = (CQuad *)m_pLayers->Map()->GetDataSwapped(pQLayer->m_Data);
-				for(int i = 0; i < pQLayer->m_NumQuads; ++i)
-				{
-					CQuad *pQuad = &pQuads[i];
-					for(int j = 0; j < 4; ++j)
-					{
-						int QuadIDX = j;
-						if(j == 2)
-							QuadIDX = 3;
-						else if(j == 3)
-							QuadIDX = 2;
-						if(!Textured)
-						{
-							// ignore the conversion for the position coordinates
-							vtmpQuads[i].m_aVertices[j].m_X = (pQuad->m_aPoints[QuadIDX].x);
-							vtmpQuads[i].m_aVertices[j].m_Y = (pQuad->m_aPoints[QuadIDX].y);
-							vtmpQuads[i].m_aVertices[j].m_CenterX = (pQuad->m_aPoints[4].x);
-							vtmpQuads[i].m_aVertices[j].m_CenterY = (pQuad->m_aPoints[4].y);
-							vtmpQuads[i].m_aVertices[j].m_R = (unsigned char)pQuad->m_aColors[QuadIDX].r;
-							vtmpQuads[i].m_aVertices[j].m_G = (unsigned char)pQuad->m_aColors[QuadIDX].g;
-							vtmpQuads[i].m_aVertices[j].m_B = (unsigned char)pQuad->m_aColors[QuadIDX].b;
-							vtmpQuads[i].m_aVertices[j].m_A = (unsigned char)pQuad->m_aColors[QuadIDX].a;
-						}
-						else
-						{
-							// ignore the conversion for the position coordinates
-							vtmpQuadsTextured[i].m_aVertices[j].m_X = (pQuad->m_aPoints[QuadIDX].x);
-							vtmpQuadsTextured[i].m_aVertices[j].m_Y = (pQuad->m_aPoints[QuadIDX].y);
-							vtmpQuadsTextured[i].m_aVertices[j].m_CenterX = (pQuad->m_aPoints[4].x);
-							vtmpQuadsTextured[i].m_aVertices[j].m_CenterY = (pQuad->m_aPoints[4].y);
-							vtmpQuadsTextured[i].m_aVertices[j].m_U = fx2f(pQuad->m_aTexcoords[QuadIDX].x);
-							vtmpQuadsTextured[i].m_aVertices[j].m_V = fx2f(pQuad->m_aTexcoords[QuadIDX].y);
-							vtmpQuadsTextured[i].m_aVertices[j].m_R = (unsigned char)pQuad->m_aColors[QuadIDX].r;
-							vtmpQuadsTextured[i].m_aVertices[j].m_G = (unsigned char)pQuad->m_aColors[QuadIDX].g;
-							vtmpQuadsTextured[i].m_aVertices[j].m_B = (unsigned char)pQuad->m_aColors[QuadIDX].b;
-							vtmpQuadsTextured[i].m_aVertices[j].m_A = (unsigned char)pQuad->m_aColors[QuadIDX].a;
-						}
-					}
-				}
+			Visuals.m_BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
+			// and finally inform the backend how many indices are required
+			Graphics()->IndicesNumRequiredNotify(pBuild->m_NumTiles * 6);
 
-				size_t UploadDataSize = 0;
-				if(Textured)
-					UploadDataSize = vtmpQuadsTextured.size() * sizeof(STmpQuadTextured);
-				else
-					UploadDataSize = vtmpQuads.size() * sizeof(STmpQuad);
+			RenderLoading();
+		}
+	}
 
-				if(UploadDataSize > 0)
-				{
-					void *pUploadData = NULL;
-					if(Textured)
-						pUploadData = vtmpQuadsTextured.data();
-					else
-						pUploadData = vtmpQuads.data();
-					// create the buffer object
-					int BufferObjectIndex = Graphics()->CreateBufferObject(UploadDataSize, pUploadData, 0);
-					// then create the buffer container
-					SBufferContainerInfo ContainerInfo;
-					ContainerInfo.m_Stride = (Textured ? (sizeof(STmpQuadTextured) / 4) : (sizeof(STmpQuad) / 4));
-					ContainerInfo.m_VertBufferBindingIndex = BufferObjectIndex;
-					ContainerInfo.m_vAttributes.emplace_back();
-					SBufferContainerInfo::SAttribute *pAttr = &ContainerInfo.m_vAttributes.back();
-					pAttr->m_DataTypeCount = 4;
-					pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
-					pAttr->m_Normalized = false;
-					pAttr->m_pOffset = 0;
-					pAttr->m_FuncType = 0;
-					ContainerInfo.m_vAttributes.emplace_back();
-					pAttr = &ContainerInfo.m_vAttributes.back();
-					pAttr->m_DataTypeCount = 4;
-					pAttr->m_Type = GRAPHICS_TYPE_UNSIGNED_BYTE;
-					pAttr->m_Normalized = true;
-					pAttr->m_pOffset = (void *)(sizeof(float) * 4);
-					pAttr->m_FuncType = 0;
-					if(Textured)
-					{
-						ContainerInfo.m_vAttributes.emplace_back();
-						pAttr = &ContainerInfo.m_vAttributes.back();
-						pAttr->m_DataTypeCount = 2;
-						pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
-						pAttr->m_Normalized = false;
-						pAttr->m_pOffset = (void *)(sizeof(float) * 4 + sizeof(unsigned char) * 4);
-						pAttr->m_FuncType = 0;
-					}
+	for(const auto &pJob : vpQuadLayerJobs)
+	{
+		pJob->Wait();
 
-					pQLayerVisuals->m_BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
-					// and finally inform the backend how many indices are required
-					Graphics()->IndicesNumRequiredNotify(pQLayer->m_NumQuads * 6);
+		const bool Textured = pJob->m_Textured;
+		size_t UploadDataSize = 0;
+		if(Textured)
+			UploadDataSize = pJob->m_vTmpQuadsTextured.size() * sizeof(STmpQuadTextured);
+		else
+			UploadDataSize = pJob->m_vTmpQuads.size() * sizeof(STmpQuad);
 
-					RenderLoading();
-				}
+		if(UploadDataSize > 0)
+		{
+			void *pUploadData = NULL;
+			if(Textured)
+				pUploadData = pJob->m_vTmpQuadsTextured.data();
+			else
+				pUploadData = pJob->m_vTmpQuads.data();
+			// create the buffer object
+			int BufferObjectIndex = Graphics()->CreateBufferObject(UploadDataSize, pUploadData, 0);
+			// then create the buffer container
+			SBufferContainerInfo ContainerInfo;
+			ContainerInfo.m_Stride = (Textured ? (sizeof(STmpQuadTextured) / 4) : (sizeof(STmpQuad) / 4));
+			ContainerInfo.m_VertBufferBindingIndex = BufferObjectIndex;
+			ContainerInfo.m_vAttributes.emplace_back();
+			SBufferContainerInfo::SAttribute *pAttr = &ContainerInfo.m_vAttributes.back();
+			pAttr->m_DataTypeCount = 4;
+			pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
+			pAttr->m_Normalized = false;
+			pAttr->m_pOffset = 0;
+			pAttr->m_FuncType = 0;
+			ContainerInfo.m_vAttributes.emplace_back();
+			pAttr = &ContainerInfo.m_vAttributes.back();
+			pAttr->m_DataTypeCount = 4;
+			pAttr->m_Type = GRAPHICS_TYPE_UNSIGNED_BYTE;
+			pAttr->m_Normalized = true;
+			pAttr->m_pOffset = (void *)(sizeof(float) * 4);
+			pAttr->m_FuncType = 0;
+			if(Textured)
+			{
+				ContainerInfo.m_vAttributes.emplace_back();
+				pAttr = &ContainerInfo.m_vAttributes.back();
+				pAttr->m_DataTypeCount = 2;
+				pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
+				pAttr->m_Normalized = false;
+				pAttr->m_pOffset = (void *)(sizeof(float) * 4 + sizeof(unsigned char) * 4);
+				pAttr->m_FuncType = 0;
 			}
+
+			pJob->m_pVisuals->m_BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
+			// and finally inform the backend how many indices are required
+			Graphics()->IndicesNumRequiredNotify(pJob->m_pQLayer->m_NumQuads * 6);
+
+			RenderLoading();
 		}
 	}
 }
@@ -3,18 +3,14 @@
 #ifndef GAME_CLIENT_COMPONENTS_MAPLAYERS_H
 #define GAME_CLIENT_COMPONENTS_MAPLAYERS_H
 #include <game/client/component.h>
+#include <game/client/map_layer_visuals.h>
 
-#include <cstdint>
 #include <vector>
 
 #define INDEX_BUFFER_GROUP_WIDTH 12
 #define INDEX_BUFFER_GROUP_HEIGHT 9
 #define INDEX_BORDER_BUFFER_GROUP_SIZE 20
 
-typedef char *offset_ptr_size;
-typedef uintptr_t offset_ptr;
-typedef unsigned int offset_ptr32;
-
 class CCamera;
 class CLayers;
 class CMapImages;
@@ -37,95 +33,8 @@ class CMapLayers : public CComponent
 
 	bool m_OnlineOnly;
 
-	struct STileLayerVisuals
-	{
-		STileLayerVisuals() :
-			m_pTilesOfLayer(nullptr)
-		{
-			m_Width = 0;
-			m_Height = 0;
-			m_BufferContainerIndex = -1;
-			m_IsTextured = false;
-		}
-
-		bool Init(unsigned int Width, unsigned int Height);
-
-		~STileLayerVisuals();
-
-		struct STileVisual
-		{
-			STileVisual() :
-				m_IndexBufferByteOffset(0) {}
-
-		private:
-			offset_ptr32 m_IndexBufferByteOffset;
-
-		public:
-			bool DoDraw()
-			{
-				return (m_IndexBufferByteOffset & 0x10000000) != 0;
-			}
-
-			void Draw(bool SetDraw)
-			{
-				m_IndexBufferByteOffset = (SetDraw ? 0x10000000 : (offset_ptr32)0) | (m_IndexBufferByteOffset & 0xEFFFFFFF);
-			}
-
-			offset_ptr IndexBufferByteOffset()
-			{
-				return ((offset_ptr)(m_IndexBufferByteOffset & 0xEFFFFFFF) * 6 * sizeof(uint32_t));
-			}
-
-			void SetIndexBufferByteOffset(offset_ptr32 IndexBufferByteOff)
-			{
-				m_IndexBufferByteOffset = IndexBufferByteOff | (m_IndexBufferByteOffset & 0x10000000);
-			}
-
-			void AddIndexBufferByteOffset(offset_ptr32 IndexBufferByteOff)
-			{
-				m_IndexBufferByteOffset = ((m_IndexBufferByteOffset & 0xEFFFFFFF) + IndexBufferByteOff) | (m_IndexBufferByteOffset & 0x10000000);
-			}
-		};
-		STileVisual *m_pTilesOfLayer;
-
-		STileVisual m_BorderTopLeft;
-		STileVisual m_BorderTopRight;
-		STileVisual m_BorderBottomRight;
-		STileVisual m_BorderBottomLeft;
-
-		STileVisual m_BorderKillTile; //end of map kill tile -- game layer only
-
-		std::vector<STileVisual> m_vBorderTop;
-		std::vector<STileVisual> m_vBorderLeft;
-		std::vector<STileVisual> m_vBorderRight;
-		std::vector<STileVisual> m_vBorderBottom;
-
-		unsigned int m_Width;
-		unsigned int m_Height;
-		int m_BufferContainerIndex;
-		bool m_IsTextured;
-	};
 	std::vector<STileLayerVisuals *> m_vpTileLayerVisuals;
 
-	struct SQuadLayerVisuals
-	{
-		SQuadLayerVisuals() :
-			m_QuadNum(0), m_pQuadsOfLayer(nullptr), m_BufferContainerIndex(-1), m_IsTextured(false) {}
-
-		struct SQuadVisual
-		{
-			SQuadVisual() :
-				m_IndexBufferByteOffset(0) {}
-
-			offset_ptr m_IndexBufferByteOffset;
-		};
-
-		int m_QuadNum;
-		SQuadVisual *m_pQuadsOfLayer;
-
-		int m_BufferContainerIndex;
-		bool m_IsTextured;
-	};
 	std::vector<SQuadLayerVisuals *> m_vpQuadLayerVisuals;
 
 	virtual CCamera *GetCurCamera();
@@ -729,6 +729,7 @@ public:
 	void GhostlistPopulate();
 	CGhostItem *GetOwnGhost();
 	void UpdateOwnGhost(CGhostItem Item);
+	void GhostFailed(int Slot);
 	void DeleteGhostItem(int Index);
 
 	int GetCurPopup() const { return m_Popup; }
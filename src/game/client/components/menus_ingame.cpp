@@ -919,7 +919,7 @@ int CMenus::GhostlistFetchCallback(const CFsFileInfo *pInfo, int IsDir, int Stor
 	str_format(aFilename, sizeof(aFilename), "%s/%s", pSelf->m_pClient->m_Ghost.GetGhostDir(), pInfo->m_pName);
 
 	CGhostInfo Info;
-	if(!pSelf->m_pClient->m_Ghost.GhostLoader()->GetGhostInfo(aFilename, &Info, pMap, pSelf->Client()->GetCurrentMapSha256(), pSelf->Client()->GetCurrentMapCrc()))
+	if(!pSelf->m_pClient->m_Ghost.GhostLoader()->GetGhostInfo(aFilename, pInfo->m_TimeModified, &Info, pMap, pSelf->Client()->GetCurrentMapSha256(), pSelf->Client()->GetCurrentMapCrc()))
 		return 0;
 
 	CGhostItem Item;
@@ -942,7 +942,11 @@ void CMenus::GhostlistPopulate()
 {
 	m_vGhosts.clear();
 	m_GhostPopulateStartTime = time_get_nanoseconds();
+	char aIndexFilename[IO_MAX_PATH_LENGTH];
+	str_format(aIndexFilename, sizeof(aIndexFilename), "%s/%s.ghostindex", m_pClient->m_Ghost.GetGhostDir(), Client()->GetCurrentMap());
+	m_pClient->m_Ghost.GhostLoader()->LoadIndex(aIndexFilename);
 	Storage()->ListDirectoryInfo(IStorage::TYPE_ALL, m_pClient->m_Ghost.GetGhostDir(), GhostlistFetchCallback, this);
+	m_pClient->m_Ghost.GhostLoader()->SaveIndex();
 	std::sort(m_vGhosts.begin(), m_vGhosts.end());
 
 	CGhostItem *pOwnGhost = 0;
@@ -1004,10 +1008,26 @@ void CMenus::UpdateOwnGhost(CGhostItem Item)
 	m_vGhosts.insert(std::lower_bound(m_vGhosts.begin(), m_vGhosts.end(), Item), Item);
 }
 
+void CMenus::GhostFailed(int Slot)
+{
+	for(auto &Ghost : m_vGhosts)
+	{
+		if(Ghost.m_Slot == Slot)
+		{
+			Ghost.m_Slot = -1;
+			Ghost.m_Failed = true;
+		}
+	}
+}
+
 void CMenus::DeleteGhostItem(int Index)
 {
 	if(m_vGhosts[Index].HasFile())
+	{
+		// the ghost may still be saved in the background
+		m_pClient->m_Ghost.GhostRecorder()->CancelWrite(m_vGhosts[Index].m_aFilename);
 		Storage()->RemoveFile(m_vGhosts[Index].m_aFilename, IStorage::TYPE_SAVE);
+	}
 	m_vGhosts.erase(m_vGhosts.begin() + Index);
 }
 
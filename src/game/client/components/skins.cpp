@@ -16,6 +16,9 @@
 
 #include "skins.h"
 
+#include <string>
+#include <unordered_set>
+
 bool CSkins::IsVanillaSkin(const char *pName)
 {
 	return std::any_of(std::begin(VANILLA_SKINS), std::end(VANILLA_SKINS), [pName](const char *pVanillaSkin) { return str_comp(pName, pVanillaSkin) == 0; });
@@ -24,9 +27,9 @@ bool CSkins::IsVanillaSkin(const char *pName)
 void CSkins::CGetPngFile::OnCompletion(EHttpState State)
 {
 	// Maybe this should start another thread to load the png in instead of stalling the curl thread
-	if(State == EHttpState::DONE)
+	if(State == EHttpState::DONE && m_pSkins->LoadSkinPNG(m_Data.m_Info, Dest(), Dest(), IStorage::TYPE_SAVE))
 	{
-		m_pSkins->LoadSkinPNG(m_Info, Dest(), Dest(), IStorage::TYPE_SAVE);
+		m_Data.m_Prepared = m_Data.Prepare();
 	}
 }
 
@@ -42,7 +45,8 @@ CSkins::CGetPngFile::CGetPngFile(CSkins *pSkins, const char *pUrl, IStorage *pSt
 struct SSkinScanUser
 {
 	CSkins *m_pThis;
-	CSkins::TSkinLoadedCBFunc m_SkinLoadedFunc;
+	std::vector<std::shared_ptr<CSkinLoadJob>> m_vpJobs;
+	std::unordered_set<std::string> m_Names;
 };
 
 int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
@@ -62,59 +66,15 @@ int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
 
 	// Don't add duplicate skins (one from user's config directory, other from
 	// client itself)
-	if(pSelf->m_Skins.find(aNameWithoutPng) != pSelf->m_Skins.end())
+	if(!pUserReal->m_Names.insert(aNameWithoutPng).second)
 		return 0;
 
 	char aBuf[IO_MAX_PATH_LENGTH];
 	str_format(aBuf, sizeof(aBuf), "skins/%s", pName);
-	pSelf->LoadSkin(aNameWithoutPng, aBuf, DirType);
-	pUserReal->m_SkinLoadedFunc((int)pSelf->m_Skins.size());
+	pUserReal->m_vpJobs.push_back(std::make_shared<CSkinLoadJob>(pSelf->Storage(), aNameWithoutPng, aBuf, DirType));
 	return 0;
 }
 
-static void CheckMetrics(CSkin::SSkinMetricVariable &Metrics, const uint8_t *pImg, int ImgWidth, int ImgX, int ImgY, int CheckWidth, int CheckHeight)
-{
-	int MaxY = -1;
-	int MinY = CheckHeight + 1;
-	int MaxX = -1;
-	int MinX = CheckWidth + 1;
-
-	for(int y = 0; y < CheckHeight; y++)
-	{
-		for(int x = 0; x < CheckWidth; x++)
-		{
-			int OffsetAlpha = (y + ImgY) * ImgWidth + (x + ImgX) * 4 + 3;
-			uint8_t AlphaValue = pImg[OffsetAlpha];
-			if(AlphaValue > 0)
-			{
-				if(MaxY < y)
-					MaxY = y;
-				if(MinY > y)
-					MinY = y;
-				if(MaxX < x)
-					MaxX = x;
-				if(MinX > x)
-					MinX = x;
-			}
-		}
-	}
-
-	Metrics.m_Width = clamp((MaxX - MinX) + 1, 1, CheckWidth);
-	Metrics.m_Height = clamp((MaxY - MinY) + 1, 1, CheckHeight);
-	Metrics.m_OffsetX = clamp(MinX, 0, CheckWidth - 1);
-	Metrics.m_OffsetY = clamp(MinY, 0, CheckHeight - 1);
-	Metrics.m_MaxWidth = CheckWidth;
-	Metrics.m_MaxHeight = CheckHeight;
-}
-
-const CSkin *CSkins::LoadSkin(const char *pName, const char *pPath, int DirType)
-{
-	CImageInfo Info;
-	if(!LoadSkinPNG(Info, pName, pPath, DirType))
-		return 0;
-	return LoadSkin(pName, Info);
-}
-
 bool CSkins::LoadSkinPNG(CImageInfo &Info, const char *pName, const char *pPath, int DirType)
 {
 	char aBuf[512];
@@ -127,23 +87,36 @@ bool CSkins::LoadSkinPNG(CImageInfo &Info, const char *pName, const char *pPath,
 	return true;
 }
 
-const CSkin *CSkins::LoadSkin(const char *pName, CImageInfo &Info)
+const CSkin *CSkins::LoadSkin(const char *pName, CSkinLoadData &Data)
 {
 	char aBuf[512];
 
-	if(!Graphics()->CheckImageDivisibility(pName, Info, g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridx, g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy, true))
+	if(!Data.m_Prepared)
 	{
-		str_format(aBuf, sizeof(aBuf), "skin failed image divisibility: %s", pName);
-		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "game", aBuf);
-		return nullptr;
-	}
-	if(!Graphics()->IsImageFormatRGBA(pName, Info))
-	{
-		str_format(aBuf, sizeof(aBuf), "skin format is not RGBA: %s", pName);
-		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "game", aBuf);
-		return nullptr;
+		if(!Graphics()->CheckImageDivisibility(pName, Data.m_Info, g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridx, g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy, true))
+		{
+			str_format(aBuf, sizeof(aBuf), "skin failed image divisibility: %s", pName);
+			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "game", aBuf);
+			Data.Free();
+			return nullptr;
+		}
+		if(!Graphics()->IsImageFormatRGBA(pName, Data.m_Info))
+		{
+			str_format(aBuf, sizeof(aBuf), "skin format is not RGBA: %s", pName);
+			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "game", aBuf);
+			Data.Free();
+			return nullptr;
+		}
+		if(!Data.Prepare())
+		{
+			Data.Free();
+			return nullptr;
+		}
 	}
 
+	CImageInfo &Info = Data.m_Info;
+	CImageInfo &InfoGrayscale = Data.m_InfoGrayscale;
+
 	CSkin Skin{pName};
 	Skin.m_OriginalSkin.m_Body = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_BODY]);
 	Skin.m_OriginalSkin.m_BodyOutline = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE]);
@@ -155,127 +128,20 @@ const CSkin *CSkins::LoadSkin(const char *pName, CImageInfo &Info)
 	for(int i = 0; i < 6; ++i)
 		Skin.m_OriginalSkin.m_aEyes[i] = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_EYE_NORMAL + i]);
 
-	int FeetGridPixelsWidth = (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_FOOT].m_pSet->m_Gridx);
-	int FeetGridPixelsHeight = (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_FOOT].m_pSet->m_Gridy);
-	int FeetWidth = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_W * FeetGridPixelsWidth;
-	int FeetHeight = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_H * FeetGridPixelsHeight;
-
-	int FeetOffsetX = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_X * FeetGridPixelsWidth;
-	int FeetOffsetY = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_Y * FeetGridPixelsHeight;
-
-	int FeetOutlineGridPixelsWidth = (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_pSet->m_Gridx);
-	int FeetOutlineGridPixelsHeight = (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_pSet->m_Gridy);
-	int FeetOutlineWidth = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_W * FeetOutlineGridPixelsWidth;
-	int FeetOutlineHeight = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_H * FeetOutlineGridPixelsHeight;
-
-	int FeetOutlineOffsetX = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_X * FeetOutlineGridPixelsWidth;
-	int FeetOutlineOffsetY = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_Y * FeetOutlineGridPixelsHeight;
-
-	int BodyOutlineGridPixelsWidth = (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_pSet->m_Gridx);
-	int BodyOutlineGridPixelsHeight = (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_pSet->m_Gridy);
-	int BodyOutlineWidth = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_W * BodyOutlineGridPixelsWidth;
-	int BodyOutlineHeight = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_H * BodyOutlineGridPixelsHeight;
-
-	int BodyOutlineOffsetX = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_X * BodyOutlineGridPixelsWidth;
-	int BodyOutlineOffsetY = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_Y * BodyOutlineGridPixelsHeight;
-
-	int BodyWidth = g_pData->m_aSprites[SPRITE_TEE_BODY].m_W * (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridx); // body width
-	int BodyHeight = g_pData->m_aSprites[SPRITE_TEE_BODY].m_H * (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy); // body height
-	if(BodyWidth > Info.m_Width || BodyHeight > Info.m_Height)
-		return nullptr;
-	unsigned char *pData = (unsigned char *)Info.m_pData;
-	const int PixelStep = 4;
-	int Pitch = Info.m_Width * PixelStep;
-
-	// dig out blood color
-	{
-		int aColors[3] = {0};
-		for(int y = 0; y < BodyHeight; y++)
-			for(int x = 0; x < BodyWidth; x++)
-			{
-				uint8_t AlphaValue = pData[y * Pitch + x * PixelStep + 3];
-				if(AlphaValue > 128)
-				{
-					aColors[0] += pData[y * Pitch + x * PixelStep + 0];
-					aColors[1] += pData[y * Pitch + x * PixelStep + 1];
-					aColors[2] += pData[y * Pitch + x * PixelStep + 2];
-				}
-			}
-		if(aColors[0] != 0 && aColors[1] != 0 && aColors[2] != 0)
-			Skin.m_BloodColor = ColorRGBA(normalize(vec3(aColors[0], aColors[1], aColors[2])));
-		else
-			Skin.m_BloodColor = ColorRGBA(0, 0, 0, 1);
-	}
-
-	CheckMetrics(Skin.m_Metrics.m_Body, pData, Pitch, 0, 0, BodyWidth, BodyHeight);
-
-	// body outline metrics
-	CheckMetrics(Skin.m_Metrics.m_Body, pData, Pitch, BodyOutlineOffsetX, BodyOutlineOffsetY, BodyOutlineWidth, BodyOutlineHeight);
-
-	// get feet size
-	CheckMetrics(Skin.m_Metrics.m_Feet, pData, Pitch, FeetOffsetX, FeetOffsetY, FeetWidth, FeetHeight);
-
-	// get feet outline size
-	CheckMetrics(Skin.m_Metrics.m_Feet, pData, Pitch, FeetOutlineOffsetX, FeetOutlineOffsetY, FeetOutlineWidth, FeetOutlineHeight);
-
-	// make the texture gray scale
-	for(int i = 0; i < Info.m_Width * Info.m_Height; i++)
-	{
-		int v = (pData[i * PixelStep] + pData[i * PixelStep + 1] + pData[i * PixelStep + 2]) / 3;
-		pData[i * PixelStep] = v;
-		pData[i * PixelStep + 1] = v;
-		pData[i * PixelStep + 2] = v;
-	}
-
-	int aFreq[256] = {0};
-	int OrgWeight = 0;
-	int NewWeight = 192;
-
-	// find most common frequency
-	for(int y = 0; y < BodyHeight; y++)
-		for(int x = 0; x < BodyWidth; x++)
-		{
-			if(pData[y * Pitch + x * PixelStep + 3] > 128)
-				aFreq[pData[y * Pitch + x * PixelStep]]++;
-		}
-
-	for(int i = 1; i < 256; i++)
-	{
-		if(aFreq[OrgWeight] < aFreq[i])
-			OrgWeight = i;
-	}
-
-	// reorder
-	int InvOrgWeight = 255 - OrgWeight;
-	int InvNewWeight = 255 - NewWeight;
-	for(int y = 0; y < BodyHeight; y++)
-		for(int x = 0; x < BodyWidth; x++)
-		{
-			int v = pData[y * Pitch + x * PixelStep];
-			if(v <= OrgWeight && OrgWeight == 0)
-				v = 0;
-			else if(v <= OrgWeight)
-				v = (int)(((v / (float)OrgWeight) * NewWeight));
-			else if(InvOrgWeight == 0)
-				v = NewWeight;
-			else
-				v = (int)(((v - OrgWeight) / (float)InvOrgWeight) * InvNewWeight + NewWeight);
-			pData[y * Pitch + x * PixelStep] = v;
-			pData[y * Pitch + x * PixelStep + 1] = v;
-			pData[y * Pitch + x * PixelStep + 2] = v;
-		}
-
-	Skin.m_ColorableSkin.m_Body = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_BODY]);
-	Skin.m_ColorableSkin.m_BodyOutline = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE]);
-	Skin.m_ColorableSkin.m_Feet = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_FOOT]);
-	Skin.m_ColorableSkin.m_FeetOutline = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE]);
-	Skin.m_ColorableSkin.m_Hands = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_HAND]);
-	Skin.m_ColorableSkin.m_HandsOutline = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_HAND_OUTLINE]);
+	Skin.m_ColorableSkin.m_Body = Graphics()->LoadSpriteTexture(InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_BODY]);
+	Skin.m_ColorableSkin.m_BodyOutline = Graphics()->LoadSpriteTexture(InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE]);
+	Skin.m_ColorableSkin.m_Feet = Graphics()->LoadSpriteTexture(InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_FOOT]);
+	Skin.m_ColorableSkin.m_FeetOutline = Graphics()->LoadSpriteTexture(InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE]);
+	Skin.m_ColorableSkin.m_Hands = Graphics()->LoadSpriteTexture(InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_HAND]);
+	Skin.m_ColorableSkin.m_HandsOutline = Graphics()->LoadSpriteTexture(InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_HAND_OUTLINE]);
 
 	for(int i = 0; i < 6; ++i)
-		Skin.m_ColorableSkin.m_aEyes[i] = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_EYE_NORMAL + i]);
+		Skin.m_ColorableSkin.m_aEyes[i] = Graphics()->LoadSpriteTexture(InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_EYE_NORMAL + i]);
+
+	Skin.m_BloodColor = Data.m_BloodColor;
+	Skin.m_Metrics = Data.m_Metrics;
 
-	Graphics()->FreePNG(&Info);
+	Data.Free();
 
 	// set skin data
 	if(g_Config.m_Debug)
@@ -302,13 +168,39 @@ void CSkins::OnInit()
 		}
 	}
 
+	m_PlaceholderSkin.m_BloodColor = ColorRGBA(1.0f, 1.0f, 1.0f);
+
 	// load skins;
-	Refresh([this](int SkinCounter) {
-		GameClient()->m_Menus.RenderLoading(Localize("Loading DDNet Client"), Localize("Loading skin files"), 0);
-	});
+	GameClient()->m_Menus.RenderLoading(Localize("Loading DDNet Client"), Localize("Loading skin files"), 0);
+	Refresh();
+}
+
+void CSkins::OnRender()
+{
+	if(m_LoadJobs.empty())
+		return;
+
+	// upload the skins in the order they were found, only as many per
+	// frame as fit into the budget
+	const int64_t Deadline = time_get() + time_freq() * UPLOAD_BUDGET_MS / 1000;
+	while(!m_LoadJobs.empty() && m_LoadJobs.front()->Status() == IJob::STATE_DONE && time_get() < Deadline)
+	{
+		const std::shared_ptr<CSkinLoadJob> pJob = m_LoadJobs.front();
+		m_LoadJobs.pop_front();
+		m_LoadingSkins.erase(pJob->m_aName);
+		if(pJob->m_Loaded)
+			LoadSkin(pJob->m_aName, pJob->m_Data);
+	}
+
+	if(m_LoadJobs.empty())
+	{
+		if(m_Skins.empty())
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "gameclient", "failed to load skins. folder='skins/'");
+		GameClient()->OnSkinsRefreshed();
+	}
 }
 
-void CSkins::Refresh(TSkinLoadedCBFunc &&SkinLoadedFunc)
+void CSkins::Refresh()
 {
 	for(const auto &SkinIt : m_Skins)
 	{
@@ -335,18 +227,35 @@ void CSkins::Refresh(TSkinLoadedCBFunc &&SkinLoadedFunc)
 	m_Skins.clear();
 	m_DownloadSkins.clear();
 	m_DownloadingSkins = 0;
+	m_LoadingSkins.clear();
+	m_LoadJobs.clear();
 	SSkinScanUser SkinScanUser;
 	SkinScanUser.m_pThis = this;
-	SkinScanUser.m_SkinLoadedFunc = SkinLoadedFunc;
 	Storage()->ListDirectory(IStorage::TYPE_ALL, "skins", SkinScan, &SkinScanUser);
-	if(m_Skins.empty())
+
+	// decode and prepare the images on the job pool, OnRender uploads them
+	// once they are done. The default skin is loaded right away, it is
+	// used in place of the skins that are still loading.
+	std::shared_ptr<CSkinLoadJob> pDefaultJob;
+	for(const auto &pJob : SkinScanUser.m_vpJobs)
 	{
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "gameclient", "failed to load skins. folder='skins/'");
-		CSkin DummySkin{"dummy"};
-		DummySkin.m_BloodColor = ColorRGBA(1.0f, 1.0f, 1.0f);
-		auto &&pDummySkin = std::make_unique<CSkin>(std::move(DummySkin));
-		m_Skins.insert({pDummySkin->GetName(), std::move(pDummySkin)});
+		if(str_comp(pJob->m_aName, "default") == 0)
+		{
+			pDefaultJob = pJob;
+			continue;
+		}
+		Engine()->AddJob(pJob);
+		m_LoadJobs.push_back(pJob);
+		m_LoadingSkins.insert(pJob->m_aName);
 	}
+	if(pDefaultJob)
+	{
+		CJobPool::RunBlocking(pDefaultJob.get());
+		if(pDefaultJob->m_Loaded)
+			LoadSkin(pDefaultJob->m_aName, pDefaultJob->m_Data);
+	}
+	if(m_LoadJobs.empty() && m_Skins.empty())
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "gameclient", "failed to load skins. folder='skins/'");
 }
 
 int CSkins::Num()
@@ -361,7 +270,7 @@ const CSkin *CSkins::Find(const char *pName)
 	{
 		pSkin = FindOrNullptr("default");
 		if(pSkin == nullptr)
-			return m_Skins.begin()->second.get();
+			return m_Skins.empty() ? &m_PlaceholderSkin : m_Skins.begin()->second.get();
 		else
 			return pSkin;
 	}
@@ -401,6 +310,10 @@ const CSkin *CSkins::FindImpl(const char *pName)
 	if(str_comp(pName, "default") == 0)
 		return nullptr;
 
+	// don't download skins that are still loading from disk
+	if(m_LoadingSkins.count(pName))
+		return nullptr;
+
 	if(!g_Config.m_ClDownloadSkins)
 		return nullptr;
 
@@ -410,12 +323,12 @@ const CSkin *CSkins::FindImpl(const char *pName)
 	const auto SkinDownloadIt = m_DownloadSkins.find(pName);
 	if(SkinDownloadIt != m_DownloadSkins.end())
 	{
-		if(SkinDownloadIt->second->m_pTask && SkinDownloadIt->second->m_pTask->State() == EHttpState::DONE && SkinDownloadIt->second->m_pTask->m_Info.m_pData)
+		if(SkinDownloadIt->second->m_pTask && SkinDownloadIt->second->m_pTask->State() == EHttpState::DONE && SkinDownloadIt->second->m_pTask->m_Data.m_Info.m_pData)
 		{
 			char aPath[IO_MAX_PATH_LENGTH];
 			str_format(aPath, sizeof(aPath), "downloadedskins/%s.png", SkinDownloadIt->second->GetName());
 			Storage()->RenameFile(SkinDownloadIt->second->m_aPath, aPath, IStorage::TYPE_SAVE);
-			const auto *pSkin = LoadSkin(SkinDownloadIt->second->GetName(), SkinDownloadIt->second->m_pTask->m_Info);
+			const auto *pSkin = LoadSkin(SkinDownloadIt->second->GetName(), SkinDownloadIt->second->m_pTask->m_Data);
 			SkinDownloadIt->second->m_pTask = nullptr;
 			--m_DownloadingSkins;
 			return pSkin;
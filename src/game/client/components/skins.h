@@ -5,10 +5,15 @@
 
 #include <base/system.h>
 #include <engine/shared/http.h>
+#include <engine/shared/jobs.h>
 #include <game/client/component.h>
 #include <game/client/skin.h>
+#include <game/client/skin_load.h>
+
+#include <deque>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
 class CSkins : public CComponent
 {
@@ -24,7 +29,7 @@ public:
 
 	public:
 		CGetPngFile(CSkins *pSkins, const char *pUrl, IStorage *pStorage, const char *pDest);
-		CImageInfo m_Info;
+		CSkinLoadData m_Data;
 	};
 
 	struct CDownloadSkin
@@ -56,12 +61,16 @@ public:
 		const char *GetName() const { return m_aName; }
 	};
 
-	typedef std::function<void(int)> TSkinLoadedCBFunc;
-
 	virtual int Sizeof() const override { return sizeof(*this); }
 	void OnInit() override;
-
-	void Refresh(TSkinLoadedCBFunc &&SkinLoadedFunc);
+	void OnRender() override;
+
+	/**
+	 * Unloads all skins and starts loading the skin files again. Only the
+	 * default skin is available right away, the others are uploaded by
+	 * OnRender once their jobs are done.
+	 */
+	void Refresh();
 	int Num();
 	std::unordered_map<std::string_view, std::unique_ptr<CSkin>> &GetSkinsUnsafe() { return m_Skins; }
 	const CSkin *FindOrNullptr(const char *pName, bool IgnorePrefix = false);
@@ -82,9 +91,19 @@ private:
 	size_t m_DownloadingSkins = 0;
 	char m_aEventSkinPrefix[24];
 
+	// skins that are decoded on the job pool, in the order they were found
+	std::deque<std::shared_ptr<CSkinLoadJob>> m_LoadJobs;
+	std::unordered_set<std::string_view> m_LoadingSkins;
+	// used while no skin is loaded at all
+	CSkin m_PlaceholderSkin{"dummy"};
+
+	/**
+	 * Upload time per frame for the skins that are done loading.
+	 */
+	static constexpr int UPLOAD_BUDGET_MS = 4;
+
 	bool LoadSkinPNG(CImageInfo &Info, const char *pName, const char *pPath, int DirType);
-	const CSkin *LoadSkin(const char *pName, const char *pPath, int DirType);
-	const CSkin *LoadSkin(const char *pName, CImageInfo &Info);
+	const CSkin *LoadSkin(const char *pName, CSkinLoadData &Data);
 	const CSkin *FindImpl(const char *pName);
 	static int SkinScan(const char *pName, int IsDir, int DirType, void *pUser);
 };
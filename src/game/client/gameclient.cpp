@@ -548,6 +548,7 @@ void CGameClient::OnReset()
 {
 	m_aLastNewPredictedTick[0] = -1;
 	m_aLastNewPredictedTick[1] = -1;
+	m_PredictionCache.m_Valid = false;
 
 	m_aLocalTuneZone[0] = 0;
 	m_aLocalTuneZone[1] = 0;
@@ -908,6 +909,7 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 	{
 		CNetMsg_Sv_KillMsg *pMsg = (CNetMsg_Sv_KillMsg *)pRawMsg;
 		// reset character prediction
+		m_PredictionCache.m_Valid = false;
 		if(!(m_GameWorld.m_WorldConfig.m_IsFNG && pMsg->m_Weapon == WEAPON_LASER))
 		{
 			m_CharOrder.GiveWeak(pMsg->m_Victim);
@@ -945,6 +947,7 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 		CNetMsg_Sv_KillMsgTeam *pMsg = (CNetMsg_Sv_KillMsgTeam *)pRawMsg;
 
 		// reset prediction
+		m_PredictionCache.m_Valid = false;
 		std::vector<std::pair<int, int>> vStrongWeakSorted;
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
@@ -1307,6 +1310,8 @@ void CGameClient::InvalidateSnapshot()
 
 void CGameClient::OnNewSnapshot()
 {
+	m_PredictionCache.m_Valid = false;
+
 	auto &&Evolve = [this](CNetObj_Character *pCharacter, int Tick) {
 		CWorldCore TempWorld;
 		CCharacterCore TempCore = CCharacterCore();
@@ -1956,115 +1961,38 @@ void CGameClient::OnPredict()
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		aBeforeRender[i] = GetSmoothPos(i);
 
-	// init
-	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
-	m_PredictedWorld.CopyWorld(&m_GameWorld);
-
-	// don't predict inactive players, or entities from other teams
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
-			if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
-				pChar->Destroy();
-
-	CProjectile *pProjNext = 0;
-	for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
-	{
-		pProjNext = (CProjectile *)pProj->TypeNext();
-		if(IsOtherTeam(pProj->GetOwner()))
-		{
-			pProj->Destroy();
-		}
-	}
-
-	CCharacter *pLocalChar = m_PredictedWorld.GetCharacterByID(m_Snap.m_LocalClientID);
-	if(!pLocalChar)
+	const bool Continue = CanContinuePrediction();
+	if(!PredictWorld(Continue))
 		return;
-	CCharacter *pDummyChar = 0;
-	if(PredictDummy())
-		pDummyChar = m_PredictedWorld.GetCharacterByID(m_PredictedDummyID);
 
-	// predict
-	for(int Tick = Client()->GameTick(g_Config.m_ClDummy) + 1; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
+	// check that continuing the last prediction gives the same result as
+	// predicting everything since the snapshot again
+	if(Continue && g_Config.m_ClPredictValidate)
 	{
-		// fetch the previous characters
-		if(Tick == Client()->PredGameTick(g_Config.m_ClDummy))
-		{
-			m_PrevPredictedWorld.CopyWorld(&m_PredictedWorld);
-			m_PredictedPrevChar = pLocalChar->GetCore();
-			for(int i = 0; i < MAX_CLIENTS; i++)
-				if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
-					m_aClients[i].m_PrevPredicted = pChar->GetCore();
-		}
-
-		// optionally allow some movement in freeze by not predicting freeze the last one to two ticks
-		if(g_Config.m_ClPredictFreeze == 2 && Client()->PredGameTick(g_Config.m_ClDummy) - 1 - Client()->PredGameTick(g_Config.m_ClDummy) % 2 <= Tick)
-			pLocalChar->m_CanMoveInFreeze = true;
-
-		// apply inputs and tick
-		CNetObj_PlayerInput *pInputData = (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping);
-		CNetObj_PlayerInput *pDummyInputData = !pDummyChar ? 0 : (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping ^ 1);
-		bool DummyFirst = pInputData && pDummyInputData && pDummyChar->GetCID() < pLocalChar->GetCID();
-
-		if(DummyFirst)
-			pDummyChar->OnDirectInput(pDummyInputData);
-		if(pInputData)
-			pLocalChar->OnDirectInput(pInputData);
-		if(pDummyInputData && !DummyFirst)
-			pDummyChar->OnDirectInput(pDummyInputData);
-		m_PredictedWorld.m_GameTick = Tick;
-		if(pInputData)
-			pLocalChar->OnPredictedInput(pInputData);
-		if(pDummyInputData)
-			pDummyChar->OnPredictedInput(pDummyInputData);
-		m_PredictedWorld.Tick();
-
-		// fetch the current characters
-		if(Tick == Client()->PredGameTick(g_Config.m_ClDummy))
+		CNetObj_CharacterCore aContinued[MAX_CLIENTS];
+		bool aHasContinued[MAX_CLIENTS];
+		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			m_PredictedChar = pLocalChar->GetCore();
-			for(int i = 0; i < MAX_CLIENTS; i++)
-				if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
-					m_aClients[i].m_Predicted = pChar->GetCore();
+			CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i);
+			aHasContinued[i] = pChar != nullptr;
+			if(pChar)
+				pChar->GetCore().Write(&aContinued[i]);
 		}
-
+		if(!PredictWorld(false))
+			return;
 		for(int i = 0; i < MAX_CLIENTS; i++)
-			if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
-			{
-				m_aClients[i].m_aPredPos[Tick % 200] = pChar->Core()->m_Pos;
-				m_aClients[i].m_aPredTick[Tick % 200] = Tick;
-			}
-
-		// check if we want to trigger effects
-		if(Tick > m_aLastNewPredictedTick[Dummy])
 		{
-			m_aLastNewPredictedTick[Dummy] = Tick;
-			m_NewPredictedTick = true;
-			vec2 Pos = pLocalChar->Core()->m_Pos;
-			int Events = pLocalChar->Core()->m_TriggeredEvents;
-			if(g_Config.m_ClPredict && !m_SuppressEvents)
-				if(Events & COREEVENT_AIR_JUMP)
-					m_Effects.AirJump(Pos, 1.0f);
-			if(g_Config.m_SndGame && !m_SuppressEvents)
+			CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i);
+			CNetObj_CharacterCore Full;
+			if(pChar)
+				pChar->GetCore().Write(&Full);
+			if(aHasContinued[i] != (pChar != nullptr) || (pChar && mem_comp(&aContinued[i], &Full, sizeof(Full)) != 0))
 			{
-				if(Events & COREEVENT_GROUND_JUMP)
-					m_Sounds.PlayAndRecord(CSounds::CHN_WORLD, SOUND_PLAYER_JUMP, 1.0f, Pos);
-				if(Events & COREEVENT_HOOK_ATTACH_GROUND)
-					m_Sounds.PlayAndRecord(CSounds::CHN_WORLD, SOUND_HOOK_ATTACH_GROUND, 1.0f, Pos);
-				if(Events & COREEVENT_HOOK_HIT_NOHOOK)
-					m_Sounds.PlayAndRecord(CSounds::CHN_WORLD, SOUND_HOOK_NOATTACH, 1.0f, Pos);
+				char aBuf[128];
+				str_format(aBuf, sizeof(aBuf), "continued prediction differs for client %d at tick %d", i, Client()->PredGameTick(g_Config.m_ClDummy));
+				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "client", aBuf);
 			}
 		}
-
-		// check if we want to trigger predicted airjump for dummy
-		if(AntiPingPlayers() && pDummyChar && Tick > m_aLastNewPredictedTick[!Dummy])
-		{
-			m_aLastNewPredictedTick[!Dummy] = Tick;
-			vec2 Pos = pDummyChar->Core()->m_Pos;
-			int Events = pDummyChar->Core()->m_TriggeredEvents;
-			if(g_Config.m_ClPredict && !m_SuppressEvents)
-				if(Events & COREEVENT_AIR_JUMP)
-					m_Effects.AirJump(Pos, 1.0f);
-		}
 	}
 
 	// detect mispredictions of other players and make corrections smoother when possible
@@ -2162,6 +2090,183 @@ void CGameClient::OnPredict()
 		m_Ghost.OnNewPredictedSnapshot();
 }
 
+bool CGameClient::CanContinuePrediction()
+{
+	const CPredictionCache &Cache = m_PredictionCache;
+	if(!Cache.m_Valid || g_Config.m_ClPredictCache == 0)
+		return false;
+	// the partial freeze prediction depends on the distance to the predicted tick
+	if(g_Config.m_ClPredictFreeze == 2)
+		return false;
+	if(m_PredictedWorld.m_pParent != &m_GameWorld || m_GameWorld.m_pChild != &m_PredictedWorld || !m_PredictedWorld.m_IsValidCopy)
+		return false;
+	const int FirstTick = Client()->GameTick(g_Config.m_ClDummy) + 1;
+	const int PredTick = Client()->PredGameTick(g_Config.m_ClDummy);
+	if(Cache.m_SnapTick != FirstTick - 1 || Cache.m_LastTick < FirstTick - 1 || Cache.m_LastTick > PredTick)
+		return false;
+	if(Cache.m_Dummy != (bool)g_Config.m_ClDummy || Cache.m_DummySwapping != m_IsDummySwapping ||
+		Cache.m_DummyID != (PredictDummy() ? m_PredictedDummyID : -1))
+		return false;
+
+	// the inputs of the already predicted ticks must not have changed
+	for(int Tick = FirstTick; Tick <= Cache.m_LastTick; Tick++)
+	{
+		const CPredictionCache::CTickInputs &Inputs = Cache.m_aInputs[Tick % CPredictionCache::NUM_TICKS];
+		if(Inputs.m_Tick != Tick)
+			return false;
+		for(int i = 0; i < NUM_DUMMIES; i++)
+		{
+			if(i == 1 && Cache.m_DummyID == -1)
+				break;
+			const int *pInput = Client()->GetInput(Tick, m_IsDummySwapping ^ i);
+			if(Inputs.m_aHasInput[i] != (pInput != nullptr) || (pInput && mem_comp(&Inputs.m_aInputs[i], pInput, sizeof(CNetObj_PlayerInput)) != 0))
+				return false;
+		}
+	}
+	return true;
+}
+
+bool CGameClient::PredictWorld(bool Continue)
+{
+	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
+	m_PredictionCache.m_Valid = false;
+	int StartTick = Client()->GameTick(g_Config.m_ClDummy) + 1;
+	if(Continue)
+	{
+		// m_PredictedWorld still holds the state after the last predicted tick
+		StartTick = m_PredictionCache.m_LastTick + 1;
+	}
+	else
+	{
+		m_PredictedWorld.CopyWorld(&m_GameWorld);
+
+		// don't predict inactive players, or entities from other teams
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
+				if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
+					pChar->Destroy();
+
+		CProjectile *pProjNext = 0;
+		for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
+		{
+			pProjNext = (CProjectile *)pProj->TypeNext();
+			if(IsOtherTeam(pProj->GetOwner()))
+			{
+				pProj->Destroy();
+			}
+		}
+	}
+
+	CCharacter *pLocalChar = m_PredictedWorld.GetCharacterByID(m_Snap.m_LocalClientID);
+	if(!pLocalChar)
+		return false;
+	CCharacter *pDummyChar = 0;
+	if(PredictDummy())
+		pDummyChar = m_PredictedWorld.GetCharacterByID(m_PredictedDummyID);
+
+	// predict
+	for(int Tick = StartTick; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
+	{
+		// fetch the previous characters
+		if(Tick == Client()->PredGameTick(g_Config.m_ClDummy))
+		{
+			m_PrevPredictedWorld.CopyWorld(&m_PredictedWorld);
+			m_PredictedPrevChar = pLocalChar->GetCore();
+			for(int i = 0; i < MAX_CLIENTS; i++)
+				if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
+					m_aClients[i].m_PrevPredicted = pChar->GetCore();
+		}
+
+		// optionally allow some movement in freeze by not predicting freeze the last one to two ticks
+		if(g_Config.m_ClPredictFreeze == 2 && Client()->PredGameTick(g_Config.m_ClDummy) - 1 - Client()->PredGameTick(g_Config.m_ClDummy) % 2 <= Tick)
+			pLocalChar->m_CanMoveInFreeze = true;
+
+		// apply inputs and tick
+		CNetObj_PlayerInput *pInputData = (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping);
+		CNetObj_PlayerInput *pDummyInputData = !pDummyChar ? 0 : (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping ^ 1);
+		bool DummyFirst = pInputData && pDummyInputData && pDummyChar->GetCID() < pLocalChar->GetCID();
+
+		// remember the inputs to detect whether the tick has to be predicted again
+		CPredictionCache::CTickInputs &Inputs = m_PredictionCache.m_aInputs[Tick % CPredictionCache::NUM_TICKS];
+		Inputs.m_Tick = Tick;
+		Inputs.m_aHasInput[0] = pInputData != nullptr;
+		if(pInputData)
+			Inputs.m_aInputs[0] = *pInputData;
+		Inputs.m_aHasInput[1] = pDummyInputData != nullptr;
+		if(pDummyInputData)
+			Inputs.m_aInputs[1] = *pDummyInputData;
+
+		if(DummyFirst)
+			pDummyChar->OnDirectInput(pDummyInputData);
+		if(pInputData)
+			pLocalChar->OnDirectInput(pInputData);
+		if(pDummyInputData && !DummyFirst)
+			pDummyChar->OnDirectInput(pDummyInputData);
+		m_PredictedWorld.m_GameTick = Tick;
+		if(pInputData)
+			pLocalChar->OnPredictedInput(pInputData);
+		if(pDummyInputData)
+			pDummyChar->OnPredictedInput(pDummyInputData);
+		m_PredictedWorld.Tick();
+
+		// fetch the current characters
+		if(Tick == Client()->PredGameTick(g_Config.m_ClDummy))
+		{
+			m_PredictedChar = pLocalChar->GetCore();
+			for(int i = 0; i < MAX_CLIENTS; i++)
+				if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
+					m_aClients[i].m_Predicted = pChar->GetCore();
+		}
+
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
+			{
+				m_aClients[i].m_aPredPos[Tick % 200] = pChar->Core()->m_Pos;
+				m_aClients[i].m_aPredTick[Tick % 200] = Tick;
+			}
+
+		// check if we want to trigger effects
+		if(Tick > m_aLastNewPredictedTick[Dummy])
+		{
+			m_aLastNewPredictedTick[Dummy] = Tick;
+			m_NewPredictedTick = true;
+			vec2 Pos = pLocalChar->Core()->m_Pos;
+			int Events = pLocalChar->Core()->m_TriggeredEvents;
+			if(g_Config.m_ClPredict && !m_SuppressEvents)
+				if(Events & COREEVENT_AIR_JUMP)
+					m_Effects.AirJump(Pos, 1.0f);
+			if(g_Config.m_SndGame && !m_SuppressEvents)
+			{
+				if(Events & COREEVENT_GROUND_JUMP)
+					m_Sounds.PlayAndRecord(CSounds::CHN_WORLD, SOUND_PLAYER_JUMP, 1.0f, Pos);
+				if(Events & COREEVENT_HOOK_ATTACH_GROUND)
+					m_Sounds.PlayAndRecord(CSounds::CHN_WORLD, SOUND_HOOK_ATTACH_GROUND, 1.0f, Pos);
+				if(Events & COREEVENT_HOOK_HIT_NOHOOK)
+					m_Sounds.PlayAndRecord(CSounds::CHN_WORLD, SOUND_HOOK_NOATTACH, 1.0f, Pos);
+			}
+		}
+
+		// check if we want to trigger predicted airjump for dummy
+		if(AntiPingPlayers() && pDummyChar && Tick > m_aLastNewPredictedTick[!Dummy])
+		{
+			m_aLastNewPredictedTick[!Dummy] = Tick;
+			vec2 Pos = pDummyChar->Core()->m_Pos;
+			int Events = pDummyChar->Core()->m_TriggeredEvents;
+			if(g_Config.m_ClPredict && !m_SuppressEvents)
+				if(Events & COREEVENT_AIR_JUMP)
+					m_Effects.AirJump(Pos, 1.0f);
+		}
+	}
+
+	m_PredictionCache.m_Valid = true;
+	m_PredictionCache.m_SnapTick = Client()->GameTick(g_Config.m_ClDummy);
+	m_PredictionCache.m_LastTick = maximum(Client()->PredGameTick(g_Config.m_ClDummy), StartTick - 1);
+	m_PredictionCache.m_Dummy = g_Config.m_ClDummy;
+	m_PredictionCache.m_DummySwapping = m_IsDummySwapping;
+	m_PredictionCache.m_DummyID = PredictDummy() ? m_PredictedDummyID : -1;
+	return true;
+}
+
 void CGameClient::OnActivateEditor()
 {
 	OnRelease();
@@ -3381,15 +3486,12 @@ void CGameClient::LoadExtrasSkin(const char *pPath, bool AsDir)
 
 void CGameClient::RefreshSkins()
 {
-	const auto SkinStartLoadTime = time_get_nanoseconds();
-	m_Skins.Refresh([&](int) {
-		// if skin refreshing takes to long, swap to a loading screen
-		if(time_get_nanoseconds() - SkinStartLoadTime > 500ms)
-		{
-			m_Menus.RenderLoading(Localize("Loading skin files"), "", 0, false);
-		}
-	});
+	m_Skins.Refresh();
+	OnSkinsRefreshed();
+}
 
+void CGameClient::OnSkinsRefreshed()
+{
 	for(auto &Client : m_aClients)
 	{
 		Client.m_SkinInfo.m_OriginalRenderSkin.Reset();
@@ -192,6 +192,38 @@ private:
 	int m_PredictedTick;
 	int m_aLastNewPredictedTick[NUM_DUMMIES];
 
+	// Describes the state in m_PredictedWorld, so that the next prediction
+	// can continue from it instead of predicting all ticks since the last
+	// snapshot again. That's only done if the snapshot and the inputs of the
+	// already predicted ticks didn't change.
+	struct CPredictionCache
+	{
+		enum
+		{
+			NUM_TICKS = 200,
+		};
+
+		struct CTickInputs
+		{
+			int m_Tick = -1;
+			bool m_aHasInput[NUM_DUMMIES] = {false, false};
+			CNetObj_PlayerInput m_aInputs[NUM_DUMMIES];
+		};
+
+		bool m_Valid = false;
+		int m_SnapTick;
+		int m_LastTick;
+		bool m_Dummy;
+		int m_DummySwapping;
+		int m_DummyID;
+		CTickInputs m_aInputs[NUM_TICKS];
+	};
+	CPredictionCache m_PredictionCache;
+	bool CanContinuePrediction();
+	// Predicts m_PredictedWorld up to the predicted tick, returns false if
+	// the local character doesn't exist.
+	bool PredictWorld(bool Continue);
+
 	int m_LastRoundStartTick;
 
 	int m_LastFlagCarrierRed;
@@ -501,6 +533,8 @@ public:
 	void HandleLanguageChanged();
 
 	void RefreshSkins();
+	// resolves the skins of all clients again, after skins were loaded or unloaded
+	void OnSkinsRefreshed();
 
 	void RenderShutdownMessage();
 
@@ -0,0 +1,521 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include "map_layer_visuals.h"
+
+#include <base/math.h>
+
+#include <game/mapitems.h>
+
+#include <limits>
+
+static void FillTmpTile(SGraphicTile *pTmpTile, SGraphicTileTexureCoords *pTmpTex, unsigned char Flags, unsigned char Index, int x, int y, const ivec2 &Offset, int Scale, CMapItemGroup *pGroup)
+{
+	if(pTmpTex)
+	{
+		unsigned char x0 = 0;
+		unsigned char y0 = 0;
+		unsigned char x1 = x0 + 1;
+		unsigned char y1 = y0;
+		unsigned char x2 = x0 + 1;
+		unsigned char y2 = y0 + 1;
+		unsigned char x3 = x0;
+		unsigned char y3 = y0 + 1;
+
+		if(Flags & TILEFLAG_XFLIP)
+		{
+			x0 = x2;
+			x1 = x3;
+			x2 = x3;
+			x3 = x0;
+		}
+
+		if(Flags & TILEFLAG_YFLIP)
+		{
+			y0 = y3;
+			y2 = y1;
+			y3 = y1;
+			y1 = y0;
+		}
+
+		if(Flags & TILEFLAG_ROTATE)
+		{
+			unsigned char Tmp = x0;
+			x0 = x3;
+			x3 = x2;
+			x2 = x1;
+			x1 = Tmp;
+			Tmp = y0;
+			y0 = y3;
+			y3 = y2;
+			y2 = y1;
+			y1 = Tmp;
+		}
+
+		pTmpTex->m_TexCoordTopLeft.x = x0;
+		pTmpTex->m_TexCoordTopLeft.y = y0;
+		pTmpTex->m_TexCoordBottomLeft.x = x3;
+		pTmpTex->m_TexCoordBottomLeft.y = y3;
+		pTmpTex->m_TexCoordTopRight.x = x1;
+		pTmpTex->m_TexCoordTopRight.y = y1;
+		pTmpTex->m_TexCoordBottomRight.x = x2;
+		pTmpTex->m_TexCoordBottomRight.y = y2;
+
+		pTmpTex->m_TexCoordTopLeft.z = Index;
+		pTmpTex->m_TexCoordBottomLeft.z = Index;
+		pTmpTex->m_TexCoordTopRight.z = Index;
+		pTmpTex->m_TexCoordBottomRight.z = Index;
+
+		bool HasRotation = (Flags & TILEFLAG_ROTATE) != 0;
+		pTmpTex->m_TexCoordTopLeft.w = HasRotation;
+		pTmpTex->m_TexCoordBottomLeft.w = HasRotation;
+		pTmpTex->m_TexCoordTopRight.w = HasRotation;
+		pTmpTex->m_TexCoordBottomRight.w = HasRotation;
+	}
+
+	pTmpTile->m_TopLeft.x = x * Scale + Offset.x;
+	pTmpTile->m_TopLeft.y = y * Scale + Offset.y;
+	pTmpTile->m_BottomLeft.x = x * Scale + Offset.x;
+	pTmpTile->m_BottomLeft.y = y * Scale + Scale + Offset.y;
+	pTmpTile->m_TopRight.x = x * Scale + Scale + Offset.x;
+	pTmpTile->m_TopRight.y = y * Scale + Offset.y;
+	pTmpTile->m_BottomRight.x = x * Scale + Scale + Offset.x;
+	pTmpTile->m_BottomRight.y = y * Scale + Scale + Offset.y;
+}
+
+static void FillTmpTileSpeedup(SGraphicTile *pTmpTile, SGraphicTileTexureCoords *pTmpTex, unsigned char Flags, unsigned char Index, int x, int y, const ivec2 &Offset, int Scale, CMapItemGroup *pGroup, short AngleRotate)
+{
+	int Angle = AngleRotate % 360;
+	FillTmpTile(pTmpTile, pTmpTex, Angle >= 270 ? ROTATION_270 : (Angle >= 180 ? ROTATION_180 : (Angle >= 90 ? ROTATION_90 : 0)), AngleRotate % 90, x, y, Offset, Scale, pGroup);
+}
+
+bool STileLayerVisuals::Init(unsigned int Width, unsigned int Height)
+{
+	m_Width = Width;
+	m_Height = Height;
+	if(Width == 0 || Height == 0)
+		return false;
+	if constexpr(sizeof(unsigned int) >= sizeof(ptrdiff_t))
+		if(Width >= std::numeric_limits<std::ptrdiff_t>::max() || Height >= std::numeric_limits<std::ptrdiff_t>::max())
+			return false;
+
+	m_pTilesOfLayer = new STileLayerVisuals::STileVisual[Height * Width];
+
+	m_vBorderTop.resize(Width);
+	m_vBorderBottom.resize(Width);
+
+	m_vBorderLeft.resize(Height);
+	m_vBorderRight.resize(Height);
+	return true;
+}
+
+STileLayerVisuals::~STileLayerVisuals()
+{
+	delete[] m_pTilesOfLayer;
+
+	m_pTilesOfLayer = NULL;
+}
+
+static bool AddTile(std::vector<SGraphicTile> &vTmpTiles, std::vector<SGraphicTileTexureCoords> &vTmpTileTexCoords, unsigned char Index, unsigned char Flags, int x, int y, CMapItemGroup *pGroup, bool DoTextureCoords, bool FillSpeedup = false, int AngleRotate = -1, const ivec2 &Offset = ivec2{0, 0}, int Scale = 32)
+{
+	if(Index)
+	{
+		vTmpTiles.emplace_back();
+		SGraphicTile &Tile = vTmpTiles.back();
+		SGraphicTileTexureCoords *pTileTex = NULL;
+		if(DoTextureCoords)
+		{
+			vTmpTileTexCoords.emplace_back();
+			SGraphicTileTexureCoords &TileTex = vTmpTileTexCoords.back();
+			pTileTex = &TileTex;
+		}
+		if(FillSpeedup)
+			FillTmpTileSpeedup(&Tile, pTileTex, Flags, 0, x, y, Offset, Scale, pGroup, AngleRotate);
+		else
+			FillTmpTile(&Tile, pTileTex, Flags, Index, x, y, Offset, Scale, pGroup);
+
+		return true;
+	}
+	return false;
+}
+
+static void mem_copy_special(void *pDest, void *pSource, size_t Size, size_t Count, size_t Steps)
+{
+	size_t CurStep = 0;
+	for(size_t i = 0; i < Count; ++i)
+	{
+		mem_copy(((char *)pDest) + CurStep + i * Size, ((char *)pSource) + i * Size, Size);
+		CurStep += Steps;
+	}
+}
+
+void STmpTileBuffer::Reserve(size_t Size, bool DoTextureCoords)
+{
+	m_vTiles.reserve(Size);
+	if(DoTextureCoords)
+		m_vTexCoords.reserve(Size);
+}
+
+bool STmpTileBuffer::Add(unsigned char Index, unsigned char Flags, int x, int y, CMapItemGroup *pGroup, bool DoTextureCoords, bool FillSpeedup, int AngleRotate, const ivec2 &Offset)
+{
+	return AddTile(m_vTiles, m_vTexCoords, Index, Flags, x, y, pGroup, DoTextureCoords, FillSpeedup, AngleRotate, Offset);
+}
+
+void STmpTileBuffer::Write(char *pUploadData, size_t FirstTile, bool DoTextureCoords) const
+{
+	if(m_vTiles.empty())
+		return;
+	const size_t Stride = sizeof(vec2) + (DoTextureCoords ? sizeof(ubvec4) : 0);
+	char *pDest = pUploadData + FirstTile * 4 * Stride;
+	mem_copy_special(pDest, (void *)m_vTiles.data(), sizeof(vec2), m_vTiles.size() * 4, (DoTextureCoords ? sizeof(ubvec4) : 0));
+	if(DoTextureCoords)
+		mem_copy_special(pDest + sizeof(vec2), (void *)m_vTexCoords.data(), sizeof(ubvec4), m_vTiles.size() * 4, sizeof(vec2));
+}
+
+CTileLayerBuild::CTileLayerBuild() :
+	m_BandsLeft(0)
+{
+	sphore_init(&m_Done);
+}
+
+CTileLayerBuild::~CTileLayerBuild()
+{
+	sphore_destroy(&m_Done);
+	free(m_pUploadData);
+}
+
+std::vector<std::shared_ptr<IJob>> CTileLayerBuild::CreateBands(int BandTiles)
+{
+	const int Height = m_pTMap->m_Height;
+	const int BandHeight = maximum(1, BandTiles / m_pTMap->m_Width);
+	std::vector<std::shared_ptr<IJob>> vpJobs;
+	for(int StartY = 0; StartY < Height; StartY += BandHeight)
+	{
+		m_vpBands.push_back(std::make_shared<CTileLayerBandJob>(this, StartY, minimum(StartY + BandHeight, Height)));
+		vpJobs.push_back(m_vpBands.back());
+	}
+	m_BandsLeft = m_vpBands.size();
+	return vpJobs;
+}
+
+void CTileLayerBuild::Wait()
+{
+	sphore_wait(&m_Done);
+}
+
+void CTileLayerBuild::GetTile(int x, int y, unsigned char &Index, unsigned char &Flags, int &AngleRotate) const
+{
+	const int TileIndex = y * m_pTMap->m_Width + x;
+	Index = 0;
+	Flags = 0;
+	AngleRotate = -1;
+	if(m_IsEntityLayer)
+	{
+		if(m_IsGameLayer)
+		{
+			Index = ((CTile *)m_pTiles)[TileIndex].m_Index;
+			Flags = ((CTile *)m_pTiles)[TileIndex].m_Flags;
+		}
+		if(m_IsFrontLayer)
+		{
+			Index = ((CTile *)m_pTiles)[TileIndex].m_Index;
+			Flags = ((CTile *)m_pTiles)[TileIndex].m_Flags;
+		}
+		if(m_IsSwitchLayer)
+		{
+			Flags = 0;
+			Index = ((CSwitchTile *)m_pTiles)[TileIndex].m_Type;
+			if(m_CurOverlay == 0)
+			{
+				Flags = ((CSwitchTile *)m_pTiles)[TileIndex].m_Flags;
+				if(Index == TILE_SWITCHTIMEDOPEN)
+					Index = 8;
+			}
+			else if(m_CurOverlay == 1)
+				Index = ((CSwitchTile *)m_pTiles)[TileIndex].m_Number;
+			else if(m_CurOverlay == 2)
+				Index = ((CSwitchTile *)m_pTiles)[TileIndex].m_Delay;
+		}
+		if(m_IsTeleLayer)
+		{
+			Index = ((CTeleTile *)m_pTiles)[TileIndex].m_Type;
+			Flags = 0;
+			if(m_CurOverlay == 1)
+			{
+				if(IsTeleTileNumberUsedAny(Index))
+					Index = ((CTeleTile *)m_pTiles)[TileIndex].m_Number;
+				else
+					Index = 0;
+			}
+		}
+		if(m_IsSpeedupLayer)
+		{
+			Index = ((CSpeedupTile *)m_pTiles)[TileIndex].m_Type;
+			Flags = 0;
+			AngleRotate = ((CSpeedupTile *)m_pTiles)[TileIndex].m_Angle;
+			if(((CSpeedupTile *)m_pTiles)[TileIndex].m_Force == 0)
+				Index = 0;
+			else if(m_CurOverlay == 1)
+				Index = ((CSpeedupTile *)m_pTiles)[TileIndex].m_Force;
+			else if(m_CurOverlay == 2)
+				Index = ((CSpeedupTile *)m_pTiles)[TileIndex].m_MaxSpeed;
+		}
+		if(m_IsTuneLayer)
+		{
+			Index = ((CTuneTile *)m_pTiles)[TileIndex].m_Type;
+			Flags = 0;
+		}
+	}
+	else
+	{
+		Index = ((CTile *)m_pTiles)[TileIndex].m_Index;
+		Flags = ((CTile *)m_pTiles)[TileIndex].m_Flags;
+	}
+}
+
+void CTileLayerBandJob::Run()
+{
+	const CTileLayerBuild &Layer = *m_pLayer;
+	STileLayerVisuals &Visuals = *Layer.m_pVisuals;
+	CMapItemGroup *pGroup = Layer.m_pGroup;
+	const bool DoTextureCoords = Layer.m_DoTextureCoords;
+	const int Width = Layer.m_pTMap->m_Width;
+	const int Height = Layer.m_pTMap->m_Height;
+	const bool AddAsSpeedup = Layer.m_IsSpeedupLayer && Layer.m_CurOverlay == 0;
+
+	m_Tiles.Reserve((size_t)Width * (m_EndY - m_StartY), DoTextureCoords);
+	m_Corners.Reserve(4, DoTextureCoords);
+	if(m_StartY == 0)
+		m_BorderTop.Reserve(Width, DoTextureCoords);
+	if(m_EndY == Height)
+		m_BorderBottom.Reserve(Width, DoTextureCoords);
+	m_BorderLeft.Reserve(m_EndY - m_StartY, DoTextureCoords);
+	m_BorderRight.Reserve(m_EndY - m_StartY, DoTextureCoords);
+
+	for(int y = m_StartY; y < m_EndY; ++y)
+	{
+		for(int x = 0; x < Width; ++x)
+		{
+			unsigned char Index;
+			unsigned char Flags;
+			int AngleRotate;
+			Layer.GetTile(x, y, Index, Flags, AngleRotate);
+
+			//the amount of tiles handled before this tile
+			Visuals.m_pTilesOfLayer[y * Width + x].SetIndexBufferByteOffset((offset_ptr32)(m_Tiles.m_vTiles.size()));
+			if(m_Tiles.Add(Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
+				Visuals.m_pTilesOfLayer[y * Width + x].Draw(true);
+
+			//do the border tiles
+			if(x == 0)
+			{
+				if(y == 0)
+				{
+					Visuals.m_BorderTopLeft.SetIndexBufferByteOffset((offset_ptr32)(m_Corners.m_vTiles.size()));
+					if(m_Corners.Add(Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{-32, -32}))
+						Visuals.m_BorderTopLeft.Draw(true);
+				}
+				else if(y == Height - 1)
+				{
+					Visuals.m_BorderBottomLeft.SetIndexBufferByteOffset((offset_ptr32)(m_Corners.m_vTiles.size()));
+					if(m_Corners.Add(Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{-32, 0}))
+						Visuals.m_BorderBottomLeft.Draw(true);
+				}
+				Visuals.m_vBorderLeft[y].SetIndexBufferByteOffset((offset_ptr32)(m_BorderLeft.m_vTiles.size()));
+				if(m_BorderLeft.Add(Index, Flags, 0, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{-32, 0}))
+					Visuals.m_vBorderLeft[y].Draw(true);
+			}
+			else if(x == Width - 1)
+			{
+				if(y == 0)
+				{
+					Visuals.m_BorderTopRight.SetIndexBufferByteOffset((offset_ptr32)(m_Corners.m_vTiles.size()));
+					if(m_Corners.Add(Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, -32}))
+						Visuals.m_BorderTopRight.Draw(true);
+				}
+				else if(y == Height - 1)
+				{
+					Visuals.m_BorderBottomRight.SetIndexBufferByteOffset((offset_ptr32)(m_Corners.m_vTiles.size()));
+					if(m_Corners.Add(Index, Flags, 0, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, 0}))
+						Visuals.m_BorderBottomRight.Draw(true);
+				}
+				Visuals.m_vBorderRight[y].SetIndexBufferByteOffset((offset_ptr32)(m_BorderRight.m_vTiles.size()));
+				if(m_BorderRight.Add(Index, Flags, 0, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, 0}))
+					Visuals.m_vBorderRight[y].Draw(true);
+			}
+			if(y == 0)
+			{
+				Visuals.m_vBorderTop[x].SetIndexBufferByteOffset((offset_ptr32)(m_BorderTop.m_vTiles.size()));
+				if(m_BorderTop.Add(Index, Flags, x, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, -32}))
+					Visuals.m_vBorderTop[x].Draw(true);
+			}
+			else if(y == Height - 1)
+			{
+				Visuals.m_vBorderBottom[x].SetIndexBufferByteOffset((offset_ptr32)(m_BorderBottom.m_vTiles.size()));
+				if(m_BorderBottom.Add(Index, Flags, x, 0, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate, ivec2{0, 0}))
+					Visuals.m_vBorderBottom[x].Draw(true);
+			}
+		}
+	}
+
+	// the band that finishes last joins the layer, which must not be touched after signaling it
+	if(m_pLayer->m_BandsLeft.fetch_sub(1) == 1)
+	{
+		m_pLayer->Join();
+		sphore_signal(&m_pLayer->m_Done);
+	}
+}
+
+void CTileLayerBuild::Join()
+{
+	STileLayerVisuals &Visuals = *m_pVisuals;
+	const int Width = m_pTMap->m_Width;
+
+	// the tiles of all bands come first, then the kill tile, the corners and the borders
+	size_t TilesHandledCount = 0;
+	for(const auto &pBand : m_vpBands)
+	{
+		if(TilesHandledCount > 0)
+		{
+			for(int i = pBand->m_StartY * Width; i < pBand->m_EndY * Width; ++i)
+				Visuals.m_pTilesOfLayer[i].AddIndexBufferByteOffset(TilesHandledCount);
+		}
+		TilesHandledCount += pBand->m_Tiles.m_vTiles.size();
+	}
+
+	//append one kill tile to the gamelayer
+	STmpTileBuffer KillTile;
+	if(m_IsGameLayer)
+	{
+		Visuals.m_BorderKillTile.SetIndexBufferByteOffset((offset_ptr32)(TilesHandledCount));
+		if(KillTile.Add(TILE_DEATH, 0, 0, 0, m_pGroup, m_DoTextureCoords))
+			Visuals.m_BorderKillTile.Draw(true);
+		TilesHandledCount += KillTile.m_vTiles.size();
+	}
+
+	//add the border corners, then the borders and fix their byte offsets
+	// the top corners are in the first band, the bottom corners in the last one
+	size_t LastBandCorners = TilesHandledCount;
+	for(size_t i = 0; i + 1 < m_vpBands.size(); ++i)
+		LastBandCorners += m_vpBands[i]->m_Corners.m_vTiles.size();
+	Visuals.m_BorderTopLeft.AddIndexBufferByteOffset(TilesHandledCount);
+	Visuals.m_BorderTopRight.AddIndexBufferByteOffset(TilesHandledCount);
+	Visuals.m_BorderBottomLeft.AddIndexBufferByteOffset(LastBandCorners);
+	Visuals.m_BorderBottomRight.AddIndexBufferByteOffset(LastBandCorners);
+	for(const auto &pBand : m_vpBands)
+		TilesHandledCount += pBand->m_Corners.m_vTiles.size();
+
+	//now the borders
+	for(int i = 0; i < Width; ++i)
+		Visuals.m_vBorderTop[i].AddIndexBufferByteOffset(TilesHandledCount);
+	TilesHandledCount += m_vpBands.front()->m_BorderTop.m_vTiles.size();
+
+	for(int i = 0; i < Width; ++i)
+		Visuals.m_vBorderBottom[i].AddIndexBufferByteOffset(TilesHandledCount);
+	TilesHandledCount += m_vpBands.back()->m_BorderBottom.m_vTiles.size();
+
+	for(const auto &pBand : m_vpBands)
+	{
+		for(int i = pBand->m_StartY; i < pBand->m_EndY; ++i)
+			Visuals.m_vBorderLeft[i].AddIndexBufferByteOffset(TilesHandledCount);
+		TilesHandledCount += pBand->m_BorderLeft.m_vTiles.size();
+	}
+
+	for(const auto &pBand : m_vpBands)
+	{
+		for(int i = pBand->m_StartY; i < pBand->m_EndY; ++i)
+			Visuals.m_vBorderRight[i].AddIndexBufferByteOffset(TilesHandledCount);
+		TilesHandledCount += pBand->m_BorderRight.m_vTiles.size();
+	}
+
+	m_NumTiles = TilesHandledCount;
+	m_UploadDataSize = m_NumTiles * (sizeof(SGraphicTile) + (m_DoTextureCoords ? sizeof(SGraphicTileTexureCoords) : 0));
+	if(m_UploadDataSize == 0)
+		return;
+
+	// write everything in the same order directly to the vertex data
+	m_pUploadData = (char *)malloc(sizeof(char) * m_UploadDataSize);
+	size_t FirstTile = 0;
+	const auto &&Write = [&](const STmpTileBuffer &Buffer) {
+		Buffer.Write(m_pUploadData, FirstTile, m_DoTextureCoords);
+		FirstTile += Buffer.m_vTiles.size();
+	};
+	for(const auto &pBand : m_vpBands)
+		Write(pBand->m_Tiles);
+	Write(KillTile);
+	for(const auto &pBand : m_vpBands)
+		Write(pBand->m_Corners);
+	Write(m_vpBands.front()->m_BorderTop);
+	Write(m_vpBands.back()->m_BorderBottom);
+	for(const auto &pBand : m_vpBands)
+		Write(pBand->m_BorderLeft);
+	for(const auto &pBand : m_vpBands)
+		Write(pBand->m_BorderRight);
+	dbg_assert(FirstTile == m_NumTiles, "tile layer visuals were not written completely");
+
+	// the bands are not needed anymore
+	m_vpBands.clear();
+}
+
+void CQuadLayerBuildJob::Run()
+{
+	if(m_Textured)
+		m_vTmpQuadsTextured.resize(m_pQLayer->m_NumQuads);
+	else
+		m_vTmpQuads.resize(m_pQLayer->m_NumQuads);
+
+	for(int i = 0; i < m_pQLayer->m_NumQuads; ++i)
+	{
+		CQuad *pQuad = &m_pQuads[i];
+		for(int j = 0; j < 4; ++j)
+		{
+			int QuadIDX = j;
+			if(j == 2)
+				QuadIDX = 3;
+			else if(j == 3)
+				QuadIDX = 2;
+			if(!m_Textured)
+			{
+				// ignore the conversion for the position coordinates
+				m_vTmpQuads[i].m_aVertices[j].m_X = (pQuad->m_aPoints[QuadIDX].x);
+				m_vTmpQuads[i].m_aVertices[j].m_Y = (pQuad->m_aPoints[QuadIDX].y);
+				m_vTmpQuads[i].m_aVertices[j].m_CenterX = (pQuad->m_aPoints[4].x);
+				m_vTmpQuads[i].m_aVertices[j].m_CenterY = (pQuad->m_aPoints[4].y);
+				m_vTmpQuads[i].m_aVertices[j].m_R = (unsigned char)pQuad->m_aColors[QuadIDX].r;
+				m_vTmpQuads[i].m_aVertices[j].m_G = (unsigned char)pQuad->m_aColors[QuadIDX].g;
+				m_vTmpQuads[i].m_aVertices[j].m_B = (unsigned char)pQuad->m_aColors[QuadIDX].b;
+				m_vTmpQuads[i].m_aVertices[j].m_A = (unsigned char)pQuad->m_aColors[QuadIDX].a;
+			}
+			else
+			{
+				// ignore the conversion for the position coordinates
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_X = (pQuad->m_aPoints[QuadIDX].x);
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_Y = (pQuad->m_aPoints[QuadIDX].y);
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_CenterX = (pQuad->m_aPoints[4].x);
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_CenterY = (pQuad->m_aPoints[4].y);
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_U = fx2f(pQuad->m_aTexcoords[QuadIDX].x);
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_V = fx2f(pQuad->m_aTexcoords[QuadIDX].y);
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_R = (unsigned char)pQuad->m_aColors[QuadIDX].r;
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_G = (unsigned char)pQuad->m_aColors[QuadIDX].g;
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_B = (unsigned char)pQuad->m_aColors[QuadIDX].b;
+				m_vTmpQuadsTextured[i].m_aVertices[j].m_A = (unsigned char)pQuad->m_aColors[QuadIDX].a;
+			}
+		}
+	}
+
+	sphore_signal(&m_Done);
+}
+
+CQuadLayerBuildJob::CQuadLayerBuildJob()
+{
+	sphore_init(&m_Done);
+}
+
+CQuadLayerBuildJob::~CQuadLayerBuildJob()
+{
+	sphore_destroy(&m_Done);
+}
+
+void CQuadLayerBuildJob::Wait()
+{
+	sphore_wait(&m_Done);
+}
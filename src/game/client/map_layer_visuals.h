@@ -0,0 +1,255 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_CLIENT_MAP_LAYER_VISUALS_H
+#define GAME_CLIENT_MAP_LAYER_VISUALS_H
+
+#include <base/system.h>
+#include <base/vmath.h>
+
+#include <engine/graphics.h>
+#include <engine/shared/jobs.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+typedef char *offset_ptr_size;
+typedef uintptr_t offset_ptr;
+typedef unsigned int offset_ptr32;
+
+struct CMapItemGroup;
+struct CMapItemLayerTilemap;
+struct CMapItemLayerQuads;
+struct CQuad;
+
+struct STileLayerVisuals
+{
+	STileLayerVisuals() :
+		m_pTilesOfLayer(nullptr)
+	{
+		m_Width = 0;
+		m_Height = 0;
+		m_BufferContainerIndex = -1;
+		m_IsTextured = false;
+	}
+
+	bool Init(unsigned int Width, unsigned int Height);
+
+	~STileLayerVisuals();
+
+	struct STileVisual
+	{
+		STileVisual() :
+			m_IndexBufferByteOffset(0) {}
+
+	private:
+		offset_ptr32 m_IndexBufferByteOffset;
+
+	public:
+		bool DoDraw()
+		{
+			return (m_IndexBufferByteOffset & 0x10000000) != 0;
+		}
+
+		void Draw(bool SetDraw)
+		{
+			m_IndexBufferByteOffset = (SetDraw ? 0x10000000 : (offset_ptr32)0) | (m_IndexBufferByteOffset & 0xEFFFFFFF);
+		}
+
+		offset_ptr IndexBufferByteOffset()
+		{
+			return ((offset_ptr)(m_IndexBufferByteOffset & 0xEFFFFFFF) * 6 * sizeof(uint32_t));
+		}
+
+		void SetIndexBufferByteOffset(offset_ptr32 IndexBufferByteOff)
+		{
+			m_IndexBufferByteOffset = IndexBufferByteOff | (m_IndexBufferByteOffset & 0x10000000);
+		}
+
+		void AddIndexBufferByteOffset(offset_ptr32 IndexBufferByteOff)
+		{
+			m_IndexBufferByteOffset = ((m_IndexBufferByteOffset & 0xEFFFFFFF) + IndexBufferByteOff) | (m_IndexBufferByteOffset & 0x10000000);
+		}
+	};
+	STileVisual *m_pTilesOfLayer;
+
+	STileVisual m_BorderTopLeft;
+	STileVisual m_BorderTopRight;
+	STileVisual m_BorderBottomRight;
+	STileVisual m_BorderBottomLeft;
+
+	STileVisual m_BorderKillTile; //end of map kill tile -- game layer only
+
+	std::vector<STileVisual> m_vBorderTop;
+	std::vector<STileVisual> m_vBorderLeft;
+	std::vector<STileVisual> m_vBorderRight;
+	std::vector<STileVisual> m_vBorderBottom;
+
+	unsigned int m_Width;
+	unsigned int m_Height;
+	int m_BufferContainerIndex;
+	bool m_IsTextured;
+};
+
+struct SQuadLayerVisuals
+{
+	SQuadLayerVisuals() :
+		m_QuadNum(0), m_pQuadsOfLayer(nullptr), m_BufferContainerIndex(-1), m_IsTextured(false) {}
+
+	struct SQuadVisual
+	{
+		SQuadVisual() :
+			m_IndexBufferByteOffset(0) {}
+
+		offset_ptr m_IndexBufferByteOffset;
+	};
+
+	int m_QuadNum;
+	SQuadVisual *m_pQuadsOfLayer;
+
+	int m_BufferContainerIndex;
+	bool m_IsTextured;
+};
+
+struct STmpQuadVertexTextured
+{
+	float m_X, m_Y, m_CenterX, m_CenterY;
+	unsigned char m_R, m_G, m_B, m_A;
+	float m_U, m_V;
+};
+
+struct STmpQuadVertex
+{
+	float m_X, m_Y, m_CenterX, m_CenterY;
+	unsigned char m_R, m_G, m_B, m_A;
+};
+
+struct STmpQuad
+{
+	STmpQuadVertex m_aVertices[4];
+};
+
+struct STmpQuadTextured
+{
+	STmpQuadVertexTextured m_aVertices[4];
+};
+
+// Tiles of one part of a tile layer, with the texture coordinates if the layer is textured
+struct STmpTileBuffer
+{
+	std::vector<SGraphicTile> m_vTiles;
+	std::vector<SGraphicTileTexureCoords> m_vTexCoords;
+
+	void Reserve(size_t Size, bool DoTextureCoords);
+	bool Add(unsigned char Index, unsigned char Flags, int x, int y, CMapItemGroup *pGroup, bool DoTextureCoords, bool FillSpeedup = false, int AngleRotate = -1, const ivec2 &Offset = ivec2{0, 0});
+
+	// copies the tiles to the interleaved vertex data starting at tile `FirstTile`
+	void Write(char *pUploadData, size_t FirstTile, bool DoTextureCoords) const;
+};
+
+class CTileLayerBuild;
+
+// Builds the tiles of the rows [m_StartY, m_EndY) of a tile layer. The offsets
+// written to the visuals are relative to the buffers of this band, the band
+// that finishes last joins all bands of the layer.
+class CTileLayerBandJob : public IJob
+{
+	CTileLayerBuild *m_pLayer;
+
+	void Run() override;
+
+public:
+	CTileLayerBandJob(CTileLayerBuild *pLayer, int StartY, int EndY) :
+		m_pLayer(pLayer), m_StartY(StartY), m_EndY(EndY) {}
+
+	int m_StartY;
+	int m_EndY;
+	STmpTileBuffer m_Tiles;
+	STmpTileBuffer m_Corners;
+	STmpTileBuffer m_BorderTop;
+	STmpTileBuffer m_BorderBottom;
+	STmpTileBuffer m_BorderLeft;
+	STmpTileBuffer m_BorderRight;
+};
+
+// CPU side of building the visuals of one tile layer (or one of its overlays)
+// at map load. The bands of the layer run on the job pool, the vertex data
+// they produce is uploaded on the main thread once Wait() returns.
+class CTileLayerBuild
+{
+	friend CTileLayerBandJob;
+
+	std::vector<std::shared_ptr<CTileLayerBandJob>> m_vpBands;
+	std::atomic<int> m_BandsLeft;
+	SEMAPHORE m_Done;
+
+	void Join();
+
+public:
+	/**
+	 * Bands of rows of big layers are built in parallel, each with at least this many tiles.
+	 */
+	static constexpr int BAND_TILES = 256 * 256;
+
+	STileLayerVisuals *m_pVisuals = nullptr;
+	CMapItemLayerTilemap *m_pTMap = nullptr;
+	void *m_pTiles = nullptr;
+	CMapItemGroup *m_pGroup = nullptr;
+	int m_CurOverlay = 0;
+	bool m_DoTextureCoords = false;
+	bool m_IsGameLayer = false;
+	bool m_IsFrontLayer = false;
+	bool m_IsSwitchLayer = false;
+	bool m_IsTeleLayer = false;
+	bool m_IsSpeedupLayer = false;
+	bool m_IsTuneLayer = false;
+	bool m_IsEntityLayer = false;
+
+	char *m_pUploadData = nullptr;
+	size_t m_UploadDataSize = 0;
+	size_t m_NumTiles = 0;
+
+	CTileLayerBuild();
+	~CTileLayerBuild();
+
+	/**
+	 * Splits the layer into bands of rows with at least `BandTiles` tiles each.
+	 *
+	 * @return The jobs of the bands, each of them has to be run exactly once.
+	 */
+	std::vector<std::shared_ptr<IJob>> CreateBands(int BandTiles = BAND_TILES);
+
+	/**
+	 * Blocks until all bands have been run and the vertex data is complete.
+	 */
+	void Wait();
+
+	void GetTile(int x, int y, unsigned char &Index, unsigned char &Flags, int &AngleRotate) const;
+};
+
+class CQuadLayerBuildJob : public IJob
+{
+	SEMAPHORE m_Done;
+
+	void Run() override;
+
+public:
+	SQuadLayerVisuals *m_pVisuals = nullptr;
+	CMapItemLayerQuads *m_pQLayer = nullptr;
+	CQuad *m_pQuads = nullptr;
+	bool m_Textured = false;
+
+	std::vector<STmpQuad> m_vTmpQuads;
+	std::vector<STmpQuadTextured> m_vTmpQuadsTextured;
+
+	CQuadLayerBuildJob();
+	~CQuadLayerBuildJob();
+
+	/**
+	 * Blocks until the job has been run.
+	 */
+	void Wait();
+};
+
+#endif
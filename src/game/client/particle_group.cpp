@@ -0,0 +1,133 @@
+#include "particle_group.h"
+
+#include <base/math.h>
+
+#include <game/collision.h>
+
+void CParticleGroup::Clear()
+{
+	for(auto *pvArray : {&m_vPosX, &m_vPosY, &m_vVelX, &m_vVelY, &m_vLife, &m_vLifeSpan, &m_vRot, &m_vRotspeed, &m_vGravity, &m_vFriction, &m_vStartSize, &m_vEndSize, &m_vStartAlpha, &m_vEndAlpha})
+		pvArray->clear();
+	m_vColor.clear();
+	m_vSpr.clear();
+	m_vUseAlphaFading.clear();
+	m_vCollides.clear();
+}
+
+void CParticleGroup::Add(const CParticle &Part, float TimePassed)
+{
+	m_vPosX.push_back(Part.m_Pos.x);
+	m_vPosY.push_back(Part.m_Pos.y);
+	m_vVelX.push_back(Part.m_Vel.x);
+	m_vVelY.push_back(Part.m_Vel.y);
+	m_vLife.push_back(TimePassed);
+	m_vLifeSpan.push_back(Part.m_LifeSpan);
+	m_vRot.push_back(Part.m_Rot);
+	m_vRotspeed.push_back(Part.m_Rotspeed);
+	m_vGravity.push_back(Part.m_Gravity);
+	m_vFriction.push_back(Part.m_Friction);
+	m_vStartSize.push_back(Part.m_StartSize);
+	m_vEndSize.push_back(Part.m_EndSize);
+	m_vStartAlpha.push_back(Part.m_StartAlpha);
+	m_vEndAlpha.push_back(Part.m_EndAlpha);
+	m_vColor.push_back(Part.m_Color);
+	m_vSpr.push_back(Part.m_Spr);
+	m_vUseAlphaFading.push_back(Part.m_UseAlphaFading);
+	m_vCollides.push_back(Part.m_Collides);
+}
+
+void CParticleGroup::Move(int From, int To)
+{
+	for(auto *pvArray : {&m_vPosX, &m_vPosY, &m_vVelX, &m_vVelY, &m_vLife, &m_vLifeSpan, &m_vRot, &m_vRotspeed, &m_vGravity, &m_vFriction, &m_vStartSize, &m_vEndSize, &m_vStartAlpha, &m_vEndAlpha})
+		(*pvArray)[To] = (*pvArray)[From];
+	m_vColor[To] = m_vColor[From];
+	m_vSpr[To] = m_vSpr[From];
+	m_vUseAlphaFading[To] = m_vUseAlphaFading[From];
+	m_vCollides[To] = m_vCollides[From];
+}
+
+void CParticleGroup::Truncate(int Size)
+{
+	for(auto *pvArray : {&m_vPosX, &m_vPosY, &m_vVelX, &m_vVelY, &m_vLife, &m_vLifeSpan, &m_vRot, &m_vRotspeed, &m_vGravity, &m_vFriction, &m_vStartSize, &m_vEndSize, &m_vStartAlpha, &m_vEndAlpha})
+		pvArray->resize(Size);
+	m_vColor.resize(Size);
+	m_vSpr.resize(Size);
+	m_vUseAlphaFading.resize(Size);
+	m_vCollides.resize(Size);
+}
+
+void CParticleGroup::Update(float TimePassed, int FrictionCount, const CCollision *pCollision)
+{
+	const int Num = Size();
+	float *pPosX = m_vPosX.data();
+	float *pPosY = m_vPosY.data();
+	float *pVelX = m_vVelX.data();
+	float *pVelY = m_vVelY.data();
+	const float *pGravity = m_vGravity.data();
+	const float *pFriction = m_vFriction.data();
+
+	for(int i = 0; i < Num; i++)
+		pVelY[i] += pGravity[i] * TimePassed;
+
+	// apply friction
+	for(int f = 0; f < FrictionCount; f++)
+	{
+		for(int i = 0; i < Num; i++)
+		{
+			pVelX[i] *= pFriction[i];
+			pVelY[i] *= pFriction[i];
+		}
+	}
+
+	// the velocity now holds the distance to move
+	for(int i = 0; i < Num; i++)
+	{
+		pVelX[i] *= TimePassed;
+		pVelY[i] *= TimePassed;
+	}
+
+	const unsigned char *pCollides = m_vCollides.data();
+	for(int i = 0; i < Num; i++)
+	{
+		pPosX[i] = pCollides[i] ? pPosX[i] : pPosX[i] + pVelX[i];
+		pPosY[i] = pCollides[i] ? pPosY[i] : pPosY[i] + pVelY[i];
+	}
+
+	for(int i = 0; i < Num; i++)
+	{
+		if(!pCollides[i])
+			continue;
+		vec2 Pos(pPosX[i], pPosY[i]);
+		vec2 Vel(pVelX[i], pVelY[i]);
+		pCollision->MovePoint(&Pos, &Vel, random_float(0.1f, 1.0f), NULL);
+		pPosX[i] = Pos.x;
+		pPosY[i] = Pos.y;
+		pVelX[i] = Vel.x;
+		pVelY[i] = Vel.y;
+	}
+
+	const float InvTimePassed = 1.0f / TimePassed;
+	float *pLife = m_vLife.data();
+	float *pRot = m_vRot.data();
+	const float *pRotspeed = m_vRotspeed.data();
+	for(int i = 0; i < Num; i++)
+	{
+		pVelX[i] *= InvTimePassed;
+		pVelY[i] *= InvTimePassed;
+		pLife[i] += TimePassed;
+		pRot[i] += TimePassed * pRotspeed[i];
+	}
+
+	// remove the dead particles in one pass
+	const float *pLifeSpan = m_vLifeSpan.data();
+	int NumAlive = 0;
+	for(int i = 0; i < Num; i++)
+	{
+		if(pLife[i] > pLifeSpan[i])
+			continue;
+		if(i != NumAlive)
+			Move(i, NumAlive);
+		NumAlive++;
+	}
+	Truncate(NumAlive);
+}
@@ -0,0 +1,105 @@
+#ifndef GAME_CLIENT_PARTICLE_GROUP_H
+#define GAME_CLIENT_PARTICLE_GROUP_H
+
+#include <base/color.h>
+#include <base/vmath.h>
+
+#include <vector>
+
+class CCollision;
+
+// particles
+struct CParticle
+{
+	void SetDefault()
+	{
+		m_Pos = vec2(0, 0);
+		m_Vel = vec2(0, 0);
+		m_LifeSpan = 0;
+		m_StartSize = 32;
+		m_EndSize = 32;
+		m_UseAlphaFading = false;
+		m_StartAlpha = 1;
+		m_EndAlpha = 1;
+		m_Rot = 0;
+		m_Rotspeed = 0;
+		m_Gravity = 0;
+		m_Friction = 0;
+		m_FlowAffected = 1.0f;
+		m_Color = ColorRGBA(1, 1, 1, 1);
+		m_Collides = true;
+	}
+
+	vec2 m_Pos;
+	vec2 m_Vel;
+
+	int m_Spr;
+
+	float m_FlowAffected;
+
+	float m_LifeSpan;
+
+	float m_StartSize;
+	float m_EndSize;
+
+	bool m_UseAlphaFading;
+	float m_StartAlpha;
+	float m_EndAlpha;
+
+	float m_Rot;
+	float m_Rotspeed;
+
+	float m_Gravity;
+	float m_Friction;
+
+	ColorRGBA m_Color;
+
+	bool m_Collides;
+};
+
+// The particles of one group, stored as one array per attribute so the
+// update runs over contiguous floats the compiler can vectorize. Removing
+// particles keeps the order of the others, the newest particle is the last.
+class CParticleGroup
+{
+public:
+	std::vector<float> m_vPosX;
+	std::vector<float> m_vPosY;
+	std::vector<float> m_vVelX;
+	std::vector<float> m_vVelY;
+	std::vector<float> m_vLife;
+	std::vector<float> m_vLifeSpan;
+	std::vector<float> m_vRot;
+	std::vector<float> m_vRotspeed;
+	std::vector<float> m_vGravity;
+	std::vector<float> m_vFriction;
+	std::vector<float> m_vStartSize;
+	std::vector<float> m_vEndSize;
+	std::vector<float> m_vStartAlpha;
+	std::vector<float> m_vEndAlpha;
+	std::vector<ColorRGBA> m_vColor;
+	std::vector<int> m_vSpr;
+	std::vector<unsigned char> m_vUseAlphaFading;
+	std::vector<unsigned char> m_vCollides;
+
+	int Size() const { return m_vPosX.size(); }
+	void Clear();
+
+	// `TimePassed` is the time the particle already lived
+	void Add(const CParticle &Part, float TimePassed);
+
+	// Moves all particles by `TimePassed`, applying the friction
+	// `FrictionCount` times, and removes the dead ones. Particles that
+	// collide are moved through `pCollision` after the others.
+	void Update(float TimePassed, int FrictionCount, const CCollision *pCollision);
+
+	float LifeFraction(int Index) const { return m_vLife[Index] / m_vLifeSpan[Index]; }
+	float CurrentSize(int Index) const { return mix(m_vStartSize[Index], m_vEndSize[Index], LifeFraction(Index)); }
+	float CurrentAlpha(int Index) const { return m_vUseAlphaFading[Index] ? mix(m_vStartAlpha[Index], m_vEndAlpha[Index], LifeFraction(Index)) : m_vColor[Index].a; }
+
+private:
+	void Move(int From, int To);
+	void Truncate(int Size);
+};
+
+#endif
@@ -0,0 +1,231 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include "skin_load.h"
+
+#include <base/log.h>
+#include <base/math.h>
+
+#include <engine/gfx/image_loader.h>
+#include <engine/storage.h>
+
+#include <game/generated/client_data.h>
+
+static void CheckMetrics(CSkin::SSkinMetricVariable &Metrics, const uint8_t *pImg, int ImgWidth, int ImgX, int ImgY, int CheckWidth, int CheckHeight)
+{
+	int MaxY = -1;
+	int MinY = CheckHeight + 1;
+	int MaxX = -1;
+	int MinX = CheckWidth + 1;
+
+	for(int y = 0; y < CheckHeight; y++)
+	{
+		for(int x = 0; x < CheckWidth; x++)
+		{
+			int OffsetAlpha = (y + ImgY) * ImgWidth + (x + ImgX) * 4 + 3;
+			uint8_t AlphaValue = pImg[OffsetAlpha];
+			if(AlphaValue > 0)
+			{
+				if(MaxY < y)
+					MaxY = y;
+				if(MinY > y)
+					MinY = y;
+				if(MaxX < x)
+					MaxX = x;
+				if(MinX > x)
+					MinX = x;
+			}
+		}
+	}
+
+	Metrics.m_Width = clamp((MaxX - MinX) + 1, 1, CheckWidth);
+	Metrics.m_Height = clamp((MaxY - MinY) + 1, 1, CheckHeight);
+	Metrics.m_OffsetX = clamp(MinX, 0, CheckWidth - 1);
+	Metrics.m_OffsetY = clamp(MinY, 0, CheckHeight - 1);
+	Metrics.m_MaxWidth = CheckWidth;
+	Metrics.m_MaxHeight = CheckHeight;
+}
+
+bool CSkinLoadData::Prepare()
+{
+	const CImageInfo &Info = m_Info;
+
+	// images that need a warning or have to be resized are handled on the main thread
+	if(Info.m_Format != CImageInfo::FORMAT_RGBA || Info.m_Width == 0 || Info.m_Height == 0 ||
+		Info.m_Width % g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridx != 0 ||
+		Info.m_Height % g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy != 0)
+		return false;
+
+	int FeetGridPixelsWidth = (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_FOOT].m_pSet->m_Gridx);
+	int FeetGridPixelsHeight = (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_FOOT].m_pSet->m_Gridy);
+	int FeetWidth = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_W * FeetGridPixelsWidth;
+	int FeetHeight = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_H * FeetGridPixelsHeight;
+
+	int FeetOffsetX = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_X * FeetGridPixelsWidth;
+	int FeetOffsetY = g_pData->m_aSprites[SPRITE_TEE_FOOT].m_Y * FeetGridPixelsHeight;
+
+	int FeetOutlineGridPixelsWidth = (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_pSet->m_Gridx);
+	int FeetOutlineGridPixelsHeight = (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_pSet->m_Gridy);
+	int FeetOutlineWidth = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_W * FeetOutlineGridPixelsWidth;
+	int FeetOutlineHeight = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_H * FeetOutlineGridPixelsHeight;
+
+	int FeetOutlineOffsetX = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_X * FeetOutlineGridPixelsWidth;
+	int FeetOutlineOffsetY = g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE].m_Y * FeetOutlineGridPixelsHeight;
+
+	int BodyOutlineGridPixelsWidth = (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_pSet->m_Gridx);
+	int BodyOutlineGridPixelsHeight = (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_pSet->m_Gridy);
+	int BodyOutlineWidth = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_W * BodyOutlineGridPixelsWidth;
+	int BodyOutlineHeight = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_H * BodyOutlineGridPixelsHeight;
+
+	int BodyOutlineOffsetX = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_X * BodyOutlineGridPixelsWidth;
+	int BodyOutlineOffsetY = g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE].m_Y * BodyOutlineGridPixelsHeight;
+
+	int BodyWidth = g_pData->m_aSprites[SPRITE_TEE_BODY].m_W * (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridx); // body width
+	int BodyHeight = g_pData->m_aSprites[SPRITE_TEE_BODY].m_H * (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy); // body height
+	if(BodyWidth > Info.m_Width || BodyHeight > Info.m_Height)
+		return false;
+	const unsigned char *pOrgData = (const unsigned char *)Info.m_pData;
+	const int PixelStep = 4;
+	int Pitch = Info.m_Width * PixelStep;
+
+	// dig out blood color
+	{
+		int aColors[3] = {0};
+		for(int y = 0; y < BodyHeight; y++)
+			for(int x = 0; x < BodyWidth; x++)
+			{
+				uint8_t AlphaValue = pOrgData[y * Pitch + x * PixelStep + 3];
+				if(AlphaValue > 128)
+				{
+					aColors[0] += pOrgData[y * Pitch + x * PixelStep + 0];
+					aColors[1] += pOrgData[y * Pitch + x * PixelStep + 1];
+					aColors[2] += pOrgData[y * Pitch + x * PixelStep + 2];
+				}
+			}
+		if(aColors[0] != 0 && aColors[1] != 0 && aColors[2] != 0)
+			m_BloodColor = ColorRGBA(normalize(vec3(aColors[0], aColors[1], aColors[2])));
+		else
+			m_BloodColor = ColorRGBA(0, 0, 0, 1);
+	}
+
+	m_Metrics.Reset();
+	CheckMetrics(m_Metrics.m_Body, pOrgData, Pitch, 0, 0, BodyWidth, BodyHeight);
+
+	// body outline metrics
+	CheckMetrics(m_Metrics.m_Body, pOrgData, Pitch, BodyOutlineOffsetX, BodyOutlineOffsetY, BodyOutlineWidth, BodyOutlineHeight);
+
+	// get feet size
+	CheckMetrics(m_Metrics.m_Feet, pOrgData, Pitch, FeetOffsetX, FeetOffsetY, FeetWidth, FeetHeight);
+
+	// get feet outline size
+	CheckMetrics(m_Metrics.m_Feet, pOrgData, Pitch, FeetOutlineOffsetX, FeetOutlineOffsetY, FeetOutlineWidth, FeetOutlineHeight);
+
+	// the colorable textures are made from a copy, the original ones are uploaded as well
+	free(m_InfoGrayscale.m_pData);
+	m_InfoGrayscale = Info;
+	m_InfoGrayscale.m_pData = malloc((size_t)Pitch * Info.m_Height);
+	unsigned char *pData = (unsigned char *)m_InfoGrayscale.m_pData;
+
+	// make the texture gray scale
+	for(int i = 0; i < Info.m_Width * Info.m_Height; i++)
+	{
+		int v = (pOrgData[i * PixelStep] + pOrgData[i * PixelStep + 1] + pOrgData[i * PixelStep + 2]) / 3;
+		pData[i * PixelStep] = v;
+		pData[i * PixelStep + 1] = v;
+		pData[i * PixelStep + 2] = v;
+		pData[i * PixelStep + 3] = pOrgData[i * PixelStep + 3];
+	}
+
+	int aFreq[256] = {0};
+	int OrgWeight = 0;
+	int NewWeight = 192;
+
+	// find most common frequency
+	for(int y = 0; y < BodyHeight; y++)
+		for(int x = 0; x < BodyWidth; x++)
+		{
+			if(pData[y * Pitch + x * PixelStep + 3] > 128)
+				aFreq[pData[y * Pitch + x * PixelStep]]++;
+		}
+
+	for(int i = 1; i < 256; i++)
+	{
+		if(aFreq[OrgWeight] < aFreq[i])
+			OrgWeight = i;
+	}
+
+	// reorder
+	int InvOrgWeight = 255 - OrgWeight;
+	int InvNewWeight = 255 - NewWeight;
+	for(int y = 0; y < BodyHeight; y++)
+		for(int x = 0; x < BodyWidth; x++)
+		{
+			int v = pData[y * Pitch + x * PixelStep];
+			if(v <= OrgWeight && OrgWeight == 0)
+				v = 0;
+			else if(v <= OrgWeight)
+				v = (int)(((v / (float)OrgWeight) * NewWeight));
+			else if(InvOrgWeight == 0)
+				v = NewWeight;
+			else
+				v = (int)(((v - OrgWeight) / (float)InvOrgWeight) * InvNewWeight + NewWeight);
+			pData[y * Pitch + x * PixelStep] = v;
+			pData[y * Pitch + x * PixelStep + 1] = v;
+			pData[y * Pitch + x * PixelStep + 2] = v;
+		}
+
+	return true;
+}
+
+void CSkinLoadData::Free()
+{
+	free(m_Info.m_pData);
+	m_Info.m_pData = nullptr;
+	free(m_InfoGrayscale.m_pData);
+	m_InfoGrayscale.m_pData = nullptr;
+	m_Prepared = false;
+}
+
+CSkinLoadJob::CSkinLoadJob(IStorage *pStorage, const char *pName, const char *pPath, int DirType) :
+	m_pStorage(pStorage),
+	m_DirType(DirType)
+{
+	str_copy(m_aName, pName);
+	str_copy(m_aPath, pPath);
+}
+
+void CSkinLoadJob::Run()
+{
+	void *pFileData;
+	unsigned FileSize;
+	if(!m_pStorage->ReadFile(m_aPath, m_DirType, &pFileData, &FileSize))
+	{
+		log_info("skins", "failed to load skin from %s", m_aName);
+		return;
+	}
+
+	TImageByteBuffer ByteBuffer((uint8_t *)pFileData, (uint8_t *)pFileData + FileSize);
+	free(pFileData);
+	SImageByteBuffer ImageByteBuffer(&ByteBuffer);
+
+	uint8_t *pImgBuffer = nullptr;
+	EImageFormat ImageFormat;
+	int PngliteIncompatible;
+	if(!::LoadPNG(ImageByteBuffer, m_aPath, PngliteIncompatible, m_Data.m_Info.m_Width, m_Data.m_Info.m_Height, pImgBuffer, ImageFormat))
+	{
+		log_info("skins", "failed to load skin from %s", m_aName);
+		return;
+	}
+	if(ImageFormat == IMAGE_FORMAT_RGB)
+		m_Data.m_Info.m_Format = CImageInfo::FORMAT_RGB;
+	else if(ImageFormat == IMAGE_FORMAT_RGBA)
+		m_Data.m_Info.m_Format = CImageInfo::FORMAT_RGBA;
+	else
+	{
+		free(pImgBuffer);
+		log_error("skins", "image had unsupported image format. filename='%s' format='%d'", m_aPath, (int)ImageFormat);
+		return;
+	}
+	m_Data.m_Info.m_pData = pImgBuffer;
+	m_Loaded = true;
+	m_Data.m_Prepared = m_Data.Prepare();
+}
@@ -0,0 +1,64 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_CLIENT_SKIN_LOAD_H
+#define GAME_CLIENT_SKIN_LOAD_H
+
+#include <base/color.h>
+#include <base/system.h>
+
+#include <engine/graphics.h>
+#include <engine/shared/jobs.h>
+
+#include <game/client/skin.h>
+
+class IStorage;
+
+// Image data of a skin together with everything that can be computed
+// from it without the graphics backend, so it can be prepared off the
+// main thread and only has to be uploaded there.
+class CSkinLoadData
+{
+public:
+	CImageInfo m_Info;
+	CImageInfo m_InfoGrayscale;
+	CSkin::SSkinMetrics m_Metrics;
+	ColorRGBA m_BloodColor;
+	bool m_Prepared = false;
+
+	CSkinLoadData() = default;
+	CSkinLoadData(const CSkinLoadData &Other) = delete;
+	CSkinLoadData &operator=(const CSkinLoadData &Other) = delete;
+	~CSkinLoadData() { Free(); }
+
+	/**
+	 * Computes the blood color, the metrics and the colorable image of the
+	 * decoded skin in `m_Info`.
+	 *
+	 * @return `false` if the image has to be checked and resized on the main thread first.
+	 */
+	bool Prepare();
+
+	/**
+	 * Frees both images.
+	 */
+	void Free();
+};
+
+// Decodes and prepares one skin file, independent of the graphics backend.
+class CSkinLoadJob : public IJob
+{
+	IStorage *m_pStorage;
+	char m_aPath[IO_MAX_PATH_LENGTH];
+	int m_DirType;
+
+	void Run() override;
+
+public:
+	CSkinLoadJob(IStorage *pStorage, const char *pName, const char *pPath, int DirType);
+
+	char m_aName[24];
+	bool m_Loaded = false;
+	CSkinLoadData m_Data;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include <antibot/antibot_data.h>
 
 #include <cmath>
+#include <limits>
 #include <engine/map.h>
 
 #include <game/collision.h>
@@ -481,6 +482,51 @@ bool CCollision::TestBox(vec2 Pos, vec2 Size) const
 	return false;
 }
 
+// steps of MoveBox that are tested together
+static constexpr int MOVE_BOX_CHUNK_STEPS = 16;
+static constexpr int MOVE_BOX_MIN_CHUNK_STEPS = 4;
+
+// Bound for how far the positions MoveBox adds up step by step can drift
+// from the exact path through rounding: half an ulp per step, plus a unit.
+static float MoveBoxMargin(vec2 Pos, int Steps)
+{
+	const float Magnitude = maximum(absolute(Pos.x), absolute(Pos.y)) + Steps;
+	return 1.0f + Steps * Magnitude * std::numeric_limits<float>::epsilon();
+}
+
+bool CCollision::TestBoxPath(vec2 Pos, vec2 Delta, vec2 Size, float Margin) const
+{
+	if(!m_pTiles)
+		return false;
+
+	const vec2 Extent = Size * 0.5f + vec2(Margin, Margin);
+	const float MinX = minimum(Pos.x, Pos.x + Delta.x) - Extent.x;
+	const float MinY = minimum(Pos.y, Pos.y + Delta.y) - Extent.y;
+	const float MaxX = maximum(Pos.x, Pos.x + Delta.x) + Extent.x;
+	const float MaxY = maximum(Pos.y, Pos.y + Delta.y) + Extent.y;
+	// also catches NaN, out of range coordinates can't be rounded
+	const float Limit = 1e9f;
+	if(!(MinX > -Limit && MinY > -Limit && MaxX < Limit && MaxY < Limit))
+		return true;
+
+	// rounding and the tile lookup are monotonic, so the tiles of all
+	// points in the area lie between the tiles of its corners
+	const int StartX = clamp(round_to_int(MinX) / 32, 0, m_Width - 1);
+	const int StartY = clamp(round_to_int(MinY) / 32, 0, m_Height - 1);
+	const int EndX = clamp(round_to_int(MaxX) / 32, 0, m_Width - 1);
+	const int EndY = clamp(round_to_int(MaxY) / 32, 0, m_Height - 1);
+	for(int y = StartY; y <= EndY; y++)
+	{
+		for(int x = StartX; x <= EndX; x++)
+		{
+			const int Index = m_pTiles[y * m_Width + x].m_Index;
+			if(Index == TILE_SOLID || Index == TILE_NOHOOK)
+				return true;
+		}
+	}
+	return false;
+}
+
 void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elasticity, bool *pGrounded) const
 {
 	// do the move
@@ -496,6 +542,14 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elast
 		float ElasticityX = clamp(Elasticity.x, -1.0f, 1.0f);
 		float ElasticityY = clamp(Elasticity.y, -1.0f, 1.0f);
 
+		// Steps are at most one unit long. Instead of testing the box after
+		// each of them, test the area covered by the next few steps at once
+		// and skip the per-step tests if it doesn't contain any solid tile.
+		// The positions are still computed step by step to keep the results
+		// exactly the same.
+		int ChunkSteps = 0;
+		bool ChunkFree = false;
+
 		for(int i = 0; i <= Max; i++)
 		{
 			// Early break as optimization to stop checking for collisions for
@@ -515,9 +569,19 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elast
 				break;
 			}
 
-			if(TestBox(vec2(NewPos.x, NewPos.y), Size))
+			if(ChunkSteps == 0)
+			{
+				ChunkSteps = minimum(Max + 1 - i, MOVE_BOX_CHUNK_STEPS);
+				// not worth it for slow movement
+				ChunkFree = ChunkSteps >= MOVE_BOX_MIN_CHUNK_STEPS && !TestBoxPath(Pos, Vel * Fraction * (float)ChunkSteps, Size, MoveBoxMargin(Pos, ChunkSteps));
+			}
+			ChunkSteps--;
+
+			if(!ChunkFree && TestBox(vec2(NewPos.x, NewPos.y), Size))
 			{
 				int Hits = 0;
+				// the velocity changes, start a new chunk
+				ChunkSteps = 0;
 
 				if(TestBox(vec2(Pos.x, NewPos.y), Size))
 				{
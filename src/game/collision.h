@@ -44,6 +44,10 @@ public:
 	void MovePoint(vec2 *pInoutPos, vec2 *pInoutVel, float Elasticity, int *pBounces) const;
 	void MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elasticity, bool *pGrounded = nullptr) const;
 	bool TestBox(vec2 Pos, vec2 Size) const;
+	// Conservative TestBox for a whole move: returns false only if no solid
+	// tile lies within `Margin` of the area the box covers on its way from
+	// `Pos` to `Pos + Delta`.
+	bool TestBoxPath(vec2 Pos, vec2 Delta, vec2 Size, float Margin) const;
 
 	// DDRace
 
@@ -0,0 +1,615 @@
+#include "auto_map_rules.h"
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/shared/linereader.h>
+
+#include <game/mapitems.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio> // sscanf
+#include <map>
+#include <thread>
+
+// Based on triple32inc from https://github.com/skeeto/hash-prospector/tree/79a6074062a84907df6e45b756134b74e2956760
+static uint32_t HashUInt32(uint32_t Num)
+{
+	Num++;
+	Num ^= Num >> 17;
+	Num *= 0xed5ad4bbu;
+	Num ^= Num >> 11;
+	Num *= 0xac4c1b51u;
+	Num ^= Num >> 15;
+	Num *= 0x31848babu;
+	Num ^= Num >> 14;
+	return Num;
+}
+
+#define HASH_MAX 65536
+
+static const uint32_t HASH_PRIME = 31;
+
+// The part of the location hash that is the same for every tile, the
+// coordinates are added by `HashLocation` as `HashUInt32(X)` and
+// `HashUInt32(Y)`.
+static uint32_t HashRule(uint32_t Seed, uint32_t Run, uint32_t Rule)
+{
+	uint32_t Hash = 1;
+	Hash = Hash * HASH_PRIME + HashUInt32(Seed);
+	Hash = Hash * HASH_PRIME + HashUInt32(Run);
+	Hash = Hash * HASH_PRIME + HashUInt32(Rule);
+	return Hash;
+}
+
+static int HashLocation(uint32_t RuleHash, uint32_t HashX, uint32_t HashY)
+{
+	uint32_t Hash = RuleHash;
+	Hash = Hash * HASH_PRIME + HashX;
+	Hash = Hash * HASH_PRIME + HashY;
+	Hash = HashUInt32(Hash * HASH_PRIME); // Just to double-check that values are well-distributed
+	return Hash % HASH_MAX;
+}
+
+void CAutoMapRules::Load(CLineReader &LineReader)
+{
+	CConfiguration *pCurrentConf = nullptr;
+	CRun *pCurrentRun = nullptr;
+	CIndexRule *pCurrentIndex = nullptr;
+
+	// read each line
+	while(char *pLine = LineReader.Get())
+	{
+		// skip blank/empty lines as well as comments
+		if(str_length(pLine) > 0 && pLine[0] != '#' && pLine[0] != '\n' && pLine[0] != '\r' && pLine[0] != '\t' && pLine[0] != '\v' && pLine[0] != ' ')
+		{
+			if(pLine[0] == '[')
+			{
+				// new configuration, get the name
+				pLine++;
+				CConfiguration NewConf;
+				NewConf.m_aName[0] = '\0';
+				NewConf.m_StartX = 0;
+				NewConf.m_StartY = 0;
+				NewConf.m_EndX = 0;
+				NewConf.m_EndY = 0;
+				m_vConfigs.push_back(NewConf);
+				int ConfigurationID = m_vConfigs.size() - 1;
+				pCurrentConf = &m_vConfigs[ConfigurationID];
+				str_copy(pCurrentConf->m_aName, pLine, minimum<int>(sizeof(pCurrentConf->m_aName), str_length(pLine)));
+
+				// add start run
+				CRun NewRun;
+				NewRun.m_AutomapCopy = true;
+				pCurrentConf->m_vRuns.push_back(NewRun);
+				int RunID = pCurrentConf->m_vRuns.size() - 1;
+				pCurrentRun = &pCurrentConf->m_vRuns[RunID];
+			}
+			else if(str_startswith(pLine, "NewRun") && pCurrentConf)
+			{
+				// add new run
+				CRun NewRun;
+				NewRun.m_AutomapCopy = true;
+				pCurrentConf->m_vRuns.push_back(NewRun);
+				int RunID = pCurrentConf->m_vRuns.size() - 1;
+				pCurrentRun = &pCurrentConf->m_vRuns[RunID];
+			}
+			else if(str_startswith(pLine, "Index") && pCurrentRun)
+			{
+				// new index
+				int ID = 0;
+				char aOrientation1[128] = "";
+				char aOrientation2[128] = "";
+				char aOrientation3[128] = "";
+
+				sscanf(pLine, "Index %d %127s %127s %127s", &ID, aOrientation1, aOrientation2, aOrientation3);
+
+				CIndexRule NewIndexRule;
+				NewIndexRule.m_ID = ID;
+				NewIndexRule.m_Flag = 0;
+				NewIndexRule.m_RandomProbability = 1.0f;
+				NewIndexRule.m_DefaultRule = true;
+				NewIndexRule.m_SkipEmpty = false;
+				NewIndexRule.m_SkipFull = false;
+
+				if(str_length(aOrientation1) > 0)
+				{
+					if(!str_comp(aOrientation1, "XFLIP"))
+						NewIndexRule.m_Flag |= TILEFLAG_XFLIP;
+					else if(!str_comp(aOrientation1, "YFLIP"))
+						NewIndexRule.m_Flag |= TILEFLAG_YFLIP;
+					else if(!str_comp(aOrientation1, "ROTATE"))
+						NewIndexRule.m_Flag |= TILEFLAG_ROTATE;
+				}
+
+				if(str_length(aOrientation2) > 0)
+				{
+					if(!str_comp(aOrientation2, "XFLIP"))
+						NewIndexRule.m_Flag |= TILEFLAG_XFLIP;
+					else if(!str_comp(aOrientation2, "YFLIP"))
+						NewIndexRule.m_Flag |= TILEFLAG_YFLIP;
+					else if(!str_comp(aOrientation2, "ROTATE"))
+						NewIndexRule.m_Flag |= TILEFLAG_ROTATE;
+				}
+
+				if(str_length(aOrientation3) > 0)
+				{
+					if(!str_comp(aOrientation3, "XFLIP"))
+						NewIndexRule.m_Flag |= TILEFLAG_XFLIP;
+					else if(!str_comp(aOrientation3, "YFLIP"))
+						NewIndexRule.m_Flag |= TILEFLAG_YFLIP;
+					else if(!str_comp(aOrientation3, "ROTATE"))
+						NewIndexRule.m_Flag |= TILEFLAG_ROTATE;
+				}
+
+				// add the index rule object and make it current
+				pCurrentRun->m_vIndexRules.push_back(NewIndexRule);
+				int IndexRuleID = pCurrentRun->m_vIndexRules.size() - 1;
+				pCurrentIndex = &pCurrentRun->m_vIndexRules[IndexRuleID];
+			}
+			else if(str_startswith(pLine, "Pos") && pCurrentIndex)
+			{
+				int x = 0, y = 0;
+				char aValue[128];
+				int Value = CPosRule::NORULE;
+				std::vector<CIndexInfo> vNewIndexList;
+
+				sscanf(pLine, "Pos %d %d %127s", &x, &y, aValue);
+
+				if(!str_comp(aValue, "EMPTY"))
+				{
+					Value = CPosRule::INDEX;
+					CIndexInfo NewIndexInfo = {0, 0, false};
+					vNewIndexList.push_back(NewIndexInfo);
+				}
+				else if(!str_comp(aValue, "FULL"))
+				{
+					Value = CPosRule::NOTINDEX;
+					CIndexInfo NewIndexInfo1 = {0, 0, false};
+					// CIndexInfo NewIndexInfo2 = {-1, 0};
+					vNewIndexList.push_back(NewIndexInfo1);
+					// vNewIndexList.push_back(NewIndexInfo2);
+				}
+				else if(!str_comp(aValue, "INDEX") || !str_comp(aValue, "NOTINDEX"))
+				{
+					if(!str_comp(aValue, "INDEX"))
+						Value = CPosRule::INDEX;
+					else
+						Value = CPosRule::NOTINDEX;
+
+					int pWord = 4;
+					while(true)
+					{
+						int ID = 0;
+						char aOrientation1[128] = "";
+						char aOrientation2[128] = "";
+						char aOrientation3[128] = "";
+						char aOrientation4[128] = "";
+						sscanf(str_trim_words(pLine, pWord), "%d %127s %127s %127s %127s", &ID, aOrientation1, aOrientation2, aOrientation3, aOrientation4);
+
+						CIndexInfo NewIndexInfo;
+						NewIndexInfo.m_ID = ID;
+						NewIndexInfo.m_Flag = 0;
+						NewIndexInfo.m_TestFlag = false;
+
+						if(!str_comp(aOrientation1, "OR"))
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							pWord += 2;
+							continue;
+						}
+						else if(str_length(aOrientation1) > 0)
+						{
+							NewIndexInfo.m_TestFlag = true;
+							if(!str_comp(aOrientation1, "XFLIP"))
+								NewIndexInfo.m_Flag = TILEFLAG_XFLIP;
+							else if(!str_comp(aOrientation1, "YFLIP"))
+								NewIndexInfo.m_Flag = TILEFLAG_YFLIP;
+							else if(!str_comp(aOrientation1, "ROTATE"))
+								NewIndexInfo.m_Flag = TILEFLAG_ROTATE;
+							else if(!str_comp(aOrientation1, "NONE"))
+								NewIndexInfo.m_Flag = 0;
+							else
+								NewIndexInfo.m_TestFlag = false;
+						}
+						else
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							break;
+						}
+
+						if(!str_comp(aOrientation2, "OR"))
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							pWord += 3;
+							continue;
+						}
+						else if(str_length(aOrientation2) > 0 && NewIndexInfo.m_Flag != 0)
+						{
+							if(!str_comp(aOrientation2, "XFLIP"))
+								NewIndexInfo.m_Flag |= TILEFLAG_XFLIP;
+							else if(!str_comp(aOrientation2, "YFLIP"))
+								NewIndexInfo.m_Flag |= TILEFLAG_YFLIP;
+							else if(!str_comp(aOrientation2, "ROTATE"))
+								NewIndexInfo.m_Flag |= TILEFLAG_ROTATE;
+						}
+						else
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							break;
+						}
+
+						if(!str_comp(aOrientation3, "OR"))
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							pWord += 4;
+							continue;
+						}
+						else if(str_length(aOrientation3) > 0 && NewIndexInfo.m_Flag != 0)
+						{
+							if(!str_comp(aOrientation3, "XFLIP"))
+								NewIndexInfo.m_Flag |= TILEFLAG_XFLIP;
+							else if(!str_comp(aOrientation3, "YFLIP"))
+								NewIndexInfo.m_Flag |= TILEFLAG_YFLIP;
+							else if(!str_comp(aOrientation3, "ROTATE"))
+								NewIndexInfo.m_Flag |= TILEFLAG_ROTATE;
+						}
+						else
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							break;
+						}
+
+						if(!str_comp(aOrientation4, "OR"))
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							pWord += 5;
+							continue;
+						}
+						else
+						{
+							vNewIndexList.push_back(NewIndexInfo);
+							break;
+						}
+					}
+				}
+
+				if(Value != CPosRule::NORULE)
+				{
+					CPosRule NewPosRule = {x, y, Value, vNewIndexList};
+					pCurrentIndex->m_vRules.push_back(NewPosRule);
+
+					pCurrentConf->m_StartX = minimum(pCurrentConf->m_StartX, NewPosRule.m_X);
+					pCurrentConf->m_StartY = minimum(pCurrentConf->m_StartY, NewPosRule.m_Y);
+					pCurrentConf->m_EndX = maximum(pCurrentConf->m_EndX, NewPosRule.m_X);
+					pCurrentConf->m_EndY = maximum(pCurrentConf->m_EndY, NewPosRule.m_Y);
+
+					if(x == 0 && y == 0)
+					{
+						for(const auto &Index : vNewIndexList)
+						{
+							if(Value == CPosRule::INDEX && Index.m_ID == 0)
+								pCurrentIndex->m_SkipFull = true;
+							else
+								pCurrentIndex->m_SkipEmpty = true;
+						}
+					}
+				}
+			}
+			else if(str_startswith(pLine, "Random") && pCurrentIndex)
+			{
+				float Value;
+				char Specifier = ' ';
+				sscanf(pLine, "Random %f%c", &Value, &Specifier);
+				if(Specifier == '%')
+				{
+					pCurrentIndex->m_RandomProbability = Value / 100.0f;
+				}
+				else
+				{
+					pCurrentIndex->m_RandomProbability = 1.0f / Value;
+				}
+			}
+			else if(str_startswith(pLine, "NoDefaultRule") && pCurrentIndex)
+			{
+				pCurrentIndex->m_DefaultRule = false;
+			}
+			else if(str_startswith(pLine, "NoLayerCopy") && pCurrentRun)
+			{
+				pCurrentRun->m_AutomapCopy = false;
+			}
+		}
+	}
+
+	// add default rule for Pos 0 0 if there is none
+	for(auto &Config : m_vConfigs)
+	{
+		for(auto &Run : Config.m_vRuns)
+		{
+			for(auto &IndexRule : Run.m_vIndexRules)
+			{
+				bool Found = false;
+				for(const auto &Rule : IndexRule.m_vRules)
+				{
+					if(Rule.m_X == 0 && Rule.m_Y == 0)
+					{
+						Found = true;
+						break;
+					}
+				}
+				if(!Found && IndexRule.m_DefaultRule)
+				{
+					std::vector<CIndexInfo> vNewIndexList;
+					CIndexInfo NewIndexInfo = {0, 0, false};
+					vNewIndexList.push_back(NewIndexInfo);
+					CPosRule NewPosRule = {0, 0, CPosRule::NOTINDEX, vNewIndexList};
+					IndexRule.m_vRules.push_back(NewPosRule);
+
+					IndexRule.m_SkipEmpty = true;
+					IndexRule.m_SkipFull = false;
+				}
+				if(IndexRule.m_SkipEmpty && IndexRule.m_SkipFull)
+				{
+					IndexRule.m_SkipEmpty = false;
+					IndexRule.m_SkipFull = false;
+				}
+			}
+		}
+	}
+
+	Compile();
+}
+
+void CAutoMapRules::Compile()
+{
+	m_vPredicates.clear();
+	std::map<std::array<uint16_t, 256>, int> PredicateIDs;
+	for(auto &Config : m_vConfigs)
+	{
+		for(auto &Run : Config.m_vRuns)
+		{
+			std::vector<std::vector<int>> vvRulesByIndex(256);
+			for(int i = 0; i < (int)Run.m_vIndexRules.size(); i++)
+			{
+				CIndexRule &IndexRule = Run.m_vIndexRules[i];
+				IndexRule.m_vCompiledRules.clear();
+				IndexRule.m_FullMask = 0;
+				IndexRule.m_EmptyMask = 0;
+
+				// which indices and flags the tile itself can have
+				std::array<uint16_t, 256> aCenter;
+				aCenter.fill(0xffff);
+				for(const auto &Rule : IndexRule.m_vRules)
+				{
+					std::array<uint16_t, 256> aPredicate = {};
+					bool MatchOutside = false;
+					for(const auto &Index : Rule.m_vIndexList)
+					{
+						// tiles outside of the layer have the index -1 and no flags
+						if(Index.m_ID == -1 && (!Index.m_TestFlag || Index.m_Flag == 0))
+							MatchOutside = true;
+						if(Index.m_ID < 0 || Index.m_ID > 255 || (Index.m_TestFlag && (Index.m_Flag < 0 || Index.m_Flag > 15)))
+							continue;
+						aPredicate[Index.m_ID] |= Index.m_TestFlag ? 1 << Index.m_Flag : 0xffff;
+					}
+					if(Rule.m_Value == CPosRule::NOTINDEX)
+					{
+						for(auto &Flags : aPredicate)
+							Flags = ~Flags;
+						MatchOutside = !MatchOutside;
+					}
+
+					if(Rule.m_X == 0 && Rule.m_Y == 0)
+					{
+						for(int Index = 0; Index < 256; Index++)
+							aCenter[Index] &= aPredicate[Index];
+					}
+
+					// `EMPTY` and `FULL` next to the tile are decided by its
+					// neighborhood
+					if(absolute(Rule.m_X) <= 1 && absolute(Rule.m_Y) <= 1)
+					{
+						const bool AnyFull = std::any_of(aPredicate.begin() + 1, aPredicate.end(), [](uint16_t Flags) { return Flags != 0; });
+						const bool AllFull = std::all_of(aPredicate.begin() + 1, aPredicate.end(), [](uint16_t Flags) { return Flags == 0xffff; });
+						if(aPredicate[0] == 0xffff && !AnyFull && !MatchOutside)
+						{
+							IndexRule.m_EmptyMask |= NeighborhoodBit(Rule.m_X, Rule.m_Y);
+							continue;
+						}
+						if(aPredicate[0] == 0 && AllFull && MatchOutside)
+						{
+							IndexRule.m_FullMask |= NeighborhoodBit(Rule.m_X, Rule.m_Y);
+							continue;
+						}
+					}
+
+					auto Inserted = PredicateIDs.emplace(aPredicate, m_vPredicates.size());
+					if(Inserted.second)
+						m_vPredicates.push_back(aPredicate);
+					IndexRule.m_vCompiledRules.push_back({Rule.m_X, Rule.m_Y, Inserted.first->second, MatchOutside});
+				}
+
+				for(int Index = 0; Index < 256; Index++)
+				{
+					if(aCenter[Index])
+						vvRulesByIndex[Index].push_back(i);
+				}
+			}
+
+			std::map<std::vector<int>, int> Classes;
+			for(int Index = 0; Index < 256; Index++)
+				Run.m_aIndexClass[Index] = Classes.emplace(vvRulesByIndex[Index], Classes.size()).first->second;
+
+			std::vector<const std::vector<int> *> vpClassRules(Classes.size());
+			for(const auto &[vRules, Class] : Classes)
+				vpClassRules[Class] = &vRules;
+
+			Run.m_vRulesByKeyStart.clear();
+			Run.m_vRulesByKey.clear();
+			for(const std::vector<int> *pRules : vpClassRules)
+			{
+				for(int Neighborhood = 0; Neighborhood < NUM_NEIGHBORHOODS; Neighborhood++)
+				{
+					Run.m_vRulesByKeyStart.push_back(Run.m_vRulesByKey.size());
+					for(int i : *pRules)
+					{
+						const CIndexRule &IndexRule = Run.m_vIndexRules[i];
+						if((Neighborhood & IndexRule.m_FullMask) == IndexRule.m_FullMask && (Neighborhood & IndexRule.m_EmptyMask) == 0)
+							Run.m_vRulesByKey.push_back(i);
+					}
+				}
+			}
+			Run.m_vRulesByKeyStart.push_back(Run.m_vRulesByKey.size());
+		}
+	}
+}
+
+bool CAutoMapRules::RespectsRules(const CIndexRule &IndexRule, const CTile *pReadTiles, int Width, int Height, int x, int y) const
+{
+	for(const auto &Rule : IndexRule.m_vCompiledRules)
+	{
+		const int CheckX = x + Rule.m_X;
+		const int CheckY = y + Rule.m_Y;
+		bool Match;
+		if(CheckX >= 0 && CheckX < Width && CheckY >= 0 && CheckY < Height)
+		{
+			const CTile &Check = pReadTiles[CheckY * Width + CheckX];
+			const int CheckFlags = Check.m_Flags & (TILEFLAG_ROTATE | TILEFLAG_XFLIP | TILEFLAG_YFLIP);
+			Match = (m_vPredicates[Rule.m_Predicate][Check.m_Index] >> CheckFlags) & 1;
+		}
+		else
+		{
+			Match = Rule.m_MatchOutside;
+		}
+		if(!Match)
+			return false;
+	}
+	return true;
+}
+
+void CAutoMapRules::ProceedRows(const CRun &Run, int RunID, CTile *pTiles, const CTile *pReadTiles, int Width, int Height, int FromY, int ToY, int Seed, int SeedOffsetX, int SeedOffsetY, unsigned char *pChanged) const
+{
+	std::vector<uint32_t> vRuleHashes(Run.m_vIndexRules.size());
+	for(int i = 0; i < (int)Run.m_vIndexRules.size(); i++)
+		vRuleHashes[i] = HashRule(Seed, RunID, i);
+	std::vector<uint32_t> vColumnHashes(Width);
+	for(int x = 0; x < Width; x++)
+		vColumnHashes[x] = HashUInt32(x + SeedOffsetX);
+
+	const int RightColumn = NeighborhoodBit(1, -1) | NeighborhoodBit(1, 0) | NeighborhoodBit(1, 1);
+	for(int y = FromY; y < ToY; y++)
+	{
+		const uint32_t RowHash = HashUInt32(y + SeedOffsetY);
+		const CTile *pAbove = y > 0 ? &pReadTiles[(y - 1) * Width] : nullptr;
+		const CTile *pRow = &pReadTiles[y * Width];
+		const CTile *pBelow = y + 1 < Height ? &pReadTiles[(y + 1) * Width] : nullptr;
+		// the right column of the neighborhood of a tile, the rest is
+		// shifted over from the tile before
+		auto &&FullColumn = [&](int CheckX) {
+			if(CheckX < 0 || CheckX >= Width)
+				return RightColumn;
+			return ((!pAbove || pAbove[CheckX].m_Index) ? NeighborhoodBit(1, -1) : 0) |
+			       (pRow[CheckX].m_Index ? NeighborhoodBit(1, 0) : 0) |
+			       ((!pBelow || pBelow[CheckX].m_Index) ? NeighborhoodBit(1, 1) : 0);
+		};
+		int Neighborhood = FullColumn(-1) >> 1 | FullColumn(0);
+
+		for(int x = 0; x < Width; x++)
+		{
+			CTile *pTile = &pTiles[y * Width + x];
+			const CTile *pReadTile = &pReadTiles[y * Width + x];
+			Neighborhood = ((Neighborhood >> 1) & ~RightColumn) | FullColumn(x + 1);
+
+			// only the rules that can match the tile and the tiles around it
+			// are checked
+			int Key = Run.m_aIndexClass[pReadTile->m_Index] * NUM_NEIGHBORHOODS + Neighborhood;
+			int Next = Run.m_vRulesByKeyStart[Key];
+			while(Next < Run.m_vRulesByKeyStart[Key + 1])
+			{
+				const int i = Run.m_vRulesByKey[Next++];
+				const CIndexRule &IndexRule = Run.m_vIndexRules[i];
+				if(IndexRule.m_SkipEmpty && pTile->m_Index == 0) // skip empty tiles
+					continue;
+				if(IndexRule.m_SkipFull && pTile->m_Index != 0) // skip full tiles
+					continue;
+				if(!RespectsRules(IndexRule, pReadTiles, Width, Height, x, y))
+					continue;
+				if(IndexRule.m_RandomProbability < 1.0f && HashLocation(vRuleHashes[i], vColumnHashes[x], RowHash) >= HASH_MAX * IndexRule.m_RandomProbability)
+					continue;
+
+				pTile->m_Index = IndexRule.m_ID;
+				pTile->m_Flags = IndexRule.m_Flag;
+				if(pChanged)
+					pChanged[y * Width + x] = 1;
+
+				// without a copy, the following rules and tiles see the new tile
+				if(pReadTile == pTile)
+				{
+					Neighborhood = (Neighborhood & ~NeighborhoodBit(0, 0)) | (pTile->m_Index ? NeighborhoodBit(0, 0) : 0);
+					const int NewKey = Run.m_aIndexClass[pTile->m_Index] * NUM_NEIGHBORHOODS + Neighborhood;
+					if(NewKey != Key)
+					{
+						Key = NewKey;
+						const int *pBegin = Run.m_vRulesByKey.data() + Run.m_vRulesByKeyStart[Key];
+						const int *pEnd = Run.m_vRulesByKey.data() + Run.m_vRulesByKeyStart[Key + 1];
+						Next = std::upper_bound(pBegin, pEnd, i) - Run.m_vRulesByKey.data();
+					}
+				}
+			}
+		}
+	}
+}
+
+void CAutoMapRules::Proceed(CTile *pTiles, int Width, int Height, int ConfigID, int Seed, int SeedOffsetX, int SeedOffsetY, std::vector<unsigned char> *pvChanged, int NumThreads) const
+{
+	if(ConfigID < 0 || ConfigID >= (int)m_vConfigs.size())
+		return;
+
+	const CConfiguration &Config = m_vConfigs[ConfigID];
+	if(pvChanged)
+		pvChanged->assign((size_t)Width * Height, 0);
+	unsigned char *pChanged = pvChanged ? pvChanged->data() : nullptr;
+
+	const int NumBands = (Height + PARALLEL_BAND_ROWS - 1) / PARALLEL_BAND_ROWS;
+	if(NumThreads <= 0)
+		NumThreads = std::thread::hardware_concurrency();
+	NumThreads = Width * Height < PARALLEL_MIN_TILES ? 1 : clamp(NumThreads, 1, NumBands);
+
+	// for every run: copy tiles, automap, overwrite tiles
+	std::vector<CTile> vReadTiles;
+	for(int h = 0; h < (int)Config.m_vRuns.size(); ++h)
+	{
+		const CRun &Run = Config.m_vRuns[h];
+
+		// don't make copy if it's requested, every tile then sees the tiles
+		// automapped before it
+		if(!Run.m_AutomapCopy)
+		{
+			ProceedRows(Run, h, pTiles, pTiles, Width, Height, 0, Height, Seed, SeedOffsetX, SeedOffsetY, pChanged);
+			continue;
+		}
+
+		vReadTiles.assign(pTiles, pTiles + (size_t)Width * Height);
+		if(NumThreads == 1)
+		{
+			ProceedRows(Run, h, pTiles, vReadTiles.data(), Width, Height, 0, Height, Seed, SeedOffsetX, SeedOffsetY, pChanged);
+			continue;
+		}
+
+		// the tiles only depend on the copy, so the bands can be done in any
+		// order without changing the result
+		std::atomic<int> NextBand(0);
+		auto &&ProceedNext = [&]() {
+			for(int Band = NextBand++; Band < NumBands; Band = NextBand++)
+				ProceedRows(Run, h, pTiles, vReadTiles.data(), Width, Height, Band * PARALLEL_BAND_ROWS, minimum(Height, (Band + 1) * PARALLEL_BAND_ROWS), Seed, SeedOffsetX, SeedOffsetY, pChanged);
+		};
+		std::vector<std::thread> vThreads;
+		for(int i = 1; i < NumThreads; i++)
+			vThreads.emplace_back(ProceedNext);
+		ProceedNext();
+		for(std::thread &Thread : vThreads)
+			Thread.join();
+	}
+}
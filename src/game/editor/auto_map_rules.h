@@ -0,0 +1,129 @@
+#ifndef GAME_EDITOR_AUTO_MAP_RULES_H
+#define GAME_EDITOR_AUTO_MAP_RULES_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class CLineReader;
+class CTile;
+
+// The configurations of an automapper rules file and how they are applied to
+// the tiles of a layer, independent of the editor.
+class CAutoMapRules
+{
+public:
+	struct CIndexInfo
+	{
+		int m_ID;
+		int m_Flag;
+		bool m_TestFlag;
+	};
+
+	struct CPosRule
+	{
+		int m_X;
+		int m_Y;
+		int m_Value;
+		std::vector<CIndexInfo> m_vIndexList;
+
+		enum
+		{
+			NORULE = 0,
+			INDEX,
+			NOTINDEX
+		};
+	};
+
+	// A `CPosRule` with its index list turned into a lookup table, see
+	// `CAutoMapRules::m_vPredicates`.
+	struct CCompiledPosRule
+	{
+		int m_X;
+		int m_Y;
+		int m_Predicate;
+		bool m_MatchOutside;
+	};
+
+	struct CIndexRule
+	{
+		int m_ID;
+		std::vector<CPosRule> m_vRules;
+		int m_Flag;
+		float m_RandomProbability;
+		bool m_DefaultRule;
+		bool m_SkipEmpty;
+		bool m_SkipFull;
+
+		// the position rules that aren't covered by `m_FullMask` and
+		// `m_EmptyMask`
+		std::vector<CCompiledPosRule> m_vCompiledRules;
+		// the tiles around this one that must be full or empty, as
+		// neighborhood bits, see `NUM_NEIGHBORHOODS`
+		int m_FullMask;
+		int m_EmptyMask;
+	};
+
+	struct CRun
+	{
+		std::vector<CIndexRule> m_vIndexRules;
+		bool m_AutomapCopy;
+
+		// The index rules that can match a tile, in order, by the key
+		// `m_aIndexClass[Index] * NUM_NEIGHBORHOODS + Neighborhood`: from
+		// `m_vRulesByKey[m_vRulesByKeyStart[Key]]` up to
+		// `m_vRulesByKeyStart[Key + 1]`. Indices that the same rules can
+		// match share a class.
+		std::array<int, 256> m_aIndexClass;
+		std::vector<int> m_vRulesByKeyStart;
+		std::vector<int> m_vRulesByKey;
+	};
+
+	struct CConfiguration
+	{
+		std::vector<CRun> m_vRuns;
+		char m_aName[128];
+		int m_StartX;
+		int m_StartY;
+		int m_EndX;
+		int m_EndY;
+	};
+
+	// A neighborhood says which of the 3x3 tiles around a tile are full, i.e.
+	// outside of the layer or not empty, with one `NeighborhoodBit` each.
+	static constexpr int NUM_NEIGHBORHOODS = 1 << 9;
+
+	// Layers with fewer tiles are automapped on one thread.
+	static constexpr int PARALLEL_MIN_TILES = 128 * 128;
+	// number of rows a thread automaps at once
+	static constexpr int PARALLEL_BAND_ROWS = 16;
+
+	// Reads the configurations of a rules file.
+	void Load(CLineReader &LineReader);
+
+	// Applies the configuration `ConfigID` to the `Width` x `Height` tiles at
+	// `pTiles`, with `SeedOffsetX`, `SeedOffsetY` the position of the tiles in
+	// the layer for random rules. The runs that read from a copy of the tiles
+	// are spread over `NumThreads` threads, or one per core if it's 0, the
+	// result doesn't depend on it. If `pvChanged` is set, it is filled with
+	// one entry per tile that is set if a rule was applied to it.
+	void Proceed(CTile *pTiles, int Width, int Height, int ConfigID, int Seed, int SeedOffsetX = 0, int SeedOffsetY = 0, std::vector<unsigned char> *pvChanged = nullptr, int NumThreads = 0) const;
+
+	const std::vector<CConfiguration> &Configs() const { return m_vConfigs; }
+
+private:
+	void Compile();
+	static int NeighborhoodBit(int x, int y) { return 1 << ((y + 1) * 3 + x + 1); }
+	void ProceedRows(const CRun &Run, int RunID, CTile *pTiles, const CTile *pReadTiles, int Width, int Height, int FromY, int ToY, int Seed, int SeedOffsetX, int SeedOffsetY, unsigned char *pChanged) const;
+	bool RespectsRules(const CIndexRule &IndexRule, const CTile *pReadTiles, int Width, int Height, int x, int y) const;
+
+	std::vector<CConfiguration> m_vConfigs = {};
+
+	// For every index, which of the flags `TILEFLAG_XFLIP | TILEFLAG_YFLIP |
+	// TILEFLAG_ROTATE` a tile with that index can have to match a position
+	// rule, one bit per combination. Position rules with the same index list
+	// share a table.
+	std::vector<std::array<uint16_t, 256>> m_vPredicates;
+};
+
+#endif
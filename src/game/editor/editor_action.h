@@ -1,6 +1,7 @@
 #ifndef GAME_EDITOR_EDITOR_ACTION_H
 #define GAME_EDITOR_EDITOR_ACTION_H
 
+#include <cstddef>
 #include <string>
 
 class CEditor;
@@ -20,6 +21,12 @@ public:
 
 	virtual bool IsEmpty() { return false; }
 
+	// Memory held by the action, to limit the size of the history.
+	virtual size_t MemoryUsage() const { return 0; }
+	// Called once the action is unlikely to be undone soon, it may then
+	// trade a slower undo for less memory.
+	virtual void Compress() {}
+
 	const char *DisplayText() const { return m_aDisplayText; }
 
 protected:
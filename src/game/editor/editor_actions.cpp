@@ -17,7 +17,8 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditor *pEditor, int Group) :
 			{
 				if(!Map.m_pTeleLayer->m_History.empty())
 				{
-					m_TeleTileChanges = std::map(Map.m_pTeleLayer->m_History);
+					m_TeleTileChanges = std::move(Map.m_pTeleLayer->m_History);
+					m_TeleTileChanges.Finish();
 					Map.m_pTeleLayer->ClearHistory();
 				}
 			}
@@ -25,7 +26,8 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditor *pEditor, int Group) :
 			{
 				if(!Map.m_pTuneLayer->m_History.empty())
 				{
-					m_TuneTileChanges = std::map(Map.m_pTuneLayer->m_History);
+					m_TuneTileChanges = std::move(Map.m_pTuneLayer->m_History);
+					m_TuneTileChanges.Finish();
 					Map.m_pTuneLayer->ClearHistory();
 				}
 			}
@@ -33,7 +35,8 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditor *pEditor, int Group) :
 			{
 				if(!Map.m_pSwitchLayer->m_History.empty())
 				{
-					m_SwitchTileChanges = std::map(Map.m_pSwitchLayer->m_History);
+					m_SwitchTileChanges = std::move(Map.m_pSwitchLayer->m_History);
+					m_SwitchTileChanges.Finish();
 					Map.m_pSwitchLayer->ClearHistory();
 				}
 			}
@@ -41,14 +44,16 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditor *pEditor, int Group) :
 			{
 				if(!Map.m_pSpeedupLayer->m_History.empty())
 				{
-					m_SpeedupTileChanges = std::map(Map.m_pSpeedupLayer->m_History);
+					m_SpeedupTileChanges = std::move(Map.m_pSpeedupLayer->m_History);
+					m_SpeedupTileChanges.Finish();
 					Map.m_pSpeedupLayer->ClearHistory();
 				}
 			}
 
 			if(!pLayerTiles->m_TilesHistory.empty())
 			{
-				m_vTileChanges.emplace_back(k, std::map(pLayerTiles->m_TilesHistory));
+				m_vTileChanges.emplace_back(k, std::move(pLayerTiles->m_TilesHistory));
+				m_vTileChanges.back().second.Finish();
 				pLayerTiles->ClearHistory();
 			}
 		}
@@ -71,39 +76,13 @@ void CEditorBrushDrawAction::SetInfos()
 		m_TotalLayers++;
 
 		if(pLayer->m_Type == LAYERTYPE_TILES)
-		{
-			std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(pLayer);
-			auto Changes = Pair.second;
-			for(auto &Change : Changes)
-			{
-				m_TotalTilesDrawn += Change.second.size();
-			}
-		}
+			m_TotalTilesDrawn += Pair.second.Size();
 	}
 
-	// Process speedup tiles
-	for(auto const &SpeedupChange : m_SpeedupTileChanges)
-	{
-		m_TotalTilesDrawn += SpeedupChange.second.size();
-	}
-
-	// Process tele tiles
-	for(auto const &TeleChange : m_TeleTileChanges)
-	{
-		m_TotalTilesDrawn += TeleChange.second.size();
-	}
-
-	// Process switch tiles
-	for(auto const &SwitchChange : m_SwitchTileChanges)
-	{
-		m_TotalTilesDrawn += SwitchChange.second.size();
-	}
-
-	// Process tune tiles
-	for(auto const &TuneChange : m_TuneTileChanges)
-	{
-		m_TotalTilesDrawn += TuneChange.second.size();
-	}
+	m_TotalTilesDrawn += m_SpeedupTileChanges.Size();
+	m_TotalTilesDrawn += m_TeleTileChanges.Size();
+	m_TotalTilesDrawn += m_SwitchTileChanges.Size();
+	m_TotalTilesDrawn += m_TuneTileChanges.Size();
 
 	m_TotalLayers += !m_SpeedupTileChanges.empty();
 	m_TotalLayers += !m_SwitchTileChanges.empty();
@@ -126,6 +105,24 @@ void CEditorBrushDrawAction::Redo()
 	Apply(false);
 }
 
+size_t CEditorBrushDrawAction::MemoryUsage() const
+{
+	size_t Size = m_SpeedupTileChanges.MemoryUsage() + m_TeleTileChanges.MemoryUsage() + m_SwitchTileChanges.MemoryUsage() + m_TuneTileChanges.MemoryUsage();
+	for(auto const &Pair : m_vTileChanges)
+		Size += Pair.second.MemoryUsage();
+	return Size;
+}
+
+void CEditorBrushDrawAction::Compress()
+{
+	for(auto &Pair : m_vTileChanges)
+		Pair.second.Compress();
+	m_SpeedupTileChanges.Compress();
+	m_TeleTileChanges.Compress();
+	m_SwitchTileChanges.Compress();
+	m_TuneTileChanges.Compress();
+}
+
 void CEditorBrushDrawAction::Apply(bool Undo)
 {
 	auto &Map = m_pEditor->m_Map;
@@ -139,96 +136,65 @@ void CEditorBrushDrawAction::Apply(bool Undo)
 		if(pLayer->m_Type == LAYERTYPE_TILES)
 		{
 			std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(pLayer);
-			auto Changes = Pair.second;
-			for(auto &Change : Changes)
-			{
-				int y = Change.first;
-				auto Line = Change.second;
-				for(auto &Tile : Line)
-				{
-					int x = Tile.first;
-					STileStateChange State = Tile.second;
-					pLayerTiles->SetTileIgnoreHistory(x, y, Undo ? State.m_Previous : State.m_Current);
-				}
-			}
+			Pair.second.ForEachSpan([&](const auto &Span, const STileStateChange *pChanges) {
+				CTile *pTiles = &pLayerTiles->m_pTiles[Span.m_Y * pLayerTiles->m_Width + Span.m_X];
+				for(int i = 0; i < Span.m_Num; i++)
+					pTiles[i] = Undo ? pChanges[i].m_Previous : pChanges[i].m_Current;
+			});
 		}
 	}
 
 	// Process speedup tiles
-	for(auto const &SpeedupChange : m_SpeedupTileChanges)
-	{
-		int y = SpeedupChange.first;
-		auto Line = SpeedupChange.second;
-		for(auto &Tile : Line)
+	m_SpeedupTileChanges.ForEachSpan([&](const auto &Span, const SSpeedupTileStateChange *pChanges) {
+		const int Index = Span.m_Y * Map.m_pSpeedupLayer->m_Width + Span.m_X;
+		for(int i = 0; i < Span.m_Num; i++)
 		{
-			int x = Tile.first;
-			int Index = y * Map.m_pSpeedupLayer->m_Width + x;
-			SSpeedupTileStateChange State = Tile.second;
-			SSpeedupTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map.m_pSpeedupLayer->m_pSpeedupTile[Index].m_Force = Data.m_Force;
-			Map.m_pSpeedupLayer->m_pSpeedupTile[Index].m_MaxSpeed = Data.m_MaxSpeed;
-			Map.m_pSpeedupLayer->m_pSpeedupTile[Index].m_Angle = Data.m_Angle;
-			Map.m_pSpeedupLayer->m_pSpeedupTile[Index].m_Type = Data.m_Type;
-			Map.m_pSpeedupLayer->m_pTiles[Index].m_Index = Data.m_Index;
+			const SSpeedupTileStateChange::SData &Data = Undo ? pChanges[i].m_Previous : pChanges[i].m_Current;
+			Map.m_pSpeedupLayer->m_pSpeedupTile[Index + i].m_Force = Data.m_Force;
+			Map.m_pSpeedupLayer->m_pSpeedupTile[Index + i].m_MaxSpeed = Data.m_MaxSpeed;
+			Map.m_pSpeedupLayer->m_pSpeedupTile[Index + i].m_Angle = Data.m_Angle;
+			Map.m_pSpeedupLayer->m_pSpeedupTile[Index + i].m_Type = Data.m_Type;
+			Map.m_pSpeedupLayer->m_pTiles[Index + i].m_Index = Data.m_Index;
 		}
-	}
+	});
 
 	// Process tele tiles
-	for(auto const &TeleChange : m_TeleTileChanges)
-	{
-		int y = TeleChange.first;
-		auto Line = TeleChange.second;
-		for(auto &Tile : Line)
+	m_TeleTileChanges.ForEachSpan([&](const auto &Span, const STeleTileStateChange *pChanges) {
+		const int Index = Span.m_Y * Map.m_pTeleLayer->m_Width + Span.m_X;
+		for(int i = 0; i < Span.m_Num; i++)
 		{
-			int x = Tile.first;
-			int Index = y * Map.m_pTeleLayer->m_Width + x;
-			STeleTileStateChange State = Tile.second;
-			STeleTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map.m_pTeleLayer->m_pTeleTile[Index].m_Number = Data.m_Number;
-			Map.m_pTeleLayer->m_pTeleTile[Index].m_Type = Data.m_Type;
-			Map.m_pTeleLayer->m_pTiles[Index].m_Index = Data.m_Index;
+			const STeleTileStateChange::SData &Data = Undo ? pChanges[i].m_Previous : pChanges[i].m_Current;
+			Map.m_pTeleLayer->m_pTeleTile[Index + i].m_Number = Data.m_Number;
+			Map.m_pTeleLayer->m_pTeleTile[Index + i].m_Type = Data.m_Type;
+			Map.m_pTeleLayer->m_pTiles[Index + i].m_Index = Data.m_Index;
 		}
-	}
+	});
 
 	// Process switch tiles
-	for(auto const &SwitchChange : m_SwitchTileChanges)
-	{
-		int y = SwitchChange.first;
-		auto Line = SwitchChange.second;
-		for(auto &Tile : Line)
+	m_SwitchTileChanges.ForEachSpan([&](const auto &Span, const SSwitchTileStateChange *pChanges) {
+		const int Index = Span.m_Y * Map.m_pSwitchLayer->m_Width + Span.m_X;
+		for(int i = 0; i < Span.m_Num; i++)
 		{
-			int x = Tile.first;
-			int Index = y * Map.m_pSwitchLayer->m_Width + x;
-			SSwitchTileStateChange State = Tile.second;
-			SSwitchTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map.m_pSwitchLayer->m_pSwitchTile[Index].m_Number = Data.m_Number;
-			Map.m_pSwitchLayer->m_pSwitchTile[Index].m_Type = Data.m_Type;
-			Map.m_pSwitchLayer->m_pSwitchTile[Index].m_Flags = Data.m_Flags;
-			Map.m_pSwitchLayer->m_pSwitchTile[Index].m_Delay = Data.m_Delay;
-			Map.m_pSwitchLayer->m_pTiles[Index].m_Index = Data.m_Index;
+			const SSwitchTileStateChange::SData &Data = Undo ? pChanges[i].m_Previous : pChanges[i].m_Current;
+			Map.m_pSwitchLayer->m_pSwitchTile[Index + i].m_Number = Data.m_Number;
+			Map.m_pSwitchLayer->m_pSwitchTile[Index + i].m_Type = Data.m_Type;
+			Map.m_pSwitchLayer->m_pSwitchTile[Index + i].m_Flags = Data.m_Flags;
+			Map.m_pSwitchLayer->m_pSwitchTile[Index + i].m_Delay = Data.m_Delay;
+			Map.m_pSwitchLayer->m_pTiles[Index + i].m_Index = Data.m_Index;
 		}
-	}
+	});
 
 	// Process tune tiles
-	for(auto const &TuneChange : m_TuneTileChanges)
-	{
-		int y = TuneChange.first;
-		auto Line = TuneChange.second;
-		for(auto &Tile : Line)
+	m_TuneTileChanges.ForEachSpan([&](const auto &Span, const STuneTileStateChange *pChanges) {
+		const int Index = Span.m_Y * Map.m_pTuneLayer->m_Width + Span.m_X;
+		for(int i = 0; i < Span.m_Num; i++)
 		{
-			int x = Tile.first;
-			int Index = y * Map.m_pTuneLayer->m_Width + x;
-			STuneTileStateChange State = Tile.second;
-			STuneTileStateChange::SData Data = Undo ? State.m_Previous : State.m_Current;
-
-			Map.m_pTuneLayer->m_pTuneTile[Index].m_Number = Data.m_Number;
-			Map.m_pTuneLayer->m_pTuneTile[Index].m_Type = Data.m_Type;
-			Map.m_pTuneLayer->m_pTiles[Index].m_Index = Data.m_Index;
+			const STuneTileStateChange::SData &Data = Undo ? pChanges[i].m_Previous : pChanges[i].m_Current;
+			Map.m_pTuneLayer->m_pTuneTile[Index + i].m_Number = Data.m_Number;
+			Map.m_pTuneLayer->m_pTuneTile[Index + i].m_Type = Data.m_Type;
+			Map.m_pTuneLayer->m_pTiles[Index + i].m_Index = Data.m_Index;
 		}
-	}
+	});
 }
 
 // -------------------------------------------
@@ -429,56 +395,10 @@ void CEditorActionEditQuadPointProp::Apply(int Value)
 
 // ---------------------------------------------------------------------------------------
 
-CEditorActionBulk::CEditorActionBulk(CEditor *pEditor, const std::vector<std::shared_ptr<IEditorAction>> &vpActions, const char *pDisplay, bool Reverse) :
-	IEditorAction(pEditor), m_vpActions(vpActions), m_Reverse(Reverse)
-{
-	// Assuming we only use bulk for actions of same type, if no display was provided
-	if(!pDisplay)
-	{
-		const char *pBaseDisplay = m_vpActions[0]->DisplayText();
-		if(m_vpActions.size() == 1)
-			str_copy(m_aDisplayText, pBaseDisplay);
-		else
-			str_format(m_aDisplayText, sizeof(m_aDisplayText), "%s (x%d)", pBaseDisplay, (int)m_vpActions.size());
-	}
-	else
-	{
-		str_copy(m_aDisplayText, pDisplay);
-	}
-}
-
-void CEditorActionBulk::Undo()
-{
-	if(m_Reverse)
-	{
-		for(auto pIt = m_vpActions.rbegin(); pIt != m_vpActions.rend(); pIt++)
-		{
-			auto &pAction = *pIt;
-			pAction->Undo();
-		}
-	}
-	else
-	{
-		for(auto &pAction : m_vpActions)
-		{
-			pAction->Undo();
-		}
-	}
-}
-
-void CEditorActionBulk::Redo()
-{
-	for(auto &pAction : m_vpActions)
-	{
-		pAction->Redo();
-	}
-}
-
-// ---------
-
-CEditorActionTileChanges::CEditorActionTileChanges(CEditor *pEditor, int GroupIndex, int LayerIndex, const char *pAction, const EditorTileStateChangeHistory<STileStateChange> &Changes) :
-	CEditorActionLayerBase(pEditor, GroupIndex, LayerIndex), m_Changes(Changes)
+CEditorActionTileChanges::CEditorActionTileChanges(CEditor *pEditor, int GroupIndex, int LayerIndex, const char *pAction, EditorTileStateChangeHistory<STileStateChange> &&Changes) :
+	CEditorActionLayerBase(pEditor, GroupIndex, LayerIndex), m_Changes(std::move(Changes))
 {
+	m_Changes.Finish();
 	ComputeInfos();
 	str_format(m_aDisplayText, sizeof(m_aDisplayText), "%s (x%d)", pAction, m_TotalChanges);
 }
@@ -497,26 +417,18 @@ void CEditorActionTileChanges::Apply(bool Undo)
 {
 	auto &Map = m_pEditor->m_Map;
 	std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(m_pLayer);
-	for(auto &Change : m_Changes)
-	{
-		int y = Change.first;
-		auto Line = Change.second;
-		for(auto &Tile : Line)
-		{
-			int x = Tile.first;
-			STileStateChange State = Tile.second;
-			pLayerTiles->SetTileIgnoreHistory(x, y, Undo ? State.m_Previous : State.m_Current);
-		}
-	}
+	m_Changes.ForEachSpan([&](const auto &Span, const STileStateChange *pChanges) {
+		CTile *pTiles = &pLayerTiles->m_pTiles[Span.m_Y * pLayerTiles->m_Width + Span.m_X];
+		for(int i = 0; i < Span.m_Num; i++)
+			pTiles[i] = Undo ? pChanges[i].m_Previous : pChanges[i].m_Current;
+	});
 
 	Map.OnModify();
 }
 
 void CEditorActionTileChanges::ComputeInfos()
 {
-	m_TotalChanges = 0;
-	for(auto &Line : m_Changes)
-		m_TotalChanges += Line.second.size();
+	m_TotalChanges = m_Changes.Size();
 }
 
 // ---------
@@ -26,12 +26,14 @@ public:
 	void Undo() override;
 	void Redo() override;
 	bool IsEmpty() override;
+	size_t MemoryUsage() const override;
+	void Compress() override;
 
 private:
 	int m_Group;
 	// m_vTileChanges is a list of changes for each layer that was modified.
-	// The std::pair is used to pair one layer (index) with its history (2D map).
-	// EditorTileStateChangeHistory<T> is a 2D map, storing a change item at a specific y,x position.
+	// The std::pair is used to pair one layer (index) with its history.
+	// EditorTileStateChangeHistory<T> stores the changed tiles as spans of rows.
 	std::vector<std::pair<int, EditorTileStateChangeHistory<STileStateChange>>> m_vTileChanges;
 	EditorTileStateChangeHistory<STeleTileStateChange> m_TeleTileChanges;
 	EditorTileStateChangeHistory<SSpeedupTileStateChange> m_SpeedupTileChanges;
@@ -139,29 +141,15 @@ private:
 
 // -------------------------------------------------------------
 
-class CEditorActionBulk : public IEditorAction
-{
-public:
-	CEditorActionBulk(CEditor *pEditor, const std::vector<std::shared_ptr<IEditorAction>> &vpActions, const char *pDisplay = nullptr, bool Reverse = false);
-
-	void Undo() override;
-	void Redo() override;
-
-private:
-	std::vector<std::shared_ptr<IEditorAction>> m_vpActions;
-	std::string m_Display;
-	bool m_Reverse;
-};
-
-//
-
 class CEditorActionTileChanges : public CEditorActionLayerBase
 {
 public:
-	CEditorActionTileChanges(CEditor *pEditor, int GroupIndex, int LayerIndex, const char *pAction, const EditorTileStateChangeHistory<STileStateChange> &Changes);
+	CEditorActionTileChanges(CEditor *pEditor, int GroupIndex, int LayerIndex, const char *pAction, EditorTileStateChangeHistory<STileStateChange> &&Changes);
 
 	void Undo() override;
 	void Redo() override;
+	size_t MemoryUsage() const override { return m_Changes.MemoryUsage(); }
+	void Compress() override { m_Changes.Compress(); }
 
 private:
 	EditorTileStateChangeHistory<STileStateChange> m_Changes;
@@ -1,9 +1,68 @@
+#include <base/system.h>
+
 #include <engine/shared/config.h>
 
-#include "editor.h"
-#include "editor_actions.h"
 #include "editor_history.h"
 
+CEditorActionBulk::CEditorActionBulk(CEditor *pEditor, const std::vector<std::shared_ptr<IEditorAction>> &vpActions, const char *pDisplay, bool Reverse) :
+	IEditorAction(pEditor), m_vpActions(vpActions), m_Reverse(Reverse)
+{
+	// Assuming we only use bulk for actions of same type, if no display was provided
+	if(!pDisplay)
+	{
+		const char *pBaseDisplay = m_vpActions[0]->DisplayText();
+		if(m_vpActions.size() == 1)
+			str_copy(m_aDisplayText, pBaseDisplay);
+		else
+			str_format(m_aDisplayText, sizeof(m_aDisplayText), "%s (x%d)", pBaseDisplay, (int)m_vpActions.size());
+	}
+	else
+	{
+		str_copy(m_aDisplayText, pDisplay);
+	}
+}
+
+void CEditorActionBulk::Undo()
+{
+	if(m_Reverse)
+	{
+		for(auto pIt = m_vpActions.rbegin(); pIt != m_vpActions.rend(); pIt++)
+		{
+			auto &pAction = *pIt;
+			pAction->Undo();
+		}
+	}
+	else
+	{
+		for(auto &pAction : m_vpActions)
+		{
+			pAction->Undo();
+		}
+	}
+}
+
+void CEditorActionBulk::Redo()
+{
+	for(auto &pAction : m_vpActions)
+	{
+		pAction->Redo();
+	}
+}
+
+size_t CEditorActionBulk::MemoryUsage() const
+{
+	size_t Size = 0;
+	for(const auto &pAction : m_vpActions)
+		Size += pAction->MemoryUsage();
+	return Size;
+}
+
+void CEditorActionBulk::Compress()
+{
+	for(auto &pAction : m_vpActions)
+		pAction->Compress();
+}
+
 void CEditorHistory::RecordAction(const std::shared_ptr<IEditorAction> &pAction)
 {
 	RecordAction(pAction, nullptr);
@@ -25,15 +84,31 @@ void CEditorHistory::RecordAction(const std::shared_ptr<IEditorAction> &pAction,
 
 	m_vpRedoActions.clear();
 
-	if((int)m_vpUndoActions.size() >= g_Config.m_ClEditorMaxHistory)
+	std::shared_ptr<IEditorAction> pUndoAction = pAction;
+	if(pDisplay != nullptr)
+		pUndoAction = std::make_shared<CEditorActionBulk>(m_pEditor, std::vector<std::shared_ptr<IEditorAction>>{pAction}, pDisplay);
+	PushUndoAction(m_vpUndoActions, pUndoAction, g_Config.m_ClEditorMaxHistory, (size_t)g_Config.m_ClEditorMaxHistoryMemory * 1024 * 1024, g_Config.m_ClEditorCompressHistory);
+}
+
+void CEditorHistory::PushUndoAction(std::deque<std::shared_ptr<IEditorAction>> &vpUndoActions, const std::shared_ptr<IEditorAction> &pAction, int MaxActions, size_t MemoryLimit, bool Compress)
+{
+	if((int)vpUndoActions.size() >= MaxActions)
+		vpUndoActions.pop_front();
+	vpUndoActions.push_back(pAction);
+
+	// keep the last few actions quick to undo and compress older ones
+	if(Compress && vpUndoActions.size() > NUM_UNCOMPRESSED_ACTIONS)
+		vpUndoActions[vpUndoActions.size() - 1 - NUM_UNCOMPRESSED_ACTIONS]->Compress();
+
+	// drop the oldest actions when over the memory limit, but keep the new one
+	size_t MemoryUsage = 0;
+	for(const auto &pUndoAction : vpUndoActions)
+		MemoryUsage += pUndoAction->MemoryUsage();
+	while(MemoryUsage > MemoryLimit && vpUndoActions.size() > 1)
 	{
-		m_vpUndoActions.pop_front();
+		MemoryUsage -= vpUndoActions.front()->MemoryUsage();
+		vpUndoActions.pop_front();
 	}
-
-	if(pDisplay == nullptr)
-		m_vpUndoActions.emplace_back(pAction);
-	else
-		m_vpUndoActions.emplace_back(std::make_shared<CEditorActionBulk>(m_pEditor, std::vector<std::shared_ptr<IEditorAction>>{pAction}, pDisplay));
 }
 
 bool CEditorHistory::Undo()
@@ -3,7 +3,27 @@
 
 #include "editor_action.h"
 
+#include <deque>
+#include <memory>
 #include <queue>
+#include <string>
+#include <vector>
+
+class CEditorActionBulk : public IEditorAction
+{
+public:
+	CEditorActionBulk(CEditor *pEditor, const std::vector<std::shared_ptr<IEditorAction>> &vpActions, const char *pDisplay = nullptr, bool Reverse = false);
+
+	void Undo() override;
+	void Redo() override;
+	size_t MemoryUsage() const override;
+	void Compress() override;
+
+private:
+	std::vector<std::shared_ptr<IEditorAction>> m_vpActions;
+	std::string m_Display;
+	bool m_Reverse;
+};
 
 class CEditorHistory
 {
@@ -37,6 +57,15 @@ public:
 	std::deque<std::shared_ptr<IEditorAction>> m_vpUndoActions;
 	std::deque<std::shared_ptr<IEditorAction>> m_vpRedoActions;
 
+	// number of most recent undo actions that are never compressed
+	static constexpr size_t NUM_UNCOMPRESSED_ACTIONS = 3;
+
+	// Adds `pAction` to `vpUndoActions`, compresses the action that is no
+	// longer one of the `NUM_UNCOMPRESSED_ACTIONS` most recent ones if
+	// `Compress` is set and drops the oldest actions to stay within
+	// `MaxActions` and `MemoryLimit` bytes, but never `pAction` itself.
+	static void PushUndoAction(std::deque<std::shared_ptr<IEditorAction>> &vpUndoActions, const std::shared_ptr<IEditorAction> &pAction, int MaxActions, size_t MemoryLimit, bool Compress);
+
 private:
 	std::vector<std::shared_ptr<IEditorAction>> m_vpBulkActions;
 	bool m_IsBulk;
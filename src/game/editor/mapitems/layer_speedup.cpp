@@ -163,10 +163,11 @@ void CLayerSpeedup::BrushDraw(std::shared_ptr<CLayer> pBrush, float wx, float wy
 
 void CLayerSpeedup::RecordStateChange(int x, int y, SSpeedupTileStateChange::SData Previous, SSpeedupTileStateChange::SData Current)
 {
-	if(!m_History[y][x].m_Changed)
-		m_History[y][x] = SSpeedupTileStateChange{true, Previous, Current};
+	SSpeedupTileStateChange &Change = m_History.At(x, y);
+	if(!Change.m_Changed)
+		Change = SSpeedupTileStateChange{true, Previous, Current};
 	else
-		m_History[y][x].m_Current = Current;
+		Change.m_Current = Current;
 }
 
 void CLayerSpeedup::BrushFlipX()
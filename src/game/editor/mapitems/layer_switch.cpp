@@ -163,10 +163,11 @@ void CLayerSwitch::BrushDraw(std::shared_ptr<CLayer> pBrush, float wx, float wy)
 
 void CLayerSwitch::RecordStateChange(int x, int y, SSwitchTileStateChange::SData Previous, SSwitchTileStateChange::SData Current)
 {
-	if(!m_History[y][x].m_Changed)
-		m_History[y][x] = SSwitchTileStateChange{true, Previous, Current};
+	SSwitchTileStateChange &Change = m_History.At(x, y);
+	if(!Change.m_Changed)
+		Change = SSwitchTileStateChange{true, Previous, Current};
 	else
-		m_History[y][x].m_Current = Current;
+		Change.m_Current = Current;
 }
 
 void CLayerSwitch::BrushFlipX()
@@ -167,12 +167,11 @@ void CLayerTele::BrushDraw(std::shared_ptr<CLayer> pBrush, float wx, float wy)
 
 void CLayerTele::RecordStateChange(int x, int y, STeleTileStateChange::SData Previous, STeleTileStateChange::SData Current)
 {
-	if(!m_History[y][x].m_Changed)
-		m_History[y][x] = STeleTileStateChange{true, Previous, Current};
+	STeleTileStateChange &Change = m_History.At(x, y);
+	if(!Change.m_Changed)
+		Change = STeleTileStateChange{true, Previous, Current};
 	else
-	{
-		m_History[y][x].m_Current = Current;
-	}
+		Change.m_Current = Current;
 }
 
 void CLayerTele::BrushFlipX()
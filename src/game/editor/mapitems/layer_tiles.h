@@ -2,7 +2,7 @@
 #define GAME_EDITOR_MAPITEMS_LAYER_TILES_H
 
 #include <game/editor/editor_trackers.h>
-#include <map>
+#include <game/editor/tile_state_changes.h>
 
 #include "layer.h"
 
@@ -14,7 +14,7 @@ struct STileStateChange
 };
 
 template<typename T>
-using EditorTileStateChangeHistory = std::map<int, std::map<int, T>>;
+using EditorTileStateChangeHistory = CTileStateChanges<T>;
 
 enum
 {
@@ -144,10 +144,11 @@ void CLayerTune::BrushDraw(std::shared_ptr<CLayer> pBrush, float wx, float wy)
 
 void CLayerTune::RecordStateChange(int x, int y, STuneTileStateChange::SData Previous, STuneTileStateChange::SData Current)
 {
-	if(!m_History[y][x].m_Changed)
-		m_History[y][x] = STuneTileStateChange{true, Previous, Current};
+	STuneTileStateChange &Change = m_History.At(x, y);
+	if(!Change.m_Changed)
+		Change = STuneTileStateChange{true, Previous, Current};
 	else
-		m_History[y][x].m_Current = Current;
+		Change.m_Current = Current;
 }
 
 void CLayerTune::BrushFlipX()
@@ -0,0 +1,23 @@
+#include "tile_state_changes.h"
+
+#include <zlib.h>
+
+bool TileStateChangesCompress(const void *pData, size_t Size, std::vector<unsigned char> &vCompressed)
+{
+	unsigned long CompressedSize = compressBound(Size);
+	std::vector<unsigned char> vBuffer(CompressedSize);
+	// speed matters more than size, the changes are mostly runs of the same tiles
+	const int Result = compress2(vBuffer.data(), &CompressedSize, static_cast<const Bytef *>(pData), Size, Z_BEST_SPEED);
+	if(Result != Z_OK || CompressedSize >= Size)
+		return false;
+	// copied so that only the compressed size stays allocated
+	vCompressed.assign(vBuffer.begin(), vBuffer.begin() + CompressedSize);
+	return true;
+}
+
+bool TileStateChangesUncompress(const std::vector<unsigned char> &vCompressed, void *pData, size_t Size)
+{
+	unsigned long UncompressedSize = Size;
+	const int Result = uncompress(static_cast<Bytef *>(pData), &UncompressedSize, vCompressed.data(), vCompressed.size());
+	return Result == Z_OK && UncompressedSize == Size;
+}
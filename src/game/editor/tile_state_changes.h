@@ -0,0 +1,169 @@
+#ifndef GAME_EDITOR_TILE_STATE_CHANGES_H
+#define GAME_EDITOR_TILE_STATE_CHANGES_H
+
+#include <base/system.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Deflates `Size` bytes of `pData` into `vCompressed`. Returns false if that
+// doesn't make them any smaller.
+bool TileStateChangesCompress(const void *pData, size_t Size, std::vector<unsigned char> &vCompressed);
+// Inflates data compressed with `TileStateChangesCompress` to exactly `Size`
+// bytes at `pData`.
+bool TileStateChangesUncompress(const std::vector<unsigned char> &vCompressed, void *pData, size_t Size);
+
+// Changes to the tiles of a layer for undo and redo in the editor. `T` holds
+// a `m_Changed` flag and the previous and current state of a tile.
+//
+// While an action is recorded, changes are kept in dense rows so that
+// changing a tile again is cheap. `Finish` packs them into spans of adjacent
+// changed tiles of a row, which are then applied as a whole. The spans of
+// older actions can additionally be deflated with `Compress`.
+template<typename T>
+class CTileStateChanges
+{
+	static_assert(std::is_trivially_copyable_v<T>, "the changes are compressed as raw bytes");
+
+public:
+	struct SSpan
+	{
+		int m_X;
+		int m_Y;
+		int m_Num;
+	};
+
+	CTileStateChanges() = default;
+	CTileStateChanges(const CTileStateChanges &Other) = default;
+	CTileStateChanges(CTileStateChanges &&Other) noexcept { *this = std::move(Other); }
+	CTileStateChanges &operator=(const CTileStateChanges &Other) = default;
+	CTileStateChanges &operator=(CTileStateChanges &&Other) noexcept
+	{
+		m_vvRows = std::move(Other.m_vvRows);
+		m_vSpans = std::move(Other.m_vSpans);
+		m_vChanges = std::move(Other.m_vChanges);
+		m_vCompressed = std::move(Other.m_vCompressed);
+		m_NumChanges = Other.m_NumChanges;
+		m_MemoryUsage = Other.m_MemoryUsage;
+		Other.clear();
+		return *this;
+	}
+
+	// Returns the change of the tile at `x`, `y` for recording, its
+	// `m_Changed` flag is unset if the tile wasn't changed before.
+	T &At(int x, int y)
+	{
+		dbg_assert(m_vSpans.empty(), "changes can't be recorded after finishing");
+		if((size_t)y >= m_vvRows.size())
+			m_vvRows.resize(y + 1);
+		std::vector<T> &vRow = m_vvRows[y];
+		if((size_t)x >= vRow.size())
+			vRow.resize(x + 1);
+		return vRow[x];
+	}
+
+	bool empty() const { return m_vvRows.empty() && m_vSpans.empty(); }
+
+	void clear()
+	{
+		// swapped out rather than cleared to release the memory
+		std::vector<std::vector<T>>().swap(m_vvRows);
+		std::vector<SSpan>().swap(m_vSpans);
+		std::vector<T>().swap(m_vChanges);
+		std::vector<unsigned char>().swap(m_vCompressed);
+		m_NumChanges = 0;
+		m_MemoryUsage = 0;
+	}
+
+	// Packs the recorded changes into spans.
+	void Finish()
+	{
+		if(m_vvRows.empty())
+			return;
+
+		// count first to allocate exactly what is needed
+		int NumSpans = 0;
+		for(const std::vector<T> &vRow : m_vvRows)
+		{
+			for(int x = 0; x < (int)vRow.size(); x++)
+			{
+				if(!vRow[x].m_Changed)
+					continue;
+				m_NumChanges++;
+				NumSpans += x == 0 || !vRow[x - 1].m_Changed;
+			}
+		}
+		m_vSpans.reserve(NumSpans);
+		m_vChanges.reserve(m_NumChanges);
+		for(int y = 0; y < (int)m_vvRows.size(); y++)
+		{
+			const std::vector<T> &vRow = m_vvRows[y];
+			for(int x = 0; x < (int)vRow.size();)
+			{
+				if(!vRow[x].m_Changed)
+				{
+					x++;
+					continue;
+				}
+				SSpan Span = {x, y, 0};
+				for(; x < (int)vRow.size() && vRow[x].m_Changed; x++, Span.m_Num++)
+					m_vChanges.push_back(vRow[x]);
+				m_vSpans.push_back(Span);
+			}
+		}
+		std::vector<std::vector<T>>().swap(m_vvRows);
+		m_MemoryUsage = m_vSpans.capacity() * sizeof(SSpan) + m_vChanges.capacity() * sizeof(T);
+	}
+
+	// Deflates the finished changes, they are inflated again for each use.
+	void Compress()
+	{
+		if(m_vChanges.empty() || !TileStateChangesCompress(m_vChanges.data(), m_vChanges.size() * sizeof(T), m_vCompressed))
+			return;
+		std::vector<T>().swap(m_vChanges);
+		m_MemoryUsage = m_vSpans.capacity() * sizeof(SSpan) + m_vCompressed.capacity();
+	}
+
+	bool IsCompressed() const { return !m_vCompressed.empty(); }
+	// number of changed tiles, once finished
+	int Size() const { return m_NumChanges; }
+	// bytes held by the finished changes
+	size_t MemoryUsage() const { return m_MemoryUsage; }
+
+	// Calls `Fn(const SSpan &Span, const T *pChanges)` for every span of the
+	// finished changes, ordered by row and column.
+	template<typename F>
+	void ForEachSpan(F &&Fn) const
+	{
+		dbg_assert(m_vvRows.empty(), "changes must be finished before they are applied");
+		std::vector<T> vUncompressed;
+		const T *pChanges = m_vChanges.data();
+		if(IsCompressed())
+		{
+			vUncompressed.resize(m_NumChanges);
+			if(!TileStateChangesUncompress(m_vCompressed, vUncompressed.data(), vUncompressed.size() * sizeof(T)))
+			{
+				dbg_msg("editor", "failed to uncompress tile changes");
+				return;
+			}
+			pChanges = vUncompressed.data();
+		}
+		for(const SSpan &Span : m_vSpans)
+		{
+			Fn(Span, pChanges);
+			pChanges += Span.m_Num;
+		}
+	}
+
+private:
+	std::vector<std::vector<T>> m_vvRows;
+	std::vector<SSpan> m_vSpans;
+	std::vector<T> m_vChanges;
+	std::vector<unsigned char> m_vCompressed;
+	int m_NumChanges = 0;
+	size_t m_MemoryUsage = 0;
+};
+
+#endif
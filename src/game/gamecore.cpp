@@ -5,10 +5,18 @@
 #include "collision.h"
 #include "mapitems.h"
 #include "teamscore.h"
+#include "teleouts.h"
 
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/shared/config.h>
 
+#include <algorithm>
+
+// slack for the broad-phase so that it never drops a character the exact
+// distance checks would have found
+static constexpr float BROAD_PHASE_MARGIN = 1.0f;
+
 const char *CTuningParams::ms_apNames[] =
 	{
 #define MACRO_TUNING_PARAM(Name, ScriptName, Value, Description) #ScriptName,
@@ -70,7 +78,7 @@ float VelocityRamp(float Value, float Start, float Range, float Curvature)
 	return 1.0f / std::pow(Curvature, (Value - Start) / Range);
 }
 
-void CCharacterCore::Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams, std::map<int, std::vector<vec2>> *pTeleOuts)
+void CCharacterCore::Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams, const CTeleOuts *pTeleOuts)
 {
 	m_pWorld = pWorld;
 	m_pCollision = pCollision;
@@ -290,10 +298,13 @@ void CCharacterCore::Tick(bool UseInput, bool DoDeferredTick)
 		if(!this->m_HookHitDisabled && m_pWorld && m_Tuning.m_PlayerHooking)
 		{
 			float Distance = 0.0f;
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			int aIds[MAX_CLIENTS];
+			const int NumIds = m_pWorld->CharactersNear(m_HookPos, NewPos, PhysicalSize() + 2.0f, aIds);
+			for(int Index = 0; Index < NumIds; Index++)
 			{
+				const int i = aIds[Index];
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-				if(!pCharCore || pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
+				if(pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
 					continue;
 
 				vec2 ClosestPoint;
@@ -327,7 +338,7 @@ void CCharacterCore::Tick(bool UseInput, bool DoDeferredTick)
 				m_HookState = HOOK_RETRACT_START;
 			}
 
-			if(GoingThroughTele && m_pWorld && m_pTeleOuts && !m_pTeleOuts->empty() && !(*m_pTeleOuts)[teleNr - 1].empty())
+			if(GoingThroughTele && m_pWorld && m_pTeleOuts && !(*m_pTeleOuts)[teleNr - 1].empty())
 			{
 				m_TriggeredEvents = 0;
 				SetHookedPlayer(-1);
@@ -406,11 +417,19 @@ void CCharacterCore::TickDeferred()
 {
 	if(m_pWorld)
 	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		// only close characters collide, the hooked one is pulled from any distance
+		int aIds[MAX_CLIENTS];
+		int NumIds = m_pWorld->CharactersNear(m_Pos, m_Pos, PhysicalSize() * 1.25f, aIds);
+		if(m_HookedPlayer != -1 && m_pWorld->m_apCharacters[m_HookedPlayer] && std::find(aIds, aIds + NumIds, m_HookedPlayer) == aIds + NumIds)
+		{
+			aIds[NumIds++] = m_HookedPlayer;
+			std::sort(aIds, aIds + NumIds);
+		}
+
+		for(int Index = 0; Index < NumIds; Index++)
 		{
+			const int i = aIds[Index];
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-			if(!pCharCore)
-				continue;
 
 			// player *p = (player*)ent;
 			// if(pCharCore == this) // || !(p->flags&FLAG_ALIVE)
@@ -514,7 +533,29 @@ void CCharacterCore::Move()
 	{
 		// check player collision
 		float Distance = distance(m_Pos, NewPos);
+		int aIds[MAX_CLIENTS];
+		int NumIds = 0;
 		if(Distance > 0)
+		{
+			// a single swept circle test rules out everyone who can't be
+			// touched on the way, the steps below are only taken for the rest
+			NumIds = m_pWorld->CharactersNear(m_Pos, NewPos, PhysicalSize(), aIds);
+			if(m_pWorld->m_BroadPhase)
+			{
+				int NumClose = 0;
+				for(int Index = 0; Index < NumIds; Index++)
+				{
+					const CCharacterCore *pCharCore = m_pWorld->m_apCharacters[aIds[Index]];
+					if(pCharCore == this)
+						continue;
+					vec2 ClosestPoint;
+					if(!closest_point_on_line(m_Pos, NewPos, pCharCore->m_Pos, ClosestPoint) || distance(pCharCore->m_Pos, ClosestPoint) < PhysicalSize() + BROAD_PHASE_MARGIN)
+						aIds[NumClose++] = aIds[Index];
+				}
+				NumIds = NumClose;
+			}
+		}
+		if(NumIds > 0)
 		{
 			int End = Distance + 1;
 			vec2 LastPos = m_Pos;
@@ -522,10 +563,11 @@ void CCharacterCore::Move()
 			{
 				float a = i / Distance;
 				vec2 Pos = mix(m_Pos, NewPos, a);
-				for(int p = 0; p < MAX_CLIENTS; p++)
+				for(int Index = 0; Index < NumIds; Index++)
 				{
+					const int p = aIds[Index];
 					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
-					if(!pCharCore || pCharCore == this)
+					if(pCharCore == this)
 						continue;
 					if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || pCharCore->m_CollisionDisabled || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
 						continue;
@@ -677,7 +719,7 @@ void CCharacterCore::SetTeamsCore(CTeamsCore *pTeams)
 	m_pTeams = pTeams;
 }
 
-void CCharacterCore::SetTeleOuts(std::map<int, std::vector<vec2>> *pTeleOuts)
+void CCharacterCore::SetTeleOuts(const CTeleOuts *pTeleOuts)
 {
 	m_pTeleOuts = pTeleOuts;
 }
@@ -691,6 +733,25 @@ bool CCharacterCore::IsSwitchActiveCb(int Number, void *pUser)
 	return false;
 }
 
+int CWorldCore::CharactersNear(vec2 From, vec2 To, float Radius, int *pIds) const
+{
+	// the margin covers the rounding of the exact tests done by the callers
+	Radius += BROAD_PHASE_MARGIN;
+	const vec2 Min = vec2(minimum(From.x, To.x) - Radius, minimum(From.y, To.y) - Radius);
+	const vec2 Max = vec2(maximum(From.x, To.x) + Radius, maximum(From.y, To.y) + Radius);
+	int NumIds = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CCharacterCore *pCharCore = m_apCharacters[i];
+		if(!pCharCore)
+			continue;
+		if(m_BroadPhase && !(pCharCore->m_Pos.x >= Min.x && pCharCore->m_Pos.x <= Max.x && pCharCore->m_Pos.y >= Min.y && pCharCore->m_Pos.y <= Max.y))
+			continue;
+		pIds[NumIds++] = i;
+	}
+	return NumIds;
+}
+
 void CWorldCore::InitSwitchers(int HighestSwitchNumber)
 {
 	if(HighestSwitchNumber > 0)
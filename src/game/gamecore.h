@@ -16,6 +16,7 @@
 
 class CCollision;
 class CTeamsCore;
+class CTeleOuts;
 
 class CTuneParam
 {
@@ -209,9 +210,18 @@ public:
 		return m_pPrng->RandomBits() % BelowThis;
 	}
 
+	// Broad-phase for the interactions between characters: writes the ids
+	// of all characters within `Radius` of the box spanned by `From` and
+	// `To` to `pIds` in ascending order and returns their number. The
+	// positions are read on every call, characters move one after another
+	// within a tick and can be teleported in between.
+	int CharactersNear(vec2 From, vec2 To, float Radius, int *pIds) const;
+
 	CTuningParams m_aTuning[2];
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
 	CPrng *m_pPrng;
+	// only for comparing against the exhaustive checks in tests
+	bool m_BroadPhase = true;
 
 	void InitSwitchers(int HighestSwitchNumber);
 	std::vector<SSwitchers> m_vSwitchers;
@@ -221,7 +231,7 @@ class CCharacterCore
 {
 	CWorldCore *m_pWorld = nullptr;
 	CCollision *m_pCollision;
-	std::map<int, std::vector<vec2>> *m_pTeleOuts;
+	const CTeleOuts *m_pTeleOuts;
 
 public:
 	static constexpr float PhysicalSize() { return 28.0f; };
@@ -269,7 +279,7 @@ public:
 
 	int m_TriggeredEvents;
 
-	void Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams = nullptr, std::map<int, std::vector<vec2>> *pTeleOuts = nullptr);
+	void Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams = nullptr, const CTeleOuts *pTeleOuts = nullptr);
 	void SetCoreWorld(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams);
 	void Reset();
 	void TickDeferred();
@@ -290,7 +300,7 @@ public:
 
 	// DDNet Character
 	void SetTeamsCore(CTeamsCore *pTeams);
-	void SetTeleOuts(std::map<int, std::vector<vec2>> *pTeleOuts);
+	void SetTeleOuts(const CTeleOuts *pTeleOuts);
 	void ReadDDNet(const CNetObj_DDNetCharacter *pObjDDNet);
 	bool m_Solo;
 	bool m_Jetpack;
@@ -1281,6 +1281,31 @@ bool CCharacter::IsSnappingCharacterInView(int SnappingClientID)
 	return true;
 }
 
+int CCharacter::SnapLodInterval(int SnappingClient)
+{
+	if(SnappingClient == SERVER_DEMO_CLIENT)
+		return 1;
+
+	int ID = m_pPlayer->GetCID();
+	const CPlayer *pSnapPlayer = GameServer()->m_apPlayers[SnappingClient];
+	const CCharacter *pSnapChar = GameServer()->GetPlayerChar(SnappingClient);
+
+	// the client's own character, its spectating target and everyone
+	// interacting with it or in its team are always kept up to date
+	if(ID == SnappingClient || ID == pSnapPlayer->m_SpectatorID)
+		return 1;
+	if(pSnapChar && (pSnapChar->m_Core.HookedPlayer() == ID || m_Core.HookedPlayer() == SnappingClient))
+		return 1;
+	if(Team() != TEAM_FLOCK && SameTeam(SnappingClient))
+		return 1;
+
+	int Interval = NetworkLodInterval(SnappingClient);
+	// hiders need to see where the seekers are going and vice versa
+	if(m_pPlayer->m_Hidden.m_InGame && pSnapPlayer->m_Hidden.m_InGame && m_pPlayer->m_Hidden.m_IsSeeker != pSnapPlayer->m_Hidden.m_IsSeeker)
+		Interval = minimum(Interval, 2);
+	return Interval;
+}
+
 void CCharacter::Snap(int SnappingClient)
 {
 	int ID = m_pPlayer->GetCID();
@@ -1296,6 +1321,10 @@ void CCharacter::Snap(int SnappingClient)
 	if(!IsSnappingCharacterInView(SnappingClient))
 		return;
 
+	static const int s_aLodTypes[] = {NETOBJTYPE_CHARACTER, NETOBJTYPE_DDNETCHARACTER};
+	if(Server()->SnapHoldItems(SnappingClient, ID, SnapLodInterval(SnappingClient), s_aLodTypes, std::size(s_aLodTypes)))
+		return;
+
 	SnapCharacter(SnappingClient, ID);
 
 	CNetObj_DDNetCharacter *pDDNetCharacter = Server()->SnapNewItem<CNetObj_DDNetCharacter>(ID);
@@ -1388,7 +1417,7 @@ int CCharacter::Team()
 	return Teams()->m_Core.Team(m_pPlayer->GetCID());
 }
 
-void CCharacter::SetTeleports(std::map<int, std::vector<vec2>> *pTeleOuts, std::map<int, std::vector<vec2>> *pTeleCheckOuts)
+void CCharacter::SetTeleports(const CTeleOuts *pTeleOuts, const CTeleOuts *pTeleCheckOuts)
 {
 	m_pTeleOuts = pTeleOuts;
 	m_pTeleCheckOuts = pTeleCheckOuts;
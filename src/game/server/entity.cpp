@@ -45,6 +45,11 @@ bool CEntity::NetworkClippedLine(int SnappingClient, vec2 StartPos, vec2 EndPos)
 	return ::NetworkClippedLine(m_pGameWorld->GameServer(), SnappingClient, StartPos, EndPos);
 }
 
+int CEntity::NetworkLodInterval(int SnappingClient) const
+{
+	return ::NetworkLodInterval(m_pGameWorld->GameServer(), SnappingClient, m_Pos);
+}
+
 bool CEntity::GameLayerClipped(vec2 CheckPos)
 {
 	return round_to_int(CheckPos.x) / 32 < -200 || round_to_int(CheckPos.x) / 32 > GameServer()->Collision()->GetWidth() + 200 ||
@@ -100,6 +105,22 @@ bool NetworkClipped(const CGameContext *pGameServer, int SnappingClient, vec2 Ch
 	return absolute(dy) > pGameServer->m_apPlayers[SnappingClient]->m_ShowDistance.y;
 }
 
+int NetworkLodInterval(const CGameContext *pGameServer, int SnappingClient, vec2 CheckPos)
+{
+	if(SnappingClient == SERVER_DEMO_CLIENT)
+		return 1;
+
+	// how far out in the view the position is, 1 being at its border
+	const CPlayer *pPlayer = pGameServer->m_apPlayers[SnappingClient];
+	float Distance = maximum(absolute(pPlayer->m_ViewPos.x - CheckPos.x) / pPlayer->m_ShowDistance.x,
+		absolute(pPlayer->m_ViewPos.y - CheckPos.y) / pPlayer->m_ShowDistance.y);
+	if(Distance < 0.5f)
+		return 1;
+	if(Distance < 1.0f)
+		return 2;
+	return 4;
+}
+
 bool NetworkClippedLine(const CGameContext *pGameServer, int SnappingClient, vec2 StartPos, vec2 EndPos)
 {
 	if(SnappingClient == SERVER_DEMO_CLIENT || pGameServer->m_apPlayers[SnappingClient]->m_ShowAll)
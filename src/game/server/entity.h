@@ -160,6 +160,20 @@ public: // TODO: Maybe make protected
 	bool NetworkClipped(int SnappingClient, vec2 CheckPos) const;
 	bool NetworkClippedLine(int SnappingClient, vec2 StartPos, vec2 EndPos) const;
 
+	/*
+		Function: NetworkLodInterval
+			Gets how often the entity has to be refreshed in the
+			snapshots of a client that can see it, see `sv_snap_lod`.
+
+		Arguments:
+			SnappingClient - ID of the client which snapshot is
+				being generated.
+
+		Returns:
+			The refresh interval in snapshots, 1 for every snapshot.
+	*/
+	int NetworkLodInterval(int SnappingClient) const;
+
 	bool GameLayerClipped(vec2 CheckPos);
 
 	// DDRace
@@ -173,5 +187,6 @@ public: // TODO: Maybe make protected
 
 bool NetworkClipped(const CGameContext *pGameServer, int SnappingClient, vec2 CheckPos);
 bool NetworkClippedLine(const CGameContext *pGameServer, int SnappingClient, vec2 StartPos, vec2 EndPos);
+int NetworkLodInterval(const CGameContext *pGameServer, int SnappingClient, vec2 CheckPos);
 
 #endif
@@ -20,6 +20,7 @@
 #include <engine/shared/linereader.h>
 #include <engine/shared/memheap.h>
 #include <engine/shared/network.h>
+#include <engine/shared/tick_profiler.h>
 #include <engine/storage.h>
 
 #include <game/collision.h>
@@ -34,6 +35,7 @@
 #include "entities/pickup.h"
 #include "gamemodes/DDRace.h"
 #include "gamemodes/mod.h"
+#include "hidden_chat.h"
 #include "player.h"
 #include "score.h"
 #include <engine/server/server.h>
@@ -562,14 +564,10 @@ void CGameContext::SendChatTarget(int To, const char *pText, int Flags) const
 
 	if(To == -1)
 	{
+		CClientMask Mask;
 		for(int i = 0; i < Server()->MaxClients(); i++)
-		{
-			if(!((Server()->IsSixup(i) && (Flags & CHAT_SIXUP)) ||
-				   (!Server()->IsSixup(i) && (Flags & CHAT_SIX))))
-				continue;
-
-			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
-		}
+			Mask[i] = (Server()->IsSixup(i) && (Flags & CHAT_SIXUP)) || (!Server()->IsSixup(i) && (Flags & CHAT_SIX));
+		Server()->SendPackMsgMask(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, Mask);
 	}
 	else
 	{
@@ -622,66 +620,32 @@ void CGameContext::SendChat(int ChatterClientID, int Team, const char *pText, in
 
 		// hidden mode
 		CGameControllerDDRace *pController = (CGameControllerDDRace *)m_pController;
-		// send to the clients
+		CClientMask aAudiences[NUM_HIDDEN_CHAT_AUDIENCES];
+		CPlayer *pChatterPlayer = ChatterClientID >= 0 && ChatterClientID < MAX_CLIENTS ? m_apPlayers[ChatterClientID] : nullptr;
+		const bool IsChatterGameOver = pChatterPlayer && pController->HiddenIsPlayerGameOver(pChatterPlayer);
 		for(int i = 0; i < Server()->MaxClients(); i++)
 		{
-			if(!m_apPlayers[i])
+			if(!m_apPlayers[i] || m_apPlayers[i]->m_DND)
 				continue;
 			bool Send = (Server()->IsSixup(i) && (Flags & CHAT_SIXUP)) ||
 				    (!Server()->IsSixup(i) && (Flags & CHAT_SIX));
+			if(!Send)
+				continue;
 
 			if(ChatterClientID >= 0 && ChatterClientID < MAX_CLIENTS)
 			{ // 正常玩家聊天
-				CPlayer *pChatterPlayer = m_apPlayers[ChatterClientID];
-				CPlayer *pReceiverPlayer = m_apPlayers[i];
-				if(!pChatterPlayer || !pReceiverPlayer)
+				if(!pChatterPlayer)
 					continue;
 
-				CNetMsg_Sv_Chat Msg2;
-				Msg2.m_Team = 0;
-				Msg2.m_ClientID = ChatterClientID;
-
-				bool isChatterGameOver = pController->HiddenIsPlayerGameOver(pChatterPlayer);
-				bool isReceiverGameOver = pController->HiddenIsPlayerGameOver(pReceiverPlayer);
-
-				// 需要修改内容
-				// 当说话的人出局而接收的人没有出局
-				// 仅限step 4
-				bool IsCase1 =
-					isChatterGameOver && !isReceiverGameOver && pController->m_Hidden.nowStep == STEP_S4;
-				// 说话人没出局但是接收的出局了
-				bool IsCase2 =
-					!isChatterGameOver && isReceiverGameOver;
-
-				bool needModifyTextFlag = false; // 需要修改聊天文本
-
-				if(IsCase1)
-				{
-					Msg2.m_Team = 1;
-					needModifyTextFlag = true;
-				}
-				else if(IsCase2)
-				{
-					Msg2.m_Team = 1;
-				}
-
-				if(needModifyTextFlag)
-					Msg2.m_pMessage = Config()->m_HiddenCantSeeMSG;
-				else
-					Msg2.m_pMessage = aText;
-
-				if(!m_apPlayers[i]->m_DND && Send)
-					Server()->SendPackMsg(&Msg2, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+				bool isReceiverGameOver = pController->HiddenIsPlayerGameOver(m_apPlayers[i]);
+				aAudiences[HiddenChatAudience(IsChatterGameOver, isReceiverGameOver, pController->m_Hidden.nowStep == STEP_S4)].set(i);
 			}
 			else
 			{ // 系统消息
-				if(!m_apPlayers[i])
-					continue;
-
-				if(!m_apPlayers[i]->m_DND && Send)
-					Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+				aAudiences[HIDDEN_CHAT_ALL].set(i);
 			}
 		}
+		HiddenSendChat(Server(), &Msg, Config()->m_HiddenCantSeeMSG, aAudiences, MSGFLAG_VITAL | MSGFLAG_NORECORD);
 
 		str_format(aBuf, sizeof(aBuf), "Chat: %s", aText);
 		LogEvent(aBuf, ChatterClientID);
@@ -783,7 +747,10 @@ void CGameContext::SendBroadcast(const char *pText, int ClientID, bool IsImporta
 	if(ClientID == -1)
 	{
 		dbg_assert(IsImportant, "broadcast messages to all players must be important");
-		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
+		CClientMask Mask;
+		for(int i = 0; i < Server()->MaxClients(); i++)
+			Mask[i] = Server()->ClientIngame(i);
+		Server()->SendPackMsgMask(&Msg, MSGFLAG_VITAL, Mask);
 
 		for(auto &pPlayer : m_apPlayers)
 		{
@@ -878,15 +845,20 @@ void CGameContext::SendVoteSet(int ClientID)
 
 	if(ClientID == -1)
 	{
+		CClientMask SixMask;
+		CClientMask SixupMask;
 		for(int i = 0; i < Server()->MaxClients(); i++)
 		{
 			if(!m_apPlayers[i])
 				continue;
 			if(!Server()->IsSixup(i))
-				Server()->SendPackMsg(&Msg6, MSGFLAG_VITAL, i);
+				SixMask.set(i);
 			else
-				Server()->SendPackMsg(&Msg7, MSGFLAG_VITAL, i);
+				SixupMask.set(i);
 		}
+		if(SixMask.any())
+			Server()->SendPackMsgMask(&Msg6, MSGFLAG_VITAL, SixMask);
+		Server()->SendPackMsgMask(&Msg7, MSGFLAG_VITAL, SixupMask);
 	}
 	else
 	{
@@ -1068,13 +1040,20 @@ void CGameContext::OnTick()
 
 	// copy tuning
 	m_World.m_Core.m_aTuning[0] = m_Tuning;
-	m_World.Tick();
+	{
+		CTickProfileScope Scope(TICK_SECTION_WORLD);
+		m_World.Tick();
+	}
 
 	UpdatePlayerMaps();
 
 	// if(world.paused) // make sure that the game object always updates
-	m_pController->Tick();
+	{
+		CTickProfileScope Scope(TICK_SECTION_CONTROLLER);
+		m_pController->Tick();
+	}
 
+	CTickProfileScope PlayersScope(TICK_SECTION_PLAYERS);
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		if(m_apPlayers[i])
@@ -1092,8 +1071,10 @@ void CGameContext::OnTick()
 		if(pPlayer)
 			pPlayer->PostPostTick();
 	}
+	PlayersScope.Stop();
 
 	// update voting
+	CTickProfileScope VotesScope(TICK_SECTION_VOTES);
 	if(m_VoteCloseTime)
 	{
 		// abort the kick-vote on player-leave
@@ -1267,6 +1248,8 @@ void CGameContext::OnTick()
 			}
 		}
 	}
+	VotesScope.Stop();
+
 	for(int i = 0; i < m_NumMutes; i++)
 	{
 		if(m_aMutes[i].m_Expire <= Server()->Tick())
@@ -4031,7 +4014,8 @@ void CGameContext::OnInit(const void *pPersistentData)
 	Console()->SetTeeHistorianCommandCallback(CommandCallback, this);
 
 	uint64_t aSeed[2];
-	secure_random_fill(aSeed, sizeof(aSeed));
+	if(!Server()->TeeHistorianReplaySeed(aSeed))
+		secure_random_fill(aSeed, sizeof(aSeed));
 	m_Prng.Seed(aSeed);
 	m_World.m_Core.m_pPrng = &m_Prng;
 
@@ -4262,7 +4246,7 @@ void CGameContext::OnInit(const void *pPersistentData)
 		// 解析m_Hidden.aSkins
 		{
 			char *str = Config()->m_HiddenSkins;
-			char *cstr = new char[str_length(str)]; // 创建一个字符数组，用来存储字符串的内容
+			char *cstr = new char[str_length(str) + 1]; // 创建一个字符数组，用来存储字符串的内容
 			std::strcpy(cstr, str); // 将字符串的内容复制到字符数组中
 
 			char *token = std::strtok(cstr, ","); // 使用strtok()函数，按照逗号切分字符串，返回第一个子字符串
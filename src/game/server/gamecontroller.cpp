@@ -756,23 +756,10 @@ void IGameController::InitTeleporter()
 		return;
 	int Width = GameServer()->Collision()->Layers()->TeleLayer()->m_Width;
 	int Height = GameServer()->Collision()->Layers()->TeleLayer()->m_Height;
+	const CTeleTile *pTiles = GameServer()->Collision()->TeleLayer();
 
-	for(int i = 0; i < Width * Height; i++)
-	{
-		int Number = GameServer()->Collision()->TeleLayer()[i].m_Number;
-		int Type = GameServer()->Collision()->TeleLayer()[i].m_Type;
-		if(Number > 0)
-		{
-			if(Type == TILE_TELEOUT)
-			{
-				m_TeleOuts[Number - 1].emplace_back(i % Width * 32.0f + 16.0f, i / Width * 32.0f + 16.0f);
-			}
-			else if(Type == TILE_TELECHECKOUT)
-			{
-				m_TeleCheckOuts[Number - 1].emplace_back(i % Width * 32.0f + 16.0f, i / Width * 32.0f + 16.0f);
-			}
-		}
-	}
+	m_TeleOuts.Init(pTiles, Width, Height, TILE_TELEOUT);
+	m_TeleCheckOuts.Init(pTiles, Width, Height, TILE_TELECHECKOUT);
 }
 
 void IGameController::DoTeamChange(CPlayer *pPlayer, int Team, bool DoChatMsg)
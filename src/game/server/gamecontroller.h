@@ -7,6 +7,7 @@
 #include <engine/map.h>
 #include <engine/shared/protocol.h>
 #include <game/server/teams.h>
+#include <game/teleouts.h>
 
 #include <map>
 #include <vector>
@@ -155,8 +156,8 @@ public:
 	// DDRace
 
 	float m_CurrentRecord;
-	std::map<int, std::vector<vec2>> m_TeleOuts;
-	std::map<int, std::vector<vec2>> m_TeleCheckOuts;
+	CTeleOuts m_TeleOuts;
+	CTeleOuts m_TeleCheckOuts;
 	CGameTeams &Teams() { return m_Teams; }
 	std::shared_ptr<CScoreLoadBestTimeResult> m_pLoadBestTimeResult;
 };
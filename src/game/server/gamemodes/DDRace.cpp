@@ -5,6 +5,7 @@
 #include <engine/server.h>
 #include <engine/server/server.h>
 #include <engine/shared/config.h>
+#include <engine/shared/tick_profiler.h>
 #include <game/mapitems.h>
 #include <game/server/entities/character.h>
 #include <game/server/entities/pickup.h>
@@ -27,8 +28,7 @@ CGameControllerDDRace::CGameControllerDDRace(class CGameContext *pGameServer) :
 {
 	m_pGameType = g_Config.m_SvTestingCommands ? TEST_TYPE_NAME : GAME_TYPE_NAME;
 
-	// hidden mode
-	InitTeleporter();
+	// hidden mode, the teleporters are already initialized by IGameController
 	if(HiddenModeCanTurnOn())
 	{
 		m_HiddenModeCanTurnOn = true;
@@ -181,7 +181,10 @@ void CGameControllerDDRace::Tick()
 {
 	IGameController::Tick();
 	Teams().ProcessSaveTeam();
-	Teams().Tick();
+	{
+		CTickProfileScope Scope(TICK_SECTION_TEAMS);
+		Teams().Tick();
+	}
 
 	if(m_pLoadBestTimeResult != nullptr && m_pLoadBestTimeResult->m_Completed)
 	{
@@ -208,6 +211,7 @@ void CGameControllerDDRace::Tick()
 			int tickSpeed = Server()->TickSpeed();
 			int endTick = m_Hidden.stepEndTick;
 
+			CTickProfileScope Scope(TICK_SECTION_HIDDEN);
 			HiddenTick(nowTick, endTick, tickSpeed, m_Hidden.nowStep);
 		}
 	}
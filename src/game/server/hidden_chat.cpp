@@ -0,0 +1,34 @@
+#include "hidden_chat.h"
+
+#include <engine/server.h>
+
+int HiddenChatAudience(bool IsChatterGameOver, bool IsReceiverGameOver, bool IsStep4)
+{
+	// 需要修改内容
+	// 当说话的人出局而接收的人没有出局
+	// 仅限step 4
+	if(IsChatterGameOver && !IsReceiverGameOver && IsStep4)
+		return HIDDEN_CHAT_CANT_SEE;
+	// 说话人没出局但是接收的出局了
+	if(!IsChatterGameOver && IsReceiverGameOver)
+		return HIDDEN_CHAT_TEAM;
+	return HIDDEN_CHAT_ALL;
+}
+
+void HiddenSendChat(IServer *pServer, const CNetMsg_Sv_Chat *pMsg, const char *pCantSeeText, const CClientMask *pAudiences, int Flags)
+{
+	pServer->SendPackMsgMask(pMsg, Flags, pAudiences[HIDDEN_CHAT_ALL]);
+	if(pAudiences[HIDDEN_CHAT_TEAM].any())
+	{
+		CNetMsg_Sv_Chat MsgTeam = *pMsg;
+		MsgTeam.m_Team = 1;
+		pServer->SendPackMsgMask(&MsgTeam, Flags, pAudiences[HIDDEN_CHAT_TEAM]);
+	}
+	if(pAudiences[HIDDEN_CHAT_CANT_SEE].any())
+	{
+		CNetMsg_Sv_Chat MsgCantSee = *pMsg;
+		MsgCantSee.m_Team = 1;
+		MsgCantSee.m_pMessage = pCantSeeText;
+		pServer->SendPackMsgMask(&MsgCantSee, Flags, pAudiences[HIDDEN_CHAT_CANT_SEE]);
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef GAME_SERVER_HIDDEN_CHAT_H
+#define GAME_SERVER_HIDDEN_CHAT_H
+
+#include <engine/shared/protocol.h>
+
+class CNetMsg_Sv_Chat;
+class IServer;
+
+// The receivers of a player's chat message in Hidden mode fall into a few
+// audiences that get the same message, each of them is packed once for all
+// of its receivers.
+enum
+{
+	HIDDEN_CHAT_ALL,
+	HIDDEN_CHAT_TEAM, // chatter alive, receiver out
+	HIDDEN_CHAT_CANT_SEE, // chatter out, receiver alive in step 4
+	NUM_HIDDEN_CHAT_AUDIENCES,
+};
+
+int HiddenChatAudience(bool IsChatterGameOver, bool IsReceiverGameOver, bool IsStep4);
+
+// Sends `pMsg` to its audiences: as it is to `HIDDEN_CHAT_ALL`, as team chat
+// to `HIDDEN_CHAT_TEAM` and as team chat saying `pCantSeeText` to
+// `HIDDEN_CHAT_CANT_SEE`.
+void HiddenSendChat(IServer *pServer, const CNetMsg_Sv_Chat *pMsg, const char *pCantSeeText, const CClientMask *pAudiences, int Flags);
+
+#endif
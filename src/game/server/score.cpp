@@ -160,7 +160,7 @@ void CScore::SaveScore(int ClientID, float Time, const char *pTimestamp, const f
 	for(int i = 0; i < NUM_CHECKPOINTS; i++)
 		Tmp->m_aCurrentTimeCp[i] = aTimeCp[i];
 
-	m_pPool->ExecuteWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score");
+	m_pPool->ExecuteWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score", /* Batch */ true);
 }
 
 void CScore::SaveTeamScore(int *pClientIDs, unsigned int Size, float Time, const char *pTimestamp)
@@ -183,7 +183,7 @@ void CScore::SaveTeamScore(int *pClientIDs, unsigned int Size, float Time, const
 	str_copy(Tmp->m_aMap, g_Config.m_SvMap, sizeof(Tmp->m_aMap));
 	Tmp->m_TeamrankUuid = RandomUuid();
 
-	m_pPool->ExecuteWrite(CScoreWorker::SaveTeamScore, std::move(Tmp), "save team score");
+	m_pPool->ExecuteWrite(CScoreWorker::SaveTeamScore, std::move(Tmp), "save team score", /* Batch */ true);
 }
 
 void CScore::ShowRank(int ClientID, const char *pName)
@@ -319,7 +319,7 @@ void CScore::SaveTeam(int ClientID, const char *pCode, const char *pServer)
 	}
 	pController->Teams().KillSavedTeam(ClientID, Team);
 	GameServer()->SendChatTeam(Team, aBuf);
-	m_pPool->ExecuteWrite(CScoreWorker::SaveTeam, std::move(Tmp), "save team");
+	m_pPool->ExecuteWrite(CScoreWorker::SaveTeam, std::move(Tmp), "save team", /* Batch */ false);
 }
 
 void CScore::LoadTeam(const char *pCode, int ClientID)
@@ -359,7 +359,7 @@ void CScore::LoadTeam(const char *pCode, int ClientID)
 			Tmp->m_NumPlayer++;
 		}
 	}
-	m_pPool->ExecuteWrite(CScoreWorker::LoadTeam, std::move(Tmp), "load team");
+	m_pPool->ExecuteWrite(CScoreWorker::LoadTeam, std::move(Tmp), "load team", /* Batch */ false);
 }
 
 void CScore::GetSaves(int ClientID)
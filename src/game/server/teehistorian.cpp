@@ -1,5 +1,6 @@
 #include "teehistorian.h"
 
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/external/json-parser/json.h>
 #include <engine/shared/config.h>
@@ -144,7 +145,8 @@ void CTeeHistorian::WriteHeader(const CGameInfo *pGameInfo)
 	Write(aJson, str_length(aJson));
 
 	char aBuffer1[1024];
-	char aBuffer2[1024];
+	// string settings can be longer than aJson, e.g. hidden_skins
+	std::vector<char> vValueBuffer;
 	bool First = true;
 
 #define MACRO_CONFIG_INT(Name, ScriptName, Def, Min, Max, Flags, Desc) \
@@ -163,11 +165,14 @@ void CTeeHistorian::WriteHeader(const CGameInfo *pGameInfo)
 #define MACRO_CONFIG_STR(Name, ScriptName, Len, Def, Flags, Desc) \
 	if((Flags)&CFGFLAG_SERVER && !((Flags)&CFGFLAG_NONTEEHISTORIC) && str_comp(pGameInfo->m_pConfig->m_##Name, (Def)) != 0) \
 	{ \
-		str_format(aJson, sizeof(aJson), "%s\"%s\":\"%s\"", \
+		str_format(aJson, sizeof(aJson), "%s\"%s\":\"", \
 			First ? "" : ",", \
-			E(aBuffer1, #ScriptName), \
-			E(aBuffer2, pGameInfo->m_pConfig->m_##Name)); \
+			E(aBuffer1, #ScriptName)); \
 		Write(aJson, str_length(aJson)); \
+		vValueBuffer.resize((Len)*6); \
+		EscapeJson(vValueBuffer.data(), (int)vValueBuffer.size(), pGameInfo->m_pConfig->m_##Name); \
+		Write(vValueBuffer.data(), str_length(vValueBuffer.data())); \
+		Write("\"", 1); \
 		First = false; \
 	}
 
@@ -818,3 +823,365 @@ void CTeeHistorian::Finish()
 
 	Write(Buffer.Data(), Buffer.Size());
 }
+
+CTeeHistorianReader::CTeeHistorianReader()
+{
+	m_pData = nullptr;
+	m_DataSize = 0;
+	m_pHeader = nullptr;
+	m_aError[0] = '\0';
+	m_Finished = true;
+}
+
+CTeeHistorianReader::~CTeeHistorianReader()
+{
+	if(m_pHeader)
+	{
+		json_value_free(m_pHeader);
+	}
+}
+
+bool CTeeHistorianReader::Open(const void *pData, int DataSize)
+{
+	if(m_pHeader)
+	{
+		json_value_free(m_pHeader);
+		m_pHeader = nullptr;
+	}
+	m_pData = (const unsigned char *)pData;
+	m_DataSize = DataSize;
+	m_aError[0] = '\0';
+	m_Finished = true;
+
+	if(DataSize < (int)sizeof(TEEHISTORIAN_UUID) || mem_comp(pData, &TEEHISTORIAN_UUID, sizeof(TEEHISTORIAN_UUID)) != 0)
+	{
+		str_copy(m_aError, "not a teehistorian file");
+		return false;
+	}
+	const unsigned char *pHeader = m_pData + sizeof(TEEHISTORIAN_UUID);
+	const unsigned char *pEnd = m_pData + DataSize;
+	const unsigned char *pHeaderEnd = pHeader;
+	while(pHeaderEnd < pEnd && *pHeaderEnd != 0)
+	{
+		pHeaderEnd++;
+	}
+	if(pHeaderEnd == pEnd)
+	{
+		str_copy(m_aError, "unterminated header");
+		return false;
+	}
+	m_pHeader = json_parse((const char *)pHeader, pHeaderEnd - pHeader);
+	if(!m_pHeader || m_pHeader->type != json_object)
+	{
+		str_copy(m_aError, "invalid header");
+		return false;
+	}
+	const char *pVersion = HeaderString("version");
+	if(!pVersion || str_comp(pVersion, TEEHISTORIAN_VERSION) != 0)
+	{
+		str_format(m_aError, sizeof(m_aError), "unsupported version '%s'", pVersion ? pVersion : "");
+		return false;
+	}
+
+	pHeaderEnd++;
+	m_Unpacker.Reset(pHeaderEnd, pEnd - pHeaderEnd);
+	m_Finished = false;
+	m_Tick = 0;
+	// Tick 0 is implicit at the start, the first player record begins tick 1.
+	m_LastPlayerClientID = MAX_CLIENTS;
+	m_InInputs = false;
+	m_TickPending = false;
+	m_NextJoinProtocol = CTeeHistorian::PROTOCOL_6;
+	for(auto &Player : m_aPlayers)
+	{
+		Player.m_Alive = false;
+		Player.m_X = 0;
+		Player.m_Y = 0;
+		Player.m_HaveInput = false;
+		mem_zero(&Player.m_Input, sizeof(Player.m_Input));
+	}
+	return true;
+}
+
+const char *CTeeHistorianReader::HeaderString(const char *pKey) const
+{
+	if(!m_pHeader)
+	{
+		return nullptr;
+	}
+	const json_value *pValue = json_object_get(m_pHeader, pKey);
+	if(pValue->type != json_string)
+	{
+		return nullptr;
+	}
+	return json_string_get(pValue);
+}
+
+bool CTeeHistorianReader::PlayerRecord(int ClientID)
+{
+	// Player records of a tick are written in ascending client ID order,
+	// going backwards or coming after inputs implicitly starts the next tick.
+	bool NewTick = m_InInputs || ClientID <= m_LastPlayerClientID;
+	m_LastPlayerClientID = ClientID;
+	m_InInputs = false;
+	if(NewTick)
+	{
+		m_Tick++;
+	}
+	return NewTick;
+}
+
+bool CTeeHistorianReader::Read(CItem *pItem)
+{
+	if(m_Finished)
+	{
+		return false;
+	}
+	if(m_TickPending)
+	{
+		*pItem = m_PendingItem;
+		m_TickPending = false;
+		return true;
+	}
+	if(!ReadItem(pItem))
+	{
+		m_Finished = true;
+		return false;
+	}
+	if(m_TickPending)
+	{
+		// The player record implicitly started a new tick, report the tick
+		// first and the record on the next call.
+		m_PendingItem = *pItem;
+		pItem->m_Type = ITEM_TICK;
+		pItem->m_ClientID = -1;
+	}
+	else if(pItem->m_Type == ITEM_FINISH)
+	{
+		m_Finished = true;
+	}
+	return true;
+}
+
+bool CTeeHistorianReader::ReadItem(CItem *pItem)
+{
+	int Kind = m_Unpacker.GetIntOrDefault(-TEEHISTORIAN_FINISH);
+	if(m_Unpacker.Error())
+	{
+		str_copy(m_aError, "unexpected end of data");
+		return false;
+	}
+
+	pItem->m_ClientID = -1;
+	pItem->m_pString = nullptr;
+	pItem->m_pData = nullptr;
+	pItem->m_DataSize = 0;
+
+	bool IsPlayerRecord = false;
+	if(Kind >= 0)
+	{
+		// PLAYER_DIFF, the kind is the client ID
+		int ClientID = Kind;
+		int dx = m_Unpacker.GetInt();
+		int dy = m_Unpacker.GetInt();
+		if(ClientID >= MAX_CLIENTS || !m_aPlayers[ClientID].m_Alive || m_Unpacker.Error())
+		{
+			str_format(m_aError, sizeof(m_aError), "invalid player diff cid=%d", ClientID);
+			return false;
+		}
+		m_aPlayers[ClientID].m_X += dx;
+		m_aPlayers[ClientID].m_Y += dy;
+		pItem->m_Type = ITEM_PLAYER;
+		pItem->m_ClientID = ClientID;
+		pItem->m_X = m_aPlayers[ClientID].m_X;
+		pItem->m_Y = m_aPlayers[ClientID].m_Y;
+		IsPlayerRecord = true;
+	}
+	else
+	{
+		switch(-Kind)
+		{
+		case TEEHISTORIAN_FINISH:
+			pItem->m_Type = ITEM_FINISH;
+			break;
+		case TEEHISTORIAN_TICK_SKIP:
+		{
+			int dt = m_Unpacker.GetInt();
+			m_Tick += maximum(dt, 0) + 1;
+			m_LastPlayerClientID = -1;
+			m_InInputs = false;
+			pItem->m_Type = ITEM_TICK;
+			if(dt < 0)
+			{
+				str_format(m_aError, sizeof(m_aError), "invalid tick skip dt=%d", dt);
+				return false;
+			}
+			break;
+		}
+		case TEEHISTORIAN_PLAYER_NEW:
+		case TEEHISTORIAN_PLAYER_OLD:
+		{
+			int ClientID = m_Unpacker.GetInt();
+			if(ClientID < 0 || ClientID >= MAX_CLIENTS)
+			{
+				str_format(m_aError, sizeof(m_aError), "invalid player cid=%d", ClientID);
+				return false;
+			}
+			CReaderPlayer *pPlayer = &m_aPlayers[ClientID];
+			if(-Kind == TEEHISTORIAN_PLAYER_NEW)
+			{
+				pPlayer->m_Alive = true;
+				pPlayer->m_X = m_Unpacker.GetInt();
+				pPlayer->m_Y = m_Unpacker.GetInt();
+				pItem->m_Type = ITEM_PLAYER;
+				pItem->m_X = pPlayer->m_X;
+				pItem->m_Y = pPlayer->m_Y;
+			}
+			else
+			{
+				pPlayer->m_Alive = false;
+				pItem->m_Type = ITEM_PLAYER_DEAD;
+			}
+			pItem->m_ClientID = ClientID;
+			IsPlayerRecord = true;
+			break;
+		}
+		case TEEHISTORIAN_INPUT_DIFF:
+		case TEEHISTORIAN_INPUT_NEW:
+		{
+			int ClientID = m_Unpacker.GetInt();
+			if(ClientID < 0 || ClientID >= MAX_CLIENTS)
+			{
+				str_format(m_aError, sizeof(m_aError), "invalid input cid=%d", ClientID);
+				return false;
+			}
+			CReaderPlayer *pPlayer = &m_aPlayers[ClientID];
+			int aData[sizeof(CNetObj_PlayerInput) / sizeof(int32_t)];
+			for(int &Data : aData)
+			{
+				Data = m_Unpacker.GetInt();
+			}
+			if(-Kind == TEEHISTORIAN_INPUT_DIFF)
+			{
+				if(!pPlayer->m_HaveInput)
+				{
+					str_format(m_aError, sizeof(m_aError), "input diff without previous input cid=%d", ClientID);
+					return false;
+				}
+				int *pInput = (int *)&pPlayer->m_Input;
+				for(size_t i = 0; i < std::size(aData); i++)
+				{
+					// addition with wrapping by casting to unsigned
+					pInput[i] = (unsigned)pInput[i] + (unsigned)aData[i];
+				}
+			}
+			else
+			{
+				mem_copy(&pPlayer->m_Input, aData, sizeof(pPlayer->m_Input));
+			}
+			pPlayer->m_HaveInput = true;
+			pItem->m_Type = ITEM_INPUT;
+			pItem->m_ClientID = ClientID;
+			pItem->m_Input = pPlayer->m_Input;
+			break;
+		}
+		case TEEHISTORIAN_MESSAGE:
+		{
+			pItem->m_Type = ITEM_MESSAGE;
+			pItem->m_ClientID = m_Unpacker.GetInt();
+			pItem->m_DataSize = m_Unpacker.GetInt();
+			pItem->m_pData = m_Unpacker.GetRaw(pItem->m_DataSize);
+			break;
+		}
+		case TEEHISTORIAN_JOIN:
+			pItem->m_Type = ITEM_JOIN;
+			pItem->m_ClientID = m_Unpacker.GetInt();
+			pItem->m_Protocol = m_NextJoinProtocol;
+			m_NextJoinProtocol = CTeeHistorian::PROTOCOL_6;
+			break;
+		case TEEHISTORIAN_DROP:
+			pItem->m_Type = ITEM_DROP;
+			pItem->m_ClientID = m_Unpacker.GetInt();
+			pItem->m_pString = m_Unpacker.GetString(0);
+			break;
+		case TEEHISTORIAN_CONSOLE_COMMAND:
+		{
+			pItem->m_Type = ITEM_CONSOLE_COMMAND;
+			pItem->m_ClientID = m_Unpacker.GetInt();
+			pItem->m_FlagMask = m_Unpacker.GetInt();
+			pItem->m_pString = m_Unpacker.GetString(0);
+			int NumArgs = m_Unpacker.GetInt();
+			pItem->m_NumArgs = 0;
+			for(int i = 0; i < NumArgs && !m_Unpacker.Error(); i++)
+			{
+				const char *pArg = m_Unpacker.GetString(0);
+				if(i < MAX_CONSOLE_ARGS)
+				{
+					pItem->m_apArgs[pItem->m_NumArgs++] = pArg;
+				}
+			}
+			break;
+		}
+		case TEEHISTORIAN_EX:
+		{
+			const CUuid *pUuid = (const CUuid *)m_Unpacker.GetRaw(sizeof(CUuid));
+			int Size = m_Unpacker.GetInt();
+			const unsigned char *pData = m_Unpacker.GetRaw(Size);
+			if(m_Unpacker.Error())
+			{
+				break;
+			}
+			pItem->m_Type = ITEM_EX;
+			pItem->m_Uuid = *pUuid;
+			pItem->m_pData = pData;
+			pItem->m_DataSize = Size;
+
+			CUnpacker Ex;
+			Ex.Reset(pData, Size);
+			if(*pUuid == UUID_TEEHISTORIAN_JOINVER6 || *pUuid == UUID_TEEHISTORIAN_JOINVER7)
+			{
+				m_NextJoinProtocol = *pUuid == UUID_TEEHISTORIAN_JOINVER6 ? CTeeHistorian::PROTOCOL_6 : CTeeHistorian::PROTOCOL_7;
+			}
+			else if(*pUuid == UUID_TEEHISTORIAN_PLAYER_READY || *pUuid == UUID_TEEHISTORIAN_PLAYER_REJOIN)
+			{
+				int ClientID = Ex.GetInt();
+				if(!Ex.Error())
+				{
+					pItem->m_Type = *pUuid == UUID_TEEHISTORIAN_PLAYER_READY ? ITEM_PLAYER_READY : ITEM_PLAYER_REJOIN;
+					pItem->m_ClientID = ClientID;
+				}
+			}
+			break;
+		}
+		default:
+			str_format(m_aError, sizeof(m_aError), "unknown item kind %d", Kind);
+			return false;
+		}
+	}
+
+	if(m_Unpacker.Error())
+	{
+		str_copy(m_aError, "unexpected end of data");
+		return false;
+	}
+	int MinClientID = pItem->m_Type == ITEM_CONSOLE_COMMAND || pItem->m_Type == ITEM_EX || pItem->m_Type == ITEM_TICK || pItem->m_Type == ITEM_FINISH ? -1 : 0;
+	if(pItem->m_ClientID < MinClientID || pItem->m_ClientID >= MAX_CLIENTS)
+	{
+		str_format(m_aError, sizeof(m_aError), "invalid cid=%d", pItem->m_ClientID);
+		return false;
+	}
+
+	if(IsPlayerRecord)
+	{
+		if(PlayerRecord(pItem->m_ClientID))
+		{
+			m_TickPending = true;
+		}
+	}
+	else if(pItem->m_Type != ITEM_TICK && pItem->m_Type != ITEM_FINISH)
+	{
+		m_InInputs = true;
+	}
+	pItem->m_Tick = m_Tick;
+	return true;
+}
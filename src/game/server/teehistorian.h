@@ -3,11 +3,14 @@
 
 #include <base/hash.h>
 #include <engine/console.h>
+#include <engine/shared/packer.h>
 #include <engine/shared/protocol.h>
 #include <game/generated/protocol.h>
 
 #include <ctime>
+#include <vector>
 
+typedef struct _json_value json_value;
 class CConfig;
 class CTuningParams;
 class CUuidManager;
@@ -144,4 +147,104 @@ private:
 	CTeam m_aPrevTeams[MAX_CLIENTS];
 };
 
+class CTeeHistorianReader
+{
+public:
+	enum
+	{
+		ITEM_TICK,
+		ITEM_PLAYER,
+		ITEM_PLAYER_DEAD,
+		ITEM_INPUT,
+		ITEM_MESSAGE,
+		ITEM_JOIN,
+		ITEM_PLAYER_READY,
+		ITEM_PLAYER_REJOIN,
+		ITEM_DROP,
+		ITEM_CONSOLE_COMMAND,
+		ITEM_EX,
+		ITEM_FINISH,
+	};
+
+	enum
+	{
+		MAX_CONSOLE_ARGS = 16,
+	};
+
+	// Pointers point into the data passed to `Open`, they stay valid as long
+	// as that data does.
+	struct CItem
+	{
+		int m_Type;
+		int m_Tick;
+		int m_ClientID;
+
+		// ITEM_PLAYER
+		int m_X;
+		int m_Y;
+
+		// ITEM_INPUT, the full input with the diff already applied
+		CNetObj_PlayerInput m_Input;
+
+		// ITEM_JOIN, one of `CTeeHistorian::PROTOCOL_*`
+		int m_Protocol;
+
+		// ITEM_DROP: reason, ITEM_CONSOLE_COMMAND: command name
+		const char *m_pString;
+
+		// ITEM_CONSOLE_COMMAND
+		int m_FlagMask;
+		int m_NumArgs;
+		const char *m_apArgs[MAX_CONSOLE_ARGS];
+
+		// ITEM_MESSAGE, ITEM_EX
+		CUuid m_Uuid;
+		const void *m_pData;
+		int m_DataSize;
+	};
+
+	CTeeHistorianReader();
+	~CTeeHistorianReader();
+
+	// Parses the header, returns false and sets `Error()` if the data is not
+	// a teehistorian file.
+	bool Open(const void *pData, int DataSize);
+	// Returns false once the file is finished or on error.
+	bool Read(CItem *pItem);
+
+	// The parsed JSON header, see `CTeeHistorian::WriteHeader`.
+	const json_value *Header() const { return m_pHeader; }
+	const char *HeaderString(const char *pKey) const;
+	const char *Error() const { return m_aError; }
+	int Tick() const { return m_Tick; }
+
+private:
+	bool ReadItem(CItem *pItem);
+	bool PlayerRecord(int ClientID);
+
+	const unsigned char *m_pData;
+	int m_DataSize;
+	CUnpacker m_Unpacker;
+	json_value *m_pHeader;
+	char m_aError[128];
+
+	bool m_Finished;
+	int m_Tick;
+	int m_LastPlayerClientID;
+	bool m_InInputs;
+	bool m_TickPending;
+	CItem m_PendingItem;
+	int m_NextJoinProtocol;
+
+	struct CReaderPlayer
+	{
+		bool m_Alive;
+		int m_X;
+		int m_Y;
+		bool m_HaveInput;
+		CNetObj_PlayerInput m_Input;
+	};
+	CReaderPlayer m_aPlayers[MAX_CLIENTS];
+};
+
 #endif // GAME_SERVER_TEEHISTORIAN_H
@@ -0,0 +1,41 @@
+#include "teleouts.h"
+
+#include <game/mapitems.h>
+
+CTeleOuts::CTeleOuts()
+{
+	Clear();
+}
+
+void CTeleOuts::Clear()
+{
+	for(int &Start : m_aStart)
+		Start = 0;
+	m_vPositions.clear();
+}
+
+void CTeleOuts::Init(const CTeleTile *pTiles, int Width, int Height, int Type)
+{
+	Clear();
+
+	// counting sort by number, keeping the map order of the exits with the
+	// same number
+	int aCount[NUM_INDICES] = {0};
+	for(int i = 0; i < Width * Height; i++)
+	{
+		if(pTiles[i].m_Number > 0 && pTiles[i].m_Type == Type)
+			aCount[pTiles[i].m_Number - 1]++;
+	}
+	for(int Index = 0; Index < NUM_INDICES; Index++)
+		m_aStart[Index + 1] = m_aStart[Index] + aCount[Index];
+
+	m_vPositions.resize(m_aStart[NUM_INDICES]);
+	int aNext[NUM_INDICES];
+	for(int Index = 0; Index < NUM_INDICES; Index++)
+		aNext[Index] = m_aStart[Index];
+	for(int i = 0; i < Width * Height; i++)
+	{
+		if(pTiles[i].m_Number > 0 && pTiles[i].m_Type == Type)
+			m_vPositions[aNext[pTiles[i].m_Number - 1]++] = vec2(i % Width * 32.0f + 16.0f, i / Width * 32.0f + 16.0f);
+	}
+}
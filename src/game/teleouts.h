@@ -0,0 +1,60 @@
+#ifndef GAME_TELEOUTS_H
+#define GAME_TELEOUTS_H
+
+#include <base/vmath.h>
+
+#include <vector>
+
+class CTeleTile;
+
+// The exits of all teleporters of one kind (e.g. TILE_TELEOUT) in a map,
+// grouped by teleporter number. Built once when the map is loaded and only
+// read afterwards, the exits of all numbers share one buffer.
+class CTeleOuts
+{
+public:
+	enum
+	{
+		// teleporter numbers are 1 to 255, indices are the number minus one
+		NUM_INDICES = 256,
+	};
+
+	class CSpan
+	{
+		const vec2 *m_pData;
+		int m_Size;
+
+	public:
+		CSpan(const vec2 *pData, int Size) :
+			m_pData(pData), m_Size(Size) {}
+		bool empty() const { return m_Size == 0; }
+		int size() const { return m_Size; }
+		const vec2 &operator[](int Index) const { return m_pData[Index]; }
+		const vec2 *begin() const { return m_pData; }
+		const vec2 *end() const { return m_pData + m_Size; }
+	};
+
+	CTeleOuts();
+
+	// Collects the positions of the tiles of type `Type` from the given
+	// tele layer, replacing the previous contents.
+	void Init(const CTeleTile *pTiles, int Width, int Height, int Type);
+	void Clear();
+
+	// Exits of the teleporter with the number `Index + 1`, empty for
+	// numbers without exits and out of range indices.
+	CSpan operator[](int Index) const
+	{
+		if(Index < 0 || Index >= NUM_INDICES)
+			return CSpan(nullptr, 0);
+		return CSpan(m_vPositions.data() + m_aStart[Index], m_aStart[Index + 1] - m_aStart[Index]);
+	}
+
+private:
+	// exits of index i are `m_vPositions[m_aStart[i]]` to
+	// `m_vPositions[m_aStart[i + 1] - 1]`
+	int m_aStart[NUM_INDICES + 1];
+	std::vector<vec2> m_vPositions;
+};
+
+#endif
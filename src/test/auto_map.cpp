@@ -0,0 +1,356 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/linereader.h>
+#include <game/editor/auto_map_rules.h>
+#include <game/mapitems.h>
+#include <test/test.h>
+
+#include <random>
+#include <set>
+#include <vector>
+
+static uint32_t HashUInt32(uint32_t Num)
+{
+	Num++;
+	Num ^= Num >> 17;
+	Num *= 0xed5ad4bbu;
+	Num ^= Num >> 11;
+	Num *= 0xac4c1b51u;
+	Num ^= Num >> 15;
+	Num *= 0x31848babu;
+	Num ^= Num >> 14;
+	return Num;
+}
+
+#define HASH_MAX 65536
+
+static int HashLocation(uint32_t Seed, uint32_t Run, uint32_t Rule, uint32_t X, uint32_t Y)
+{
+	const uint32_t Prime = 31;
+	uint32_t Hash = 1;
+	Hash = Hash * Prime + HashUInt32(Seed);
+	Hash = Hash * Prime + HashUInt32(Run);
+	Hash = Hash * Prime + HashUInt32(Rule);
+	Hash = Hash * Prime + HashUInt32(X);
+	Hash = Hash * Prime + HashUInt32(Y);
+	Hash = HashUInt32(Hash * Prime);
+	return Hash % HASH_MAX;
+}
+
+// The implementation of CAutoMapRules::Proceed that checks every rule for
+// every tile.
+static void ReferenceProceed(const CAutoMapRules &Rules, CTile *pTiles, int Width, int Height, int ConfigID, int Seed, int SeedOffsetX, int SeedOffsetY, std::vector<unsigned char> &vChanged)
+{
+	const CAutoMapRules::CConfiguration *pConf = &Rules.Configs()[ConfigID];
+	vChanged.assign(Width * Height, 0);
+
+	for(size_t h = 0; h < pConf->m_vRuns.size(); ++h)
+	{
+		const CAutoMapRules::CRun *pRun = &pConf->m_vRuns[h];
+
+		std::vector<CTile> vCopy;
+		const CTile *pReadTiles = pTiles;
+		if(pRun->m_AutomapCopy)
+		{
+			vCopy.assign(pTiles, pTiles + Width * Height);
+			pReadTiles = vCopy.data();
+		}
+
+		for(int y = 0; y < Height; y++)
+		{
+			for(int x = 0; x < Width; x++)
+			{
+				CTile *pTile = &pTiles[y * Width + x];
+
+				for(size_t i = 0; i < pRun->m_vIndexRules.size(); ++i)
+				{
+					const CAutoMapRules::CIndexRule *pIndexRule = &pRun->m_vIndexRules[i];
+					if(pIndexRule->m_SkipEmpty && pTile->m_Index == 0)
+						continue;
+					if(pIndexRule->m_SkipFull && pTile->m_Index != 0)
+						continue;
+
+					bool RespectRules = true;
+					for(size_t j = 0; j < pIndexRule->m_vRules.size() && RespectRules; ++j)
+					{
+						const CAutoMapRules::CPosRule *pRule = &pIndexRule->m_vRules[j];
+
+						int CheckIndex, CheckFlags;
+						int CheckX = x + pRule->m_X;
+						int CheckY = y + pRule->m_Y;
+						if(CheckX >= 0 && CheckX < Width && CheckY >= 0 && CheckY < Height)
+						{
+							int CheckTile = CheckY * Width + CheckX;
+							CheckIndex = pReadTiles[CheckTile].m_Index;
+							CheckFlags = pReadTiles[CheckTile].m_Flags & (TILEFLAG_ROTATE | TILEFLAG_XFLIP | TILEFLAG_YFLIP);
+						}
+						else
+						{
+							CheckIndex = -1;
+							CheckFlags = 0;
+						}
+
+						if(pRule->m_Value == CAutoMapRules::CPosRule::INDEX)
+						{
+							RespectRules = false;
+							for(const auto &Index : pRule->m_vIndexList)
+							{
+								if(CheckIndex == Index.m_ID && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
+								{
+									RespectRules = true;
+									break;
+								}
+							}
+						}
+						else if(pRule->m_Value == CAutoMapRules::CPosRule::NOTINDEX)
+						{
+							for(const auto &Index : pRule->m_vIndexList)
+							{
+								if(CheckIndex == Index.m_ID && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
+								{
+									RespectRules = false;
+									break;
+								}
+							}
+						}
+					}
+
+					if(RespectRules &&
+						(pIndexRule->m_RandomProbability >= 1.0f || HashLocation(Seed, h, i, x + SeedOffsetX, y + SeedOffsetY) < HASH_MAX * pIndexRule->m_RandomProbability))
+					{
+						pTile->m_Index = pIndexRule->m_ID;
+						pTile->m_Flags = pIndexRule->m_Flag;
+						vChanged[y * Width + x] = 1;
+					}
+				}
+			}
+		}
+	}
+}
+
+static bool operator==(const CTile &Lhs, const CTile &Rhs)
+{
+	return Lhs.m_Index == Rhs.m_Index && Lhs.m_Flags == Rhs.m_Flags && Lhs.m_Skip == Rhs.m_Skip && Lhs.m_Reserved == Rhs.m_Reserved;
+}
+
+// Automaps the tiles with both implementations and returns the number of
+// changed tiles.
+static int ExpectMatchesReference(const CAutoMapRules &Rules, int ConfigID, const std::vector<CTile> &vTiles, int Width, int Height, std::mt19937 &Rng, const char *pName)
+{
+	const int Seed = 1 + Rng() % 1000;
+	const int SeedOffsetX = Rng() % 100;
+	const int SeedOffsetY = Rng() % 100;
+	std::vector<CTile> vExpected = vTiles;
+	std::vector<unsigned char> vExpectedChanged;
+	ReferenceProceed(Rules, vExpected.data(), Width, Height, ConfigID, Seed, SeedOffsetX, SeedOffsetY, vExpectedChanged);
+
+	for(int NumThreads : {1, 3})
+	{
+		std::vector<CTile> vActual = vTiles;
+		std::vector<unsigned char> vActualChanged;
+		Rules.Proceed(vActual.data(), Width, Height, ConfigID, Seed, SeedOffsetX, SeedOffsetY, &vActualChanged, NumThreads);
+		EXPECT_EQ(vExpected, vActual) << pName << " " << Rules.Configs()[ConfigID].m_aName << " threads " << NumThreads;
+		EXPECT_EQ(vExpectedChanged, vActualChanged) << pName << " " << Rules.Configs()[ConfigID].m_aName << " threads " << NumThreads;
+	}
+
+	int NumChanged = 0;
+	for(unsigned char Changed : vExpectedChanged)
+		NumChanged += Changed;
+	return NumChanged;
+}
+
+static void LoadRules(CAutoMapRules &Rules, const char *pPath)
+{
+	IOHANDLE File = io_open(pPath, IOFLAG_READ | IOFLAG_SKIP_BOM);
+	ASSERT_TRUE(File) << pPath;
+	CLineReader LineReader;
+	LineReader.Init(File);
+	Rules.Load(LineReader);
+	io_close(File);
+}
+
+TEST(AutoMap, MatchesReference)
+{
+	const char *apRuleFiles[] = {
+		"basic_freeze",
+		"ddmax_freeze",
+		"ddnet_tiles",
+		"ddnet_walls",
+		"desert_main",
+		"fadeout",
+		"generic_clear",
+		"generic_unhookable",
+		"generic_unhookable_0.7",
+		"grass_main",
+		"grass_main_0.7",
+		"jungle_main",
+		"jungle_midground",
+		"round_tiles",
+		"water",
+		"winter_main",
+	};
+
+	// large enough to be automapped on several threads
+	const int Width = 130;
+	const int Height = 128;
+	static_assert(Width * Height >= CAutoMapRules::PARALLEL_MIN_TILES);
+
+	int NumChanged = 0;
+	for(const char *pRuleFile : apRuleFiles)
+	{
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "data/editor/automap/%s.rules", pRuleFile);
+		CAutoMapRules Rules;
+		LoadRules(Rules, aPath);
+		EXPECT_FALSE(Rules.Configs().empty()) << aPath;
+
+		// the indices the rules look for, so that they actually apply
+		std::set<int> Indices = {0, 1};
+		for(const auto &Config : Rules.Configs())
+			for(const auto &Run : Config.m_vRuns)
+				for(const auto &IndexRule : Run.m_vIndexRules)
+					for(const auto &Rule : IndexRule.m_vRules)
+						for(const auto &Index : Rule.m_vIndexList)
+							if(Index.m_ID >= 0 && Index.m_ID < 256)
+								Indices.insert(Index.m_ID);
+		const std::vector<int> vIndices(Indices.begin(), Indices.end());
+
+		for(int ConfigID = 0; ConfigID < (int)Rules.Configs().size(); ConfigID++)
+		{
+			std::mt19937 Rng(ConfigID);
+			std::vector<CTile> vTiles(Width * Height, CTile{});
+			// blocks of solid tiles with other tiles sprinkled in
+			for(int i = 0; i < 60; i++)
+			{
+				const int x0 = Rng() % Width, y0 = Rng() % Height;
+				const int x1 = minimum(Width, x0 + 2 + (int)(Rng() % 20)), y1 = minimum(Height, y0 + 2 + (int)(Rng() % 12));
+				for(int y = y0; y < y1; y++)
+					for(int x = x0; x < x1; x++)
+						vTiles[y * Width + x].m_Index = 1;
+			}
+			for(auto &Tile : vTiles)
+			{
+				if(Rng() % 8 == 0)
+				{
+					Tile.m_Index = vIndices[Rng() % vIndices.size()];
+					Tile.m_Flags = Rng() % 16;
+				}
+				Tile.m_Skip = Rng() % 2;
+			}
+
+			NumChanged += ExpectMatchesReference(Rules, ConfigID, vTiles, Width, Height, Rng, pRuleFile);
+		}
+	}
+	EXPECT_GT(NumChanged, 0);
+}
+
+TEST(AutoMap, NoLayerCopy)
+{
+	CTestInfo Info;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	// without a copy, the rules see the tiles changed by earlier rules,
+	// including earlier rules on the same tile
+	const char aRules[] =
+		"[Chain]\n"
+		"NoLayerCopy\n"
+		"Index 2\n"
+		"Pos 0 0 INDEX 1\n"
+		"Pos 1 0 INDEX 1 OR 2\n"
+		"Index 3 XFLIP\n"
+		"Pos 0 0 INDEX 2\n"
+		"Pos 0 1 NOTINDEX 4 ROTATE\n"
+		"Index 4\n"
+		"Pos -1 0 INDEX 3 XFLIP\n"
+		"Random 50%\n"
+		"Index 1\n"
+		"Pos 0 0 INDEX 4\n"
+		"Pos 0 -1 FULL\n"
+		"Index 0\n"
+		"Pos 0 0 INDEX 4\n"
+		"Pos 1 0 EMPTY\n"
+		"Index 5\n"
+		"Pos 0 0 EMPTY\n"
+		"Pos 0 1 FULL\n"
+		"Random 2\n"
+		"Index 7\n"
+		"Pos -1 0 EMPTY\n"
+		"Pos 1 1 FULL\n"
+		"Random 3\n"
+		"NewRun\n"
+		"Index 5 ROTATE\n"
+		"Pos 0 0 INDEX 3 OR 4\n"
+		"Pos 0 -1 EMPTY\n"
+		"Index 6\n"
+		"Pos 0 0 EMPTY\n"
+		"Pos 0 1 INDEX -1 OR 1\n";
+	io_write(File, aRules, str_length(aRules));
+	io_close(File);
+
+	CAutoMapRules Rules;
+	LoadRules(Rules, Info.m_aFilename);
+	fs_remove(Info.m_aFilename);
+	ASSERT_EQ(Rules.Configs().size(), 1u);
+
+	const int Width = 140;
+	const int Height = 130;
+	std::mt19937 Rng(0);
+	int NumChanged = 0;
+	for(int i = 0; i < 4; i++)
+	{
+		std::vector<CTile> vTiles(Width * Height, CTile{});
+		for(auto &Tile : vTiles)
+		{
+			Tile.m_Index = Rng() % 3 ? Rng() % 5 : 0;
+			Tile.m_Flags = Rng() % 4 ? 0 : Rng() % 16;
+		}
+		NumChanged += ExpectMatchesReference(Rules, 0, vTiles, Width, Height, Rng, "chain");
+	}
+	EXPECT_GT(NumChanged, 0);
+}
+
+TEST(AutoMap, ProceedTime)
+{
+	// a large layer of blocks, automapped with a bundled rules file
+	CAutoMapRules Rules;
+	LoadRules(Rules, "data/editor/automap/grass_main.rules");
+	ASSERT_FALSE(Rules.Configs().empty());
+
+	const int Width = 300;
+	const int Height = 300;
+	std::mt19937 Rng(0);
+	std::vector<CTile> vTiles(Width * Height, CTile{});
+	for(int i = 0; i < 700; i++)
+	{
+		const int x0 = Rng() % Width, y0 = Rng() % Height;
+		const int x1 = minimum(Width, x0 + 2 + (int)(Rng() % 30)), y1 = minimum(Height, y0 + 2 + (int)(Rng() % 15));
+		for(int y = y0; y < y1; y++)
+			for(int x = x0; x < x1; x++)
+				vTiles[y * Width + x].m_Index = 1;
+	}
+
+	for(int ConfigID = 0; ConfigID < (int)Rules.Configs().size(); ConfigID++)
+	{
+		auto &&Measure = [&](auto &&Proceed) {
+			std::vector<CTile> vAutomapped = vTiles;
+			const int64_t Start = time_get();
+			Proceed(vAutomapped.data());
+			return (time_get() - Start) * 1000 / time_freq();
+		};
+		char aName[64];
+		str_format(aName, sizeof(aName), "Config%dReferenceMs", ConfigID);
+		RecordProperty(aName, (int)Measure([&](CTile *pTiles) {
+			std::vector<unsigned char> vChanged;
+			ReferenceProceed(Rules, pTiles, Width, Height, ConfigID, 1, 0, 0, vChanged);
+		}));
+		str_format(aName, sizeof(aName), "Config%dOneThreadMs", ConfigID);
+		RecordProperty(aName, (int)Measure([&](CTile *pTiles) {
+			Rules.Proceed(pTiles, Width, Height, ConfigID, 1, 0, 0, nullptr, 1);
+		}));
+		str_format(aName, sizeof(aName), "Config%dAllThreadsMs", ConfigID);
+		RecordProperty(aName, (int)Measure([&](CTile *pTiles) {
+			Rules.Proceed(pTiles, Width, Height, ConfigID, 1);
+		}));
+	}
+}
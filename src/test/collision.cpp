@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <test/test.h>
+
+#include <random>
+#include <vector>
+
+// The step-by-step implementation of CCollision::MoveBox that tests the box
+// after every step.
+static void ReferenceMoveBox(const CCollision &Collision, vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elasticity, bool *pGrounded)
+{
+	vec2 Pos = *pInoutPos;
+	vec2 Vel = *pInoutVel;
+
+	float Distance = length(Vel);
+	int Max = (int)Distance;
+
+	if(Distance > 0.00001f)
+	{
+		float Fraction = 1.0f / (float)(Max + 1);
+		float ElasticityX = clamp(Elasticity.x, -1.0f, 1.0f);
+		float ElasticityY = clamp(Elasticity.y, -1.0f, 1.0f);
+
+		for(int i = 0; i <= Max; i++)
+		{
+			if(Vel == vec2(0, 0))
+				break;
+
+			vec2 NewPos = Pos + Vel * Fraction;
+			if(NewPos == Pos)
+				break;
+
+			if(Collision.TestBox(vec2(NewPos.x, NewPos.y), Size))
+			{
+				int Hits = 0;
+
+				if(Collision.TestBox(vec2(Pos.x, NewPos.y), Size))
+				{
+					if(pGrounded && ElasticityY > 0 && Vel.y > 0)
+						*pGrounded = true;
+					NewPos.y = Pos.y;
+					Vel.y *= -ElasticityY;
+					Hits++;
+				}
+
+				if(Collision.TestBox(vec2(NewPos.x, Pos.y), Size))
+				{
+					NewPos.x = Pos.x;
+					Vel.x *= -ElasticityX;
+					Hits++;
+				}
+
+				if(Hits == 0)
+				{
+					if(pGrounded && ElasticityY > 0 && Vel.y > 0)
+						*pGrounded = true;
+					NewPos.y = Pos.y;
+					Vel.y *= -ElasticityY;
+					NewPos.x = Pos.x;
+					Vel.x *= -ElasticityX;
+				}
+			}
+
+			Pos = NewPos;
+		}
+	}
+
+	*pInoutPos = Pos;
+	*pInoutVel = Vel;
+}
+
+// Fills the map with `Density` percent solid tiles and some freeze, with a solid
+// top and left border.
+static void RandomMap(CTestMap &Map, int Density, std::mt19937 &Rng)
+{
+	for(int y = 0; y < Map.Height(); y++)
+	{
+		for(int x = 0; x < Map.Width(); x++)
+		{
+			if(x == 0 || y == 0 || (int)(Rng() % 100) < Density)
+				Map.Tile(x, y).m_Index = Rng() % 4 ? TILE_SOLID : TILE_NOHOOK;
+			else if(Rng() % 20 == 0)
+				Map.Tile(x, y).m_Index = TILE_FREEZE;
+		}
+	}
+}
+
+TEST(Collision, MoveBoxMatchesStepping)
+{
+	std::mt19937 Rng(0);
+	std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+	for(int Density : {0, 2, 10, 35})
+	{
+		CTestMap Map(80, 50);
+		RandomMap(Map, Density, Rng);
+		CLayers Layers;
+		Layers.InitBackground(&Map);
+		CCollision Collision;
+		Collision.Init(&Layers);
+
+		for(int i = 0; i < 4000; i++)
+		{
+			// partly outside of the map, where the border tiles repeat
+			const vec2 Pos = vec2((Unit(Rng) * 1.2f - 0.1f) * Map.Width() * 32.0f, (Unit(Rng) * 1.2f - 0.1f) * Map.Height() * 32.0f);
+			// from standing still to the velocity limit of characters
+			const float Speed = std::pow(6000.0f, Unit(Rng)) - 1.0f;
+			const float Angle = Unit(Rng) * 2.0f * pi;
+			const vec2 Vel = direction(Angle) * Speed;
+			const vec2 Size = i % 3 ? CCharacterCore::PhysicalSizeVec2() : vec2(Unit(Rng) * 64.0f, Unit(Rng) * 64.0f);
+			const vec2 Elasticity = i % 4 ? vec2(0.0f, 0.0f) : vec2(Unit(Rng) * 3.0f - 1.5f, Unit(Rng) * 3.0f - 1.5f);
+
+			vec2 ExpectedPos = Pos;
+			vec2 ExpectedVel = Vel;
+			bool ExpectedGrounded = false;
+			ReferenceMoveBox(Collision, &ExpectedPos, &ExpectedVel, Size, Elasticity, &ExpectedGrounded);
+
+			vec2 ActualPos = Pos;
+			vec2 ActualVel = Vel;
+			bool ActualGrounded = false;
+			Collision.MoveBox(&ActualPos, &ActualVel, Size, Elasticity, &ActualGrounded);
+
+			ASSERT_EQ(mem_comp(&ExpectedPos, &ActualPos, sizeof(vec2)), 0) << "density " << Density << " case " << i;
+			ASSERT_EQ(mem_comp(&ExpectedVel, &ActualVel, sizeof(vec2)), 0) << "density " << Density << " case " << i;
+			ASSERT_EQ(ExpectedGrounded, ActualGrounded) << "density " << Density << " case " << i;
+		}
+	}
+}
+
+TEST(Collision, MoveBoxTime)
+{
+	// characters at different speeds on dense maps
+	const int NumMoves = 5000;
+	for(int Density : {2, 10, 35})
+	{
+		std::mt19937 Rng(Density);
+		std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+		CTestMap Map(200, 200);
+		RandomMap(Map, Density, Rng);
+		CLayers Layers;
+		Layers.InitBackground(&Map);
+		CCollision Collision;
+		Collision.Init(&Layers);
+
+		for(int MaxSpeed : {20, 100, 1000})
+		{
+			std::vector<vec2> vPos, vVel;
+			for(int i = 0; i < NumMoves; i++)
+			{
+				vPos.emplace_back(Unit(Rng) * Map.Width() * 32.0f, Unit(Rng) * Map.Height() * 32.0f);
+				vVel.push_back(direction(Unit(Rng) * 2.0f * pi) * Unit(Rng) * MaxSpeed);
+			}
+
+			auto &&Measure = [&](auto &&MoveBox) {
+				const int64_t Start = time_get();
+				for(int i = 0; i < NumMoves; i++)
+				{
+					vec2 Pos = vPos[i];
+					vec2 Vel = vVel[i];
+					bool Grounded = false;
+					MoveBox(&Pos, &Vel, CCharacterCore::PhysicalSizeVec2(), vec2(0.0f, 0.0f), &Grounded);
+				}
+				return (time_get() - Start) * 1000000000 / time_freq() / NumMoves;
+			};
+			char aName[64];
+			str_format(aName, sizeof(aName), "Solid%dSpeed%dSteppingNs", Density, MaxSpeed);
+			RecordProperty(aName, (int)Measure([&](vec2 *pPos, vec2 *pVel, vec2 Size, vec2 Elasticity, bool *pGrounded) {
+				ReferenceMoveBox(Collision, pPos, pVel, Size, Elasticity, pGrounded);
+			}));
+			str_format(aName, sizeof(aName), "Solid%dSpeed%dMoveBoxNs", Density, MaxSpeed);
+			RecordProperty(aName, (int)Measure([&](vec2 *pPos, vec2 *pVel, vec2 Size, vec2 Elasticity, bool *pGrounded) {
+				Collision.MoveBox(pPos, pVel, Size, Elasticity, pGrounded);
+			}));
+		}
+	}
+}
@@ -1,7 +1,10 @@
 #include "test.h"
 #include <gtest/gtest.h>
 #include <memory>
+#include <random>
+#include <vector>
 
+#include <base/system.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 #include <game/mapitems_ex.h>
@@ -105,3 +108,65 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, ParallelCompression)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	CTestInfo Info;
+
+	// map-like data: a few large, compressible layers and many small items
+	std::mt19937 Rng(0);
+	std::vector<std::vector<int>> vvData;
+	for(int i = 0; i < 40; i++)
+	{
+		std::vector<int> vData(i % 8 == 0 ? 30000 + Rng() % 30000 : 1 + Rng() % 500);
+		for(int &Value : vData)
+			Value = Rng() % 4 == 0 ? Rng() : Rng() % 16;
+		vvData.push_back(std::move(vData));
+	}
+
+	char aaFilenames[3][128];
+	const int aNumThreads[] = {1, 4, 0};
+	for(int i = 0; i < 3; i++)
+	{
+		str_format(aaFilenames[i], sizeof(aaFilenames[i]), "%s-%d", Info.m_aFilename, i);
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), aaFilenames[i]));
+		for(int j = 0; j < (int)vvData.size(); j++)
+		{
+			EXPECT_EQ(Writer.AddData(vvData[j].size() * sizeof(int), vvData[j].data(), j % 3 == 0 ? CDataFileWriter::COMPRESSION_BEST : CDataFileWriter::COMPRESSION_DEFAULT), j);
+			Writer.AddItem(MAPITEMTYPE_TEST, j, sizeof(j), &j);
+		}
+		Writer.Finish(aNumThreads[i]);
+	}
+
+	void *apFiles[3];
+	unsigned aFileSizes[3];
+	for(int i = 0; i < 3; i++)
+		ASSERT_TRUE(pStorage->ReadFile(aaFilenames[i], IStorage::TYPE_SAVE, &apFiles[i], &aFileSizes[i]));
+	for(int i = 1; i < 3; i++)
+	{
+		ASSERT_EQ(aFileSizes[i], aFileSizes[0]);
+		EXPECT_EQ(mem_comp(apFiles[i], apFiles[0], aFileSizes[0]), 0) << "threads " << aNumThreads[i];
+	}
+	for(void *pFile : apFiles)
+		free(pFile);
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), aaFilenames[1], IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), (int)vvData.size());
+		for(int j = 0; j < (int)vvData.size(); j++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(j), (int)(vvData[j].size() * sizeof(int)));
+			EXPECT_EQ(mem_comp(Reader.GetData(j), vvData[j].data(), Reader.GetDataSize(j)), 0) << "data " << j;
+		}
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		for(const auto &aFilename : aaFilenames)
+			pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+	}
+}
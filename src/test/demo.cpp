@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+#include <test/test.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+static const int ITEM_TYPE = 9;
+
+class CRecordingListener : public CDemoPlayer::IListener
+{
+public:
+	std::vector<unsigned char> m_vLastSnapshot;
+	int m_NumSnapshots = 0;
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		const unsigned char *pBytes = static_cast<const unsigned char *>(pData);
+		m_vLastSnapshot.assign(pBytes, pBytes + Size);
+		m_NumSnapshots++;
+	}
+	void OnDemoPlayerMessage(void *pData, int Size) override {}
+};
+
+TEST(Demo, SeekSnapshotCache)
+{
+	CNetBase::Init();
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	auto pStorage = std::unique_ptr<IStorage>(Info.CreateTestStorage());
+	ASSERT_TRUE(pStorage);
+
+	CSnapshotDelta Delta;
+	CSnapshotBuilder Builder;
+	std::map<int, std::vector<unsigned char>> Snapshots;
+	{
+		CDemoRecorder Recorder(&Delta);
+		unsigned char aMapData[4] = {1, 2, 3, 4};
+		ASSERT_EQ(Recorder.Start(pStorage.get(), nullptr, "seek.demo", "0.6 test", "test", SHA256_ZEROED, 0, "client", sizeof(aMapData), aMapData), 0);
+
+		std::mt19937 Rng(0);
+		int Tick = 100;
+		for(int i = 0; i < 2000; i++)
+		{
+			// gaps larger than a compressed tick marker can hold
+			Tick += i % 300 == 299 ? 40 : 1;
+			Builder.Init();
+			for(int ID = 0; ID < 4; ID++)
+			{
+				int *pItem = static_cast<int *>(Builder.NewItem(ITEM_TYPE, ID, 2 * sizeof(int)));
+				ASSERT_TRUE(pItem);
+				// some items stay the same over many ticks
+				pItem[0] = ID == 0 ? Tick : Tick / 100;
+				pItem[1] = ID * (int)(Rng() % 3);
+			}
+			alignas(CSnapshot) char aData[CSnapshot::MAX_SIZE];
+			const int Size = Builder.Finish(aData);
+			Recorder.RecordSnapshot(Tick, aData, Size);
+			Snapshots[Tick].assign(aData, aData + Size);
+		}
+		Recorder.Stop(IDemoRecorder::EStopMode::KEEP_FILE);
+	}
+
+	CDemoPlayer Player(&Delta, false);
+	CRecordingListener Listener;
+	Player.SetListener(&Listener);
+	ASSERT_EQ(Player.Load(pStorage.get(), nullptr, "seek.demo", IStorage::TYPE_SAVE), 0);
+	Player.Play();
+	ASSERT_TRUE(Player.IsPlaying()) << Player.ErrorMessage();
+	const int FirstTick = Player.BaseInfo()->m_FirstTick;
+	const int LastTick = Player.BaseInfo()->m_LastTick;
+	EXPECT_EQ(FirstTick, Snapshots.begin()->first);
+	EXPECT_EQ(LastTick, Snapshots.rbegin()->first);
+
+	auto CheckSeek = [&](int WantedTick, int MaxSnapshots) {
+		Listener.m_NumSnapshots = 0;
+		ASSERT_EQ(Player.SetPos(WantedTick), 0);
+		const int CurrentTick = Player.BaseInfo()->m_CurrentTick;
+		ASSERT_TRUE(Snapshots.count(CurrentTick)) << "wanted " << WantedTick << " current " << CurrentTick;
+		EXPECT_EQ(Listener.m_vLastSnapshot, Snapshots[CurrentTick]) << "wanted " << WantedTick;
+		EXPECT_LE(Listener.m_NumSnapshots, MaxSnapshots) << "wanted " << WantedTick;
+	};
+
+	// cold seeks go back to the key frames that are up to 5 seconds apart
+	std::mt19937 Rng(1);
+	for(int i = 0; i < 20; i++)
+		CheckSeek(FirstTick + Rng() % (LastTick - FirstTick + 1), 6 * SERVER_TICK_SPEED);
+
+	// playing the whole demo remembers the snapshots at the seek points
+	CheckSeek(FirstTick, 6 * SERVER_TICK_SPEED);
+	Player.Unpause();
+	Player.Update(/* RealTime */ false);
+	EXPECT_TRUE(Player.BaseInfo()->m_Paused);
+
+	// warm seeks only replay the ticks since the closest seek point
+	for(int i = 0; i < 200; i++)
+		CheckSeek(FirstTick + Rng() % (LastTick - FirstTick + 1), SERVER_TICK_SPEED);
+	CheckSeek(FirstTick, SERVER_TICK_SPEED);
+	CheckSeek(LastTick, SERVER_TICK_SPEED);
+
+	Player.Stop();
+}
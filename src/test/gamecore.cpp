@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/teamscore.h>
+#include <test/test.h>
+
+#include <random>
+#include <vector>
+
+class CTestWorld
+{
+public:
+	CWorldCore m_World;
+	CTeamsCore m_Teams;
+	CCharacterCore m_aCores[MAX_CLIENTS] = {};
+
+	CTestWorld(CCollision *pCollision, bool BroadPhase)
+	{
+		m_World.m_BroadPhase = BroadPhase;
+		std::mt19937 Rng(0);
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			CCharacterCore &Core = m_aCores[i];
+			Core.Init(&m_World, pCollision, &m_Teams);
+			Core.Reset();
+			Core.m_Id = i;
+			// crowded, some of them fast enough to pass through others
+			Core.m_Pos = vec2(32.0f * (40 + Rng() % 40), 32.0f * (8 + Rng() % 40));
+			if(i % 4 == 0)
+				Core.m_Vel = vec2((float)(Rng() % 200) - 100.0f, (float)(Rng() % 200) - 100.0f);
+			Core.m_Solo = i % 17 == 16;
+			Core.m_Super = i == 5;
+			if(i % 9 == 8)
+				m_Teams.Team(i, 1);
+			m_World.m_apCharacters[i] = &Core;
+		}
+	}
+
+	void Tick(const CNetObj_PlayerInput *pInputs)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			m_aCores[i].m_Input = pInputs[i];
+			m_aCores[i].Tick(true);
+		}
+		for(auto &Core : m_aCores)
+			Core.Move();
+	}
+};
+
+TEST(GameCore, BroadPhaseDeterminism)
+{
+	// solid borders and a few platforms
+	CTestMap Map(120, 60);
+	for(int y = 0; y < Map.Height(); y++)
+	{
+		for(int x = 0; x < Map.Width(); x++)
+		{
+			const bool Border = x == 0 || y == 0 || x == Map.Width() - 1 || y == Map.Height() - 1;
+			const bool Platform = y % 12 == 11 && x % 30 >= 5 && x % 30 < 20;
+			if(Border || Platform)
+				Map.Tile(x, y).m_Index = TILE_SOLID;
+		}
+	}
+	CLayers Layers;
+	Layers.InitBackground(&Map);
+	CCollision Collision;
+	Collision.Init(&Layers);
+
+	const int NumTicks = 500;
+	std::vector<CNetObj_PlayerInput> vInputs(NumTicks * MAX_CLIENTS);
+	std::mt19937 Rng(1);
+	for(int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			CNetObj_PlayerInput &Input = vInputs[Tick * MAX_CLIENTS + i];
+			// hold inputs for a while, like players do
+			if(Tick > 0 && Rng() % 8)
+			{
+				Input = vInputs[(Tick - 1) * MAX_CLIENTS + i];
+				continue;
+			}
+			Input = {};
+			Input.m_Direction = (int)(Rng() % 3) - 1;
+			Input.m_Jump = Rng() % 4 == 0;
+			Input.m_Hook = Rng() % 2;
+			Input.m_TargetX = (int)(Rng() % 401) - 200;
+			Input.m_TargetY = (int)(Rng() % 401) - 200;
+			if(Input.m_TargetX == 0 && Input.m_TargetY == 0)
+				Input.m_TargetY = -1;
+		}
+	}
+
+	CTestWorld Exhaustive(&Collision, false);
+	CTestWorld BroadPhase(&Collision, true);
+	int NumHooked = 0;
+	for(int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		Exhaustive.Tick(&vInputs[Tick * MAX_CLIENTS]);
+		BroadPhase.Tick(&vInputs[Tick * MAX_CLIENTS]);
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const CCharacterCore &Expected = Exhaustive.m_aCores[i];
+			const CCharacterCore &Actual = BroadPhase.m_aCores[i];
+			ASSERT_EQ(mem_comp(&Expected.m_Pos, &Actual.m_Pos, sizeof(vec2)), 0) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(mem_comp(&Expected.m_Vel, &Actual.m_Vel, sizeof(vec2)), 0) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(mem_comp(&Expected.m_HookPos, &Actual.m_HookPos, sizeof(vec2)), 0) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Expected.m_HookState, Actual.m_HookState) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Expected.HookedPlayer(), Actual.HookedPlayer()) << "tick " << Tick << " character " << i;
+			NumHooked += Actual.HookedPlayer() != -1;
+		}
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			Exhaustive.m_aCores[i].Quantize();
+			BroadPhase.m_aCores[i].Quantize();
+		}
+	}
+	// make sure the characters actually got in touch with each other
+	EXPECT_GT(NumHooked, 0);
+}
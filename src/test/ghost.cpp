@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/client/ghost.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+#include <test/test.h>
+
+#include <memory>
+
+static const char *const TEST_MAP = "Tutorial";
+static const char *const TEST_INDEX = "Tutorial.ghostindex";
+
+// The index and the header checks only need storage, no graphics or kernel.
+class GhostIndex : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	std::unique_ptr<IConsole> m_pConsole;
+	std::unique_ptr<IStorage> m_pStorage;
+	CGhostLoader m_Loader;
+	SHA256_DIGEST m_MapSha256;
+
+	GhostIndex()
+	{
+		m_Info.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pConsole = CreateConsole(CFGFLAG_CLIENT);
+		m_pStorage = std::unique_ptr<IStorage>(m_Info.CreateTestStorage());
+		m_Loader.Init(m_pConsole.get(), m_pStorage.get());
+		m_MapSha256 = sha256("map", 3);
+	}
+
+	void WriteGhost(const char *pFilename, const char *pOwner, int Time)
+	{
+		CGhostHeader Header;
+		mem_zero(&Header, sizeof(Header));
+		mem_copy(Header.m_aMarker, "TWGHOST", 8);
+		Header.m_Version = 6;
+		str_copy(Header.m_aOwner, pOwner);
+		str_copy(Header.m_aMap, TEST_MAP);
+		uint_to_bytes_be(Header.m_aNumTicks, 100);
+		uint_to_bytes_be(Header.m_aTime, Time);
+		Header.m_MapSha256 = m_MapSha256;
+		WriteFile(pFilename, &Header, sizeof(Header));
+	}
+
+	void WriteFile(const char *pFilename, const void *pData, unsigned Size)
+	{
+		IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		io_write(File, pData, Size);
+		io_close(File);
+	}
+
+	bool Info(const char *pFilename, time_t Modified, CGhostInfo *pInfo)
+	{
+		return m_Loader.GetGhostInfo(pFilename, Modified, pInfo, TEST_MAP, m_MapSha256, 0);
+	}
+
+	void ExpectInfo(const char *pFilename, time_t Modified, const char *pOwner, int Time)
+	{
+		CGhostInfo GhostInfo;
+		ASSERT_TRUE(Info(pFilename, Modified, &GhostInfo)) << pFilename;
+		EXPECT_STREQ(GhostInfo.m_aOwner, pOwner);
+		EXPECT_STREQ(GhostInfo.m_aMap, TEST_MAP);
+		EXPECT_EQ(GhostInfo.m_NumTicks, 100);
+		EXPECT_EQ(GhostInfo.m_Time, Time);
+	}
+
+	// fills the index with the three test ghosts, removes the files and
+	// reloads the index, so it is the only source of the headers
+	void BuildIndex()
+	{
+		WriteGhost("a.gho", "alice", 1000);
+		WriteGhost("b.gho", "bob", 2000);
+		WriteGhost("c.gho", "carol", 3000);
+		m_Loader.LoadIndex(TEST_INDEX);
+		ExpectInfo("a.gho", 10, "alice", 1000);
+		ExpectInfo("b.gho", 20, "bob", 2000);
+		ExpectInfo("c.gho", 30, "carol", 3000);
+		m_Loader.SaveIndex();
+		for(const char *pFilename : {"a.gho", "b.gho", "c.gho"})
+			EXPECT_TRUE(m_pStorage->RemoveFile(pFilename, IStorage::TYPE_SAVE));
+		m_Loader.LoadIndex(TEST_INDEX);
+	}
+};
+
+TEST_F(GhostIndex, RoundTrip)
+{
+	BuildIndex();
+	ExpectInfo("a.gho", 10, "alice", 1000);
+	ExpectInfo("b.gho", 20, "bob", 2000);
+	ExpectInfo("c.gho", 30, "carol", 3000);
+
+	// the header checks still run on the cached headers
+	CGhostInfo GhostInfo;
+	EXPECT_FALSE(m_Loader.GetGhostInfo("a.gho", 10, &GhostInfo, "other_map", m_MapSha256, 0));
+	m_Loader.SaveIndex();
+}
+
+TEST_F(GhostIndex, ChangedFile)
+{
+	BuildIndex();
+
+	// a different modification time reads the file again
+	WriteGhost("a.gho", "anna", 1500);
+	ExpectInfo("a.gho", 11, "anna", 1500);
+	CGhostInfo GhostInfo;
+	EXPECT_FALSE(Info("b.gho", 21, &GhostInfo));
+	m_Loader.SaveIndex();
+
+	m_Loader.LoadIndex(TEST_INDEX);
+	EXPECT_TRUE(m_pStorage->RemoveFile("a.gho", IStorage::TYPE_SAVE));
+	ExpectInfo("a.gho", 11, "anna", 1500);
+	EXPECT_FALSE(Info("a.gho", 10, &GhostInfo));
+	m_Loader.SaveIndex();
+}
+
+TEST_F(GhostIndex, DeletedFile)
+{
+	BuildIndex();
+
+	// entries that are not looked up are dropped on save
+	ExpectInfo("a.gho", 10, "alice", 1000);
+	ExpectInfo("c.gho", 30, "carol", 3000);
+	m_Loader.SaveIndex();
+
+	m_Loader.LoadIndex(TEST_INDEX);
+	CGhostInfo GhostInfo;
+	EXPECT_FALSE(Info("b.gho", 20, &GhostInfo));
+	ExpectInfo("a.gho", 10, "alice", 1000);
+	ExpectInfo("c.gho", 30, "carol", 3000);
+	m_Loader.SaveIndex();
+}
+
+TEST_F(GhostIndex, Corrupt)
+{
+	// an index that is not an index, one of another version and a truncated one
+	BuildIndex();
+	void *pIndex;
+	unsigned IndexSize;
+	ASSERT_TRUE(m_pStorage->ReadFile(TEST_INDEX, IStorage::TYPE_SAVE, &pIndex, &IndexSize));
+	unsigned char aWrongVersion[9] = {'T', 'W', 'G', 'H', 'I', 'D', 'X', 0, 0xff};
+	const struct
+	{
+		const void *m_pData;
+		unsigned m_Size;
+	} aCorrupt[] = {
+		{"garbage", 7},
+		{aWrongVersion, sizeof(aWrongVersion)},
+		{pIndex, IndexSize - 10},
+	};
+	for(const auto &Corrupt : aCorrupt)
+	{
+		SCOPED_TRACE(Corrupt.m_Size);
+		WriteGhost("a.gho", "alice", 1000);
+		WriteGhost("b.gho", "bob", 2000);
+		WriteFile(TEST_INDEX, Corrupt.m_pData, Corrupt.m_Size);
+
+		// the files are read again and the index is rewritten
+		m_Loader.LoadIndex(TEST_INDEX);
+		ExpectInfo("a.gho", 10, "alice", 1000);
+		ExpectInfo("b.gho", 20, "bob", 2000);
+		m_Loader.SaveIndex();
+
+		EXPECT_TRUE(m_pStorage->RemoveFile("a.gho", IStorage::TYPE_SAVE));
+		EXPECT_TRUE(m_pStorage->RemoveFile("b.gho", IStorage::TYPE_SAVE));
+		m_Loader.LoadIndex(TEST_INDEX);
+		ExpectInfo("a.gho", 10, "alice", 1000);
+		ExpectInfo("b.gho", 20, "bob", 2000);
+		m_Loader.SaveIndex();
+	}
+	free(pIndex);
+}
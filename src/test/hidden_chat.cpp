@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server.h>
+#include <engine/shared/packer.h>
+#include <game/server/hidden_chat.h>
+
+#include <random>
+#include <vector>
+
+// Records the messages sent to every client, or only repacks them like the
+// server does, for the benchmark.
+class CTestServer : public IServer
+{
+public:
+	struct CSent
+	{
+		int m_MsgID;
+		bool m_System;
+		bool m_NoTranslate;
+		int m_Flags;
+		std::vector<unsigned char> m_vData;
+
+		bool operator==(const CSent &Other) const
+		{
+			return m_MsgID == Other.m_MsgID && m_System == Other.m_System && m_NoTranslate == Other.m_NoTranslate && m_Flags == Other.m_Flags && m_vData == Other.m_vData;
+		}
+	};
+
+	bool m_aSixup[MAX_CLIENTS] = {};
+	int m_aVersion[MAX_CLIENTS] = {};
+	int m_aaIdMap[MAX_CLIENTS][VANILLA_MAX_CLIENTS];
+	char m_aaName[MAX_CLIENTS][16];
+	std::vector<CSent> m_avSent[MAX_CLIENTS];
+	bool m_Record = true;
+	CPacker m_Repacked;
+
+	CTestServer()
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			str_format(m_aaName[i], sizeof(m_aaName[i]), "tee %d", i);
+			for(int &ID : m_aaIdMap[i])
+				ID = -1;
+		}
+	}
+
+	void Repack(const CMsgPacker *pMsg)
+	{
+		m_Repacked.Reset();
+		m_Repacked.AddInt((pMsg->m_MsgID << 1) | (pMsg->m_System ? 1 : 0));
+		m_Repacked.AddRaw(pMsg->Data(), pMsg->Size());
+	}
+
+	void Record(const CMsgPacker *pMsg, int Flags, int ClientID)
+	{
+		if(m_Record)
+			m_avSent[ClientID].push_back({pMsg->m_MsgID, pMsg->m_System, pMsg->m_NoTranslate, Flags, std::vector<unsigned char>(pMsg->Data(), pMsg->Data() + pMsg->Size())});
+	}
+
+	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID) override
+	{
+		// the server repacks every message for both protocols
+		Repack(pMsg);
+		Repack(pMsg);
+		Record(pMsg, Flags, ClientID);
+		return 0;
+	}
+
+	int SendMsgMask(CMsgPacker *pMsg, int Flags, const CClientMask &Mask) override
+	{
+		bool aRepacked[2] = {false, false};
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!Mask[i])
+				continue;
+			if(!aRepacked[m_aSixup[i]])
+				Repack(pMsg);
+			aRepacked[m_aSixup[i]] = true;
+			Record(pMsg, Flags, i);
+		}
+		return 0;
+	}
+
+	int MaxClients() const override { return MAX_CLIENTS; }
+	bool IsSixup(int ClientID) const override { return m_aSixup[ClientID]; }
+	int GetClientVersion(int ClientID) const override { return m_aVersion[ClientID]; }
+	int *GetIdMap(int ClientID) override { return m_aaIdMap[ClientID]; }
+	const char *ClientName(int ClientID) const override { return m_aaName[ClientID]; }
+	bool ClientIngame(int ClientID) const override { return true; }
+
+	int Port() const override { return 0; }
+	int ClientCount() const override { return 0; }
+	int DistinctClientCount() const override { return 0; }
+	const char *RealClientName(int ClientID) const override { return ""; }
+	const char *ClientClan(int ClientID) const override { return ""; }
+	int ClientCountry(int ClientID) const override { return 0; }
+	bool ClientAuthed(int ClientID) const override { return false; }
+	bool GetClientInfo(int ClientID, CClientInfo *pInfo) const override { return false; }
+	void SetClientDDNetVersion(int ClientID, int DDNetVersion) override {}
+	void GetClientAddr(int ClientID, char *pAddrStr, int Size) const override {}
+	void GetMapInfo(char *pMapName, int MapNameSize, int *pMapSize, SHA256_DIGEST *pSha256, int *pMapCrc) override {}
+	bool WouldClientNameChange(int ClientID, const char *pNameRequest) override { return false; }
+	bool WouldClientClanChange(int ClientID, const char *pClanRequest) override { return false; }
+	void SetClientName(int ClientID, const char *pName) override {}
+	void SetClientClan(int ClientID, const char *pClan) override {}
+	void SetClientCountry(int ClientID, int Country) override {}
+	void SetClientScore(int ClientID, std::optional<int> Score) override {}
+	void SetClientFlags(int ClientID, int Flags) override {}
+	int SnapNewID() override { return 0; }
+	void SnapFreeID(int ID) override {}
+	void *SnapNewItem(int Type, int ID, int Size) override { return nullptr; }
+	void SnapSetStaticsize(int ItemType, int Size) override {}
+	bool SnapHoldItems(int SnappingClient, int ID, int Interval, const int *pTypes, int NumTypes) override { return false; }
+	void SetRconCID(int ClientID) override {}
+	int GetAuthedState(int ClientID) const override { return 0; }
+	const char *GetAuthName(int ClientID) const override { return ""; }
+	void Kick(int ClientID, const char *pReason) override {}
+	void Ban(int ClientID, int Seconds, const char *pReason) override {}
+	void RedirectClient(int ClientID, int Port, bool Verbose = false) override {}
+	void ChangeMap(const char *pMap) override {}
+	void DemoRecorder_HandleAutoStart() override {}
+	void SaveDemo(int ClientID, float Time) override {}
+	void StartRecord(int ClientID) override {}
+	void StopRecord(int ClientID) override {}
+	bool IsRecording(int ClientID) override { return false; }
+	void StopDemos() override {}
+	void GetClientAddr(int ClientID, NETADDR *pAddr) const override {}
+	bool DnsblWhite(int ClientID) override { return false; }
+	bool DnsblPending(int ClientID) override { return false; }
+	bool DnsblBlack(int ClientID) override { return false; }
+	const char *GetAnnouncementLine(const char *pFileName) override { return ""; }
+	bool ClientPrevIngame(int ClientID) override { return false; }
+	const char *GetNetErrorString(int ClientID) override { return ""; }
+	void ResetNetErrorString(int ClientID) override {}
+	bool SetTimedOut(int ClientID, int OrigID) override { return false; }
+	void SetTimeoutProtected(int ClientID) override {}
+	void SetErrorShutdown(const char *pReason) override {}
+	void ExpireServerInfo() override {}
+	void FillAntibot(CAntibotRoundData *pData) override {}
+	void SendMsgRaw(int ClientID, const void *pData, int Size, int Flags) override {}
+	const char *GetMapName() const override { return ""; }
+	bool TeeHistorianReplaySeed(uint64_t aSeed[2]) const override { return false; }
+};
+
+static const char *const gs_pCantSeeText = "You can't see what the dead say";
+static const int gs_Flags = MSGFLAG_VITAL | MSGFLAG_NORECORD;
+
+// How CGameContext::SendChat sent a chat message in Hidden mode, packing it
+// for every receiver.
+static void ReferenceSendChat(IServer *pServer, int ChatterClientID, const char *pText, const CClientMask &Receivers, const bool *pGameOver, bool IsStep4)
+{
+	CNetMsg_Sv_Chat Msg;
+	Msg.m_Team = 0;
+	Msg.m_ClientID = ChatterClientID;
+	Msg.m_pMessage = pText;
+	for(int i = 0; i < pServer->MaxClients(); i++)
+	{
+		if(!Receivers[i])
+			continue;
+		if(ChatterClientID < 0)
+		{
+			pServer->SendPackMsg(&Msg, gs_Flags, i);
+			continue;
+		}
+
+		CNetMsg_Sv_Chat Msg2;
+		Msg2.m_Team = 0;
+		Msg2.m_ClientID = ChatterClientID;
+		bool IsCase1 = pGameOver[ChatterClientID] && !pGameOver[i] && IsStep4;
+		bool IsCase2 = !pGameOver[ChatterClientID] && pGameOver[i];
+		if(IsCase1 || IsCase2)
+			Msg2.m_Team = 1;
+		Msg2.m_pMessage = IsCase1 ? gs_pCantSeeText : pText;
+		pServer->SendPackMsg(&Msg2, gs_Flags, i);
+	}
+}
+
+// The audience split of CGameContext::SendChat.
+static void SendChat(IServer *pServer, int ChatterClientID, const char *pText, const CClientMask &Receivers, const bool *pGameOver, bool IsStep4)
+{
+	CNetMsg_Sv_Chat Msg;
+	Msg.m_Team = 0;
+	Msg.m_ClientID = ChatterClientID;
+	Msg.m_pMessage = pText;
+	CClientMask aAudiences[NUM_HIDDEN_CHAT_AUDIENCES];
+	for(int i = 0; i < pServer->MaxClients(); i++)
+	{
+		if(!Receivers[i])
+			continue;
+		if(ChatterClientID < 0)
+			aAudiences[HIDDEN_CHAT_ALL].set(i);
+		else
+			aAudiences[HiddenChatAudience(pGameOver[ChatterClientID], pGameOver[i], IsStep4)].set(i);
+	}
+	HiddenSendChat(pServer, &Msg, gs_pCantSeeText, aAudiences, gs_Flags);
+}
+
+static void RandomClients(CTestServer &Server, std::mt19937 &Rng)
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		Server.m_aSixup[i] = Rng() % 4 == 0;
+		// old clients see the others under their own client IDs
+		Server.m_aVersion[i] = Rng() % 4 == 0 ? VERSION_VANILLA : VERSION_DDNET_OLD + (int)(Rng() % 10000);
+		for(int &ID : Server.m_aaIdMap[i])
+			ID = Rng() % 3 ? (int)(Rng() % MAX_CLIENTS) : -1;
+	}
+}
+
+TEST(HiddenChat, MatchesPerReceiver)
+{
+	std::mt19937 Rng(0);
+	int aNumAudiences[NUM_HIDDEN_CHAT_AUDIENCES] = {};
+	int NumTranslated = 0;
+	for(int Round = 0; Round < 200; Round++)
+	{
+		CTestServer Reference;
+		RandomClients(Reference, Rng);
+		CTestServer Server = Reference;
+
+		CClientMask Receivers;
+		bool aGameOver[MAX_CLIENTS];
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			Receivers[i] = Rng() % 8 != 0;
+			aGameOver[i] = Rng() % 2;
+		}
+		const int ChatterClientID = Round % 5 == 0 ? -1 : (int)(Rng() % MAX_CLIENTS);
+		const bool IsStep4 = Rng() % 2;
+
+		ReferenceSendChat(&Reference, ChatterClientID, "hello", Receivers, aGameOver, IsStep4);
+		SendChat(&Server, ChatterClientID, "hello", Receivers, aGameOver, IsStep4);
+
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			EXPECT_EQ(Server.m_avSent[i], Reference.m_avSent[i]) << "round " << Round << " client " << i;
+			EXPECT_EQ(Server.m_avSent[i].size(), Receivers[i] ? 1u : 0u);
+			if(!Receivers[i])
+				continue;
+			if(ChatterClientID >= 0)
+				aNumAudiences[HiddenChatAudience(aGameOver[ChatterClientID], aGameOver[i], IsStep4)]++;
+			if(ChatterClientID >= 0 && !Server.m_aSixup[i] && Server.m_aVersion[i] < VERSION_DDNET_OLD)
+				NumTranslated++;
+		}
+	}
+	// all cases were covered
+	for(int Num : aNumAudiences)
+		EXPECT_GT(Num, 0);
+	EXPECT_GT(NumTranslated, 0);
+}
+
+TEST(HiddenChat, PackingTime)
+{
+	// a chat flood to a full server
+	std::mt19937 Rng(1);
+	CTestServer Server;
+	RandomClients(Server, Rng);
+	Server.m_Record = false;
+	CClientMask Receivers;
+	bool aGameOver[MAX_CLIENTS];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		Receivers.set(i);
+		aGameOver[i] = i % 3 == 0;
+	}
+	const char *pText = "a chat message of a usual length, saying something";
+	const int NumMessages = 1000;
+
+	auto &&Measure = [&](auto &&Send) {
+		const int64_t Start = time_get();
+		for(int i = 0; i < NumMessages; i++)
+			Send(&Server, i % MAX_CLIENTS, pText, Receivers, aGameOver, (i / MAX_CLIENTS) % 2 == 0);
+		return (time_get() - Start) * 1000000000 / time_freq() / NumMessages;
+	};
+	RecordProperty("PerReceiverNsPerMessage", (int)Measure(ReferenceSendChat));
+	RecordProperty("PerAudienceNsPerMessage", (int)Measure(SendChat));
+}
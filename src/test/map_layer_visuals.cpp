@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/jobs.h>
+#include <game/client/map_layer_visuals.h>
+#include <game/mapitems.h>
+
+#include <climits>
+#include <memory>
+#include <random>
+#include <vector>
+
+static const int TEST_NUM_THREADS = 4;
+
+enum
+{
+	KIND_DESIGN = 0,
+	KIND_DESIGN_UNTEXTURED,
+	KIND_GAME,
+	KIND_FRONT,
+	KIND_SWITCH,
+	KIND_TELE,
+	KIND_SPEEDUP,
+	KIND_TUNE,
+	NUM_KINDS,
+};
+
+static int KindTileSize(int Kind)
+{
+	switch(Kind)
+	{
+	case KIND_SWITCH: return sizeof(CSwitchTile);
+	case KIND_TELE: return sizeof(CTeleTile);
+	case KIND_SPEEDUP: return sizeof(CSpeedupTile);
+	case KIND_TUNE: return sizeof(CTuneTile);
+	default: return sizeof(CTile);
+	}
+}
+
+static int KindOverlayCount(int Kind)
+{
+	switch(Kind)
+	{
+	case KIND_SWITCH: return 2;
+	case KIND_TELE: return 1;
+	case KIND_SPEEDUP: return 2;
+	default: return 0;
+	}
+}
+
+class CTestTileLayer
+{
+public:
+	CMapItemLayerTilemap m_TMap;
+	CMapItemGroup m_Group;
+	std::vector<unsigned char> m_vData;
+	int m_Kind;
+
+	// about `EmptyPercent` percent of the bytes of the tiles are zero
+	CTestTileLayer(int Kind, int Width, int Height, int EmptyPercent, std::mt19937 &Rng) :
+		m_TMap(), m_Group(), m_Kind(Kind)
+	{
+		m_TMap.m_Width = Width;
+		m_TMap.m_Height = Height;
+		m_vData.resize((size_t)Width * Height * KindTileSize(Kind));
+		for(auto &Byte : m_vData)
+			Byte = (int)(Rng() % 100) < EmptyPercent ? 0 : Rng() % 256;
+	}
+
+	// builds the visuals of the overlay on `pPool`, or serially without one
+	std::unique_ptr<CTileLayerBuild> Build(STileLayerVisuals &Visuals, int Overlay, int BandTiles, CJobPool *pPool, int *pNumBands = nullptr)
+	{
+		EXPECT_TRUE(Visuals.Init(m_TMap.m_Width, m_TMap.m_Height));
+		auto pBuild = std::make_unique<CTileLayerBuild>();
+		pBuild->m_pVisuals = &Visuals;
+		pBuild->m_pTMap = &m_TMap;
+		pBuild->m_pTiles = m_vData.data();
+		pBuild->m_pGroup = &m_Group;
+		pBuild->m_CurOverlay = Overlay;
+		pBuild->m_DoTextureCoords = m_Kind != KIND_DESIGN_UNTEXTURED;
+		pBuild->m_IsGameLayer = m_Kind == KIND_GAME;
+		pBuild->m_IsFrontLayer = m_Kind == KIND_FRONT;
+		pBuild->m_IsSwitchLayer = m_Kind == KIND_SWITCH;
+		pBuild->m_IsTeleLayer = m_Kind == KIND_TELE;
+		pBuild->m_IsSpeedupLayer = m_Kind == KIND_SPEEDUP;
+		pBuild->m_IsTuneLayer = m_Kind == KIND_TUNE;
+		pBuild->m_IsEntityLayer = m_Kind != KIND_DESIGN && m_Kind != KIND_DESIGN_UNTEXTURED;
+
+		std::vector<std::shared_ptr<IJob>> vpBands = pBuild->CreateBands(BandTiles);
+		if(pNumBands)
+			*pNumBands = vpBands.size();
+		for(const auto &pBand : vpBands)
+		{
+			if(pPool)
+				pPool->Add(pBand);
+			else
+				CJobPool::RunBlocking(pBand.get());
+		}
+		pBuild->Wait();
+		return pBuild;
+	}
+};
+
+static void ExpectSameVisual(STileLayerVisuals::STileVisual &Expected, STileLayerVisuals::STileVisual &Actual)
+{
+	EXPECT_EQ(Expected.DoDraw(), Actual.DoDraw());
+	if(Expected.DoDraw())
+	{
+		EXPECT_EQ(Expected.IndexBufferByteOffset(), Actual.IndexBufferByteOffset());
+	}
+}
+
+static void ExpectSameVisuals(STileLayerVisuals &Expected, STileLayerVisuals &Actual)
+{
+	ASSERT_EQ(Expected.m_Width, Actual.m_Width);
+	ASSERT_EQ(Expected.m_Height, Actual.m_Height);
+	for(unsigned i = 0; i < Expected.m_Width * Expected.m_Height; i++)
+		ExpectSameVisual(Expected.m_pTilesOfLayer[i], Actual.m_pTilesOfLayer[i]);
+	ExpectSameVisual(Expected.m_BorderTopLeft, Actual.m_BorderTopLeft);
+	ExpectSameVisual(Expected.m_BorderTopRight, Actual.m_BorderTopRight);
+	ExpectSameVisual(Expected.m_BorderBottomRight, Actual.m_BorderBottomRight);
+	ExpectSameVisual(Expected.m_BorderBottomLeft, Actual.m_BorderBottomLeft);
+	ExpectSameVisual(Expected.m_BorderKillTile, Actual.m_BorderKillTile);
+	for(unsigned x = 0; x < Expected.m_Width; x++)
+	{
+		ExpectSameVisual(Expected.m_vBorderTop[x], Actual.m_vBorderTop[x]);
+		ExpectSameVisual(Expected.m_vBorderBottom[x], Actual.m_vBorderBottom[x]);
+	}
+	for(unsigned y = 0; y < Expected.m_Height; y++)
+	{
+		ExpectSameVisual(Expected.m_vBorderLeft[y], Actual.m_vBorderLeft[y]);
+		ExpectSameVisual(Expected.m_vBorderRight[y], Actual.m_vBorderRight[y]);
+	}
+}
+
+class MapLayerVisuals : public ::testing::Test
+{
+protected:
+	CJobPool m_Pool;
+
+	MapLayerVisuals()
+	{
+		m_Pool.Init(TEST_NUM_THREADS);
+	}
+};
+
+TEST_F(MapLayerVisuals, BandsMatchSerial)
+{
+	const int aaSizes[][2] = {{1, 1}, {1, 300}, {300, 1}, {2, 2}, {37, 53}, {256, 300}};
+	std::mt19937 Rng(0);
+	for(const auto &aSize : aaSizes)
+	{
+		for(int Kind = 0; Kind < NUM_KINDS; Kind++)
+		{
+			CTestTileLayer Layer(Kind, aSize[0], aSize[1], 40, Rng);
+			for(int Overlay = 0; Overlay <= KindOverlayCount(Kind); Overlay++)
+			{
+				SCOPED_TRACE(testing::Message() << "Width=" << aSize[0] << " Height=" << aSize[1] << " Kind=" << Kind << " Overlay=" << Overlay);
+				STileLayerVisuals SerialVisuals;
+				int NumSerialBands;
+				auto pSerial = Layer.Build(SerialVisuals, Overlay, INT_MAX, nullptr, &NumSerialBands);
+				EXPECT_EQ(NumSerialBands, 1);
+
+				// bands of one row and of a few rows
+				for(int BandRows : {1, 3})
+				{
+					STileLayerVisuals BandVisuals;
+					int NumBands;
+					auto pBands = Layer.Build(BandVisuals, Overlay, BandRows * aSize[0], &m_Pool, &NumBands);
+					EXPECT_EQ(NumBands, (aSize[1] + BandRows - 1) / BandRows);
+
+					ASSERT_EQ(pSerial->m_NumTiles, pBands->m_NumTiles);
+					ASSERT_EQ(pSerial->m_UploadDataSize, pBands->m_UploadDataSize);
+					if(pSerial->m_UploadDataSize > 0)
+					{
+						EXPECT_EQ(mem_comp(pSerial->m_pUploadData, pBands->m_pUploadData, pSerial->m_UploadDataSize), 0);
+					}
+					ExpectSameVisuals(SerialVisuals, BandVisuals);
+				}
+			}
+		}
+	}
+}
+
+TEST_F(MapLayerVisuals, TileOffsets)
+{
+	// the vertices at the offset of each drawn tile are the ones of that tile
+	std::mt19937 Rng(1);
+	for(int Kind : {KIND_DESIGN, KIND_DESIGN_UNTEXTURED, KIND_GAME})
+	{
+		SCOPED_TRACE(Kind);
+		CTestTileLayer Layer(Kind, 67, 45, 50, Rng);
+		STileLayerVisuals Visuals;
+		auto pBuild = Layer.Build(Visuals, 0, 67 * 4, &m_Pool);
+		const size_t Stride = sizeof(vec2) + (pBuild->m_DoTextureCoords ? sizeof(ubvec4) : 0);
+		int NumDrawn = 0;
+		for(int y = 0; y < 45; y++)
+		{
+			for(int x = 0; x < 67; x++)
+			{
+				STileLayerVisuals::STileVisual &Visual = Visuals.m_pTilesOfLayer[y * 67 + x];
+				EXPECT_EQ(Visual.DoDraw(), Layer.m_vData[(y * 67 + x) * sizeof(CTile)] != 0);
+				if(!Visual.DoDraw())
+					continue;
+				NumDrawn++;
+				const size_t Tile = Visual.IndexBufferByteOffset() / (6 * sizeof(uint32_t));
+				ASSERT_LT(Tile, pBuild->m_NumTiles);
+				vec2 TopLeft;
+				mem_copy(&TopLeft, pBuild->m_pUploadData + Tile * 4 * Stride, sizeof(TopLeft));
+				EXPECT_EQ(TopLeft, vec2(x * 32, y * 32));
+			}
+		}
+		EXPECT_GT(NumDrawn, 0);
+	}
+}
+
+TEST_F(MapLayerVisuals, BuildTime)
+{
+	// the CPU side of building the visuals of a big textured layer
+	const int Size = 1000;
+	std::mt19937 Rng(2);
+	CTestTileLayer Layer(KIND_DESIGN, Size, Size, 40, Rng);
+
+	int64_t Start = time_get();
+	STileLayerVisuals SerialVisuals;
+	auto pSerial = Layer.Build(SerialVisuals, 0, INT_MAX, nullptr);
+	const int64_t SerialTime = time_get() - Start;
+
+	Start = time_get();
+	STileLayerVisuals BandVisuals;
+	auto pBands = Layer.Build(BandVisuals, 0, CTileLayerBuild::BAND_TILES, &m_Pool);
+	const int64_t BandsTime = time_get() - Start;
+
+	ASSERT_EQ(pSerial->m_UploadDataSize, pBands->m_UploadDataSize);
+	EXPECT_EQ(mem_comp(pSerial->m_pUploadData, pBands->m_pUploadData, pSerial->m_UploadDataSize), 0);
+
+	RecordProperty("SerialMs", (int)(SerialTime * 1000 / time_freq()));
+	RecordProperty("BandsMs", (int)(BandsTime * 1000 / time_freq()));
+	RecordProperty("Threads", TEST_NUM_THREADS);
+}
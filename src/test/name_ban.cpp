@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <base/system.h>
 #include <engine/server/name_ban.h>
 
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
 TEST(NameBan, Empty)
 {
 	CNameBans Bans;
@@ -78,3 +84,90 @@ TEST(NameBan, UnbanNotFound)
 	CNameBans Bans;
 	Bans.Unban("abc");
 }
+
+TEST(NameBan, SkeletonDistance)
+{
+	std::mt19937 Rng(0);
+	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
+	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
+	char aName[MAX_NAME_LENGTH];
+	for(int i = 0; i < 1000; i++)
+	{
+		// few distinct characters so that the names share a lot
+		for(int Length = Rng() % MAX_NAME_LENGTH, j = 0; j <= Length; j++)
+			aName[j] = j == Length ? '\0' : "abcd1l"[Rng() % 6];
+		CNameBan Ban(aName, "", 0, false);
+		const int SkeletonLength = Rng() % (MAX_NAME_SKELETON_LENGTH + 1);
+		for(int j = 0; j < SkeletonLength; j++)
+			aSkeleton[j] = Ban.m_SkeletonLength > 0 && Rng() % 2 ? Ban.m_aSkeleton[Rng() % Ban.m_SkeletonLength] : 'a' + Rng() % 6;
+		EXPECT_EQ(Ban.SkeletonDistance(aSkeleton, SkeletonLength), str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer))) << "name '" << aName << "'";
+	}
+}
+
+TEST(NameBan, MatchesLinearScan)
+{
+	// the matching rule as a plain loop over all bans, the last one wins
+	std::vector<CNameBan> vReference;
+	auto ReferenceIsBanned = [&](const char *pName) -> const CNameBan * {
+		char aTrimmed[MAX_NAME_LENGTH];
+		str_copy(aTrimmed, str_utf8_skip_whitespaces(pName));
+		str_utf8_trim_right(aTrimmed);
+		int aSkeleton[MAX_NAME_SKELETON_LENGTH];
+		const int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
+		int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
+		const CNameBan *pResult = nullptr;
+		for(const CNameBan &Ban : vReference)
+		{
+			const int Distance = str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
+			if(Distance <= Ban.m_Distance || (Ban.m_IsSubstring && str_utf8_find_nocase(pName, Ban.m_aName)))
+				pResult = &Ban;
+		}
+		return pResult;
+	};
+
+	const char *apParts[] = {"a", "b", "c", "l", "1", "I", "ä", "xy", " ", "ab"};
+	std::mt19937 Rng(1);
+	auto RandomName = [&](char *pBuf, int BufSize) {
+		pBuf[0] = '\0';
+		for(int Parts = Rng() % 10; Parts > 0; Parts--)
+			str_append(pBuf, apParts[Rng() % std::size(apParts)], BufSize);
+	};
+
+	CNameBans Bans;
+	char aName[MAX_NAME_LENGTH];
+	for(int i = 0; i < 300; i++)
+	{
+		RandomName(aName, sizeof(aName));
+		if(Rng() % 4 == 0)
+		{
+			Bans.Unban(aName);
+			vReference.erase(std::remove_if(vReference.begin(), vReference.end(), [&](const CNameBan &Ban) { return str_comp(Ban.m_aName, aName) == 0; }), vReference.end());
+		}
+		else
+		{
+			const int Distance = Rng() % 4;
+			const bool IsSubstring = Rng() % 5 == 0;
+			Bans.Ban(aName, "", Distance, IsSubstring);
+			auto It = std::find_if(vReference.begin(), vReference.end(), [&](const CNameBan &Ban) { return str_comp(Ban.m_aName, aName) == 0; });
+			if(It == vReference.end())
+				vReference.emplace_back(aName, "", Distance, IsSubstring);
+			else
+			{
+				It->m_Distance = Distance;
+				It->m_IsSubstring = IsSubstring;
+			}
+		}
+
+		for(int j = 0; j < 20; j++)
+		{
+			RandomName(aName, sizeof(aName));
+			const CNameBan *pBan = Bans.IsBanned(aName);
+			const CNameBan *pExpected = ReferenceIsBanned(aName);
+			ASSERT_EQ(pBan == nullptr, pExpected == nullptr) << "name '" << aName << "'";
+			if(pBan)
+			{
+				EXPECT_STREQ(pBan->m_aName, pExpected->m_aName) << "name '" << aName << "'";
+			}
+		}
+	}
+}
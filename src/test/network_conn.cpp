@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static NETSOCKET BindLocalhost(NETADDR *pAddr)
+{
+	NETADDR BindAddr = {};
+	BindAddr.type = NETTYPE_IPV4;
+	NETSOCKET Socket;
+	do
+	{
+		BindAddr.port = secure_rand() % 64511 + 1024;
+	} while(!(Socket = net_udp_create(BindAddr)));
+	net_addr_from_str(pAddr, "127.0.0.1");
+	pAddr->port = BindAddr.port;
+	return Socket;
+}
+
+// One end of a connection whose packets go through a lossy relay.
+class CLossyPeer
+{
+public:
+	NETSOCKET m_Socket;
+	NETADDR m_Addr;
+	CNetConnection m_Connection;
+	CNetRecvUnpacker m_Unpacker;
+
+	// the relay's socket that this peer talks to
+	NETSOCKET m_RelaySocket;
+	NETADDR m_RelayAddr;
+
+	CLossyPeer()
+	{
+		m_Socket = BindLocalhost(&m_Addr);
+		m_RelaySocket = BindLocalhost(&m_RelayAddr);
+		m_Connection.Init(m_Socket, false);
+		m_Connection.DirectInit(m_RelayAddr, NET_SECURITY_TOKEN_UNSUPPORTED, NET_SECURITY_TOKEN_UNSUPPORTED, false);
+	}
+
+	~CLossyPeer()
+	{
+		net_udp_close(m_Socket);
+		net_udp_close(m_RelaySocket);
+	}
+
+	template<typename F>
+	void Receive(F &&OnVitalChunk)
+	{
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes;
+		while((Bytes = net_udp_recv(m_Socket, &Addr, &pData)) > 0)
+		{
+			bool Sixup = false;
+			if(CNetBase::UnpackPacket(pData, Bytes, &m_Unpacker.m_Data, Sixup) != 0 || !m_Connection.Feed(&m_Unpacker.m_Data, &Addr))
+				continue;
+			m_Unpacker.Start(&Addr, &m_Connection, 0);
+			CNetChunk Chunk;
+			while(m_Unpacker.FetchChunk(&Chunk))
+			{
+				if(Chunk.m_Flags & NET_CHUNKFLAG_VITAL)
+					OnVitalChunk(Chunk);
+			}
+		}
+	}
+};
+
+// forwards the packets that arrive at `From` to `pTo`, dropping some of them
+static void Relay(CLossyPeer *pFrom, CLossyPeer *pTo, std::mt19937 &Rng, float Loss)
+{
+	NETADDR Addr;
+	unsigned char *pData;
+	int Bytes;
+	while((Bytes = net_udp_recv(pFrom->m_RelaySocket, &Addr, &pData)) > 0)
+	{
+		if(std::uniform_real_distribution<float>(0.0f, 1.0f)(Rng) < Loss)
+			continue;
+		net_udp_send(pTo->m_RelaySocket, &pTo->m_Addr, pData, Bytes);
+	}
+}
+
+TEST(NetConnection, LossyVitalLatency)
+{
+	CNetBase::Init();
+	g_Config.m_ConnTimeout = CConfig::ms_ConnTimeout;
+	g_Config.m_ConnTimeoutProtection = CConfig::ms_ConnTimeoutProtection;
+
+	CLossyPeer Sender;
+	CLossyPeer Receiver;
+	std::mt19937 Rng(0);
+	const float Loss = 0.2f;
+
+	// Sparse vital messages, like chat or broadcasts, while both sides send
+	// unreliable traffic every tick, like inputs and snapshots.
+	const int NumMessages = 60;
+	const int64_t Start = time_get();
+	const int64_t MessageInterval = time_freq() / 20;
+	const int64_t TickInterval = time_freq() / 50;
+	int64_t NextTick = Start;
+	int NumSent = 0;
+	std::vector<int64_t> vLatencies;
+	const unsigned char aTickData[64] = {};
+	while((int)vLatencies.size() < NumMessages && time_get() - Start < 10 * time_freq())
+	{
+		const int64_t Now = time_get();
+		if(NumSent < NumMessages && Now - Start >= NumSent * MessageInterval)
+		{
+			int64_t aMessage[2] = {NumSent, Now};
+			Sender.m_Connection.QueueChunk(NET_CHUNKFLAG_VITAL, sizeof(aMessage), aMessage);
+			NumSent++;
+		}
+		if(Now >= NextTick)
+		{
+			Sender.m_Connection.QueueChunk(0, sizeof(aTickData), aTickData);
+			Receiver.m_Connection.QueueChunk(0, sizeof(aTickData), aTickData);
+			Sender.m_Connection.Flush();
+			Receiver.m_Connection.Flush();
+			NextTick += TickInterval;
+		}
+		Sender.m_Connection.Update();
+		Receiver.m_Connection.Update();
+
+		Relay(&Sender, &Receiver, Rng, Loss);
+		Relay(&Receiver, &Sender, Rng, Loss);
+		Sender.Receive([](const CNetChunk &) {});
+		Receiver.Receive([&](const CNetChunk &Chunk) {
+			int64_t aMessage[2];
+			ASSERT_EQ(Chunk.m_DataSize, (int)sizeof(aMessage));
+			mem_copy(aMessage, Chunk.m_pData, sizeof(aMessage));
+			EXPECT_EQ(aMessage[0], (int64_t)vLatencies.size());
+			vLatencies.push_back(time_get() - aMessage[1]);
+		});
+		std::this_thread::sleep_for(1ms);
+	}
+
+	ASSERT_EQ((int)vLatencies.size(), NumMessages);
+	EXPECT_EQ(Sender.m_Connection.State(), NET_CONNSTATE_ONLINE);
+
+	std::sort(vLatencies.begin(), vLatencies.end());
+	auto &&Percentile = [&](int p) { return vLatencies[(vLatencies.size() - 1) * p / 100] * 1000 / time_freq(); };
+	RecordProperty("LatencyP50Ms", (int)Percentile(50));
+	RecordProperty("LatencyP90Ms", (int)Percentile(90));
+	RecordProperty("LatencyP99Ms", (int)Percentile(99));
+	RecordProperty("LatencyMaxMs", (int)Percentile(100));
+	// with the fixed timeout of NET_CONN_RTO_MAX, more than 10% of the
+	// messages took longer than that
+	EXPECT_LT(Percentile(90), NET_CONN_RTO_MAX);
+}
+
+// Sends a vital chunk from `pFrom` and updates both peers until it's acked
+// or `Timeout` passed. Returns the retransmission timeouts `pFrom` had.
+static std::vector<int64_t> SendVital(CLossyPeer *pFrom, CLossyPeer *pTo, std::mt19937 &Rng, float Loss, int64_t Timeout)
+{
+	const unsigned char aData[16] = {};
+	pFrom->m_Connection.QueueChunk(NET_CHUNKFLAG_VITAL, sizeof(aData), aData);
+	pFrom->m_Connection.Flush();
+	std::vector<int64_t> vTimeouts = {pFrom->m_Connection.RetransmitTimeout()};
+	const int64_t Start = time_get();
+	while(pFrom->m_Connection.ResendBuffer()->First() && time_get() - Start < Timeout)
+	{
+		pFrom->m_Connection.Update();
+		pTo->m_Connection.Update();
+		Relay(pFrom, pTo, Rng, Loss);
+		pTo->Receive([](const CNetChunk &) {});
+		// the ack goes with the next packet, send one right away
+		pTo->m_Connection.QueueChunk(0, sizeof(aData), aData);
+		pTo->m_Connection.Flush();
+		Relay(pTo, pFrom, Rng, Loss);
+		pFrom->Receive([](const CNetChunk &) {});
+		if(pFrom->m_Connection.RetransmitTimeout() != vTimeouts.back())
+			vTimeouts.push_back(pFrom->m_Connection.RetransmitTimeout());
+		std::this_thread::sleep_for(1ms);
+	}
+	return vTimeouts;
+}
+
+TEST(NetConnection, RetransmitTimeout)
+{
+	CNetBase::Init();
+	g_Config.m_ConnTimeout = CConfig::ms_ConnTimeout;
+	g_Config.m_ConnTimeoutProtection = CConfig::ms_ConnTimeoutProtection;
+
+	CLossyPeer Sender;
+	CLossyPeer Receiver;
+	std::mt19937 Rng(0);
+	const int64_t Min = time_freq() * NET_CONN_RTO_MIN / 1000;
+	const int64_t Max = time_freq() * NET_CONN_RTO_MAX / 1000;
+
+	// without a round trip sample, the timeout is the maximum, the round
+	// trip on localhost is way below the minimum
+	EXPECT_EQ(SendVital(&Sender, &Receiver, Rng, 0.0f, 5 * time_freq()), std::vector<int64_t>({Max, Min}));
+
+	// doubled on every timeout while the packets get lost
+	EXPECT_EQ(SendVital(&Sender, &Receiver, Rng, 1.0f, 2 * time_freq()), std::vector<int64_t>({Min, 2 * Min, 4 * Min, Max}));
+	// the ack of a resent chunk doesn't give a sample, the backoff continues
+	EXPECT_EQ(SendVital(&Sender, &Receiver, Rng, 0.0f, 5 * time_freq()), std::vector<int64_t>({Max}));
+	EXPECT_EQ(Sender.m_Connection.ResendBuffer()->First(), nullptr);
+
+	// the next sample ends the backoff
+	EXPECT_EQ(SendVital(&Sender, &Receiver, Rng, 0.0f, 5 * time_freq()), std::vector<int64_t>({Max, Min}));
+	EXPECT_EQ(Sender.m_Connection.State(), NET_CONNSTATE_ONLINE);
+}
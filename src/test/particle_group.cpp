@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/client/particle_group.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <test/test.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// the update of a single particle as it was done before the groups were arrays
+struct CReferenceParticle
+{
+	CParticle m_Part;
+	float m_Life;
+
+	// returns the number of bounces
+	int Update(float TimePassed, int FrictionCount, const CCollision *pCollision)
+	{
+		m_Part.m_Vel.y += m_Part.m_Gravity * TimePassed;
+		for(int f = 0; f < FrictionCount; f++)
+			m_Part.m_Vel *= m_Part.m_Friction;
+		vec2 Vel = m_Part.m_Vel * TimePassed;
+		int Bounces = 0;
+		if(m_Part.m_Collides)
+			pCollision->MovePoint(&m_Part.m_Pos, &Vel, random_float(0.1f, 1.0f), &Bounces);
+		else
+			m_Part.m_Pos += Vel;
+		m_Part.m_Vel = Vel * (1.0f / TimePassed);
+		m_Life += TimePassed;
+		m_Part.m_Rot += TimePassed * m_Part.m_Rotspeed;
+		return Bounces;
+	}
+};
+
+static CParticle RandomParticle(std::mt19937 &Rng)
+{
+	std::uniform_real_distribution<float> Dist(-500.0f, 500.0f);
+	CParticle Part;
+	Part.SetDefault();
+	Part.m_Pos = vec2(Dist(Rng), Dist(Rng));
+	Part.m_Vel = vec2(Dist(Rng), Dist(Rng));
+	Part.m_LifeSpan = std::uniform_real_distribution<float>(0.1f, 2.0f)(Rng);
+	Part.m_Rotspeed = Dist(Rng) / 100.0f;
+	Part.m_Gravity = Dist(Rng);
+	Part.m_Friction = std::uniform_real_distribution<float>(0.5f, 1.0f)(Rng);
+	Part.m_Spr = Rng() % 10;
+	Part.m_Collides = false;
+	return Part;
+}
+
+// Updates the group and the reference particles `NumSteps` times and checks
+// that they stay the same. Returns the number of bounces.
+static int ExpectMatchesReference(CParticleGroup &Group, std::vector<CReferenceParticle> &vReference, const CCollision *pCollision, std::mt19937 &Rng, int NumSteps)
+{
+	int Bounces = 0;
+	for(int Step = 0; Step < NumSteps; Step++)
+	{
+		const float TimePassed = std::uniform_real_distribution<float>(0.001f, 0.05f)(Rng);
+		const int FrictionCount = Step % 3;
+		// same random elasticities for the colliding particles
+		srand(Step);
+		Group.Update(TimePassed, FrictionCount, pCollision);
+		srand(Step);
+		for(auto &Particle : vReference)
+			Bounces += Particle.Update(TimePassed, FrictionCount, pCollision);
+		vReference.erase(std::remove_if(vReference.begin(), vReference.end(), [](const CReferenceParticle &Particle) { return Particle.m_Life > Particle.m_Part.m_LifeSpan; }), vReference.end());
+
+		EXPECT_EQ(Group.Size(), (int)vReference.size());
+		if(Group.Size() != (int)vReference.size())
+			return Bounces;
+		for(int i = 0; i < Group.Size(); i++)
+		{
+			const CReferenceParticle &Expected = vReference[i];
+			EXPECT_EQ(Group.m_vPosX[i], Expected.m_Part.m_Pos.x);
+			EXPECT_EQ(Group.m_vPosY[i], Expected.m_Part.m_Pos.y);
+			EXPECT_EQ(Group.m_vVelX[i], Expected.m_Part.m_Vel.x);
+			EXPECT_EQ(Group.m_vVelY[i], Expected.m_Part.m_Vel.y);
+			EXPECT_EQ(Group.m_vRot[i], Expected.m_Part.m_Rot);
+			EXPECT_EQ(Group.m_vLife[i], Expected.m_Life);
+			EXPECT_EQ(Group.m_vSpr[i], Expected.m_Part.m_Spr);
+		}
+	}
+	return Bounces;
+}
+
+TEST(ParticleGroup, MatchesReference)
+{
+	std::mt19937 Rng(0);
+	CParticleGroup Group;
+	std::vector<CReferenceParticle> vReference;
+	for(int i = 0; i < 1000; i++)
+	{
+		const CParticle Part = RandomParticle(Rng);
+		Group.Add(Part, 0.0f);
+		vReference.push_back({Part, 0.0f});
+	}
+	ExpectMatchesReference(Group, vReference, nullptr, Rng, 100);
+	EXPECT_LT(Group.Size(), 1000);
+}
+
+TEST(ParticleGroup, Collision)
+{
+	std::mt19937 Rng(0);
+	CTestMap Map(40, 40);
+	for(int y = 0; y < Map.Height(); y++)
+	{
+		for(int x = 0; x < Map.Width(); x++)
+		{
+			if(x == 0 || y == 0 || x == Map.Width() - 1 || y == Map.Height() - 1 || Rng() % 10 == 0)
+				Map.Tile(x, y).m_Index = TILE_SOLID;
+		}
+	}
+	CLayers Layers;
+	Layers.InitBackground(&Map);
+	CCollision Collision;
+	Collision.Init(&Layers);
+
+	CParticleGroup Group;
+	std::vector<CReferenceParticle> vReference;
+	std::uniform_real_distribution<float> Pos(32.0f, 39 * 32.0f);
+	for(int i = 0; i < 1000; i++)
+	{
+		CParticle Part = RandomParticle(Rng);
+		do
+			Part.m_Pos = vec2(Pos(Rng), Pos(Rng));
+		while(Collision.CheckPoint(Part.m_Pos));
+		Part.m_Collides = i % 4 != 0;
+		Group.Add(Part, 0.0f);
+		vReference.push_back({Part, 0.0f});
+	}
+	EXPECT_GT(ExpectMatchesReference(Group, vReference, &Collision, Rng, 100), 0);
+
+	// the colliding particles don't move into the walls
+	for(int i = 0; i < Group.Size(); i++)
+	{
+		if(Group.m_vCollides[i])
+		{
+			EXPECT_FALSE(Collision.CheckPoint(Group.m_vPosX[i], Group.m_vPosY[i])) << i;
+		}
+	}
+}
+
+TEST(ParticleGroup, Saturated)
+{
+	// a full pool of particles living until the last update
+	const int NumParticles = 8192;
+	const int NumSteps = 500;
+	std::mt19937 Rng(1);
+	CParticleGroup Group;
+	std::vector<CReferenceParticle> vReference;
+	for(int i = 0; i < NumParticles; i++)
+	{
+		CParticle Part = RandomParticle(Rng);
+		Part.m_LifeSpan = 10.0f;
+		Group.Add(Part, 0.0f);
+		vReference.push_back({Part, 0.0f});
+	}
+
+	int64_t Start = time_get();
+	for(int Step = 0; Step < NumSteps - 1; Step++)
+	{
+		Group.Update(0.02f, 1, nullptr);
+		ASSERT_EQ(Group.Size(), NumParticles);
+	}
+	RecordProperty("UpdateUs", (int)((time_get() - Start) * 1000000 / time_freq() / (NumSteps - 1)));
+	Group.Update(0.5f, 1, nullptr);
+	EXPECT_EQ(Group.Size(), 0);
+
+	// the same with one particle at a time
+	Start = time_get();
+	for(int Step = 0; Step < NumSteps - 1; Step++)
+		for(auto &Particle : vReference)
+			Particle.Update(0.02f, 1, nullptr);
+	RecordProperty("ReferenceUpdateUs", (int)((time_get() - Start) * 1000000 / time_freq() / (NumSteps - 1)));
+}
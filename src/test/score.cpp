@@ -6,9 +6,15 @@
 #include <engine/server/databases/connection_pool.h>
 #include <engine/shared/config.h>
 #include <game/server/scoreworker.h>
+#include <test/test.h>
 
 #include <sqlite3.h>
 
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
 #if defined(CONF_TEST_MYSQL)
 int DummyMysqlInit = (MysqlInit(), 1);
 #endif
@@ -583,6 +589,185 @@ TEST_P(RandomMap, UnfinishedDoesntExist)
 	EXPECT_STREQ(m_pRandomMapResult->m_aMessage, "You have no more unfinished maps on this server!");
 }
 
+struct Transaction : public Score
+{
+	Transaction()
+	{
+		str_copy(m_PlayerRequest.m_aMap, "Kobra 3", sizeof(m_PlayerRequest.m_aMap));
+		str_copy(m_PlayerRequest.m_aRequestingPlayer, "brainless tee", sizeof(m_PlayerRequest.m_aRequestingPlayer));
+		m_PlayerRequest.m_Offset = 0;
+		str_copy(m_PlayerRequest.m_aServer, "GER", sizeof(m_PlayerRequest.m_aServer));
+		str_copy(m_PlayerRequest.m_aName, "nameless tee", sizeof(m_PlayerRequest.m_aName));
+		g_Config.m_SvRegionalRankings = false;
+	}
+};
+
+TEST_P(Transaction, Commit)
+{
+	ASSERT_FALSE(m_pConn->BeginTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	InsertRank(120.0);
+	InsertRank(100.0);
+	ASSERT_FALSE(m_pConn->CommitTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_FALSE(CScoreWorker::ShowRank(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectLines(m_pPlayerResult, {"nameless tee - 01:40.00 - better than 100% - requested by brainless tee", "Global rank 1"}, true);
+}
+
+TEST_P(Transaction, Rollback)
+{
+	ASSERT_FALSE(m_pConn->BeginTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	InsertRank();
+	ASSERT_FALSE(m_pConn->RollbackTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_FALSE(CScoreWorker::ShowRank(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+	ExpectLines(m_pPlayerResult, {"nameless tee is not ranked"});
+}
+
+struct CTestSqlData : ISqlData
+{
+	CTestSqlData(std::shared_ptr<ISqlResult> pResult, const char *pMap) :
+		ISqlData(std::move(pResult))
+	{
+		str_copy(m_aMap, pMap, sizeof(m_aMap));
+	}
+
+	char m_aMap[128];
+};
+
+struct ConnectionPool : public testing::Test
+{
+	ConnectionPool()
+	{
+		// the read workers and the write worker need the same database
+		str_copy(m_aDatabase, m_Info.m_aFilename, sizeof(m_aDatabase));
+		m_pPool->RegisterSqliteDatabase(CDbConnectionPool::Mode::READ, m_aDatabase);
+		m_pPool->RegisterSqliteDatabase(CDbConnectionPool::Mode::WRITE, m_aDatabase);
+	}
+
+	~ConnectionPool()
+	{
+		// wait for the workers to close their connections
+		m_pPool = nullptr;
+		fs_remove(m_aDatabase);
+	}
+
+	static bool InsertMap(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+	{
+		const CTestSqlData *pData = dynamic_cast<const CTestSqlData *>(pGameData);
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf),
+			"INSERT INTO %s_maps(Map, Server, Mapper, Points, Stars, Timestamp) "
+			"VALUES (?, 'Novice', 'Zerodin', 5, 5, CURRENT_TIMESTAMP)",
+			pSqlServer->GetPrefix());
+		if(pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+			return true;
+		pSqlServer->BindString(1, pData->m_aMap);
+		int NumInserted;
+		return pSqlServer->ExecuteUpdate(&NumInserted, pError, ErrorSize);
+	}
+
+	static bool RecordThread(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+	{
+		if(pSqlServer->PrepareStatement("SELECT 1", pError, ErrorSize))
+			return true;
+		bool End;
+		if(pSqlServer->Step(&End, pError, ErrorSize))
+			return true;
+		// keep the worker busy so that the other workers take the next reads
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		std::lock_guard<std::mutex> Lock(ms_ThreadsMutex);
+		ms_Threads.insert(std::this_thread::get_id());
+		return false;
+	}
+
+	void WaitForCompletion(const std::vector<std::shared_ptr<ISqlResult>> &vpResults)
+	{
+		for(const auto &pResult : vpResults)
+		{
+			for(int i = 0; i < 1000 && !pResult->m_Completed.load(); i++)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			ASSERT_TRUE(pResult->m_Completed.load());
+		}
+	}
+
+	int NumMaps()
+	{
+		auto pConn = CreateSqliteConnection(m_aDatabase, false);
+		char aError[256] = {};
+		EXPECT_FALSE(pConn->Connect(aError, sizeof(aError))) << aError;
+		EXPECT_FALSE(pConn->PrepareStatement("SELECT COUNT(*) FROM record_maps", aError, sizeof(aError))) << aError;
+		bool End = true;
+		EXPECT_FALSE(pConn->Step(&End, aError, sizeof(aError))) << aError;
+		EXPECT_FALSE(End);
+		int Num = End ? 0 : pConn->GetInt(1);
+		pConn->Disconnect();
+		return Num;
+	}
+
+	CTestInfo m_Info;
+	char m_aDatabase[64];
+	std::unique_ptr<CDbConnectionPool> m_pPool = std::make_unique<CDbConnectionPool>();
+
+	static std::mutex ms_ThreadsMutex;
+	static std::set<std::thread::id> ms_Threads;
+};
+
+std::mutex ConnectionPool::ms_ThreadsMutex;
+std::set<std::thread::id> ConnectionPool::ms_Threads;
+
+TEST_F(ConnectionPool, ParallelReads)
+{
+	const int NumWorkers = 3;
+	m_pPool->SetNumReadWorkers(NumWorkers);
+	ms_Threads.clear();
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < 4 * NumWorkers; i++)
+	{
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		m_pPool->Execute(RecordThread, std::make_unique<CTestSqlData>(vpResults.back(), ""), "record thread");
+	}
+	WaitForCompletion(vpResults);
+	for(const auto &pResult : vpResults)
+		EXPECT_TRUE(pResult->m_Success);
+	std::lock_guard<std::mutex> Lock(ms_ThreadsMutex);
+	EXPECT_EQ((int)ms_Threads.size(), NumWorkers);
+}
+
+TEST_F(ConnectionPool, BatchWrites)
+{
+	const int NumWrites = 50;
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < NumWrites; i++)
+	{
+		char aMap[32];
+		str_format(aMap, sizeof(aMap), "map %d", i);
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		m_pPool->ExecuteWrite(InsertMap, std::make_unique<CTestSqlData>(vpResults.back(), aMap), "insert map", true);
+	}
+	WaitForCompletion(vpResults);
+	for(const auto &pResult : vpResults)
+		EXPECT_TRUE(pResult->m_Success);
+	EXPECT_EQ(NumMaps(), NumWrites);
+}
+
+TEST_F(ConnectionPool, BatchWriteFails)
+{
+	const int NumWrites = 50;
+	const int Duplicate = 20;
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < NumWrites; i++)
+	{
+		// inserting the same map twice fails and with it the transaction
+		// of its batch, the other writes must still be committed
+		char aMap[32];
+		str_format(aMap, sizeof(aMap), "map %d", i == Duplicate ? Duplicate - 1 : i);
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		m_pPool->ExecuteWrite(InsertMap, std::make_unique<CTestSqlData>(vpResults.back(), aMap), "insert map", true);
+	}
+	WaitForCompletion(vpResults);
+	for(int i = 0; i < NumWrites; i++)
+		EXPECT_EQ(vpResults[i]->m_Success, i != Duplicate) << i;
+	EXPECT_EQ(NumMaps(), NumWrites - 1);
+}
+
 auto g_pSqliteConn = CreateSqliteConnection(":memory:", true);
 #if defined(CONF_TEST_MYSQL)
 CMysqlConfig gMysqlConfig{
@@ -624,3 +809,4 @@ INSTANTIATE(MapInfo);
 INSTANTIATE(MapVote);
 INSTANTIATE(Points);
 INSTANTIATE(RandomMap);
+INSTANTIATE(Transaction);
@@ -0,0 +1,427 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/server/server_info_entry.h>
+#include <engine/shared/masterserver.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+
+#include <random>
+#include <vector>
+
+struct CTestClient
+{
+	char m_aName[MAX_NAME_LENGTH];
+	char m_aClan[MAX_CLAN_LENGTH];
+	int m_Country;
+	std::optional<int> m_Score;
+	bool m_IsPlayer;
+	bool m_Included;
+};
+
+// the client entries as the server packed them before they were cached
+static void PackClient(CPacker *pPacker, int Format, const CTestClient &Client)
+{
+	char aBuf[16];
+	pPacker->AddString(Client.m_aName, MAX_NAME_LENGTH);
+	pPacker->AddString(Client.m_aClan, MAX_CLAN_LENGTH);
+	if(Format == CServerInfoEntry::FORMAT_SIXUP)
+	{
+		pPacker->AddInt(Client.m_Country);
+		pPacker->AddInt(Client.m_Score.value_or(-1));
+		pPacker->AddInt(Client.m_IsPlayer ? 0 : 1);
+		return;
+	}
+	str_from_int(Client.m_Country, aBuf);
+	pPacker->AddString(aBuf, 0);
+	int Score;
+	if(Client.m_Score.has_value())
+	{
+		Score = Client.m_Score.value();
+		if(Score == 9999)
+			Score = -10000;
+		else if(Score == 0)
+			Score = -1;
+		else
+			Score = -Score;
+	}
+	else
+	{
+		Score = -9999;
+	}
+	str_from_int(Score, aBuf);
+	pPacker->AddString(aBuf, 0);
+	str_from_int(Client.m_IsPlayer ? 1 : 0, aBuf);
+	pPacker->AddString(aBuf, 0);
+	if(Format == CServerInfoEntry::FORMAT_EXTENDED)
+		pPacker->AddString("", 0);
+}
+
+// the server info packets as the server packed them before the entries were
+// cached, from all clients at once
+static void ReferencePack(std::vector<std::vector<uint8_t>> &vvChunks, int Type, const CServerInfoHeader &Header, const std::vector<CTestClient> &vClients, bool SendClients)
+{
+	vvChunks.clear();
+	CPacker p;
+	char aBuf[128];
+
+	int PlayerCount = 0, ClientCount = 0;
+	for(const CTestClient &Client : vClients)
+	{
+		if(Client.m_Included)
+		{
+			if(Client.m_IsPlayer)
+				PlayerCount++;
+			ClientCount++;
+		}
+	}
+
+	p.Reset();
+	const auto &&AddInt = [&](CPacker &Packer, int Value) {
+		str_from_int(Value, aBuf);
+		Packer.AddString(aBuf, 0);
+	};
+
+	p.AddString(Header.m_pVersion, 32);
+	if(Type != SERVERINFO_VANILLA)
+		p.AddString(Header.m_pName, 256);
+	else if(Header.m_MaxClients <= VANILLA_MAX_CLIENTS)
+		p.AddString(Header.m_pName, 64);
+	else
+	{
+		str_format(aBuf, sizeof(aBuf), "%s [%d/%d]", Header.m_pName, ClientCount, maximum(ClientCount, Header.m_MaxClients - Header.m_ReservedSlots));
+		p.AddString(aBuf, 64);
+	}
+	p.AddString(Header.m_pMapName, 32);
+	if(Type == SERVERINFO_EXTENDED)
+	{
+		AddInt(p, Header.m_MapCrc);
+		AddInt(p, Header.m_MapSize);
+	}
+	p.AddString(Header.m_pGameType, 16);
+	AddInt(p, Header.m_Password ? SERVER_FLAG_PASSWORD : 0);
+
+	int MaxClientsProtocol = MAX_CLIENTS;
+	if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
+	{
+		if(ClientCount >= VANILLA_MAX_CLIENTS)
+			ClientCount = ClientCount < Header.m_MaxClients ? VANILLA_MAX_CLIENTS - 1 : VANILLA_MAX_CLIENTS;
+		MaxClientsProtocol = VANILLA_MAX_CLIENTS;
+		PlayerCount = minimum(PlayerCount, ClientCount);
+	}
+	AddInt(p, PlayerCount);
+	AddInt(p, minimum(MaxClientsProtocol, maximum(Header.m_MaxClients - maximum(Header.m_SpectatorSlots, Header.m_ReservedSlots), PlayerCount)));
+	AddInt(p, ClientCount);
+	AddInt(p, minimum(MaxClientsProtocol, maximum(Header.m_MaxClients - Header.m_ReservedSlots, ClientCount)));
+	if(Type == SERVERINFO_EXTENDED)
+		p.AddString("", 0);
+
+	CPacker q;
+	int PlayersStored = 0;
+	const auto &&Save = [&](int Size) { vvChunks.emplace_back(q.Data(), q.Data() + Size); };
+	q.Reset();
+	q.AddRaw(p.Data(), p.Size());
+	if(Type == SERVERINFO_64_LEGACY)
+		q.AddInt(PlayersStored);
+	if(!SendClients)
+	{
+		Save(q.Size());
+		return;
+	}
+
+	int Remaining = Type == SERVERINFO_EXTENDED ? -1 : Type == SERVERINFO_64_LEGACY ? 24 : VANILLA_MAX_CLIENTS;
+	const int Format = Type == SERVERINFO_EXTENDED ? CServerInfoEntry::FORMAT_EXTENDED : CServerInfoEntry::FORMAT_VANILLA;
+	for(int i = 0; i < (int)vClients.size(); i++)
+	{
+		if(!vClients[i].m_Included)
+			continue;
+		if(Remaining == 0)
+		{
+			if(Type != SERVERINFO_64_LEGACY)
+				break;
+			Save(q.Size());
+			q.Reset();
+			q.AddRaw(p.Data(), p.Size());
+			q.AddInt(PlayersStored);
+			Remaining = 24;
+		}
+		if(Remaining > 0)
+			Remaining--;
+
+		const int PreviousSize = q.Size();
+		PackClient(&q, Format, vClients[i]);
+		if(Type == SERVERINFO_EXTENDED && q.Size() >= NET_MAX_PAYLOAD - 18)
+		{
+			Save(PreviousSize);
+			const int ChunksStored = vvChunks.size();
+			q.Reset();
+			AddInt(q, ChunksStored);
+			q.AddString("", 0);
+			i--;
+			continue;
+		}
+		PlayersStored++;
+	}
+	Save(q.Size());
+}
+
+static void ReferencePackSixup(std::vector<uint8_t> &vData, const CServerInfoHeader &Header, const std::vector<CTestClient> &vClients, bool SendClients)
+{
+	int PlayerCount = 0, ClientCount = 0;
+	for(const CTestClient &Client : vClients)
+	{
+		if(Client.m_Included)
+		{
+			if(Client.m_IsPlayer)
+				PlayerCount++;
+			ClientCount++;
+		}
+	}
+
+	CPacker Packer;
+	Packer.Reset();
+	char aVersion[32];
+	str_format(aVersion, sizeof(aVersion), "0.7↔%s", Header.m_pVersion);
+	Packer.AddString(aVersion, 32);
+	Packer.AddString(Header.m_pName, 64);
+	Packer.AddString(Header.m_pHostname, 128);
+	Packer.AddString(Header.m_pMapName, 32);
+	Packer.AddString(Header.m_pGameType, 16);
+	Packer.AddInt(SERVER_FLAG_TIMESCORE | (Header.m_Password ? SERVER_FLAG_PASSWORD : 0));
+	Packer.AddInt(Header.m_SkillLevel);
+	Packer.AddInt(PlayerCount);
+	Packer.AddInt(maximum(Header.m_MaxClients - maximum(Header.m_SpectatorSlots, Header.m_ReservedSlots), PlayerCount));
+	Packer.AddInt(ClientCount);
+	Packer.AddInt(maximum(Header.m_MaxClients - Header.m_ReservedSlots, ClientCount));
+	if(SendClients)
+	{
+		for(const CTestClient &Client : vClients)
+		{
+			if(Client.m_Included)
+				PackClient(&Packer, CServerInfoEntry::FORMAT_SIXUP, Client);
+		}
+	}
+	vData.assign(Packer.Data(), Packer.Data() + Packer.Size());
+}
+
+static CServerInfoHeader TestHeader()
+{
+	CServerInfoHeader Header;
+	Header.m_pVersion = "0.6.4, 17.4";
+	Header.m_pName = "My DDNet Server with a rather long name";
+	Header.m_pHostname = "ddnet.example.org";
+	Header.m_pMapName = "Tutorial";
+	Header.m_pGameType = "DDraceNetwork";
+	Header.m_MapCrc = 0xdeadbeef;
+	Header.m_MapSize = 123456;
+	Header.m_Password = false;
+	Header.m_MaxClients = MAX_CLIENTS;
+	Header.m_SpectatorSlots = 0;
+	Header.m_ReservedSlots = 0;
+	Header.m_SkillLevel = 1;
+	return Header;
+}
+
+class CRandomClients
+{
+	std::mt19937 m_Rng;
+
+public:
+	std::vector<CTestClient> m_vClients;
+	std::vector<CServerInfoEntry> m_vEntries;
+
+	CRandomClients(int Seed) :
+		m_Rng(Seed), m_vClients(MAX_CLIENTS), m_vEntries(MAX_CLIENTS)
+	{
+		for(auto &Client : m_vClients)
+			Randomize(Client);
+	}
+
+	void Randomize(CTestClient &Client)
+	{
+		static const char *s_apNames[] = {"nameless tee", "brainless tee", "(connecting)", "Ünïcödé 名前", "aaaaaaaaaaaaaaa", "\xff\xfe"};
+		static const char *s_apClans[] = {"", "clan", "äöüäöüäö", "12345678901"};
+		static const int s_aScores[] = {0, 1, 9999, -9999, 123456, -1};
+		str_copy(Client.m_aName, s_apNames[m_Rng() % std::size(s_apNames)]);
+		str_copy(Client.m_aClan, s_apClans[m_Rng() % std::size(s_apClans)]);
+		Client.m_Country = m_Rng() % 2 ? -1 : (int)(m_Rng() % 1000);
+		if(m_Rng() % 8 == 0)
+			Client.m_Score.reset();
+		else
+			Client.m_Score = m_Rng() % 2 ? s_aScores[m_Rng() % std::size(s_aScores)] : (int)(m_Rng() % 100000);
+		Client.m_IsPlayer = m_Rng() % 4 != 0;
+		Client.m_Included = m_Rng() % 8 != 0;
+	}
+
+	// a few clients change, e.g. their score, or leave and join
+	void Churn(int NumChanges)
+	{
+		for(; NumChanges > 0; NumChanges--)
+		{
+			CTestClient &Client = m_vClients[m_Rng() % m_vClients.size()];
+			switch(m_Rng() % 4)
+			{
+			case 0: Randomize(Client); break;
+			case 1: Client.m_Included = !Client.m_Included; break;
+			default: Client.m_Score = Client.m_Score.value_or(0) + 1;
+			}
+		}
+	}
+
+	// like `CServer::UpdateServerInfoEntries`
+	void UpdateEntries(const CServerInfoEntry **ppEntries)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const CTestClient &Client = m_vClients[i];
+			ppEntries[i] = nullptr;
+			if(!Client.m_Included)
+				continue;
+			m_vEntries[i].Update(Client.m_aName, Client.m_aClan, Client.m_Country, Client.m_Score, Client.m_IsPlayer);
+			ppEntries[i] = &m_vEntries[i];
+		}
+	}
+};
+
+TEST(ServerInfoEntry, MatchesFullRebuild)
+{
+	CRandomClients Clients(0);
+	std::mt19937 Rng(1);
+	CServerInfoHeader Header = TestHeader();
+	int NumSplit = 0, NumLegacySplit = 0, NumTruncated = 0;
+	for(int Round = 0; Round < 200; Round++)
+	{
+		Clients.Churn(Rng() % 4);
+		const CServerInfoEntry *apEntries[MAX_CLIENTS];
+		Clients.UpdateEntries(apEntries);
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const CTestClient &Client = Clients.m_vClients[i];
+			if(Client.m_Included)
+			{
+				EXPECT_FALSE(Clients.m_vEntries[i].Update(Client.m_aName, Client.m_aClan, Client.m_Country, Client.m_Score, Client.m_IsPlayer));
+			}
+		}
+
+		// the server settings change less often
+		if(Round % 10 == 0)
+		{
+			const int aMaxClients[] = {VANILLA_MAX_CLIENTS, 32, MAX_CLIENTS};
+			Header.m_MaxClients = aMaxClients[Rng() % std::size(aMaxClients)];
+			Header.m_SpectatorSlots = Rng() % 3 == 0 ? Rng() % 8 : 0;
+			Header.m_ReservedSlots = Rng() % 3 == 0 ? Rng() % 8 : 0;
+			Header.m_Password = Rng() % 2;
+		}
+
+		for(int Type : {SERVERINFO_VANILLA, SERVERINFO_64_LEGACY, SERVERINFO_EXTENDED, SERVERINFO_INGAME})
+		{
+			for(bool SendClients : {false, true})
+			{
+				std::vector<std::vector<uint8_t>> vvExpected, vvActual;
+				ReferencePack(vvExpected, Type, Header, Clients.m_vClients, SendClients);
+				ServerInfoPack(vvActual, Type, Header, apEntries, SendClients);
+				ASSERT_EQ(vvActual, vvExpected) << "round " << Round << " type " << Type << " clients " << SendClients;
+				for(const auto &vChunk : vvActual)
+					EXPECT_LE(vChunk.size() + 18, (size_t)NET_MAX_PAYLOAD);
+				if(SendClients)
+				{
+					NumSplit += Type == SERVERINFO_EXTENDED && vvActual.size() > 1;
+					NumLegacySplit += Type == SERVERINFO_64_LEGACY && vvActual.size() > 1;
+				}
+			}
+		}
+		int NumIncluded = 0;
+		for(const CTestClient &Client : Clients.m_vClients)
+			NumIncluded += Client.m_Included;
+		NumTruncated += NumIncluded > VANILLA_MAX_CLIENTS;
+
+		for(bool SendClients : {false, true})
+		{
+			std::vector<uint8_t> vExpected, vActual;
+			ReferencePackSixup(vExpected, Header, Clients.m_vClients, SendClients);
+			ServerInfoPackSixup(vActual, Header, apEntries, SendClients);
+			ASSERT_EQ(vActual, vExpected) << "round " << Round << " sixup clients " << SendClients;
+		}
+	}
+	// the extended info was split into several packets, the legacy 64 player
+	// info too and the vanilla info was cut off
+	EXPECT_GT(NumSplit, 0);
+	EXPECT_GT(NumLegacySplit, 0);
+	EXPECT_GT(NumTruncated, 0);
+}
+
+TEST(ServerInfoEntry, UpdateInterval)
+{
+	// changes every 5 ms for a second, checked by a main loop running every ms
+	const int64_t Ms = time_freq() / 1000;
+	for(int IntervalMs : {0, 100})
+	{
+		int64_t LastUpdate = 0;
+		int64_t FirstChange = -1;
+		int NumRebuilds = 0;
+		int64_t MaxDelay = 0;
+		for(int64_t Now = 10000 * Ms; Now < 11000 * Ms; Now += Ms)
+		{
+			if(Now % (5 * Ms) == 0 && FirstChange < 0)
+				FirstChange = Now;
+			if(FirstChange >= 0 && ServerInfoUpdateDue(Now, LastUpdate, IntervalMs))
+			{
+				NumRebuilds++;
+				MaxDelay = maximum(MaxDelay, Now - FirstChange);
+				LastUpdate = Now;
+				FirstChange = -1;
+			}
+		}
+		if(IntervalMs == 0)
+		{
+			// every change is sent at once
+			EXPECT_EQ(NumRebuilds, 200);
+			EXPECT_EQ(MaxDelay, 0);
+		}
+		else
+		{
+			EXPECT_EQ(NumRebuilds, 10);
+			EXPECT_LE(MaxDelay, IntervalMs * Ms);
+		}
+	}
+}
+
+TEST(ServerInfoEntry, RebuildTime)
+{
+	// a full server where one score changes per rebuild
+	CRandomClients Clients(2);
+	for(auto &Client : Clients.m_vClients)
+		Client.m_Included = true;
+	const CServerInfoHeader Header = TestHeader();
+	const int NumRebuilds = 500;
+
+	// all caches of `CServer::UpdateServerInfo`
+	auto &&Measure = [&](auto &&Rebuild) {
+		std::vector<std::vector<uint8_t>> vvChunks;
+		std::vector<uint8_t> vSixup;
+		const int64_t Start = time_get();
+		for(int i = 0; i < NumRebuilds; i++)
+		{
+			Clients.m_vClients[i % MAX_CLIENTS].m_Score = i;
+			Rebuild(vvChunks, vSixup);
+		}
+		return (time_get() - Start) * 1000000000 / time_freq() / NumRebuilds;
+	};
+	RecordProperty("FullRebuildNs", (int)Measure([&](std::vector<std::vector<uint8_t>> &vvChunks, std::vector<uint8_t> &vSixup) {
+		for(int Type = 0; Type < 3; Type++)
+			for(bool SendClients : {false, true})
+				ReferencePack(vvChunks, Type, Header, Clients.m_vClients, SendClients);
+		for(bool SendClients : {false, true})
+			ReferencePackSixup(vSixup, Header, Clients.m_vClients, SendClients);
+	}));
+	RecordProperty("CachedEntriesNs", (int)Measure([&](std::vector<std::vector<uint8_t>> &vvChunks, std::vector<uint8_t> &vSixup) {
+		const CServerInfoEntry *apEntries[MAX_CLIENTS];
+		Clients.UpdateEntries(apEntries);
+		for(int Type = 0; Type < 3; Type++)
+			for(bool SendClients : {false, true})
+				ServerInfoPack(vvChunks, Type, Header, apEntries, SendClients);
+		for(bool SendClients : {false, true})
+			ServerInfoPackSixup(vSixup, Header, apEntries, SendClients);
+	}));
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <memory>
 
+#include <engine/client/serverbrowser.h>
 #include <engine/client/serverbrowser_ping_cache.h>
 #include <engine/console.h>
 #include <engine/engine.h>
@@ -97,3 +98,98 @@ TEST(ServerBrowser, PingCache)
 	EXPECT_EQ(pPingCache->GetPing(&OtherLocalhost4, 1), 1337);
 	EXPECT_EQ(pPingCache->GetPing(&OtherLocalhost6, 1), 345);
 }
+
+TEST(ServerBrowser, FoldSearchKey)
+{
+	const char *apStrings[] = {"", "a", "ABC", "Hello World", "ÄÖÜ äöü", "ΑΒΓ αβγ", "Straße", "İstanbul", "ȺȾ", "日本語", "\xff\xfe", "ab\xff" "CD"};
+	for(const char *pHaystack : apStrings)
+	{
+		char aHaystackKey[128];
+		ServerBrowserFoldSearchKey(aHaystackKey, sizeof(aHaystackKey), pHaystack);
+		for(const char *pNeedle : apStrings)
+		{
+			if(pNeedle[0] == '\0' || !str_utf8_check(pHaystack) || !str_utf8_check(pNeedle))
+				continue;
+			char aNeedleKey[128];
+			ServerBrowserFoldSearchKey(aNeedleKey, sizeof(aNeedleKey), pNeedle);
+			EXPECT_EQ(str_find(aHaystackKey, aNeedleKey) != nullptr, str_utf8_find_nocase(pHaystack, pNeedle) != nullptr) << pHaystack << " " << pNeedle;
+		}
+	}
+
+	char aKey[16];
+	ServerBrowserFoldSearchKey(aKey, sizeof(aKey), "ÄBC ÄBC ÄBC ÄBC ÄBC");
+	EXPECT_STREQ(aKey, "äbc äbc äbc ");
+}
+
+TEST(ServerBrowser, MergeSorted)
+{
+	// synthetic server list, only some servers change between sorts
+	const int NumServers = 10000;
+	std::vector<int> vKeys(NumServers);
+	std::vector<bool> vVisible(NumServers);
+	std::vector<bool> vChanged(NumServers, false);
+	unsigned Seed = 1;
+	auto Random = [&](int Max) {
+		Seed = Seed * 1103515245 + 12345;
+		return (int)((Seed >> 8) % Max);
+	};
+	for(int i = 0; i < NumServers; i++)
+	{
+		vKeys[i] = Random(100);
+		vVisible[i] = Random(4) != 0;
+	}
+	auto Less = [&](int Index1, int Index2) { return vKeys[Index1] < vKeys[Index2]; };
+
+	std::vector<int> vSorted(NumServers);
+	int NumSorted = 0;
+	for(int i = 0; i < NumServers; i++)
+	{
+		if(vVisible[i])
+			vSorted[NumSorted++] = i;
+	}
+	std::stable_sort(vSorted.begin(), vSorted.begin() + NumSorted, Less);
+
+	// the rounds after the first one, where everything changed
+	int64_t MergeTime = 0;
+	int64_t SortTime = 0;
+	for(int Round = 0; Round < 50; Round++)
+	{
+		std::vector<int> vDirty;
+		const int NumChanges = Round == 0 ? NumServers : Random(200);
+		for(int i = 0; i < NumChanges; i++)
+		{
+			const int Index = Round == 0 ? i : Random(NumServers);
+			if(!vChanged[Index])
+			{
+				vChanged[Index] = true;
+				vDirty.push_back(Index);
+			}
+			vKeys[Index] = Random(100);
+			vVisible[Index] = Random(4) != 0;
+		}
+
+		int64_t Start = time_get();
+		NumSorted = ServerBrowserMergeSorted(
+			vSorted.data(), NumSorted, vDirty, Less,
+			[&](int Index) { return vChanged[Index]; },
+			[&](int Index) { return vVisible[Index]; });
+		if(Round > 0)
+			MergeTime += time_get() - Start;
+		std::fill(vChanged.begin(), vChanged.end(), false);
+
+		// what the server browser did before, sorting all servers
+		Start = time_get();
+		std::vector<int> vExpected;
+		for(int i = 0; i < NumServers; i++)
+		{
+			if(vVisible[i])
+				vExpected.push_back(i);
+		}
+		std::stable_sort(vExpected.begin(), vExpected.end(), Less);
+		if(Round > 0)
+			SortTime += time_get() - Start;
+		ASSERT_EQ(std::vector<int>(vSorted.begin(), vSorted.begin() + NumSorted), vExpected) << "round " << Round;
+	}
+	RecordProperty("MergeUs", (int)(MergeTime * 1000000 / time_freq()));
+	RecordProperty("FullSortUs", (int)(SortTime * 1000000 / time_freq()));
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/jobs.h>
+#include <engine/storage.h>
+#include <game/client/skin_load.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static const int TEST_NUM_THREADS = 4;
+
+static std::shared_ptr<CSkinLoadJob> CreateJob(IStorage *pStorage, const char *pName)
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "data/skins/%s.png", pName);
+	return std::make_shared<CSkinLoadJob>(pStorage, pName, aPath, IStorage::TYPE_ALL);
+}
+
+static int SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	if(!IsDir && str_endswith(pName, ".png"))
+		static_cast<std::vector<std::string> *>(pUser)->emplace_back(pName, str_length(pName) - 4);
+	return 0;
+}
+
+static void ExpectSameMetric(const CSkin::SSkinMetricVariable &Expected, const CSkin::SSkinMetricVariable &Actual)
+{
+	EXPECT_EQ((int)Expected.m_Width, (int)Actual.m_Width);
+	EXPECT_EQ((int)Expected.m_Height, (int)Actual.m_Height);
+	EXPECT_EQ((int)Expected.m_OffsetX, (int)Actual.m_OffsetX);
+	EXPECT_EQ((int)Expected.m_OffsetY, (int)Actual.m_OffsetY);
+	EXPECT_EQ((int)Expected.m_MaxWidth, (int)Actual.m_MaxWidth);
+	EXPECT_EQ((int)Expected.m_MaxHeight, (int)Actual.m_MaxHeight);
+}
+
+static void ExpectSameData(const CSkinLoadData &Expected, const CSkinLoadData &Actual)
+{
+	ASSERT_EQ(Expected.m_Prepared, Actual.m_Prepared);
+	if(!Expected.m_Prepared)
+		return;
+	ASSERT_EQ(Expected.m_Info.m_Width, Actual.m_Info.m_Width);
+	ASSERT_EQ(Expected.m_Info.m_Height, Actual.m_Info.m_Height);
+	const size_t Size = (size_t)Expected.m_Info.m_Width * Expected.m_Info.m_Height * 4;
+	EXPECT_EQ(mem_comp(Expected.m_Info.m_pData, Actual.m_Info.m_pData, Size), 0);
+	EXPECT_EQ(mem_comp(Expected.m_InfoGrayscale.m_pData, Actual.m_InfoGrayscale.m_pData, Size), 0);
+	EXPECT_EQ(Expected.m_BloodColor, Actual.m_BloodColor);
+	ExpectSameMetric(Expected.m_Metrics.m_Body, Actual.m_Metrics.m_Body);
+	ExpectSameMetric(Expected.m_Metrics.m_Feet, Actual.m_Metrics.m_Feet);
+}
+
+class SkinLoad : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IStorage> m_pStorage;
+	CJobPool m_Pool;
+
+	SkinLoad() :
+		m_pStorage(CreateLocalStorage())
+	{
+		m_Pool.Init(TEST_NUM_THREADS);
+	}
+};
+
+TEST_F(SkinLoad, PrepareDefault)
+{
+	auto pJob = CreateJob(m_pStorage.get(), "default");
+	CJobPool::RunBlocking(pJob.get());
+	ASSERT_TRUE(pJob->m_Loaded);
+	ASSERT_TRUE(pJob->m_Data.m_Prepared);
+
+	const CImageInfo &Info = pJob->m_Data.m_Info;
+	const CImageInfo &Grayscale = pJob->m_Data.m_InfoGrayscale;
+	ASSERT_EQ(Info.m_Format, CImageInfo::FORMAT_RGBA);
+	ASSERT_EQ(Grayscale.m_Width, Info.m_Width);
+	ASSERT_EQ(Grayscale.m_Height, Info.m_Height);
+	ASSERT_NE(Grayscale.m_pData, Info.m_pData);
+
+	// the colorable image is gray with the alpha of the original one
+	const uint8_t *pOrg = (const uint8_t *)Info.m_pData;
+	const uint8_t *pGray = (const uint8_t *)Grayscale.m_pData;
+	for(int i = 0; i < Info.m_Width * Info.m_Height; i++)
+	{
+		ASSERT_EQ(pGray[i * 4], pGray[i * 4 + 1]) << i;
+		ASSERT_EQ(pGray[i * 4], pGray[i * 4 + 2]) << i;
+		ASSERT_EQ(pGray[i * 4 + 3], pOrg[i * 4 + 3]) << i;
+	}
+
+	const CSkin::SSkinMetrics &Metrics = pJob->m_Data.m_Metrics;
+	for(const CSkin::SSkinMetricVariable *pMetric : {&Metrics.m_Body, &Metrics.m_Feet})
+	{
+		EXPECT_GT((int)pMetric->m_Width, 0);
+		EXPECT_LE((int)pMetric->m_Width, (int)pMetric->m_MaxWidth);
+		EXPECT_GT((int)pMetric->m_Height, 0);
+		EXPECT_LE((int)pMetric->m_Height, (int)pMetric->m_MaxHeight);
+		EXPECT_GE((int)pMetric->m_OffsetX, 0);
+		EXPECT_GE((int)pMetric->m_OffsetY, 0);
+	}
+
+	const ColorRGBA &Blood = pJob->m_Data.m_BloodColor;
+	EXPECT_GT(Blood.r + Blood.g + Blood.b, 0.0f);
+	EXPECT_EQ(Blood.a, 1.0f);
+
+	pJob->m_Data.Free();
+	EXPECT_EQ(Info.m_pData, nullptr);
+	EXPECT_EQ(Grayscale.m_pData, nullptr);
+	EXPECT_FALSE(pJob->m_Data.m_Prepared);
+}
+
+TEST_F(SkinLoad, Missing)
+{
+	auto pJob = CreateJob(m_pStorage.get(), "does_not_exist");
+	CJobPool::RunBlocking(pJob.get());
+	EXPECT_FALSE(pJob->m_Loaded);
+	EXPECT_FALSE(pJob->m_Data.m_Prepared);
+	EXPECT_EQ(pJob->m_Data.m_Info.m_pData, nullptr);
+}
+
+TEST_F(SkinLoad, NotPrepared)
+{
+	// images that have to be checked on the main thread first
+	const struct
+	{
+		int m_Width;
+		int m_Height;
+		CImageInfo::EImageFormat m_Format;
+	} aCases[] = {
+		{256, 128, CImageInfo::FORMAT_RGB},
+		{100, 100, CImageInfo::FORMAT_RGBA},
+		{256, 130, CImageInfo::FORMAT_RGBA},
+	};
+	for(const auto &Case : aCases)
+	{
+		CSkinLoadData Data;
+		Data.m_Info.m_Width = Case.m_Width;
+		Data.m_Info.m_Height = Case.m_Height;
+		Data.m_Info.m_Format = Case.m_Format;
+		Data.m_Info.m_pData = calloc((size_t)Case.m_Width * Case.m_Height, CImageInfo::PixelSize(Case.m_Format));
+		EXPECT_FALSE(Data.Prepare()) << Case.m_Width << "x" << Case.m_Height;
+		EXPECT_EQ(Data.m_InfoGrayscale.m_pData, nullptr);
+	}
+}
+
+TEST_F(SkinLoad, DecodeTime)
+{
+	// the CPU side of loading all skins, serially and on the job pool
+	std::vector<std::string> vNames;
+	m_pStorage->ListDirectory(IStorage::TYPE_ALL, "data/skins", SkinScan, &vNames);
+	ASSERT_GT(vNames.size(), 1u);
+
+	std::vector<std::shared_ptr<CSkinLoadJob>> vpSerial;
+	int64_t Start = time_get();
+	for(const auto &Name : vNames)
+	{
+		vpSerial.push_back(CreateJob(m_pStorage.get(), Name.c_str()));
+		CJobPool::RunBlocking(vpSerial.back().get());
+	}
+	const int64_t SerialTime = time_get() - Start;
+
+	std::vector<std::shared_ptr<CSkinLoadJob>> vpPool;
+	Start = time_get();
+	for(const auto &Name : vNames)
+	{
+		vpPool.push_back(CreateJob(m_pStorage.get(), Name.c_str()));
+		m_Pool.Add(vpPool.back());
+	}
+	for(const auto &pJob : vpPool)
+	{
+		while(pJob->Status() != IJob::STATE_DONE)
+			thread_yield();
+	}
+	const int64_t PoolTime = time_get() - Start;
+
+	int NumPrepared = 0;
+	for(size_t i = 0; i < vNames.size(); i++)
+	{
+		SCOPED_TRACE(vNames[i]);
+		EXPECT_TRUE(vpSerial[i]->m_Loaded);
+		EXPECT_EQ(vpSerial[i]->m_Loaded, vpPool[i]->m_Loaded);
+		ExpectSameData(vpSerial[i]->m_Data, vpPool[i]->m_Data);
+		NumPrepared += vpSerial[i]->m_Data.m_Prepared;
+	}
+	EXPECT_GT(NumPrepared, 0);
+
+	RecordProperty("Skins", (int)vNames.size());
+	RecordProperty("SerialMs", (int)(SerialTime * 1000 / time_freq()));
+	RecordProperty("PoolMs", (int)(PoolTime * 1000 / time_freq()));
+	RecordProperty("Threads", TEST_NUM_THREADS);
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/snapshot.h>
+
+#include <game/generated/protocol.h>
+
+#include <iterator>
+#include <random>
+#include <vector>
+
+static const int ITEM_TYPE = 9;
+static const int NEAR_ID = 3;
+static const int FAR_ID = 7;
+static const int FAR_INTERVAL = 4;
+
+struct CTestItem
+{
+	int m_Tick;
+	int m_X;
+	int m_Y;
+};
+
+class CSnapshotLodTest : public ::testing::Test
+{
+protected:
+	CSnapshotBuilder m_Builder;
+	CSnapshotDelta m_Delta;
+	CSnapshotLod m_Lod;
+
+	alignas(CSnapshot) char m_aServerPrev[CSnapshot::MAX_SIZE];
+	alignas(CSnapshot) char m_aServerCur[CSnapshot::MAX_SIZE];
+	alignas(CSnapshot) char m_aClientPrev[CSnapshot::MAX_SIZE];
+	alignas(CSnapshot) char m_aClientCur[CSnapshot::MAX_SIZE];
+	bool m_HavePrev = false;
+
+	CSnapshot *ServerPrev() { return (CSnapshot *)m_aServerPrev; }
+	CSnapshot *ServerCur() { return (CSnapshot *)m_aServerCur; }
+	CSnapshot *ClientPrev() { return (CSnapshot *)m_aClientPrev; }
+	CSnapshot *ClientCur() { return (CSnapshot *)m_aClientCur; }
+
+	void SnapItem(int ID, int Tick)
+	{
+		CTestItem *pItem = (CTestItem *)m_Builder.NewItem(ITEM_TYPE, ID, sizeof(CTestItem));
+		ASSERT_TRUE(pItem);
+		pItem->m_Tick = Tick;
+		pItem->m_X = Tick * 10 + ID;
+		pItem->m_Y = -Tick * 3;
+	}
+
+	// Builds a snapshot the way the server does and returns the delta size
+	// the client receives for it, the client state ends up in `ClientCur()`.
+	int Step(int Tick, bool *pFarRefreshed)
+	{
+		m_Builder.Init();
+		SnapItem(NEAR_ID, Tick);
+		*pFarRefreshed = !m_HavePrev || m_Lod.IsDue(FAR_ID, FAR_INTERVAL) || !m_Builder.CopyItems(ServerPrev(), FAR_ID, &ITEM_TYPE, 1);
+		if(*pFarRefreshed)
+			SnapItem(FAR_ID, Tick);
+		int Size = m_Builder.Finish(ServerCur());
+		EXPECT_TRUE(ServerCur()->IsValid(Size));
+
+		const CSnapshot *pFrom = m_HavePrev ? ServerPrev() : CSnapshot::EmptySnapshot();
+		char aDelta[CSnapshot::MAX_SIZE];
+		int DeltaSize = m_Delta.CreateDelta(pFrom, ServerCur(), aDelta);
+
+		const CSnapshot *pClientFrom = m_HavePrev ? ClientPrev() : CSnapshot::EmptySnapshot();
+		int ClientSize = m_Delta.UnpackDelta(pClientFrom, ClientCur(), aDelta, DeltaSize);
+		EXPECT_GE(ClientSize, 0);
+
+		m_Lod.OnSnapshotSent(DeltaSize, 0);
+		mem_copy(m_aServerPrev, m_aServerCur, Size);
+		mem_copy(m_aClientPrev, m_aClientCur, maximum(ClientSize, 0));
+		m_HavePrev = true;
+		return DeltaSize;
+	}
+};
+
+TEST_F(CSnapshotLodTest, ClientKeepsCoherentItems)
+{
+	CTestItem LastFar = {-1, 0, 0};
+	int LastRefreshTick = -1;
+	for(int Tick = 0; Tick < 64; Tick++)
+	{
+		bool FarRefreshed;
+		Step(Tick, &FarRefreshed);
+
+		// both items stay in the client's snapshot every time
+		const CTestItem *pNear = (const CTestItem *)ClientCur()->FindItem(ITEM_TYPE, NEAR_ID);
+		const CTestItem *pFar = (const CTestItem *)ClientCur()->FindItem(ITEM_TYPE, FAR_ID);
+		ASSERT_TRUE(pNear);
+		ASSERT_TRUE(pFar);
+
+		// the relevant item is always current
+		EXPECT_EQ(pNear->m_Tick, Tick);
+		EXPECT_EQ(pNear->m_X, Tick * 10 + NEAR_ID);
+
+		// the distant one is a complete state of the tick it was last
+		// refreshed at, never a mix of several ticks
+		EXPECT_EQ(pFar->m_X, pFar->m_Tick * 10 + FAR_ID);
+		EXPECT_EQ(pFar->m_Y, -pFar->m_Tick * 3);
+		if(FarRefreshed)
+		{
+			EXPECT_EQ(pFar->m_Tick, Tick);
+			LastRefreshTick = Tick;
+		}
+		else
+		{
+			EXPECT_EQ(mem_comp(pFar, &LastFar, sizeof(LastFar)), 0);
+		}
+		EXPECT_LT(Tick - LastRefreshTick, FAR_INTERVAL);
+		LastFar = *pFar;
+	}
+}
+
+TEST_F(CSnapshotLodTest, HeldItemsSaveBandwidth)
+{
+	int HeldSize = -1;
+	int RefreshedSize = -1;
+	for(int Tick = 0; Tick < 16; Tick++)
+	{
+		bool FarRefreshed;
+		int DeltaSize = Step(Tick, &FarRefreshed);
+		if(Tick == 0)
+			continue;
+		if(FarRefreshed)
+			RefreshedSize = DeltaSize;
+		else
+			HeldSize = DeltaSize;
+	}
+	ASSERT_GT(HeldSize, 0);
+	ASSERT_GT(RefreshedSize, 0);
+	EXPECT_LT(HeldSize, RefreshedSize);
+}
+
+TEST(SnapshotLod, Budget)
+{
+	CSnapshotLod Lod;
+	EXPECT_EQ(Lod.Level(), 0);
+
+	// relevant items are always due
+	for(int i = 0; i < 8; i++)
+	{
+		EXPECT_TRUE(Lod.IsDue(i, 1));
+		Lod.OnSnapshotSent(100, 0);
+	}
+
+	// over budget: the intervals are stretched up to the maximum level
+	for(int i = 0; i < CSnapshotLod::MAX_LEVEL + 2; i++)
+		Lod.OnSnapshotSent(2000, 1000);
+	EXPECT_EQ(Lod.Level(), (int)CSnapshotLod::MAX_LEVEL);
+	int NumDue = 0;
+	for(int i = 0; i < 2 << CSnapshotLod::MAX_LEVEL; i++)
+	{
+		NumDue += Lod.IsDue(5, 2);
+		EXPECT_TRUE(Lod.IsDue(5, 1));
+		Lod.OnSnapshotSent(800, 1000);
+	}
+	EXPECT_EQ(NumDue, 1);
+	EXPECT_EQ(Lod.Level(), (int)CSnapshotLod::MAX_LEVEL);
+
+	// well under budget: back to the plain intervals
+	for(int i = 0; i < CSnapshotLod::MAX_LEVEL; i++)
+		Lod.OnSnapshotSent(100, 1000);
+	EXPECT_EQ(Lod.Level(), 0);
+
+	// no budget
+	Lod.OnSnapshotSent(2000, 1000);
+	Lod.OnSnapshotSent(2000, 0);
+	EXPECT_EQ(Lod.Level(), 0);
+}
+
+TEST(SnapshotDirectory, MatchesSnapshot)
+{
+	const int aTypes[] = {NETOBJTYPE_CHARACTER, NETOBJTYPE_PLAYERINFO, NETOBJTYPE_FLAG, NETOBJTYPE_DDNETCHARACTER, NETOBJTYPE_DDNETPLAYER, 0x3fff};
+	std::mt19937 Rng(0);
+	CSnapshotBuilder Builder;
+	CSnapshotDirectory Directory;
+	alignas(CSnapshot) char aData[CSnapshot::MAX_SIZE];
+	const CSnapshot *pSnapshot = (const CSnapshot *)aData;
+	for(int Round = 0; Round < 50; Round++)
+	{
+		Builder.Init();
+		const int NumItems = Round == 0 ? 0 : Rng() % (Round < 40 ? 64 : CSnapshot::MAX_ITEMS / 2);
+		for(int i = 0; i < NumItems; i++)
+		{
+			// duplicate keys happen as well
+			int *pItem = (int *)Builder.NewItem(aTypes[Rng() % std::size(aTypes)], Rng() % 96, sizeof(int));
+			if(pItem)
+				*pItem = i;
+		}
+		Builder.Finish(aData);
+		Directory.Build(pSnapshot);
+
+		for(int Type : aTypes)
+		{
+			for(int ID = 0; ID < 96; ID++)
+			{
+				ASSERT_EQ(Directory.FindItemIndex(Type, ID), pSnapshot->FindItemIndex(Type, ID)) << "round " << Round << " type " << Type << " id " << ID;
+				ASSERT_EQ(Directory.FindItem(Type, ID), pSnapshot->FindItem(Type, ID));
+			}
+
+			std::vector<int> vExpected;
+			for(int i = 0; i < pSnapshot->NumItems(); i++)
+				if(pSnapshot->GetItemType(i) == Type)
+					vExpected.push_back(i);
+			const int *pIndices;
+			const int Num = Directory.ItemsOfType(Type, &pIndices);
+			ASSERT_EQ(std::vector<int>(pIndices, pIndices + Num), vExpected) << "round " << Round << " type " << Type;
+		}
+		EXPECT_EQ(Directory.FindItemIndex(NETOBJTYPE_CHARACTER, 0xffff), -1);
+		EXPECT_EQ(Directory.FindItemIndex(OFFSET_UUID + 1000, 0), -1);
+	}
+}
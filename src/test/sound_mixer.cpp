@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/client/sound_mixer.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+static void ReferenceAccumulate(int *pOut, const short *pIn, int Channels, unsigned NumFrames, int VolumeL, int VolumeR)
+{
+	const short *pInL = pIn;
+	const short *pInR = Channels == 1 ? pIn : pIn + 1;
+	for(unsigned s = 0; s < NumFrames; s++)
+	{
+		*pOut++ += (*pInL) * VolumeL;
+		*pOut++ += (*pInR) * VolumeR;
+		pInL += Channels;
+		pInR += Channels;
+	}
+}
+
+TEST(SoundMixer, Accumulate)
+{
+	std::mt19937 Rng(0);
+	std::uniform_int_distribution<int> Sample(-32768, 32767);
+	std::uniform_int_distribution<int> Volume(0, 255);
+
+	std::vector<short> vSamples(2 * 1000);
+	for(auto &Value : vSamples)
+		Value = Sample(Rng);
+	// extremes to catch overflows in the products
+	vSamples[0] = -32768;
+	vSamples[1] = 32767;
+
+	const unsigned MaxFrames = 517;
+	std::vector<int> vExpected(MaxFrames * 2);
+	std::vector<int> vActual(MaxFrames * 2);
+	for(int Voice = 0; Voice < 64; Voice++)
+	{
+		const int Channels = Voice % 2 + 1;
+		const unsigned NumFrames = Voice == 0 ? MaxFrames : std::uniform_int_distribution<unsigned>(0, MaxFrames)(Rng);
+		const unsigned Offset = Voice == 0 ? 0 : std::uniform_int_distribution<unsigned>(0, 1000 - MaxFrames)(Rng);
+		int VolumeL = Volume(Rng);
+		int VolumeR = Volume(Rng);
+		if(Voice == 1)
+			VolumeL = VolumeR = 255;
+		if(Voice == 2)
+			VolumeL = 70000; // out of the 16 bit fast path
+		const short *pIn = vSamples.data() + Offset * Channels;
+		ReferenceAccumulate(vExpected.data(), pIn, Channels, NumFrames, VolumeL, VolumeR);
+		SoundMixAccumulate(vActual.data(), pIn, Channels, NumFrames, VolumeL, VolumeR);
+		ASSERT_EQ(vExpected, vActual) << "voice " << Voice;
+	}
+}
+
+TEST(SoundMixer, Convert)
+{
+	const int aIn[] = {0, 255, -256, 32767 * 256, -32768 * 256, 40000 * 256, -40000 * 256};
+	short aOut[std::size(aIn)];
+	for(int MasterVol : {0, 50, 100})
+	{
+		SoundMixConvert(aOut, aIn, std::size(aIn), MasterVol);
+		for(unsigned i = 0; i < std::size(aIn); i++)
+		{
+			EXPECT_EQ(aOut[i], clamp<int>(((aIn[i] * MasterVol) / 101) >> 8, -32768, 32767)) << "value " << aIn[i] << " volume " << MasterVol;
+		}
+	}
+	SoundMixConvert(aOut, aIn, std::size(aIn), 100);
+	EXPECT_EQ(aOut[5], 32767);
+	EXPECT_EQ(aOut[6], -32768);
+}
+
+TEST(SoundMixer, AccumulateTime)
+{
+	// 64 voices mixed into a buffer of 512 frames
+	std::mt19937 Rng(1);
+	std::uniform_int_distribution<int> Sample(-32768, 32767);
+	const unsigned NumFrames = 512;
+	const int NumVoices = 64;
+	const int NumMixes = 200;
+	std::vector<short> vSamples(2 * NumFrames);
+	for(auto &Value : vSamples)
+		Value = Sample(Rng);
+	std::vector<int> vMix(NumFrames * 2);
+
+	auto &&Measure = [&](auto &&Accumulate) {
+		const int64_t Start = time_get();
+		for(int Mix = 0; Mix < NumMixes; Mix++)
+		{
+			std::fill(vMix.begin(), vMix.end(), 0);
+			for(int Voice = 0; Voice < NumVoices; Voice++)
+				Accumulate(vMix.data(), vSamples.data(), Voice % 2 + 1, NumFrames, 100 + Voice, 200 - Voice);
+		}
+		return (time_get() - Start) * 1000000000 / time_freq() / NumMixes;
+	};
+	RecordProperty("ReferenceNsPerMix", (int)Measure(ReferenceAccumulate));
+	RecordProperty("MixerNsPerMix", (int)Measure(SoundMixAccumulate));
+}
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
 #include <base/system.h>
+#include <base/unicode/confusables.h>
+#include <base/unicode/tolower.h>
+
+#include <algorithm>
+#include <vector>
 
 TEST(Str, Dist)
 {
@@ -73,6 +78,107 @@ TEST(Str, Utf8CompConfusables)
 	EXPECT_TRUE(str_utf8_comp_confusable("aceiou", "ąçęįǫų") == 0);
 }
 
+TEST(Str, Utf8SkeletonTable)
+{
+	// the lookup must give the same results as searching the sorted table
+	ASSERT_TRUE(std::is_sorted(decomp_chars, decomp_chars + NUM_DECOMPS));
+	char aBuf[8];
+	int aSkeleton[32];
+	for(int Code = 1; Code < 0x110000; Code++)
+	{
+		if(Code >= 0xd800 && Code < 0xe000) // surrogates
+			continue;
+		std::vector<int> vExpected = {Code};
+		const int32_t *pFound = std::lower_bound(decomp_chars, decomp_chars + NUM_DECOMPS, Code);
+		if(pFound != decomp_chars + NUM_DECOMPS && *pFound == Code)
+		{
+			const DECOMP_SLICE &Slice = decomp_slices[pFound - decomp_chars];
+			vExpected.assign(decomp_data + Slice.offset, decomp_data + Slice.offset + decomp_lengths[Slice.length]);
+		}
+		aBuf[str_utf8_encode(aBuf, Code)] = 0;
+		const int Length = str_utf8_to_skeleton(aBuf, aSkeleton, std::size(aSkeleton));
+		ASSERT_EQ(std::vector<int>(aSkeleton, aSkeleton + Length), vExpected) << "code point " << Code;
+	}
+}
+
+TEST(Str, Utf8ToLowerTable)
+{
+	const auto &&CompareUpper = [](const UPPER_LOWER &Entry, int Code) { return Entry.upper < Code; };
+	ASSERT_TRUE(std::is_sorted(tolowermap, tolowermap + NUM_TOLOWER, [](const UPPER_LOWER &a, const UPPER_LOWER &b) { return a.upper < b.upper; }));
+	for(int Code = 0; Code < 0x110000; Code++)
+	{
+		int Expected = Code;
+		const UPPER_LOWER *pFound = std::lower_bound(tolowermap, tolowermap + NUM_TOLOWER, Code, CompareUpper);
+		if(pFound != tolowermap + NUM_TOLOWER && pFound->upper == Code)
+			Expected = pFound->lower;
+		ASSERT_EQ(str_utf8_tolower(Code), Expected) << "code point " << Code;
+	}
+	EXPECT_EQ(str_utf8_tolower(-1), -1);
+	EXPECT_EQ(str_utf8_tolower(0x110000), 0x110000);
+}
+
+TEST(Str, Utf8TableTime)
+{
+	// names of mixed scripts, as checked against name bans
+	const char *apNames[] = {"nameless tee", "brainless tee", "Ǹ1ǹ乐тёмная", "Ꮯℓαςʂ𝕚ᴄ", "ＴｅｅＷｏｒｌｄs"};
+	const int NumRounds = 2000;
+
+	// the linear scan the skeleton lookup replaced
+	const auto &&ReferenceSkeleton = [](const char *pStr, int *pBuf, int BufLen) {
+		int Length = 0;
+		while(int Code = str_utf8_decode(&pStr))
+		{
+			int i = 0;
+			while(i < NUM_DECOMPS && decomp_chars[i] < Code)
+				i++;
+			if(i < NUM_DECOMPS && decomp_chars[i] == Code)
+			{
+				for(int j = 0; j < decomp_lengths[decomp_slices[i].length] && Length < BufLen; j++)
+					pBuf[Length++] = decomp_data[decomp_slices[i].offset + j];
+			}
+			else if(Length < BufLen)
+				pBuf[Length++] = Code;
+		}
+		return Length;
+	};
+	// the binary search the lowercase lookup replaced
+	const auto &&ReferenceToLower = [](int Code) {
+		const UPPER_LOWER *pFound = std::lower_bound(tolowermap, tolowermap + NUM_TOLOWER, Code, [](const UPPER_LOWER &Entry, int Upper) { return Entry.upper < Upper; });
+		return pFound != tolowermap + NUM_TOLOWER && pFound->upper == Code ? pFound->lower : Code;
+	};
+
+	int aSkeleton[64];
+	auto &&MeasureSkeleton = [&](auto &&ToSkeleton) {
+		int Sum = 0;
+		const int64_t Start = time_get();
+		for(int Round = 0; Round < NumRounds; Round++)
+			for(const char *pName : apNames)
+				Sum += ToSkeleton(pName, aSkeleton, std::size(aSkeleton));
+		EXPECT_GT(Sum, 0);
+		return (time_get() - Start) * 1000000000 / time_freq() / (NumRounds * (int)std::size(apNames));
+	};
+	RecordProperty("ReferenceSkeletonNsPerName", (int)MeasureSkeleton(ReferenceSkeleton));
+	RecordProperty("SkeletonNsPerName", (int)MeasureSkeleton(str_utf8_to_skeleton));
+
+	auto &&MeasureToLower = [&](auto &&ToLower) {
+		int Sum = 0;
+		const int64_t Start = time_get();
+		for(int Round = 0; Round < NumRounds; Round++)
+		{
+			for(const char *pName : apNames)
+			{
+				const char *pStr = pName;
+				while(int Code = str_utf8_decode(&pStr))
+					Sum += ToLower(Code);
+			}
+		}
+		EXPECT_GT(Sum, 0);
+		return (time_get() - Start) * 1000000000 / time_freq() / (NumRounds * (int)std::size(apNames));
+	};
+	RecordProperty("ReferenceToLowerNsPerName", (int)MeasureToLower(ReferenceToLower));
+	RecordProperty("ToLowerNsPerName", (int)MeasureToLower(str_utf8_tolower));
+}
+
 TEST(Str, Utf8ToSkeleton)
 {
 	int aBuf[32];
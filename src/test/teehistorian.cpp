@@ -857,3 +857,97 @@ TEST_F(TeeHistorian, PrevGameUuid)
 	EXPECT_STREQ(JsonPrevGameUuid, "fe19c218-f555-4002-a273-126c59ccc17a");
 	json_value_free(pJson);
 }
+
+TEST_F(TeeHistorian, ReaderRoundTrip)
+{
+	CNetObj_PlayerInput Input = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+	Tick(1);
+	Player(0, 10, 20);
+	Player(3, 30, 40);
+	Inputs();
+	m_TH.RecordPlayerJoin(5, CTeeHistorian::PROTOCOL_7);
+	m_TH.RecordPlayerInput(0, 1, &Input);
+	Tick(2);
+	Player(0, 11, 19);
+	DeadPlayer(3);
+	Inputs();
+	Input.m_Direction = -1;
+	m_TH.RecordPlayerInput(0, 1, &Input);
+	m_TH.RecordPlayerReady(5);
+	Tick(3);
+	Player(0, 11, 19);
+	Tick(10);
+	Player(0, 12, 19);
+	Inputs();
+	m_TH.RecordPlayerDrop(5, "too slow");
+	Finish();
+
+	CTeeHistorianReader Reader;
+	ASSERT_TRUE(Reader.Open(m_vBuffer.data(), m_vBuffer.size())) << Reader.Error();
+	EXPECT_STREQ(Reader.HeaderString("map_name"), "Kobra 3 Solo");
+	EXPECT_EQ(Reader.HeaderString("nonexistent"), nullptr);
+
+	std::vector<CTeeHistorianReader::CItem> vItems;
+	CTeeHistorianReader::CItem Item;
+	while(Reader.Read(&Item))
+	{
+		vItems.push_back(Item);
+	}
+	EXPECT_STREQ(Reader.Error(), "");
+
+	const int EXPECTED_TYPES[] = {
+		CTeeHistorianReader::ITEM_TICK,
+		CTeeHistorianReader::ITEM_PLAYER,
+		CTeeHistorianReader::ITEM_PLAYER,
+		CTeeHistorianReader::ITEM_EX,
+		CTeeHistorianReader::ITEM_JOIN,
+		CTeeHistorianReader::ITEM_INPUT,
+		CTeeHistorianReader::ITEM_TICK,
+		CTeeHistorianReader::ITEM_PLAYER,
+		CTeeHistorianReader::ITEM_PLAYER_DEAD,
+		CTeeHistorianReader::ITEM_INPUT,
+		CTeeHistorianReader::ITEM_PLAYER_READY,
+		CTeeHistorianReader::ITEM_TICK,
+		CTeeHistorianReader::ITEM_PLAYER,
+		CTeeHistorianReader::ITEM_DROP,
+		CTeeHistorianReader::ITEM_FINISH,
+	};
+	ASSERT_EQ(vItems.size(), std::size(EXPECTED_TYPES));
+	for(size_t i = 0; i < vItems.size(); i++)
+	{
+		EXPECT_EQ(vItems[i].m_Type, EXPECTED_TYPES[i]) << "item " << i;
+	}
+
+	EXPECT_EQ(vItems[0].m_Tick, 1);
+	EXPECT_EQ(vItems[2].m_ClientID, 3);
+	EXPECT_EQ(vItems[2].m_X, 30);
+	EXPECT_EQ(vItems[2].m_Y, 40);
+	EXPECT_EQ(vItems[4].m_ClientID, 5);
+	EXPECT_EQ(vItems[4].m_Protocol, CTeeHistorian::PROTOCOL_7);
+	EXPECT_EQ(vItems[5].m_Input.m_Direction, 1);
+	EXPECT_EQ(vItems[6].m_Tick, 2);
+	EXPECT_EQ(vItems[7].m_X, 11);
+	EXPECT_EQ(vItems[7].m_Y, 19);
+	EXPECT_EQ(vItems[8].m_ClientID, 3);
+	EXPECT_EQ(mem_comp(&vItems[9].m_Input, &Input, sizeof(Input)), 0);
+	EXPECT_EQ(vItems[10].m_ClientID, 5);
+	// tick 3 did not change anything, tick 10 is written as a skip
+	EXPECT_EQ(vItems[11].m_Tick, 10);
+	EXPECT_EQ(vItems[12].m_X, 12);
+	EXPECT_STREQ(vItems[13].m_pString, "too slow");
+}
+
+TEST_F(TeeHistorian, ReaderInvalid)
+{
+	CTeeHistorianReader Reader;
+	EXPECT_FALSE(Reader.Open("", 0));
+	EXPECT_FALSE(Reader.Open("not a teehistorian file", 24));
+
+	Finish();
+	m_vBuffer.pop_back();
+	m_vBuffer.push_back(0x4b); // unknown kind
+	ASSERT_TRUE(Reader.Open(m_vBuffer.data(), m_vBuffer.size()));
+	CTeeHistorianReader::CItem Item;
+	EXPECT_FALSE(Reader.Read(&Item));
+	EXPECT_STRNE(Reader.Error(), "");
+}
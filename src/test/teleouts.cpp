@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include <game/mapitems.h>
+#include <game/teleouts.h>
+
+TEST(TeleOuts, Init)
+{
+	const int Width = 4;
+	const int Height = 3;
+	CTeleTile aTiles[Width * Height] = {};
+	auto Set = [&](int x, int y, int Number, int Type) {
+		aTiles[y * Width + x].m_Number = Number;
+		aTiles[y * Width + x].m_Type = Type;
+	};
+	Set(0, 0, 5, TILE_TELEOUT);
+	Set(1, 0, 255, TILE_TELEOUT);
+	Set(2, 1, 5, TILE_TELECHECKOUT);
+	Set(3, 2, 5, TILE_TELEOUT);
+	Set(0, 2, 1, TILE_TELEIN);
+
+	CTeleOuts TeleOuts;
+	TeleOuts.Init(aTiles, Width, Height, TILE_TELEOUT);
+
+	ASSERT_EQ(TeleOuts[5 - 1].size(), 2);
+	EXPECT_EQ(TeleOuts[5 - 1][0], vec2(16.0f, 16.0f));
+	EXPECT_EQ(TeleOuts[5 - 1][1], vec2(3 * 32.0f + 16.0f, 2 * 32.0f + 16.0f));
+	ASSERT_EQ(TeleOuts[255 - 1].size(), 1);
+	EXPECT_EQ(TeleOuts[255 - 1][0], vec2(32.0f + 16.0f, 16.0f));
+	EXPECT_TRUE(TeleOuts[1 - 1].empty());
+	EXPECT_TRUE(TeleOuts[-1].empty());
+	EXPECT_TRUE(TeleOuts[CTeleOuts::NUM_INDICES].empty());
+
+	CTeleOuts TeleCheckOuts;
+	TeleCheckOuts.Init(aTiles, Width, Height, TILE_TELECHECKOUT);
+	ASSERT_EQ(TeleCheckOuts[5 - 1].size(), 1);
+	EXPECT_EQ(TeleCheckOuts[5 - 1][0], vec2(2 * 32.0f + 16.0f, 32.0f + 16.0f));
+
+	TeleOuts.Clear();
+	EXPECT_TRUE(TeleOuts[5 - 1].empty());
+}
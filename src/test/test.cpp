@@ -132,6 +132,60 @@ CTestInfo::~CTestInfo()
 	}
 }
 
+CTestMap::CTestMap(int Width, int Height)
+{
+	m_Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+	m_Group.m_NumLayers = 1;
+	m_Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+	m_Layer.m_Version = CMapItemLayerTilemap::CURRENT_VERSION;
+	m_Layer.m_Width = Width;
+	m_Layer.m_Height = Height;
+	m_Layer.m_Flags = TILESLAYERFLAG_GAME;
+	m_vTiles.resize((size_t)Width * Height, CTile{});
+}
+
+int CTestMap::GetDataSize(int Index) const
+{
+	return m_vTiles.size() * sizeof(CTile);
+}
+
+void *CTestMap::GetData(int Index)
+{
+	return m_vTiles.data();
+}
+
+void *CTestMap::GetDataSwapped(int Index)
+{
+	return m_vTiles.data();
+}
+
+const char *CTestMap::GetDataString(int Index)
+{
+	return nullptr;
+}
+
+int CTestMap::GetItemSize(int Index)
+{
+	return Index == 0 ? sizeof(m_Group) : sizeof(m_Layer);
+}
+
+void *CTestMap::GetItem(int Index, int *pType, int *pID)
+{
+	if(pType)
+		*pType = Index == 0 ? MAPITEMTYPE_GROUP : MAPITEMTYPE_LAYER;
+	if(pID)
+		*pID = 0;
+	if(Index == 0)
+		return &m_Group;
+	return &m_Layer;
+}
+
+void CTestMap::GetType(int Type, int *pStart, int *pNum)
+{
+	*pStart = Type == MAPITEMTYPE_LAYER ? 1 : 0;
+	*pNum = Type == MAPITEMTYPE_GROUP || Type == MAPITEMTYPE_LAYER ? 1 : 0;
+}
+
 int main(int argc, const char **argv)
 {
 	CCmdlineFix CmdlineFix(&argc, &argv);
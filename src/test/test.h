@@ -1,7 +1,11 @@
 #ifndef TEST_TEST_H
 #define TEST_TEST_H
 
+#include <engine/map.h>
+#include <game/mapitems.h>
+
 #include <cstddef>
+#include <vector>
 
 class IStorage;
 
@@ -16,4 +20,33 @@ public:
 	char m_aFilenamePrefix[128];
 	char m_aFilename[128];
 };
+
+// A map that only has a game layer, to run game code without map files.
+// Set the tiles in `m_vTiles` before initializing the layers with it.
+class CTestMap : public IMap
+{
+	CMapItemGroup m_Group = {};
+	CMapItemLayerTilemap m_Layer = {};
+
+public:
+	CTestMap(int Width, int Height);
+	int Width() const { return m_Layer.m_Width; }
+	int Height() const { return m_Layer.m_Height; }
+	CTile &Tile(int x, int y) { return m_vTiles[y * Width() + x]; }
+	std::vector<CTile> m_vTiles;
+
+	int GetDataSize(int Index) const override;
+	void *GetData(int Index) override;
+	void *GetDataSwapped(int Index) override;
+	const char *GetDataString(int Index) override;
+	void UnloadData(int Index) override {}
+	int NumData() const override { return 1; }
+
+	int GetItemSize(int Index) override;
+	void *GetItem(int Index, int *pType = nullptr, int *pID = nullptr) override;
+	void GetType(int Type, int *pStart, int *pNum) override;
+	int FindItemIndex(int Type, int ID) override { return -1; }
+	void *FindItem(int Type, int ID) override { return nullptr; }
+	int NumItems() const override { return 2; }
+};
 #endif // TEST_TEST_H
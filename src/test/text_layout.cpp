@@ -0,0 +1,331 @@
+#include <gtest/gtest.h>
+
+#if defined(CONF_TEST_FREETYPE)
+#include <base/system.h>
+#include <engine/client/text_layout.h>
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char *const TEST_FONTS[] = {
+	"data/fonts/DejaVuSans.ttf",
+	"data/fonts/Font_Awesome_6_Free-Solid-900.otf",
+};
+
+static const char *const TEST_TEXTS[] = {
+	"",
+	" ",
+	"Hello World",
+	"Play",
+	"Name: nameless tee",
+	"AVAWAY Ty.",
+	"first line\nsecond line\n\nfourth line",
+	"a very long label that has to be wrapped into several lines to fit into the width of the box it is rendered in",
+	"Supercalifragilisticexpialidocious and antidisestablishmentarianism",
+	"Ünïcödé ßtrîñg — “quoted” …",
+	"\xef\x80\x8c check \xef\x80\x8d", // U+F00C and U+F00D are only in the icon font
+};
+
+class TextLayout : public ::testing::Test
+{
+protected:
+	FT_Library m_FTLibrary = nullptr;
+	std::vector<void *> m_vpFontData;
+	std::vector<FT_Face> m_vFaces;
+	std::unique_ptr<CGlyphMap> m_pGlyphMap;
+
+	TextLayout()
+	{
+		FT_Init_FreeType(&m_FTLibrary);
+		m_pGlyphMap = std::make_unique<CGlyphMap>(nullptr);
+		for(const char *pFont : TEST_FONTS)
+		{
+			IOHANDLE File = io_open(pFont, IOFLAG_READ);
+			EXPECT_TRUE(File) << pFont;
+			if(!File)
+				continue;
+			void *pData;
+			unsigned DataSize;
+			io_read_all(File, &pData, &DataSize);
+			io_close(File);
+			m_vpFontData.push_back(pData);
+
+			FT_Face Face;
+			EXPECT_EQ(FT_New_Memory_Face(m_FTLibrary, (const FT_Byte *)pData, DataSize, 0, &Face), 0) << pFont;
+			m_pGlyphMap->AddFace(Face);
+			m_vFaces.push_back(Face);
+		}
+	}
+
+	~TextLayout() override
+	{
+		m_pGlyphMap = nullptr;
+		FT_Done_FreeType(m_FTLibrary);
+		for(void *pData : m_vpFontData)
+			free(pData);
+	}
+
+	std::string FaceName(size_t Index) const
+	{
+		return std::string(m_vFaces[Index]->family_name) + " " + m_vFaces[Index]->style_name;
+	}
+};
+
+static void ExpectSameCursor(const CTextCursor &Expected, const CTextCursor &Actual)
+{
+	EXPECT_EQ(Expected.m_Flags, Actual.m_Flags);
+	EXPECT_EQ(Expected.m_LineCount, Actual.m_LineCount);
+	EXPECT_EQ(Expected.m_GlyphCount, Actual.m_GlyphCount);
+	EXPECT_EQ(Expected.m_CharCount, Actual.m_CharCount);
+	EXPECT_EQ(Expected.m_X, Actual.m_X);
+	EXPECT_EQ(Expected.m_Y, Actual.m_Y);
+	EXPECT_EQ(Expected.m_MaxCharacterHeight, Actual.m_MaxCharacterHeight);
+	EXPECT_EQ(Expected.m_LongestLineWidth, Actual.m_LongestLineWidth);
+	EXPECT_EQ(Expected.m_AlignedFontSize, Actual.m_AlignedFontSize);
+	EXPECT_EQ(Expected.m_AlignedLineSpacing, Actual.m_AlignedLineSpacing);
+	const STextBoundingBox ExpectedBox = Expected.BoundingBox();
+	const STextBoundingBox ActualBox = Actual.BoundingBox();
+	EXPECT_EQ(ExpectedBox.m_X, ActualBox.m_X);
+	EXPECT_EQ(ExpectedBox.m_Y, ActualBox.m_Y);
+	EXPECT_EQ(ExpectedBox.m_W, ActualBox.m_W);
+	EXPECT_EQ(ExpectedBox.m_H, ActualBox.m_H);
+}
+
+static void ExpectSameRun(const STextGlyphRun &Expected, const STextGlyphRun &Actual)
+{
+	EXPECT_EQ(Expected.m_LineY, Actual.m_LineY);
+	EXPECT_EQ(Expected.m_SelEnd, Actual.m_SelEnd);
+	ASSERT_EQ(Expected.m_vGlyphs.size(), Actual.m_vGlyphs.size());
+	for(size_t i = 0; i < Expected.m_vGlyphs.size(); i++)
+	{
+		const STextGlyphPlacement &ExpectedGlyph = Expected.m_vGlyphs[i];
+		const STextGlyphPlacement &ActualGlyph = Actual.m_vGlyphs[i];
+		EXPECT_EQ(ExpectedGlyph.m_X, ActualGlyph.m_X);
+		EXPECT_EQ(ExpectedGlyph.m_Y, ActualGlyph.m_Y);
+		EXPECT_EQ(ExpectedGlyph.m_Width, ActualGlyph.m_Width);
+		EXPECT_EQ(ExpectedGlyph.m_Height, ActualGlyph.m_Height);
+		for(int Uv = 0; Uv < 4; Uv++)
+			EXPECT_EQ(ExpectedGlyph.m_aUVs[Uv], ActualGlyph.m_aUVs[Uv]);
+		EXPECT_EQ(ExpectedGlyph.m_GlyphIndex, ActualGlyph.m_GlyphIndex);
+		EXPECT_EQ(ExpectedGlyph.m_Line, ActualGlyph.m_Line);
+		EXPECT_EQ(ExpectedGlyph.m_LineY, ActualGlyph.m_LineY);
+		EXPECT_EQ(ExpectedGlyph.m_SelX, ActualGlyph.m_SelX);
+		EXPECT_EQ(ExpectedGlyph.m_SelWidth, ActualGlyph.m_SelWidth);
+		EXPECT_EQ(ExpectedGlyph.m_LastCharX, ActualGlyph.m_LastCharX);
+		EXPECT_EQ(ExpectedGlyph.m_LastCharWidth, ActualGlyph.m_LastCharWidth);
+	}
+}
+
+// measures the text like TextWidth and TextBoundingBox with and without the cache
+static void ExpectSameMeasure(CTextLayout &Cached, CTextLayout &Uncached, float Size, const char *pText, float LineWidth, float LineSpacing, int Flags, unsigned RenderFlags, vec2 FakeToScreen)
+{
+	CTextCursor UncachedCursor;
+	Uncached.Measure(&UncachedCursor, Size, pText, -1, LineWidth, LineSpacing, Flags, RenderFlags, FakeToScreen);
+	CTextCursor CachedCursor;
+	Cached.Measure(&CachedCursor, Size, pText, -1, LineWidth, LineSpacing, Flags, RenderFlags, FakeToScreen);
+	ExpectSameCursor(UncachedCursor, CachedCursor);
+}
+
+TEST_F(TextLayout, CachedMatchesUncached)
+{
+	ASSERT_EQ(m_vFaces.size(), std::size(TEST_FONTS));
+	CTextLayout Cached(m_pGlyphMap.get());
+	CTextLayout Uncached(m_pGlyphMap.get(), false);
+
+	const unsigned aRenderFlags[] = {
+		0,
+		TEXT_RENDER_FLAG_KERNING,
+		TEXT_RENDER_FLAG_NO_PIXEL_ALIGMENT,
+		TEXT_RENDER_FLAG_NO_OVERSIZE,
+		TEXT_RENDER_FLAG_NO_X_BEARING | TEXT_RENDER_FLAG_NO_Y_BEARING,
+		TEXT_RENDER_FLAG_ONLY_ADVANCE_WIDTH,
+	};
+	const int aFlags[] = {0, TEXTFLAG_STOP_AT_END, TEXTFLAG_ELLIPSIS_AT_END, TEXTFLAG_DISALLOW_NEWLINE};
+	const float aLineWidths[] = {-1.0f, 0.0f, 40.0f, 150.0f};
+	const vec2 aFakeToScreen[] = {vec2(1.0f, 1.0f), vec2(1.7f, 1.7f)};
+
+	for(const char *pText : TEST_TEXTS)
+	{
+		for(float Size : {7.0f, 10.0f, 20.0f})
+		{
+			for(float LineWidth : aLineWidths)
+			{
+				for(int Flags : aFlags)
+				{
+					for(unsigned RenderFlags : aRenderFlags)
+					{
+						for(vec2 FakeToScreen : aFakeToScreen)
+						{
+							// the second pass is served from the cache
+							for(int Pass = 0; Pass < 2; Pass++)
+							{
+								SCOPED_TRACE(testing::Message() << "Pass=" << Pass << " Text='" << pText << "' Size=" << Size << " LineWidth=" << LineWidth << " Flags=" << Flags << " RenderFlags=" << RenderFlags << " FakeToScreen=" << FakeToScreen.x);
+								ExpectSameMeasure(Cached, Uncached, Size, pText, LineWidth, 2.0f, Flags, RenderFlags, FakeToScreen);
+
+								// a text container at some position, the selection and cursor are computed from the run
+								CTextCursor UncachedCursor;
+								CTextLayout::SetCursor(&UncachedCursor, 13.3f, 27.6f, Size, Flags | TEXTFLAG_RENDER);
+								UncachedCursor.m_LineWidth = LineWidth;
+								UncachedCursor.m_MaxLines = 3;
+								CTextCursor CachedCursor = UncachedCursor;
+								const unsigned ContainerFlags = CTextLayout::ContainerRenderFlags(RenderFlags, LineWidth);
+								const STextGlyphRun &UncachedRun = Uncached.Layout(&UncachedCursor, pText, -1, ContainerFlags, RenderFlags, FakeToScreen);
+								const STextGlyphRun &CachedRun = Cached.Layout(&CachedCursor, pText, -1, ContainerFlags, RenderFlags, FakeToScreen);
+								ExpectSameCursor(UncachedCursor, CachedCursor);
+								ExpectSameRun(UncachedRun, CachedRun);
+
+								// appending to the container continues from the cursor
+								const STextGlyphRun &UncachedAppended = Uncached.Layout(&UncachedCursor, pText, 5, ContainerFlags, RenderFlags, FakeToScreen);
+								const STextGlyphRun &CachedAppended = Cached.Layout(&CachedCursor, pText, 5, ContainerFlags, RenderFlags, FakeToScreen);
+								ExpectSameCursor(UncachedCursor, CachedCursor);
+								ExpectSameRun(UncachedAppended, CachedAppended);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	EXPECT_EQ(Uncached.NumCachedLayouts(), 0u);
+	EXPECT_EQ(Cached.NumCachedLayouts(), CTextLayout::MAX_CACHED_LAYOUTS);
+}
+
+TEST_F(TextLayout, CacheHit)
+{
+	CTextLayout Cached(m_pGlyphMap.get());
+	CTextCursor First;
+	Cached.Measure(&First, 10.0f, "Hello World", -1, -1.0f, 0.0f, 0, 0, vec2(1.0f, 1.0f));
+	EXPECT_EQ(Cached.NumCachedLayouts(), 1u);
+	CTextCursor Second;
+	Cached.Measure(&Second, 10.0f, "Hello World", -1, -1.0f, 0.0f, 0, 0, vec2(1.0f, 1.0f));
+	EXPECT_EQ(Cached.NumCachedLayouts(), 1u);
+	ExpectSameCursor(First, Second);
+	EXPECT_GT(Second.m_LongestLineWidth, 0.0f);
+
+	// only a prefix of the text is laid out
+	CTextCursor Prefix;
+	Cached.Measure(&Prefix, 10.0f, "Hello World", 5, -1.0f, 0.0f, 0, 0, vec2(1.0f, 1.0f));
+	EXPECT_EQ(Cached.NumCachedLayouts(), 2u);
+	EXPECT_LT(Prefix.m_LongestLineWidth, First.m_LongestLineWidth);
+
+	// the upload flags don't change the layout
+	CTextCursor OneTimeUse;
+	Cached.Measure(&OneTimeUse, 10.0f, "Hello World", -1, -1.0f, 0.0f, 0, TEXT_RENDER_FLAG_ONE_TIME_USE, vec2(1.0f, 1.0f));
+	EXPECT_EQ(Cached.NumCachedLayouts(), 2u);
+	ExpectSameCursor(First, OneTimeUse);
+
+	Cached.ClearCache();
+	EXPECT_EQ(Cached.NumCachedLayouts(), 0u);
+}
+
+TEST_F(TextLayout, CacheClearedOnFaceChange)
+{
+	ASSERT_EQ(m_vFaces.size(), std::size(TEST_FONTS));
+	CTextLayout Cached(m_pGlyphMap.get());
+	CTextLayout Uncached(m_pGlyphMap.get(), false);
+	const vec2 FakeToScreen(1.0f, 1.0f);
+
+	// the layouts cached with the old faces are dropped with the next layout
+	const auto &&ExpectCacheCleared = [&]() {
+		ExpectSameMeasure(Cached, Uncached, 10.0f, "Hello World", -1.0f, 0.0f, 0, 0, FakeToScreen);
+		EXPECT_EQ(Cached.NumCachedLayouts(), 1u);
+		for(const char *pText : TEST_TEXTS)
+		{
+			SCOPED_TRACE(pText);
+			ExpectSameMeasure(Cached, Uncached, 10.0f, pText, -1.0f, 0.0f, 0, 0, FakeToScreen);
+			ExpectSameMeasure(Cached, Uncached, 10.0f, pText, 60.0f, 0.0f, TEXTFLAG_ELLIPSIS_AT_END, 0, FakeToScreen);
+		}
+		EXPECT_EQ(Cached.NumCachedLayouts(), 2 * std::size(TEST_TEXTS));
+	};
+
+	ExpectCacheCleared();
+	CTextCursor Before;
+	Cached.Measure(&Before, 10.0f, "Hello World", -1, -1.0f, 0.0f, 0, 0, FakeToScreen);
+
+	// the icon font has no latin glyphs
+	m_pGlyphMap->SetDefaultFaceByName(FaceName(1).c_str());
+	ExpectCacheCleared();
+	CTextCursor Icons;
+	Cached.Measure(&Icons, 10.0f, "Hello World", -1, -1.0f, 0.0f, 0, 0, FakeToScreen);
+	EXPECT_NE(Before.m_LongestLineWidth, Icons.m_LongestLineWidth);
+
+	m_pGlyphMap->SetDefaultFaceByName(FaceName(0).c_str());
+	ExpectCacheCleared();
+	CTextCursor Restored;
+	Cached.Measure(&Restored, 10.0f, "Hello World", -1, -1.0f, 0.0f, 0, 0, FakeToScreen);
+	ExpectSameCursor(Before, Restored);
+
+	// the variant of a language provides the glyphs missing in the default face
+	CTextCursor NoVariant;
+	Cached.Measure(&NoVariant, 10.0f, TEST_TEXTS[std::size(TEST_TEXTS) - 1], -1, -1.0f, 0.0f, 0, 0, FakeToScreen);
+	m_pGlyphMap->SetVariantFaceByName(FaceName(1).c_str());
+	ExpectCacheCleared();
+	CTextCursor Variant;
+	Cached.Measure(&Variant, 10.0f, TEST_TEXTS[std::size(TEST_TEXTS) - 1], -1, -1.0f, 0.0f, 0, 0, FakeToScreen);
+	EXPECT_NE(NoVariant.m_LongestLineWidth, Variant.m_LongestLineWidth);
+
+	m_pGlyphMap->SetVariantFaceByName(nullptr);
+	ExpectCacheCleared();
+
+	// fallback faces are looked up before the replacement character
+	m_pGlyphMap->AddFallbackFaceByName(FaceName(1).c_str());
+	ExpectCacheCleared();
+
+	// the selected face is part of the cache key
+	m_pGlyphMap->SetIconFaceByName(FaceName(1).c_str());
+	m_pGlyphMap->SetFontPreset(EFontPreset::ICON_FONT);
+	for(const char *pText : TEST_TEXTS)
+	{
+		SCOPED_TRACE(pText);
+		ExpectSameMeasure(Cached, Uncached, 10.0f, pText, -1.0f, 0.0f, 0, 0, FakeToScreen);
+	}
+	m_pGlyphMap->SetFontPreset(EFontPreset::DEFAULT_FONT);
+}
+
+TEST_F(TextLayout, LayoutTime)
+{
+	// the labels of a menu page, laid out every frame
+	std::vector<std::string> vLabels;
+	for(int i = 0; i < 100; i++)
+		vLabels.push_back(std::string(TEST_TEXTS[i % std::size(TEST_TEXTS)]) + " " + std::to_string(i));
+	const int Frames = 100;
+
+	CTextLayout Cached(m_pGlyphMap.get());
+	CTextLayout Uncached(m_pGlyphMap.get(), false);
+	const vec2 FakeToScreen(1.5f, 1.5f);
+
+	float UncachedWidth = 0.0f;
+	int64_t Start = time_get();
+	for(int Frame = 0; Frame < Frames; Frame++)
+	{
+		for(const auto &Label : vLabels)
+		{
+			CTextCursor Cursor;
+			Uncached.Measure(&Cursor, 10.0f, Label.c_str(), -1, 200.0f, 0.0f, 0, 0, FakeToScreen);
+			UncachedWidth += Cursor.m_LongestLineWidth;
+		}
+	}
+	const int64_t UncachedTime = time_get() - Start;
+
+	float CachedWidth = 0.0f;
+	Start = time_get();
+	for(int Frame = 0; Frame < Frames; Frame++)
+	{
+		for(const auto &Label : vLabels)
+		{
+			CTextCursor Cursor;
+			Cached.Measure(&Cursor, 10.0f, Label.c_str(), -1, 200.0f, 0.0f, 0, 0, FakeToScreen);
+			CachedWidth += Cursor.m_LongestLineWidth;
+		}
+	}
+	const int64_t CachedTime = time_get() - Start;
+
+	EXPECT_EQ(UncachedWidth, CachedWidth);
+	EXPECT_EQ(Cached.NumCachedLayouts(), vLabels.size());
+	RecordProperty("UncachedMs", (int)(UncachedTime * 1000 / time_freq()));
+	RecordProperty("CachedMs", (int)(CachedTime * 1000 / time_freq()));
+	RecordProperty("Layouts", Frames * (int)vLabels.size());
+}
+#endif
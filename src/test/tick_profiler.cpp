@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/tick_profiler.h>
+
+#include <string>
+
+TEST(TickProfiler, Buckets)
+{
+	for(uint64_t Value = 0; Value < 1000000; Value = Value * 5 / 4 + 1)
+	{
+		int Bucket = CTickHistogram::BucketIndex(Value);
+		ASSERT_GE(Bucket, 0);
+		ASSERT_LT(Bucket, CTickHistogram::NUM_BUCKETS);
+		EXPECT_LE(Value, CTickHistogram::BucketUpperBound(Bucket));
+		if(Bucket > 0)
+		{
+			EXPECT_GT(Value, CTickHistogram::BucketUpperBound(Bucket - 1));
+		}
+		// relative error of at most one sub-bucket
+		EXPECT_LE(CTickHistogram::BucketUpperBound(Bucket) - Value, Value / CTickHistogram::SUB_BUCKETS);
+	}
+	EXPECT_EQ(CTickHistogram::BucketIndex(~(uint64_t)0), CTickHistogram::NUM_BUCKETS - 1);
+}
+
+TEST(TickProfiler, Quantiles)
+{
+	CTickHistogram Histogram;
+	EXPECT_EQ(Histogram.Quantile(0.5), 0u);
+	for(int i = 1; i <= 1000; i++)
+		Histogram.Record(i);
+	EXPECT_EQ(Histogram.Count(), 1000u);
+	EXPECT_EQ(Histogram.Sum(), 500500u);
+	EXPECT_EQ(Histogram.Max(), 1000u);
+	EXPECT_GE(Histogram.Quantile(0.5), 500u);
+	EXPECT_LE(Histogram.Quantile(0.5), 500u + 500u / CTickHistogram::SUB_BUCKETS);
+	EXPECT_GE(Histogram.Quantile(0.99), 990u);
+	EXPECT_EQ(Histogram.Quantile(1.0), 1000u);
+
+	Histogram.Reset();
+	EXPECT_EQ(Histogram.Count(), 0u);
+	EXPECT_EQ(Histogram.Max(), 0u);
+}
+
+TEST(TickProfiler, Metrics)
+{
+	CTickProfiler Profiler;
+	Profiler.Record(TICK_SECTION_SNAPSHOT, 3);
+	Profiler.Record(TICK_SECTION_SNAPSHOT, 100);
+
+	std::string Metrics;
+	Profiler.WriteMetrics([](const char *pData, int Size, void *pUser) {
+		static_cast<std::string *>(pUser)->append(pData, Size);
+	},
+		&Metrics);
+	EXPECT_NE(Metrics.find("# TYPE ddnet_server_tick_section_seconds histogram\n"), std::string::npos);
+	EXPECT_NE(Metrics.find("ddnet_server_tick_section_seconds_bucket{section=\"snapshot\",le=\"0.000004\"} 1\n"), std::string::npos);
+	EXPECT_NE(Metrics.find("ddnet_server_tick_section_seconds_bucket{section=\"snapshot\",le=\"+Inf\"} 2\n"), std::string::npos);
+	EXPECT_NE(Metrics.find("ddnet_server_tick_section_seconds_count{section=\"snapshot\"} 2\n"), std::string::npos);
+	EXPECT_NE(Metrics.find("ddnet_server_tick_section_seconds_count{section=\"network\"} 0\n"), std::string::npos);
+
+	int NumLines = 0;
+	Profiler.Summary([](const char *pLine, void *pUser) {
+		++*static_cast<int *>(pUser);
+	},
+		&NumLines);
+	EXPECT_EQ(NumLines, (int)NUM_TICK_SECTIONS);
+}
@@ -0,0 +1,338 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <game/editor/editor_history.h>
+#include <game/editor/tile_state_changes.h>
+#include <game/mapitems.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+// same layout as the change of a tile in the editor
+struct STestTileStateChange
+{
+	bool m_Changed;
+	CTile m_Previous;
+	CTile m_Current;
+};
+
+class CTestLayer
+{
+public:
+	int m_Width;
+	int m_Height;
+	std::vector<CTile> m_vTiles;
+	CTileStateChanges<STestTileStateChange> m_History;
+
+	CTestLayer(int Width, int Height) :
+		m_Width(Width), m_Height(Height), m_vTiles(Width * Height, CTile{}) {}
+
+	void SetTile(int x, int y, CTile Tile)
+	{
+		CTile &Current = m_vTiles[y * m_Width + x];
+		STestTileStateChange &Change = m_History.At(x, y);
+		if(!Change.m_Changed)
+			Change = STestTileStateChange{true, Current, Tile};
+		else
+			Change.m_Current = Tile;
+		Current = Tile;
+	}
+
+	void Apply(const CTileStateChanges<STestTileStateChange> &Changes, bool Undo)
+	{
+		Changes.ForEachSpan([&](const auto &Span, const STestTileStateChange *pChanges) {
+			for(int i = 0; i < Span.m_Num; i++)
+				m_vTiles[Span.m_Y * m_Width + Span.m_X + i] = Undo ? pChanges[i].m_Previous : pChanges[i].m_Current;
+		});
+	}
+};
+
+static bool operator==(const CTile &Lhs, const CTile &Rhs)
+{
+	return Lhs.m_Index == Rhs.m_Index && Lhs.m_Flags == Rhs.m_Flags && Lhs.m_Skip == Rhs.m_Skip && Lhs.m_Reserved == Rhs.m_Reserved;
+}
+
+TEST(TileStateChanges, UndoRedoRoundTrip)
+{
+	std::mt19937 Rng(0);
+	CTestLayer Layer(97, 61);
+	for(auto &Tile : Layer.m_vTiles)
+		Tile.m_Index = Rng() % 4;
+
+	std::vector<std::vector<CTile>> vvStates = {Layer.m_vTiles};
+	std::vector<CTileStateChanges<STestTileStateChange>> vActions;
+	for(int Action = 0; Action < 40; Action++)
+	{
+		const int Kind = Action % 4;
+		if(Kind == 0)
+		{
+			// fill, like a big brush or the auto mapper
+			const int x0 = Rng() % Layer.m_Width, y0 = Rng() % Layer.m_Height;
+			const int x1 = x0 + Rng() % (Layer.m_Width - x0), y1 = y0 + Rng() % (Layer.m_Height - y0);
+			CTile Tile = {(unsigned char)(Rng() % 256), (unsigned char)(Rng() % 16)};
+			for(int y = y0; y <= y1; y++)
+				for(int x = x0; x <= x1; x++)
+					Layer.SetTile(x, y, Tile);
+		}
+		else
+		{
+			// strokes that go over the same tiles several times
+			for(int i = 0; i < 300; i++)
+			{
+				CTile Tile = {(unsigned char)(Rng() % 8), (unsigned char)(Rng() % 16)};
+				Layer.SetTile(Rng() % Layer.m_Width, Rng() % Layer.m_Height, Tile);
+			}
+		}
+		if(Kind == 3)
+		{
+			// setting a tile back to its previous state is still a change
+			Layer.SetTile(0, 0, Layer.m_vTiles[0]);
+		}
+
+		vActions.push_back(std::move(Layer.m_History));
+		EXPECT_TRUE(Layer.m_History.empty());
+		vActions.back().Finish();
+		if(Action % 3 == 0)
+			vActions.back().Compress();
+		vvStates.push_back(Layer.m_vTiles);
+	}
+
+	for(int Action = vActions.size() - 1; Action >= 0; Action--)
+	{
+		Layer.Apply(vActions[Action], true);
+		ASSERT_EQ(Layer.m_vTiles, vvStates[Action]) << "undo " << Action;
+	}
+	for(int Action = 0; Action < (int)vActions.size(); Action++)
+	{
+		Layer.Apply(vActions[Action], false);
+		ASSERT_EQ(Layer.m_vTiles, vvStates[Action + 1]) << "redo " << Action;
+	}
+}
+
+TEST(TileStateChanges, Spans)
+{
+	CTileStateChanges<STestTileStateChange> Changes;
+	EXPECT_TRUE(Changes.empty());
+	for(int x : {3, 4, 5, 9})
+		Changes.At(x, 2) = STestTileStateChange{true, CTile{}, CTile{(unsigned char)x}};
+	Changes.At(0, 7) = STestTileStateChange{true, CTile{}, CTile{1}};
+	Changes.At(4, 2).m_Current.m_Index = 42;
+	EXPECT_FALSE(Changes.empty());
+	Changes.Finish();
+	EXPECT_EQ(Changes.Size(), 5);
+
+	std::vector<int> vSpans;
+	std::vector<int> vIndices;
+	Changes.ForEachSpan([&](const auto &Span, const STestTileStateChange *pChanges) {
+		vSpans.insert(vSpans.end(), {Span.m_X, Span.m_Y, Span.m_Num});
+		for(int i = 0; i < Span.m_Num; i++)
+			vIndices.push_back(pChanges[i].m_Current.m_Index);
+	});
+	EXPECT_EQ(vSpans, std::vector<int>({3, 2, 3, 9, 2, 1, 0, 7, 1}));
+	EXPECT_EQ(vIndices, std::vector<int>({3, 42, 5, 9, 1}));
+
+	Changes.clear();
+	EXPECT_TRUE(Changes.empty());
+	EXPECT_EQ(Changes.Size(), 0);
+	EXPECT_EQ(Changes.MemoryUsage(), 0u);
+}
+
+TEST(TileStateChanges, CompressFill)
+{
+	CTestLayer Layer(300, 200);
+	for(int y = 0; y < Layer.m_Height; y++)
+		for(int x = 0; x < Layer.m_Width; x++)
+			Layer.SetTile(x, y, CTile{TILE_SOLID});
+	CTileStateChanges<STestTileStateChange> Changes = std::move(Layer.m_History);
+	Changes.Finish();
+	EXPECT_EQ(Changes.Size(), Layer.m_Width * Layer.m_Height);
+	const size_t Uncompressed = Changes.MemoryUsage();
+	EXPECT_GE(Uncompressed, Layer.m_Width * Layer.m_Height * sizeof(STestTileStateChange));
+
+	Changes.Compress();
+	EXPECT_TRUE(Changes.IsCompressed());
+	EXPECT_LT(Changes.MemoryUsage() * 20, Uncompressed);
+
+	Layer.Apply(Changes, true);
+	EXPECT_EQ(Layer.m_vTiles, std::vector<CTile>(Layer.m_vTiles.size(), CTile{}));
+	Layer.Apply(Changes, false);
+	EXPECT_EQ(Layer.m_vTiles, std::vector<CTile>(Layer.m_vTiles.size(), CTile{TILE_SOLID}));
+}
+
+// an undo action of tile changes like the editor's
+class CTestTileAction : public IEditorAction
+{
+public:
+	int m_ID;
+	CTileStateChanges<STestTileStateChange> m_Changes;
+	int m_NumUndos = 0;
+	int m_NumRedos = 0;
+
+	void Undo() override { m_NumUndos++; }
+	void Redo() override { m_NumRedos++; }
+	size_t MemoryUsage() const override { return m_Changes.MemoryUsage(); }
+	void Compress() override { m_Changes.Compress(); }
+};
+
+static std::shared_ptr<CTestTileAction> RandomTileAction(int ID, std::mt19937 &Rng)
+{
+	auto pAction = std::make_shared<CTestTileAction>();
+	pAction->m_ID = ID;
+	// a brush stroke over a few rows, with tiles that don't compress to nothing
+	const int x0 = Rng() % 100, y0 = Rng() % 100;
+	for(int y = y0; y < y0 + 30; y++)
+		for(int x = x0; x < x0 + 200; x++)
+			pAction->m_Changes.At(x, y) = STestTileStateChange{true, CTile{(unsigned char)(Rng() % 4)}, CTile{(unsigned char)(Rng() % 256), (unsigned char)(Rng() % 16)}};
+	pAction->m_Changes.Finish();
+	return pAction;
+}
+
+TEST(TileStateChanges, HistoryMemoryLimit)
+{
+	const size_t MemoryLimit = 512 * 1024;
+	for(bool Compress : {false, true})
+	{
+		std::mt19937 Rng(0);
+		std::deque<std::shared_ptr<IEditorAction>> vpUndoActions;
+		std::vector<std::shared_ptr<CTestTileAction>> vpAll;
+		for(int ID = 0; ID < 40; ID++)
+		{
+			vpAll.push_back(RandomTileAction(ID, Rng));
+			CEditorHistory::PushUndoAction(vpUndoActions, vpAll.back(), 50, MemoryLimit, Compress);
+
+			// the newest actions are kept, as many as fit
+			ASSERT_FALSE(vpUndoActions.empty());
+			size_t MemoryUsage = 0;
+			for(size_t i = 0; i < vpUndoActions.size(); i++)
+			{
+				const CTestTileAction *pAction = static_cast<const CTestTileAction *>(vpUndoActions[i].get());
+				EXPECT_EQ(pAction->m_ID, ID - (int)(vpUndoActions.size() - 1 - i));
+				MemoryUsage += pAction->MemoryUsage();
+				const bool Recent = vpUndoActions.size() - 1 - i < CEditorHistory::NUM_UNCOMPRESSED_ACTIONS;
+				EXPECT_EQ(pAction->m_Changes.IsCompressed(), Compress && !Recent) << "action " << pAction->m_ID;
+			}
+			EXPECT_LE(MemoryUsage, MemoryLimit);
+			const int Oldest = ID + 1 - (int)vpUndoActions.size();
+			if(Oldest > 0)
+			{
+				EXPECT_GT(MemoryUsage + vpAll[Oldest - 1]->MemoryUsage(), MemoryLimit) << "action " << Oldest - 1 << " was dropped needlessly";
+			}
+		}
+		// compressing keeps more actions
+		RecordProperty(Compress ? "CompressedActionsKept" : "UncompressedActionsKept", (int)vpUndoActions.size());
+		if(Compress)
+			EXPECT_GT(vpUndoActions.size(), CEditorHistory::NUM_UNCOMPRESSED_ACTIONS + 1);
+		else
+			EXPECT_LT(vpUndoActions.size(), 40u);
+	}
+}
+
+TEST(TileStateChanges, HistoryLimits)
+{
+	const CConfig SavedConfig = g_Config;
+	g_Config.m_ClEditorMaxHistory = 4;
+	g_Config.m_ClEditorMaxHistoryMemory = 4096;
+	g_Config.m_ClEditorCompressHistory = 1;
+
+	std::mt19937 Rng(1);
+	CEditorHistory History;
+	std::vector<std::shared_ptr<CTestTileAction>> vpActions;
+	for(int ID = 0; ID < 10; ID++)
+	{
+		vpActions.push_back(RandomTileAction(ID, Rng));
+		// actions with a display text are wrapped into a bulk action
+		History.RecordAction(vpActions.back(), ID % 2 ? "Stroke" : nullptr);
+	}
+	ASSERT_EQ(History.m_vpUndoActions.size(), 4u);
+	EXPECT_STREQ(History.m_vpUndoActions.back()->DisplayText(), "Stroke");
+	// the bulk action passes compression on
+	EXPECT_TRUE(vpActions[6]->m_Changes.IsCompressed());
+	EXPECT_FALSE(vpActions[7]->m_Changes.IsCompressed());
+
+	int NumUndos = 0;
+	while(History.Undo())
+		NumUndos++;
+	EXPECT_EQ(NumUndos, 4);
+	for(int ID = 0; ID < 10; ID++)
+		EXPECT_EQ(vpActions[ID]->m_NumUndos, ID >= 6 ? 1 : 0) << "action " << ID;
+	ASSERT_TRUE(History.Redo());
+	EXPECT_EQ(vpActions[6]->m_NumRedos, 1);
+	EXPECT_TRUE(History.CanRedo());
+	History.RecordAction(RandomTileAction(10, Rng));
+	EXPECT_FALSE(History.CanRedo());
+	EXPECT_EQ(History.m_vpUndoActions.size(), 2u);
+
+	// an action over the memory limit on its own is still kept
+	g_Config.m_ClEditorMaxHistoryMemory = 1;
+	auto pLarge = std::make_shared<CTestTileAction>();
+	pLarge->m_ID = 11;
+	for(int y = 0; y < 300; y++)
+		for(int x = 0; x < 1000; x++)
+			pLarge->m_Changes.At(x, y) = STestTileStateChange{true, CTile{}, CTile{(unsigned char)(Rng() % 256)}};
+	pLarge->m_Changes.Finish();
+	ASSERT_GT(pLarge->MemoryUsage(), 1024u * 1024u);
+	History.RecordAction(pLarge);
+	ASSERT_EQ(History.m_vpUndoActions.size(), 1u);
+	EXPECT_EQ(History.m_vpUndoActions.front(), pLarge);
+
+	g_Config = SavedConfig;
+}
+
+TEST(TileStateChanges, FullLayerFillTime)
+{
+	// filling a whole large layer, like the auto mapper or a big brush does
+	const int Width = 1000;
+	const int Height = 1000;
+	CTestLayer Layer(Width, Height);
+	const std::vector<CTile> vBefore = Layer.m_vTiles;
+	const CTile Fill = {TILE_SOLID};
+
+	// the nested maps the changes were kept in before, for comparison
+	std::map<int, std::map<int, STestTileStateChange>> ReferenceChanges;
+	int64_t Start = time_get();
+	for(int y = 0; y < Height; y++)
+		for(int x = 0; x < Width; x++)
+			ReferenceChanges[y][x] = STestTileStateChange{true, Layer.m_vTiles[y * Width + x], Fill};
+	RecordProperty("ReferenceRecordMs", (int)((time_get() - Start) * 1000 / time_freq()));
+	// the nodes of the maps, with the 32 bytes of node links of libstdc++
+	const size_t ReferenceMemory = Width * Height * (sizeof(std::pair<const int, STestTileStateChange>) + 32) + Height * (sizeof(std::pair<const int, std::map<int, STestTileStateChange>>) + 32);
+	RecordProperty("ReferenceMemoryKiB", (int)(ReferenceMemory / 1024));
+	std::vector<CTile> vReferenceUndone = Layer.m_vTiles;
+	Start = time_get();
+	for(const auto &[y, Row] : ReferenceChanges)
+		for(const auto &[x, Change] : Row)
+			vReferenceUndone[y * Width + x] = Change.m_Previous;
+	RecordProperty("ReferenceUndoMs", (int)((time_get() - Start) * 1000 / time_freq()));
+	EXPECT_EQ(vReferenceUndone, vBefore);
+
+	Start = time_get();
+	for(int y = 0; y < Height; y++)
+		for(int x = 0; x < Width; x++)
+			Layer.SetTile(x, y, Fill);
+	CTileStateChanges<STestTileStateChange> Changes = std::move(Layer.m_History);
+	Changes.Finish();
+	RecordProperty("RecordMs", (int)((time_get() - Start) * 1000 / time_freq()));
+	RecordProperty("MemoryKiB", (int)(Changes.MemoryUsage() / 1024));
+	EXPECT_EQ(Changes.Size(), Width * Height);
+
+	Start = time_get();
+	Layer.Apply(Changes, true);
+	RecordProperty("UndoMs", (int)((time_get() - Start) * 1000 / time_freq()));
+	EXPECT_EQ(Layer.m_vTiles, vBefore);
+	Layer.Apply(Changes, false);
+
+	Start = time_get();
+	Changes.Compress();
+	RecordProperty("CompressMs", (int)((time_get() - Start) * 1000 / time_freq()));
+	RecordProperty("CompressedKiB", (int)(Changes.MemoryUsage() / 1024));
+	EXPECT_TRUE(Changes.IsCompressed());
+
+	Start = time_get();
+	Layer.Apply(Changes, true);
+	RecordProperty("CompressedUndoMs", (int)((time_get() - Start) * 1000 / time_freq()));
+	EXPECT_EQ(Layer.m_vTiles, vBefore);
+}